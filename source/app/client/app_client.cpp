@@ -4,6 +4,8 @@
 // Headers
 // ========================================================================== //
 
+#include <algorithm>
+#include <cstring>
 #include <dlog.hpp>
 #include <dutil/stopwatch.hpp>
 
@@ -12,6 +14,7 @@
 #include <imgui/imgui.h>
 #include <imgui/imgui_impl_glfw_gl3.h>
 #include "graphics/shader.hpp"
+#include "graphics/renderer.hpp"
 
 // ========================================================================== //
 // Private Functions
@@ -104,6 +107,7 @@ AppClient::AppClient(const AppClient::Descriptor& descriptor)
   : mTitle(descriptor.title)
   , mWidth(descriptor.width)
   , mHeight(descriptor.height)
+  , mPipelined(descriptor.enablePipelinedRendering)
 {
   // Initialize GLFW
   int result = glfwInit();
@@ -168,6 +172,26 @@ AppClient::~AppClient()
 
 void
 AppClient::Run()
+{
+  if (mPipelined) {
+    RunPipelined();
+  } else {
+    RunSerial();
+  }
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+AppClient::Exit()
+{
+  mRunning = false;
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+AppClient::RunSerial()
 {
   // Create and start stopwatch
   dutil::Stopwatch sw;
@@ -209,9 +233,209 @@ AppClient::Run()
 // -------------------------------------------------------------------------- //
 
 void
-AppClient::Exit()
+AppClient::RunPipelined()
 {
-  mRunning = false;
+  // ImGui lazily creates its OpenGL objects on the first new frame, make sure
+  // that happens while this thread still owns the context
+  ImGui_ImplGlfwGL3_CreateDeviceObjects();
+
+  // ImGui must not render on the game thread. The draw lists are instead
+  // copied and rendered by the render thread
+  ImGuiIO& io = ImGui::GetIO();
+  mRenderUI = io.RenderDrawListsFn;
+  io.RenderDrawListsFn = nullptr;
+
+  // Hand the context over to the render thread
+  mWriteFrame = std::make_unique<Frame>();
+  mPendingFrame = std::make_unique<Frame>();
+  mFramePending = false;
+  mRenderThreadRunning = true;
+  glfwMakeContextCurrent(nullptr);
+  mRenderThread = std::thread(&AppClient::RenderThreadMain, this);
+
+  // Create and start stopwatch
+  dutil::Stopwatch sw;
+  sw.Start();
+
+  // Run main loop
+  f64 timeLast = sw.fnow_s();
+  mRunning = true;
+  while (mRunning) {
+    MICROPROFILE_SCOPE(MAIN);
+
+    // Update time variables
+    const f64 timeCurrent = sw.fnow_s();
+    const f64 timeDelta = timeCurrent - timeLast;
+    timeLast = timeCurrent;
+
+    // Check if window has been requested to close by user
+    if (glfwWindowShouldClose(mWindow)) {
+      mRunning = false;
+      break;
+    }
+
+    // Update ImGui
+    ImGui_ImplGlfwGL3_NewFrame(mMouseGrabbed);
+
+    // Update
+    glfwPollEvents();
+    Update(timeDelta);
+
+    // Record frame
+    graphics::Renderer& renderer = GetRenderer();
+    renderer.BeginRecording(&mWriteFrame->snapshot);
+    Render();
+    renderer.EndRecording();
+    ImGui::Render();
+    CopyUI(*mWriteFrame);
+    mWriteFrame->width = mWidth;
+    mWriteFrame->height = mHeight;
+    mWriteFrame->time = glfwGetTime();
+
+    // Publish frame. If the render thread has not picked up the last frame
+    // then that frame is dropped in favour of this one
+    {
+      std::lock_guard<std::mutex> lock(mFrameMutex);
+      std::swap(mWriteFrame, mPendingFrame);
+      mFramePending = true;
+    }
+    mFrameCondition.notify_one();
+  }
+
+  // Stop render thread and take back the context, which is needed to destroy
+  // the OpenGL resources
+  {
+    std::lock_guard<std::mutex> lock(mFrameMutex);
+    mRenderThreadRunning = false;
+  }
+  mFrameCondition.notify_one();
+  mRenderThread.join();
+  glfwMakeContextCurrent(mWindow);
+  mWriteFrame.reset();
+  mPendingFrame.reset();
+  io.RenderDrawListsFn = mRenderUI;
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+AppClient::RenderThreadMain()
+{
+  MicroProfileOnThreadCreate("Render");
+  glfwMakeContextCurrent(mWindow);
+
+  // The two latest frames are kept to interpolate between them
+  auto currentFrame = std::make_unique<Frame>();
+  auto previousFrame = std::make_unique<Frame>();
+  bool hasCurrent = false;
+  bool hasPrevious = false;
+  bool interpolationDone = false;
+  u32 viewportWidth = 0;
+  u32 viewportHeight = 0;
+  std::vector<ImDrawList*> uiLists;
+
+  while (true) {
+    // Wait for a new frame, unless the current frame is still being
+    // interpolated towards
+    {
+      std::unique_lock<std::mutex> lock(mFrameMutex);
+      mFrameCondition.wait(lock, [&]() {
+        return mFramePending || !mRenderThreadRunning ||
+               (hasCurrent && !interpolationDone);
+      });
+      if (!mRenderThreadRunning) {
+        break;
+      }
+      if (mFramePending) {
+        std::swap(previousFrame, currentFrame);
+        std::swap(currentFrame, mPendingFrame);
+        mFramePending = false;
+        hasPrevious = hasCurrent;
+        hasCurrent = true;
+        interpolationDone = false;
+      }
+    }
+    MICROPROFILE_SCOPEI("AppClient", "RenderFrame", MP_ORANGE);
+
+    // Rendering lags one frame behind the game. The camera moves from the
+    // previous frame to the current frame over the time it took the game to
+    // produce the current frame
+    f32 alpha = 1.0f;
+    if (hasPrevious) {
+      const f64 frameTime = currentFrame->time - previousFrame->time;
+      if (frameTime > 0.0) {
+        alpha = f32(
+          std::clamp((glfwGetTime() - currentFrame->time) / frameTime, 0.0, 1.0));
+      }
+    }
+    interpolationDone = alpha >= 1.0f;
+
+    // Update viewport
+    if (currentFrame->width != viewportWidth ||
+        currentFrame->height != viewportHeight) {
+      viewportWidth = currentFrame->width;
+      viewportHeight = currentFrame->height;
+      if (viewportWidth && viewportHeight) {
+        glViewport(0, 0, viewportWidth, viewportHeight);
+      }
+    }
+
+    // Render
+    GetRenderer().Replay(currentFrame->snapshot,
+                         hasPrevious ? &previousFrame->snapshot : nullptr,
+                         alpha);
+    if (currentFrame->uiListCount > 0 && mRenderUI) {
+      ImDrawData drawData;
+      drawData.Valid = true;
+      uiLists.resize(currentFrame->uiListCount);
+      drawData.TotalVtxCount = 0;
+      drawData.TotalIdxCount = 0;
+      for (u32 i = 0; i < currentFrame->uiListCount; i++) {
+        uiLists[i] = currentFrame->uiLists[i].get();
+        drawData.TotalVtxCount += uiLists[i]->VtxBuffer.Size;
+        drawData.TotalIdxCount += uiLists[i]->IdxBuffer.Size;
+      }
+      drawData.CmdLists = uiLists.data();
+      drawData.CmdListsCount = int(currentFrame->uiListCount);
+      mRenderUI(&drawData);
+    }
+    glfwSwapBuffers(mWindow);
+
+    MicroProfileFlip(nullptr);
+  }
+
+  glfwMakeContextCurrent(nullptr);
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+AppClient::CopyUI(Frame& frame)
+{
+  ImDrawData* drawData = ImGui::GetDrawData();
+  frame.uiListCount = 0;
+  if (!drawData) {
+    return;
+  }
+
+  // Draw lists are reused between frames to keep their allocations
+  while (frame.uiLists.size() < u32(drawData->CmdListsCount)) {
+    frame.uiLists.push_back(std::make_unique<ImDrawList>());
+  }
+  const auto copyBuffer = [](auto& dst, const auto& src) {
+    dst.resize(src.Size);
+    if (src.Size > 0) {
+      std::memcpy(dst.Data, src.Data, src.Size * sizeof(*src.Data));
+    }
+  };
+  for (s32 i = 0; i < drawData->CmdListsCount; i++) {
+    const ImDrawList* src = drawData->CmdLists[i];
+    ImDrawList* dst = frame.uiLists[i].get();
+    copyBuffer(dst->CmdBuffer, src->CmdBuffer);
+    copyBuffer(dst->IdxBuffer, src->IdxBuffer);
+    copyBuffer(dst->VtxBuffer, src->VtxBuffer);
+  }
+  frame.uiListCount = u32(drawData->CmdListsCount);
 }
 
 // -------------------------------------------------------------------------- //
@@ -378,7 +602,7 @@ AppClient::ResizeCallback(GLFWwindow* window, int width, int height)
     const u32 _height = static_cast<u32>(height);
     app->mWidth = _width;
     app->mHeight = _height;
-    if (_width && _height) {
+    if (_width && _height && !app->mPipelined) {
       glViewport(0, 0, _width, _height);
     }
     app->OnWindowResize(_width, _height);
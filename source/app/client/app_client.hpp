@@ -7,10 +7,30 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <microprofile/microprofile.h>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 
+#include "core/macros.hpp"
 #include "app/app.hpp"
 #include "app/key.hpp"
 #include "app/mouse.hpp"
+#include "graphics/render_snapshot.hpp"
+
+// ========================================================================== //
+// Forward Declarations
+// ========================================================================== //
+
+struct ImDrawList;
+struct ImDrawData;
+
+namespace dib::graphics {
+
+DIB_FORWARD_DECLARE_CLASS(Renderer);
+
+}
 
 // ========================================================================== //
 // AppClient Declaration
@@ -34,6 +54,29 @@ public:
 
     /** Whether to enable V-sync **/
     bool enableVSync;
+
+    /** Whether to render on a separate thread. In this mode the game thread
+     * records each frame to a snapshot that the render thread then renders,
+     * which lets update and rendering overlap **/
+    bool enablePipelinedRendering = false;
+  };
+
+private:
+  /** Frame that is handed from the game thread to the render thread **/
+  struct Frame
+  {
+    /** Recorded sprites **/
+    graphics::RenderSnapshot snapshot;
+    /** Copy of the ImGui draw lists **/
+    std::vector<std::unique_ptr<ImDrawList>> uiLists;
+    /** Number of ImGui draw lists that are used **/
+    u32 uiListCount = 0;
+    /** Width of the window when the frame was recorded **/
+    u32 width = 0;
+    /** Height of the window when the frame was recorded **/
+    u32 height = 0;
+    /** Time when the frame was recorded **/
+    f64 time = 0.0;
   };
 
 private:
@@ -53,6 +96,27 @@ private:
   /** Whether mouse is grabbed by application **/
   bool mMouseGrabbed = false;
 
+  /** Whether rendering is done on a separate thread **/
+  bool mPipelined;
+  /** Render thread **/
+  std::thread mRenderThread;
+  /** Whether the render thread should keep running **/
+  bool mRenderThreadRunning = false;
+  /** Mutex protecting the pending frame **/
+  std::mutex mFrameMutex;
+  /** Signaled when a frame has been published or the render thread should
+   * stop **/
+  std::condition_variable mFrameCondition;
+  /** Frame being recorded by the game thread **/
+  std::unique_ptr<Frame> mWriteFrame;
+  /** Frame published by the game thread that the render thread has not yet
+   * picked up **/
+  std::unique_ptr<Frame> mPendingFrame;
+  /** Whether the pending frame is valid **/
+  bool mFramePending = false;
+  /** ImGui function that renders draw lists with OpenGL **/
+  void (*mRenderUI)(ImDrawData* drawData) = nullptr;
+
 public:
   /** Construct client application **/
   explicit AppClient(const Descriptor& descriptor);
@@ -75,9 +139,14 @@ public:
   /** Toggle fullscreen **/
   void ToggleFullscreen();
 
-  /** Called to render application **/
+  /** Called to render application. In pipelined mode this is called on the
+   * game thread while the renderer is recording **/
   virtual void Render() = 0;
 
+  /** Returns the renderer used to record and replay frames in pipelined
+   * mode **/
+  virtual graphics::Renderer& GetRenderer() = 0;
+
   /** Returns whether or not a key is down **/
   bool IsKeyDown(Key key) const;
 
@@ -125,6 +194,18 @@ public:
   GLFWwindow* GetWindow() const { return mWindow; }
 
 private:
+  /** Run the main loop with rendering done on the same thread **/
+  void RunSerial();
+
+  /** Run the main loop with rendering done on the render thread **/
+  void RunPipelined();
+
+  /** Main function of the render thread **/
+  void RenderThreadMain();
+
+  /** Copy the ImGui draw data of the current frame **/
+  static void CopyUI(Frame& frame);
+
   /** GLFW error callback **/
   static void ErrorCallback(int error, const char8* description);
 
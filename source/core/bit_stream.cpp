@@ -0,0 +1,268 @@
+#include "bit_stream.hpp"
+#include "core/assert.hpp"
+#include <algorithm>
+
+namespace dib {
+
+namespace {
+
+/** Values quantized at a time by the bulk paths. */
+constexpr u64 kBlockSize = 256;
+
+constexpr u64
+Mask(const u32 count)
+{
+  return count >= 64 ? ~u64{ 0 } : (u64{ 1 } << count) - 1;
+}
+
+f32
+Steps(const u32 bits)
+{
+  return static_cast<f32>(Mask(bits));
+}
+
+/**
+ * Quantize @count values, without branches so that the loop vectorizes.
+ * NaN is clamped to @min.
+ */
+void
+QuantizeBlock(const f32* values,
+              u32* out,
+              const u64 count,
+              const f32 min,
+              const f32 max,
+              const u32 bits)
+{
+  const f32 steps = Steps(bits);
+  const f32 scale = steps / (max - min);
+  for (u64 i = 0; i < count; i++) {
+    // clamped after scaling, arithmetic on a selected value stops gcc from
+    // vectorizing
+    const f32 scaled = (values[i] - min) * scale + 0.5f;
+    f32 clamped = scaled > 0.0f ? scaled : 0.0f;
+    clamped = clamped < steps ? clamped : steps;
+    // through s32, which converts in vector registers unlike u32
+    out[i] = static_cast<u32>(static_cast<s32>(clamped));
+  }
+}
+
+void
+DequantizeBlock(const u32* values,
+                f32* out,
+                const u64 count,
+                const f32 min,
+                const f32 max,
+                const u32 bits)
+{
+  const f32 scale = (max - min) / Steps(bits);
+  for (u64 i = 0; i < count; i++) {
+    out[i] = min + static_cast<f32>(values[i]) * scale;
+  }
+}
+
+}
+
+// ============================================================ //
+// BitWriter
+// ============================================================ //
+
+BitWriter::BitWriter(u8* data, const u64 capacity)
+  : data_(data)
+  , capacity_(capacity)
+{}
+
+void
+BitWriter::Put(const u64 value, const u32 count)
+{
+  scratch_ |= (value & Mask(count)) << scratch_bits_;
+  scratch_bits_ += count;
+  bit_count_ += count;
+  while (scratch_bits_ >= 8) {
+    data_[byte_offset_++] = static_cast<u8>(scratch_);
+    scratch_ >>= 8u;
+    scratch_bits_ -= 8;
+  }
+}
+
+bool
+BitWriter::WriteBits(const u64 value, const u32 count)
+{
+  AlfAssert(count <= 64, "cannot write more than 64 bits at a time");
+  if (count > capacity_ * 8 - bit_count_) {
+    return false;
+  }
+  if (count > 32) {
+    Put(value, 32);
+    Put(value >> 32u, count - 32);
+  } else {
+    Put(value, count);
+  }
+  return true;
+}
+
+bool
+BitWriter::WriteVarint(u64 value)
+{
+  while (value >= 0x80) {
+    if (!WriteBits((value & 0x7Fu) | 0x80u, 8)) {
+      return false;
+    }
+    value >>= 7u;
+  }
+  return WriteBits(value, 8);
+}
+
+bool
+BitWriter::WriteZigZag(const s64 value)
+{
+  const u64 zigzag =
+    (static_cast<u64>(value) << 1u) ^ static_cast<u64>(value >> 63);
+  return WriteVarint(zigzag);
+}
+
+bool
+BitWriter::WriteRange(const u32 value, const u32 min, const u32 max)
+{
+  AlfAssert(min <= value && value <= max, "value out of range");
+  return WriteBits(value - min, BitsRequired(max - min));
+}
+
+bool
+BitWriter::WriteQuantized(const f32 value,
+                          const f32 min,
+                          const f32 max,
+                          const u32 bits)
+{
+  return WriteQuantized(&value, 1, min, max, bits);
+}
+
+bool
+BitWriter::WriteQuantized(const f32* values,
+                          const u64 count,
+                          const f32 min,
+                          const f32 max,
+                          const u32 bits)
+{
+  AlfAssert(bits > 0 && bits <= kMaxQuantizedBits, "bad number of bits");
+  AlfAssert(min < max, "empty range");
+  if (count > (capacity_ * 8 - bit_count_) / bits) {
+    return false;
+  }
+
+  u32 block[kBlockSize];
+  for (u64 start = 0; start < count; start += kBlockSize) {
+    const u64 block_count = std::min(kBlockSize, count - start);
+    QuantizeBlock(values + start, block, block_count, min, max, bits);
+    for (u64 i = 0; i < block_count; i++) {
+      Put(block[i], bits);
+    }
+  }
+  return true;
+}
+
+void
+BitWriter::Flush()
+{
+  if (scratch_bits_ > 0) {
+    data_[byte_offset_] = static_cast<u8>(scratch_);
+  }
+}
+
+// ============================================================ //
+// BitReader
+// ============================================================ //
+
+BitReader::BitReader(const u8* data, const u64 size)
+  : data_(data)
+  , size_(size)
+{}
+
+u32
+BitReader::Take(const u32 count)
+{
+  while (scratch_bits_ < count && byte_offset_ < size_) {
+    scratch_ |= static_cast<u64>(data_[byte_offset_++]) << scratch_bits_;
+    scratch_bits_ += 8;
+  }
+  if (scratch_bits_ < count) {
+    error_ = true;
+    return 0;
+  }
+  const u32 value = static_cast<u32>(scratch_ & Mask(count));
+  scratch_ >>= count;
+  scratch_bits_ -= count;
+  bit_count_ += count;
+  return value;
+}
+
+u64
+BitReader::ReadBits(const u32 count)
+{
+  AlfAssert(count <= 64, "cannot read more than 64 bits at a time");
+  if (count > 32) {
+    const u64 low = Take(32);
+    return low | (static_cast<u64>(Take(count - 32)) << 32u);
+  }
+  return Take(count);
+}
+
+u64
+BitReader::ReadVarint()
+{
+  u64 value = 0;
+  for (u32 shift = 0; shift < 64; shift += 7) {
+    const u64 group = Take(8);
+    value |= (group & 0x7Fu) << shift;
+    if ((group & 0x80u) == 0) {
+      return value;
+    }
+  }
+  error_ = true;
+  return 0;
+}
+
+s64
+BitReader::ReadZigZag()
+{
+  const u64 zigzag = ReadVarint();
+  return static_cast<s64>((zigzag >> 1u) ^ (~(zigzag & 1u) + 1));
+}
+
+u32
+BitReader::ReadRange(const u32 min, const u32 max)
+{
+  const u64 value = min + ReadBits(BitsRequired(max - min));
+  if (value > max) {
+    error_ = true;
+    return max;
+  }
+  return static_cast<u32>(value);
+}
+
+f32
+BitReader::ReadQuantized(const f32 min, const f32 max, const u32 bits)
+{
+  f32 value;
+  ReadQuantized(&value, 1, min, max, bits);
+  return value;
+}
+
+void
+BitReader::ReadQuantized(f32* values,
+                         const u64 count,
+                         const f32 min,
+                         const f32 max,
+                         const u32 bits)
+{
+  AlfAssert(bits > 0 && bits <= kMaxQuantizedBits, "bad number of bits");
+  u32 block[kBlockSize];
+  for (u64 start = 0; start < count; start += kBlockSize) {
+    const u64 block_count = std::min(kBlockSize, count - start);
+    for (u64 i = 0; i < block_count; i++) {
+      block[i] = Take(bits);
+    }
+    DequantizeBlock(block, values + start, block_count, min, max, bits);
+  }
+}
+
+}
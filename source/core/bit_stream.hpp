@@ -0,0 +1,173 @@
+#ifndef BIT_STREAM_HPP_
+#define BIT_STREAM_HPP_
+
+#include "core/types.hpp"
+
+namespace dib {
+
+/**
+ * Bits needed to write any value in [0, @range].
+ */
+constexpr u32
+BitsRequired(u64 range)
+{
+  u32 bits = 0;
+  while (range > 0) {
+    bits++;
+    range >>= 1u;
+  }
+  return bits;
+}
+
+/**
+ * Largest number of bits a float is quantized into, more than the mantissa
+ * of a f32 would not add precision.
+ */
+constexpr u32 kMaxQuantizedBits = 24;
+
+// ============================================================ //
+// BitWriter
+// ============================================================ //
+
+/**
+ * Write values with the bits they need, instead of whole bytes.
+ *
+ * Bits are written least significant first, the first bit is the lowest bit
+ * of the first byte. Values are not aligned, they may start anywhere in a
+ * byte. Call Flush when done, to write the last partial byte.
+ */
+class BitWriter
+{
+public:
+  BitWriter(u8* data, const u64 capacity);
+
+  /**
+   * Write the low @count bits of @value, @count is at most 64.
+   * @return False if it does not fit, nothing is written then.
+   */
+  bool WriteBits(const u64 value, const u32 count);
+
+  bool WriteBool(const bool value) { return WriteBits(value ? 1 : 0, 1); }
+
+  /**
+   * Write @value in groups of 7 bits, each followed by a bit that tells if
+   * there are more. Small values are small.
+   */
+  bool WriteVarint(u64 value);
+
+  /**
+   * Write @value as a varint, zig-zag encoded so that small negative values
+   * are small too.
+   */
+  bool WriteZigZag(const s64 value);
+
+  /**
+   * Write @value in [@min, @max] with the bits that the range needs.
+   */
+  bool WriteRange(const u32 value, const u32 min, const u32 max);
+
+  /**
+   * Write @value, clamped to [@min, @max], as an integer of @bits bits.
+   */
+  bool WriteQuantized(const f32 value,
+                      const f32 min,
+                      const f32 max,
+                      const u32 bits);
+
+  /**
+   * WriteQuantized for an array. The values are quantized in blocks before
+   * they are written, in a loop without branches that the compiler can
+   * vectorize.
+   */
+  bool WriteQuantized(const f32* values,
+                      const u64 count,
+                      const f32 min,
+                      const f32 max,
+                      const u32 bits);
+
+  /**
+   * Write the last partial byte to the buffer. Writing may continue after.
+   */
+  void Flush();
+
+  u64 GetBitCount() const { return bit_count_; }
+
+  /**
+   * Bytes used, including the last partial byte.
+   */
+  u64 GetByteCount() const { return (bit_count_ + 7) / 8; }
+
+private:
+  /**
+   * Write the low @count bits of @value, @count is at most 32.
+   */
+  void Put(const u64 value, const u32 count);
+
+  u8* data_;
+  u64 capacity_;
+  u64 byte_offset_ = 0;
+  u64 bit_count_ = 0;
+
+  /** Bits not yet written to the buffer, fewer than 8 between writes. */
+  u64 scratch_ = 0;
+  u32 scratch_bits_ = 0;
+};
+
+// ============================================================ //
+// BitReader
+// ============================================================ //
+
+/**
+ * Read what a BitWriter wrote, in the same order.
+ *
+ * Reading past the end, or a value out of its range, sets the error flag
+ * instead of failing each read. Check HasError after reading a message.
+ */
+class BitReader
+{
+public:
+  BitReader(const u8* data, const u64 size);
+
+  /**
+   * Read @count bits, @count is at most 64. Zero if past the end.
+   */
+  u64 ReadBits(const u32 count);
+
+  bool ReadBool() { return ReadBits(1) != 0; }
+
+  u64 ReadVarint();
+
+  s64 ReadZigZag();
+
+  u32 ReadRange(const u32 min, const u32 max);
+
+  f32 ReadQuantized(const f32 min, const f32 max, const u32 bits);
+
+  void ReadQuantized(f32* values,
+                     const u64 count,
+                     const f32 min,
+                     const f32 max,
+                     const u32 bits);
+
+  bool HasError() const { return error_; }
+
+  u64 GetBitCount() const { return bit_count_; }
+
+private:
+  /**
+   * Read @count bits, @count is at most 32.
+   */
+  u32 Take(const u32 count);
+
+  const u8* data_;
+  u64 size_;
+  u64 byte_offset_ = 0;
+  u64 bit_count_ = 0;
+  u64 scratch_ = 0;
+  u32 scratch_bits_ = 0;
+  bool error_ = false;
+};
+
+}
+
+#endif // BIT_STREAM_HPP_
@@ -0,0 +1,349 @@
+#include "compression.hpp"
+#include "core/hash.hpp"
+#include <tsl/robin_map.h>
+#include <tsl/robin_set.h>
+#include <algorithm>
+#include <cstring>
+
+namespace dib {
+
+namespace {
+
+constexpr u32 kHashBits = 12;
+constexpr u32 kHashTableSize = 1u << kHashBits;
+constexpr u64 kMaxOffset = 0xFFFF;
+constexpr u8 kNibbleMax = 15;
+
+u32
+Read32(const u8* data)
+{
+  u32 value;
+  std::memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+u32
+Hash32(const u32 value)
+{
+  return (value * 2654435761u) >> (32 - kHashBits);
+}
+
+void
+WriteLength(std::vector<u8>& out, u64 length)
+{
+  while (length >= 255) {
+    out.push_back(255);
+    length -= 255;
+  }
+  out.push_back(static_cast<u8>(length));
+}
+
+bool
+ReadLength(const u8*& in, const u8* in_end, u64& length)
+{
+  u8 byte;
+  do {
+    if (in == in_end) {
+      return false;
+    }
+    byte = *in++;
+    length += byte;
+  } while (byte == 255);
+  return true;
+}
+
+void
+WriteSequence(std::vector<u8>& out,
+              const u8* literals,
+              const u64 literal_count,
+              const u64 offset,
+              const u64 match_length)
+{
+  const u64 match_extra = match_length - kLzMinMatch;
+  const u8 literal_nibble =
+    literal_count < kNibbleMax ? static_cast<u8>(literal_count) : kNibbleMax;
+  const u8 match_nibble =
+    match_extra < kNibbleMax ? static_cast<u8>(match_extra) : kNibbleMax;
+  out.push_back(static_cast<u8>((literal_nibble << 4u) | match_nibble));
+  if (literal_nibble == kNibbleMax) {
+    WriteLength(out, literal_count - kNibbleMax);
+  }
+  out.insert(out.end(), literals, literals + literal_count);
+
+  out.push_back(static_cast<u8>(offset & 0xFFu));
+  out.push_back(static_cast<u8>(offset >> 8u));
+  if (match_nibble == kNibbleMax) {
+    WriteLength(out, match_extra - kNibbleMax);
+  }
+}
+
+void
+WriteLastSequence(std::vector<u8>& out,
+                  const u8* literals,
+                  const u64 literal_count)
+{
+  const u8 literal_nibble =
+    literal_count < kNibbleMax ? static_cast<u8>(literal_count) : kNibbleMax;
+  out.push_back(static_cast<u8>(literal_nibble << 4u));
+  if (literal_nibble == kNibbleMax) {
+    WriteLength(out, literal_count - kNibbleMax);
+  }
+  out.insert(out.end(), literals, literals + literal_count);
+}
+
+
+/**
+ * Compress window[start, end), matches may start anywhere in the window.
+ * @param table Hash table of window[0, start), or nullptr if start is 0.
+ */
+u64
+CompressBlock(const u8* window,
+              const u64 start,
+              const u64 end,
+              const u32* table_init,
+              std::vector<u8>& out)
+{
+  const u64 out_start = out.size();
+  out.reserve(out_start + LzCompressBound(end - start));
+
+  // position + 1 of the last time each hash was seen, 0 is empty
+  u32 table[kHashTableSize];
+  if (table_init != nullptr) {
+    std::memcpy(table, table_init, sizeof(table));
+  } else {
+    std::memset(table, 0, sizeof(table));
+  }
+
+  u64 anchor = start;
+  u64 pos = start;
+  while (pos + kLzMinMatch <= end) {
+    const u32 sequence = Read32(window + pos);
+    const u32 hash = Hash32(sequence);
+    const u64 candidate = table[hash];
+    table[hash] = static_cast<u32>(pos + 1);
+
+    if (candidate == 0 || pos - (candidate - 1) > kMaxOffset ||
+        Read32(window + candidate - 1) != sequence) {
+      // step faster through data that does not compress
+      pos += 1 + ((pos - anchor) >> 6u);
+      continue;
+    }
+
+    const u64 match = candidate - 1;
+    u64 length = kLzMinMatch;
+    while (pos + length < end &&
+           window[match + length] == window[pos + length]) {
+      length++;
+    }
+
+    WriteSequence(out, window + anchor, pos - anchor, pos - match, length);
+    pos += length;
+    anchor = pos;
+  }
+  WriteLastSequence(out, window + anchor, end - anchor);
+
+  return out.size() - out_start;
+}
+
+}
+
+LzDictionary::LzDictionary(std::vector<u8> data)
+  : data_(std::move(data))
+  , table_(kHashTableSize, 0)
+{
+  if (data_.size() > kLzMaxDictionarySize) {
+    data_.erase(data_.begin(), data_.end() - kLzMaxDictionarySize);
+  }
+  if (!data_.empty()) {
+    checksum_ = HashFNV1a32(data_.data(), static_cast<u32>(data_.size()));
+  }
+
+  // later positions overwrite earlier, like when compressing
+  for (u64 pos = 0; pos + kLzMinMatch <= data_.size(); pos++) {
+    table_[Hash32(Read32(data_.data() + pos))] = static_cast<u32>(pos + 1);
+  }
+}
+
+u64
+LzCompressBound(const u64 data_count)
+{
+  // incompressible data is one sequence of literals
+  return data_count + data_count / 255 + 16;
+}
+
+u64
+LzCompress(const u8* data, const u64 data_count, std::vector<u8>& out)
+{
+  return CompressBlock(data, 0, data_count, nullptr, out);
+}
+
+u64
+LzCompress(const u8* data,
+           const u64 data_count,
+           std::vector<u8>& out,
+           const LzDictionary& dictionary)
+{
+  if (dictionary.IsEmpty()) {
+    return LzCompress(data, data_count, out);
+  }
+
+  // matches into the dictionary are found as if it came before the data
+  thread_local std::vector<u8> window{};
+  window.assign(dictionary.data_.begin(), dictionary.data_.end());
+  window.insert(window.end(), data, data + data_count);
+  return CompressBlock(window.data(),
+                       dictionary.data_.size(),
+                       window.size(),
+                       dictionary.table_.data(),
+                       out);
+}
+
+bool
+LzDecompress(const u8* data,
+             const u64 data_count,
+             u8* out,
+             const u64 out_count,
+             const LzDictionary* dictionary)
+{
+  const u8* dictionary_data = nullptr;
+  u64 dictionary_size = 0;
+  if (dictionary != nullptr) {
+    dictionary_data = dictionary->GetData().data();
+    dictionary_size = dictionary->GetData().size();
+  }
+
+  const u8* in = data;
+  const u8* const in_end = data + data_count;
+  u64 written = 0;
+
+  while (in < in_end) {
+    const u8 token = *in++;
+
+    u64 literal_count = token >> 4u;
+    if (literal_count == kNibbleMax && !ReadLength(in, in_end, literal_count)) {
+      return false;
+    }
+    if (literal_count > static_cast<u64>(in_end - in) ||
+        literal_count > out_count - written) {
+      return false;
+    }
+    if (literal_count > 0) {
+      std::memcpy(out + written, in, literal_count);
+    }
+    in += literal_count;
+    written += literal_count;
+
+    // the last sequence has no match
+    if (in == in_end) {
+      break;
+    }
+
+    if (in_end - in < 2) {
+      return false;
+    }
+    const u64 offset =
+      static_cast<u64>(in[0]) | (static_cast<u64>(in[1]) << 8u);
+    in += 2;
+    u64 length = token & 0x0Fu;
+    if (length == kNibbleMax && !ReadLength(in, in_end, length)) {
+      return false;
+    }
+    length += kLzMinMatch;
+    if (offset == 0 || offset > written + dictionary_size ||
+        length > out_count - written) {
+      return false;
+    }
+
+    // the start of the match may be in the dictionary
+    u64 i = 0;
+    if (offset > written) {
+      const u64 from_dictionary = std::min(length, offset - written);
+      std::memcpy(out + written,
+                  dictionary_data + dictionary_size - (offset - written),
+                  from_dictionary);
+      i = from_dictionary;
+    }
+
+    // byte by byte, the match may overlap what it writes
+    for (; i < length; i++) {
+      out[written + i] = out[written + i - offset];
+    }
+    written += length;
+  }
+
+  return written == out_count;
+}
+
+std::vector<u8>
+LzTrainDictionary(const std::vector<std::vector<u8>>& samples,
+                  const u64 max_size)
+{
+  constexpr u64 kGramSize = 8;
+  constexpr u64 kSegmentSize = 32;
+
+  // in how many samples each gram is found
+  tsl::robin_map<u64, u32> counts{};
+  for (const auto& sample : samples) {
+    tsl::robin_set<u64> seen{};
+    for (u64 pos = 0; pos + kGramSize <= sample.size(); pos++) {
+      const u64 gram = HashFNV1a64(sample.data() + pos, kGramSize);
+      if (seen.insert(gram).second) {
+        counts[gram]++;
+      }
+    }
+  }
+
+  // score the segments of each sample by how common their grams are
+  struct Segment
+  {
+    const u8* data;
+    u64 size;
+    u64 score;
+  };
+  std::vector<Segment> segments{};
+  for (const auto& sample : samples) {
+    for (u64 start = 0; start < sample.size(); start += kSegmentSize) {
+      Segment segment{};
+      segment.data = sample.data() + start;
+      segment.size = std::min(kSegmentSize, sample.size() - start);
+      for (u64 pos = 0; pos + kGramSize <= segment.size; pos++) {
+        segment.score +=
+          counts[HashFNV1a64(segment.data + pos, kGramSize)];
+      }
+      segments.push_back(segment);
+    }
+  }
+  std::stable_sort(
+    segments.begin(), segments.end(), [](const Segment& a, const Segment& b) {
+      return a.score > b.score;
+    });
+
+  // take the best segments that add something new
+  std::vector<const Segment*> picked{};
+  tsl::robin_set<u64> covered{};
+  u64 size = 0;
+  for (const Segment& segment : segments) {
+    if (size + segment.size > max_size) {
+      continue;
+    }
+    bool is_new = segment.size < kGramSize;
+    for (u64 pos = 0; pos + kGramSize <= segment.size; pos++) {
+      const u64 gram = HashFNV1a64(segment.data + pos, kGramSize);
+      is_new |= covered.insert(gram).second;
+    }
+    if (is_new) {
+      picked.push_back(&segment);
+      size += segment.size;
+    }
+  }
+
+  // most common last
+  std::vector<u8> dictionary{};
+  dictionary.reserve(size);
+  for (auto it = picked.rbegin(); it != picked.rend(); ++it) {
+    dictionary.insert(
+      dictionary.end(), (*it)->data, (*it)->data + (*it)->size);
+  }
+  return dictionary;
+}
+}
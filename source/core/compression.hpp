@@ -0,0 +1,117 @@
+#ifndef COMPRESSION_HPP_
+#define COMPRESSION_HPP_
+
+#include "core/types.hpp"
+#include <vector>
+
+namespace dib {
+
+/**
+ * Fast LZ77 compression, with a block format in the style of LZ4.
+ *
+ * The compressed block is a list of sequences. Each sequence starts with a
+ * token byte, where the high nibble is the number of literals and the low
+ * nibble is the match length minus kLzMinMatch. A nibble of 15 is followed by
+ * bytes that are added to it, until a byte that is not 255. Then come the
+ * literals, a u16 little endian offset back into the output and the extra
+ * bytes of the match length. The last sequence is only literals.
+ *
+ * The block does not store the decompressed size, the caller has to.
+ */
+constexpr u64 kLzMinMatch = 4;
+
+/**
+ * Matches reach at most this far back, so larger dictionaries are cut.
+ */
+constexpr u64 kLzMaxDictionarySize = 0xFFFF;
+
+/**
+ * Bytes that compressed blocks can refer to without holding them, shared by
+ * the compressor and the decompressor. Small messages have little to refer
+ * back to in themselves, a dictionary of what such messages usually hold
+ * lets them compress anyway.
+ *
+ * Only the last kLzMaxDictionarySize bytes are kept.
+ */
+class LzDictionary
+{
+public:
+  LzDictionary() = default;
+
+  explicit LzDictionary(std::vector<u8> data);
+
+  const std::vector<u8>& GetData() const { return data_; }
+
+  /**
+   * Checksum of the data, to find out if both sides use the same dictionary.
+   * Zero for the empty dictionary.
+   */
+  u32 GetChecksum() const { return checksum_; }
+
+  bool IsEmpty() const { return data_.empty(); }
+
+private:
+  friend u64 LzCompress(const u8*,
+                        const u64,
+                        std::vector<u8>&,
+                        const LzDictionary&);
+
+  std::vector<u8> data_{};
+
+  /** Hash table of the compressor, filled in with the dictionary. */
+  std::vector<u32> table_{};
+
+  u32 checksum_{ 0 };
+};
+
+// ============================================================ //
+
+/**
+ * Largest size that @data_count bytes can be compressed into.
+ */
+u64
+LzCompressBound(const u64 data_count);
+
+/**
+ * Compress @data and append it to @out.
+ * @return Number of bytes appended.
+ */
+u64
+LzCompress(const u8* data, const u64 data_count, std::vector<u8>& out);
+
+/**
+ * Compress @data with a dictionary, the block can only be decompressed with
+ * the same dictionary.
+ */
+u64
+LzCompress(const u8* data,
+           const u64 data_count,
+           std::vector<u8>& out,
+           const LzDictionary& dictionary);
+
+/**
+ * Decompress a block into @out, which must hold exactly the decompressed
+ * size. Blocks from the network are not trusted, every read and write is
+ * bounds checked.
+ * @param dictionary The dictionary the block was compressed with, if any.
+ * @return False if the block is corrupt, or does not decompress into exactly
+ * @out_count bytes.
+ */
+bool
+LzDecompress(const u8* data,
+             const u64 data_count,
+             u8* out,
+             const u64 out_count,
+             const LzDictionary* dictionary = nullptr);
+
+/**
+ * Build a dictionary of at most @max_size bytes from sample messages. The
+ * pieces of the samples that recur the most, across samples, are picked, and
+ * the most common end up last, closest to the data.
+ */
+std::vector<u8>
+LzTrainDictionary(const std::vector<std::vector<u8>>& samples,
+                  const u64 max_size);
+}
+
+#endif // COMPRESSION_HPP_
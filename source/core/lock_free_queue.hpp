@@ -0,0 +1,255 @@
+#ifndef LOCK_FREE_QUEUE_HPP_
+#define LOCK_FREE_QUEUE_HPP_
+
+#include "core/types.hpp"
+#include <atomic>
+#include <memory>
+#include <utility>
+
+namespace dib {
+
+/**
+ * Size of a cache line, used to keep the indices of the producer and the
+ * consumer from sharing one.
+ */
+static constexpr std::size_t kCacheLineSize = 64;
+
+// ============================================================ //
+// SpscQueue
+// ============================================================ //
+
+/**
+ * Bounded lock-free queue for exactly one producer thread and one consumer
+ * thread.
+ *
+ * The capacity is rounded up to a power of two. The producer only writes the
+ * tail and the consumer only writes the head, so neither side needs more than
+ * an acquire load of the index owned by the other side.
+ */
+template<typename T>
+class SpscQueue
+{
+public:
+  explicit SpscQueue(u64 capacity)
+    : capacity_(RoundUpPow2(capacity))
+    , mask_(capacity_ - 1)
+    , buffer_(std::make_unique<T[]>(capacity_))
+  {}
+
+  SpscQueue(const SpscQueue& other) = delete;
+
+  SpscQueue& operator=(const SpscQueue& other) = delete;
+
+  /**
+   * Producer only.
+   * @return False if the queue is full, @value is then left untouched.
+   */
+  bool TryPush(T&& value)
+  {
+    const u64 tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) == capacity_) {
+      return false;
+    }
+    buffer_[tail & mask_] = std::move(value);
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool TryPush(const T& value)
+  {
+    T copy = value;
+    return TryPush(std::move(copy));
+  }
+
+  /**
+   * Consumer only.
+   * @return False if the queue is empty.
+   */
+  bool TryPop(T& out)
+  {
+    const u64 head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire)) {
+      return false;
+    }
+    out = std::move(buffer_[head & mask_]);
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Number of items in the queue, only exact when neither side is active.
+   */
+  u64 GetSize() const
+  {
+    return tail_.load(std::memory_order_acquire) -
+           head_.load(std::memory_order_acquire);
+  }
+
+  bool IsEmpty() const { return GetSize() == 0; }
+
+  u64 GetCapacity() const { return capacity_; }
+
+private:
+  static u64 RoundUpPow2(u64 value)
+  {
+    u64 pow2 = 1;
+    while (pow2 < value) {
+      pow2 <<= 1u;
+    }
+    return pow2;
+  }
+
+private:
+  u64 capacity_;
+  u64 mask_;
+  std::unique_ptr<T[]> buffer_;
+
+  /** Next slot to pop, written by the consumer. */
+  alignas(kCacheLineSize) std::atomic<u64> head_{ 0 };
+
+  /** Next slot to push, written by the producer. */
+  alignas(kCacheLineSize) std::atomic<u64> tail_{ 0 };
+};
+
+// ============================================================ //
+// MpscQueue
+// ============================================================ //
+
+/**
+ * Bounded lock-free queue for any number of producer threads and one consumer
+ * thread.
+ *
+ * Each slot carries a sequence number that tells whether it is free for the
+ * producer that claimed its position, or filled for the consumer. Producers
+ * claim positions with a compare-and-swap on the tail, so a producer that is
+ * preempted between claiming and filling a slot only delays the consumer at
+ * that slot, it never corrupts the queue.
+ */
+template<typename T>
+class MpscQueue
+{
+public:
+  explicit MpscQueue(u64 capacity)
+    : capacity_(RoundUpPow2(capacity))
+    , mask_(capacity_ - 1)
+    , slots_(std::make_unique<Slot[]>(capacity_))
+  {
+    for (u64 i = 0; i < capacity_; i++) {
+      slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  MpscQueue(const MpscQueue& other) = delete;
+
+  MpscQueue& operator=(const MpscQueue& other) = delete;
+
+  /**
+   * Any thread.
+   * @return False if the queue is full, @value is then left untouched.
+   */
+  bool TryPush(T&& value)
+  {
+    return TryPushWith([&value](T& slot_value) {
+      slot_value = std::move(value);
+    });
+  }
+
+  bool TryPush(const T& value)
+  {
+    T copy = value;
+    return TryPush(std::move(copy));
+  }
+
+  /**
+   * Any thread. Fills the item in place by calling @fill with the value of
+   * its slot, which still holds what the consumer left there. A slot can so
+   * keep the memory that its value owns instead of allocating on each push.
+   * @return False if the queue is full, @fill is then not called.
+   */
+  template<typename F>
+  bool TryPushWith(F&& fill)
+  {
+    u64 tail = tail_.load(std::memory_order_relaxed);
+    for (;;) {
+      Slot& slot = slots_[tail & mask_];
+      const u64 sequence = slot.sequence.load(std::memory_order_acquire);
+      const s64 diff = static_cast<s64>(sequence - tail);
+      if (diff == 0) {
+        if (tail_.compare_exchange_weak(
+              tail, tail + 1, std::memory_order_relaxed)) {
+          fill(slot.value);
+          slot.sequence.store(tail + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        tail = tail_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /**
+   * Consumer only.
+   * @return False if the queue is empty, or if the producer of the next item
+   * has not finished pushing it yet.
+   */
+  bool TryPop(T& out)
+  {
+    return TryPopWith([&out](T& slot_value) { out = std::move(slot_value); });
+  }
+
+  /**
+   * Consumer only. Uses the next item in place by calling @consume with the
+   * value of its slot, whatever is left in it is handed to the producer that
+   * fills the slot next, see TryPushWith.
+   * @return False if the queue is empty, or if the producer of the next item
+   * has not finished pushing it yet.
+   */
+  template<typename F>
+  bool TryPopWith(F&& consume)
+  {
+    Slot& slot = slots_[head_ & mask_];
+    const u64 sequence = slot.sequence.load(std::memory_order_acquire);
+    if (sequence != head_ + 1) {
+      return false;
+    }
+    consume(slot.value);
+    slot.sequence.store(head_ + capacity_, std::memory_order_release);
+    head_++;
+    return true;
+  }
+
+  u64 GetCapacity() const { return capacity_; }
+
+private:
+  struct Slot
+  {
+    std::atomic<u64> sequence{ 0 };
+    T value{};
+  };
+
+  static u64 RoundUpPow2(u64 value)
+  {
+    u64 pow2 = 1;
+    while (pow2 < value) {
+      pow2 <<= 1u;
+    }
+    return pow2;
+  }
+
+private:
+  u64 capacity_;
+  u64 mask_;
+  std::unique_ptr<Slot[]> slots_;
+
+  /** Next slot to pop, only touched by the consumer. */
+  alignas(kCacheLineSize) u64 head_{ 0 };
+
+  /** Next slot to claim, shared by the producers. */
+  alignas(kCacheLineSize) std::atomic<u64> tail_{ 0 };
+};
+
+}
+
+#endif // LOCK_FREE_QUEUE_HPP_
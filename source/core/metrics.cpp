@@ -0,0 +1,285 @@
+#include "metrics.hpp"
+#include "core/assert.hpp"
+#include <dlog.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace dib {
+
+namespace {
+
+std::string
+FormatValue(const f64 value)
+{
+  if (std::isnan(value)) {
+    return "NaN";
+  }
+  if (std::isinf(value)) {
+    return value > 0.0 ? "+Inf" : "-Inf";
+  }
+  return dlog::Format("{}", value);
+}
+
+/**
+ * Escape a label value, or with @in_help the text of a HELP line, which
+ * keeps its quotes.
+ */
+std::string
+Escape(const std::string& text, const bool in_help = false)
+{
+  std::string escaped;
+  escaped.reserve(text.size());
+  for (const char c : text) {
+    if (c == '\\') {
+      escaped += "\\\\";
+    } else if (c == '\n') {
+      escaped += "\\n";
+    } else if (c == '"' && !in_help) {
+      escaped += "\\\"";
+    } else {
+      escaped += c;
+    }
+  }
+  return escaped;
+}
+
+std::string
+RenderLabels(const Metrics::Labels& labels)
+{
+  if (labels.empty()) {
+    return {};
+  }
+  std::string rendered = "{";
+  for (std::size_t i = 0; i < labels.size(); i++) {
+    if (i > 0) {
+      rendered += ',';
+    }
+    rendered += labels[i].first;
+    rendered += "=\"";
+    rendered += Escape(labels[i].second);
+    rendered += '"';
+  }
+  rendered += '}';
+  return rendered;
+}
+
+/**
+ * Labels of a histogram bucket, @labels with le added.
+ */
+std::string
+BucketLabels(const std::string& labels, const std::string& bound)
+{
+  const std::string le = "le=\"" + bound + "\"";
+  if (labels.empty()) {
+    return "{" + le + "}";
+  }
+  return labels.substr(0, labels.size() - 1) + "," + le + "}";
+}
+
+void
+AddAtomic(std::atomic<f64>& atomic, const f64 value)
+{
+  f64 current = atomic.load(std::memory_order_relaxed);
+  while (!atomic.compare_exchange_weak(
+    current, current + value, std::memory_order_relaxed)) {
+  }
+}
+
+}
+
+// ============================================================ //
+// Gauge
+// ============================================================ //
+
+void
+Gauge::Add(const f64 value)
+{
+  AddAtomic(value_, value);
+}
+
+// ============================================================ //
+// Histogram
+// ============================================================ //
+
+Histogram::Histogram(std::vector<f64> bounds)
+  : bounds_(std::move(bounds))
+  , buckets_(new std::atomic<u64>[bounds_.size() + 1]())
+{
+  AlfAssert(std::is_sorted(bounds_.begin(), bounds_.end()),
+            "histogram bounds must be increasing");
+}
+
+void
+Histogram::Observe(const f64 value)
+{
+  // there are few bounds, a linear search is as fast as a binary one
+  std::size_t index = 0;
+  while (index < bounds_.size() && value > bounds_[index]) {
+    index++;
+  }
+  buckets_[index].fetch_add(1, std::memory_order_relaxed);
+  AddAtomic(sum_, value);
+}
+
+u64
+Histogram::GetCount() const
+{
+  u64 count = 0;
+  for (std::size_t i = 0; i <= bounds_.size(); i++) {
+    count += GetBucketCount(i);
+  }
+  return count;
+}
+
+std::vector<f64>
+Histogram::ExponentialBounds(const f64 start, const f64 factor, const u32 count)
+{
+  std::vector<f64> bounds(count);
+  f64 bound = start;
+  for (f64& b : bounds) {
+    b = bound;
+    bound *= factor;
+  }
+  return bounds;
+}
+
+// ============================================================ //
+// Metrics
+// ============================================================ //
+
+template<typename TMetric, typename... TArgs>
+TMetric&
+Metrics::FindOrAdd(const std::string& name,
+                   const std::string& help,
+                   const Labels& labels,
+                   TArgs&&... args)
+{
+  std::string rendered = RenderLabels(labels);
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const auto& entry : entries_) {
+    if (entry->name == name && entry->labels == rendered) {
+      AlfAssert(std::holds_alternative<TMetric>(entry->metric),
+                "metric was added before with another type");
+      return std::get<TMetric>(entry->metric);
+    }
+  }
+  entries_.push_back(std::make_unique<Entry>(name,
+                                             help,
+                                             std::move(rendered),
+                                             std::in_place_type<TMetric>,
+                                             std::forward<TArgs>(args)...));
+  return std::get<TMetric>(entries_.back()->metric);
+}
+
+Counter&
+Metrics::AddCounter(const std::string& name,
+                    const std::string& help,
+                    const Labels& labels)
+{
+  return FindOrAdd<Counter>(name, help, labels);
+}
+
+Gauge&
+Metrics::AddGauge(const std::string& name,
+                  const std::string& help,
+                  const Labels& labels)
+{
+  return FindOrAdd<Gauge>(name, help, labels);
+}
+
+Histogram&
+Metrics::AddHistogram(const std::string& name,
+                      const std::string& help,
+                      std::vector<f64> bounds,
+                      const Labels& labels)
+{
+  return FindOrAdd<Histogram>(name, help, labels, std::move(bounds));
+}
+
+void
+Metrics::AddCollector(Collector collector)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  collectors_.push_back(std::move(collector));
+}
+
+std::size_t
+Metrics::GetMetricCount() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return entries_.size();
+}
+
+std::string
+Metrics::ToText() const
+{
+  // collectors run without the lock, so that they may add metrics
+  std::vector<Collector> collectors;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    collectors = collectors_;
+  }
+  for (const Collector& collector : collectors) {
+    collector();
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  // a family is written together, even if its metrics were added apart
+  std::vector<const Entry*> sorted;
+  sorted.reserve(entries_.size());
+  for (const auto& entry : entries_) {
+    sorted.push_back(entry.get());
+  }
+  std::stable_sort(
+    sorted.begin(), sorted.end(), [](const Entry* a, const Entry* b) {
+      return a->name < b->name;
+    });
+
+  std::string text;
+  const std::string* family = nullptr;
+  for (const Entry* entry : sorted) {
+    if (family == nullptr || *family != entry->name) {
+      family = &entry->name;
+      const char* type = std::holds_alternative<Counter>(entry->metric)
+                           ? "counter"
+                           : std::holds_alternative<Gauge>(entry->metric)
+                               ? "gauge"
+                               : "histogram";
+      text += dlog::Format(
+        "# HELP {} {}\n", entry->name, Escape(entry->help, true));
+      text += dlog::Format("# TYPE {} {}\n", entry->name, type);
+    }
+
+    if (const auto* counter = std::get_if<Counter>(&entry->metric)) {
+      text += dlog::Format(
+        "{}{} {}\n", entry->name, entry->labels, counter->Get());
+    } else if (const auto* gauge = std::get_if<Gauge>(&entry->metric)) {
+      text += dlog::Format(
+        "{}{} {}\n", entry->name, entry->labels, FormatValue(gauge->Get()));
+    } else {
+      const auto& histogram = std::get<Histogram>(entry->metric);
+      const std::vector<f64>& bounds = histogram.GetBounds();
+      u64 cumulative = 0;
+      for (std::size_t i = 0; i <= bounds.size(); i++) {
+        cumulative += histogram.GetBucketCount(i);
+        const std::string bound =
+          i < bounds.size() ? FormatValue(bounds[i]) : "+Inf";
+        text += dlog::Format("{}_bucket{} {}\n",
+                             entry->name,
+                             BucketLabels(entry->labels, bound),
+                             cumulative);
+      }
+      text += dlog::Format("{}_sum{} {}\n",
+                           entry->name,
+                           entry->labels,
+                           FormatValue(histogram.GetSum()));
+      // the count is the sum of the buckets, so that it matches +Inf
+      text += dlog::Format(
+        "{}_count{} {}\n", entry->name, entry->labels, cumulative);
+    }
+  }
+  return text;
+}
+
+}
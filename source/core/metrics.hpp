@@ -0,0 +1,217 @@
+#ifndef METRICS_HPP_
+#define METRICS_HPP_
+
+#include "core/types.hpp"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace dib {
+
+// ============================================================ //
+// Counter
+// ============================================================ //
+
+/**
+ * Value that only goes up, like the number of packets received.
+ *
+ * Updating is a relaxed atomic add, so any thread may count without a lock
+ * while another thread exports.
+ */
+class Counter
+{
+public:
+  void Add(const u64 value = 1)
+  {
+    value_.fetch_add(value, std::memory_order_relaxed);
+  }
+
+  u64 Get() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+  std::atomic<u64> value_{ 0 };
+};
+
+// ============================================================ //
+// Gauge
+// ============================================================ //
+
+/**
+ * Value that goes up and down, like the number of players.
+ */
+class Gauge
+{
+public:
+  void Set(const f64 value) { value_.store(value, std::memory_order_relaxed); }
+
+  void Add(const f64 value);
+
+  f64 Get() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+  std::atomic<f64> value_{ 0.0 };
+};
+
+// ============================================================ //
+// Histogram
+// ============================================================ //
+
+/**
+ * Counts of observed values in buckets with fixed upper bounds, like tick
+ * durations.
+ *
+ * Observing is a search through the bounds and relaxed atomic adds, without
+ * a lock. The counts are not read as one snapshot, an export during an
+ * observation may see the bucket counted but not the sum.
+ */
+class Histogram
+{
+public:
+  /**
+   * @param bounds Upper bounds of the buckets, in increasing order. A last
+   * bucket without bound is added.
+   */
+  explicit Histogram(std::vector<f64> bounds);
+
+  void Observe(const f64 value);
+
+  const std::vector<f64>& GetBounds() const { return bounds_; }
+
+  /**
+   * Count of values in bucket @index, not including the buckets before it.
+   * @index may be the size of the bounds, for the bucket without bound.
+   */
+  u64 GetBucketCount(const std::size_t index) const
+  {
+    return buckets_[index].load(std::memory_order_relaxed);
+  }
+
+  u64 GetCount() const;
+
+  f64 GetSum() const { return sum_.load(std::memory_order_relaxed); }
+
+  /**
+   * @count bounds, from @start and each @factor times the previous one.
+   */
+  static std::vector<f64> ExponentialBounds(const f64 start,
+                                            const f64 factor,
+                                            const u32 count);
+
+private:
+  std::vector<f64> bounds_;
+  std::unique_ptr<std::atomic<u64>[]> buckets_;
+  std::atomic<f64> sum_{ 0.0 };
+};
+
+// ============================================================ //
+// Metrics
+// ============================================================ //
+
+/**
+ * Owns counters, gauges and histograms and exports them in the Prometheus
+ * text format.
+ *
+ * Adding a metric takes a lock, keep the returned reference instead of
+ * adding on hot paths. Metrics are never removed, so the references stay
+ * valid for the lifetime of the registry. A metric is identified by its name
+ * and labels, metrics with the same name and different labels are one
+ * family, like the packets received of each packet type.
+ */
+class Metrics
+{
+public:
+  using Labels = std::vector<std::pair<std::string, std::string>>;
+
+  /**
+   * Called before each export, from the exporting thread, to update gauges
+   * that are cheap enough to read on demand.
+   */
+  using Collector = std::function<void()>;
+
+  Metrics() = default;
+
+  Metrics(const Metrics& other) = delete;
+  Metrics& operator=(const Metrics& other) = delete;
+
+  /**
+   * Add a counter, or return the existing one with the same name and
+   * labels. @name should follow the Prometheus conventions, like
+   * "dib_packets_received_total".
+   */
+  Counter& AddCounter(const std::string& name,
+                      const std::string& help,
+                      const Labels& labels = {});
+
+  Gauge& AddGauge(const std::string& name,
+                  const std::string& help,
+                  const Labels& labels = {});
+
+  /**
+   * Add a histogram, see Histogram for @bounds. An existing histogram keeps
+   * its bounds.
+   */
+  Histogram& AddHistogram(const std::string& name,
+                          const std::string& help,
+                          std::vector<f64> bounds,
+                          const Labels& labels = {});
+
+  void AddCollector(Collector collector);
+
+  /**
+   * Run the collectors and return all metrics in the Prometheus text
+   * exposition format, version 0.0.4.
+   */
+  std::string ToText() const;
+
+  std::size_t GetMetricCount() const;
+
+private:
+  struct Entry
+  {
+    std::string name;
+    std::string help;
+
+    /** Rendered, like {type="chat"}, or empty. */
+    std::string labels;
+
+    std::variant<Counter, Gauge, Histogram> metric;
+
+    template<typename TMetric, typename... TArgs>
+    Entry(std::string name_,
+          std::string help_,
+          std::string labels_,
+          std::in_place_type_t<TMetric> type,
+          TArgs&&... args)
+      : name(std::move(name_))
+      , help(std::move(help_))
+      , labels(std::move(labels_))
+      , metric(type, std::forward<TArgs>(args)...)
+    {}
+  };
+
+  /**
+   * Find the entry of @name and @labels, or add one with a TMetric built
+   * from @args.
+   */
+  template<typename TMetric, typename... TArgs>
+  TMetric& FindOrAdd(const std::string& name,
+                     const std::string& help,
+                     const Labels& labels,
+                     TArgs&&... args);
+
+  mutable std::mutex mutex_;
+
+  /** Entries are boxed, so that references to the metrics stay valid. */
+  std::vector<std::unique_ptr<Entry>> entries_{};
+
+  std::vector<Collector> collectors_{};
+};
+
+}
+
+#endif // METRICS_HPP_
@@ -0,0 +1,179 @@
+#include "metrics_exporter.hpp"
+#include <dlog.hpp>
+#include <cerrno>
+#include <cstring>
+#include <string>
+
+#if !defined(_WIN32)
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace dib {
+
+namespace {
+
+/** Requests are not parsed beyond the request line, this is plenty. */
+constexpr std::size_t kMaxRequestSize = 4096;
+
+/** A scraper that does not send its request in time is dropped. */
+constexpr int kRequestTimeoutMs = 1000;
+
+}
+
+MetricsExporter::~MetricsExporter()
+{
+  Stop();
+}
+
+#if defined(_WIN32)
+
+bool
+MetricsExporter::Start(const Metrics&, const u16)
+{
+  DLOG_WARNING("the metrics exporter is not supported on windows");
+  return false;
+}
+
+void
+MetricsExporter::Stop()
+{}
+
+void
+MetricsExporter::Serve(const Metrics&)
+{}
+
+void
+MetricsExporter::Respond(const Metrics&, const int) const
+{}
+
+#else
+
+bool
+MetricsExporter::Start(const Metrics& metrics, const u16 port)
+{
+  if (IsRunning()) {
+    return false;
+  }
+
+  socket_ = socket(AF_INET, SOCK_STREAM, 0);
+  if (socket_ < 0) {
+    DLOG_ERROR("could not create metrics socket: {}", std::strerror(errno));
+    return false;
+  }
+  const int reuse = 1;
+  setsockopt(socket_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  address.sin_port = htons(port);
+  socklen_t address_size = sizeof(address);
+  if (bind(socket_, reinterpret_cast<sockaddr*>(&address), address_size) !=
+        0 ||
+      listen(socket_, 8) != 0 ||
+      getsockname(
+        socket_, reinterpret_cast<sockaddr*>(&address), &address_size) != 0) {
+    DLOG_ERROR("could not serve metrics on port {}: {}",
+               port,
+               std::strerror(errno));
+    close(socket_);
+    socket_ = -1;
+    return false;
+  }
+  port_ = ntohs(address.sin_port);
+
+  running_ = true;
+  thread_ = std::thread([this, &metrics]() { Serve(metrics); });
+  DLOG_INFO("serving metrics on http://127.0.0.1:{}/metrics", port_);
+  return true;
+}
+
+void
+MetricsExporter::Stop()
+{
+  if (!IsRunning()) {
+    return;
+  }
+  running_ = false;
+  thread_.join();
+  close(socket_);
+  socket_ = -1;
+  port_ = 0;
+}
+
+void
+MetricsExporter::Serve(const Metrics& metrics)
+{
+  while (running_) {
+    pollfd listener{ socket_, POLLIN, 0 };
+    if (poll(&listener, 1, kPollTimeoutMs) <= 0) {
+      continue;
+    }
+    const int connection = accept(socket_, nullptr, nullptr);
+    if (connection < 0) {
+      continue;
+    }
+    Respond(metrics, connection);
+    close(connection);
+  }
+}
+
+void
+MetricsExporter::Respond(const Metrics& metrics, const int connection) const
+{
+  // read until the end of the headers, the request has no body
+  std::string request;
+  char buffer[512];
+  while (request.find("\r\n\r\n") == std::string::npos &&
+         request.size() < kMaxRequestSize) {
+    pollfd client{ connection, POLLIN, 0 };
+    if (poll(&client, 1, kRequestTimeoutMs) <= 0) {
+      return;
+    }
+    const ssize_t received = recv(connection, buffer, sizeof(buffer), 0);
+    if (received <= 0) {
+      return;
+    }
+    request.append(buffer, static_cast<std::size_t>(received));
+  }
+
+  std::string status = "200 OK";
+  std::string body;
+  if (request.compare(0, 4, "GET ") != 0) {
+    status = "405 Method Not Allowed";
+  } else if (request.compare(4, 9, "/metrics ") != 0 &&
+             request.compare(4, 2, "/ ") != 0) {
+    status = "404 Not Found";
+  } else {
+    body = metrics.ToText();
+  }
+
+  const std::string response =
+    dlog::Format("HTTP/1.0 {}\r\n"
+                 "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                 "Content-Length: {}\r\n"
+                 "Connection: close\r\n"
+                 "\r\n",
+                 status,
+                 body.size()) +
+    body;
+  std::size_t sent = 0;
+  while (sent < response.size()) {
+    const ssize_t n = send(connection,
+                           response.data() + sent,
+                           response.size() - sent,
+                           MSG_NOSIGNAL);
+    if (n <= 0) {
+      return;
+    }
+    sent += static_cast<std::size_t>(n);
+  }
+}
+
+#endif
+
+}
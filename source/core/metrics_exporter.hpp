@@ -0,0 +1,67 @@
+#ifndef METRICS_EXPORTER_HPP_
+#define METRICS_EXPORTER_HPP_
+
+#include "core/metrics.hpp"
+#include <atomic>
+#include <thread>
+
+namespace dib {
+
+/**
+ * Serves Metrics over HTTP on localhost, for a Prometheus scraper or curl:
+ *   curl http://127.0.0.1:<port>/metrics
+ *
+ * A thread of its own accepts connections and answers each GET with the
+ * text of Metrics::ToText, so a scrape never stalls the caller of Start.
+ * Only bound to the loopback interface, anything further away should go
+ * through a local agent. Not supported on Windows.
+ */
+class MetricsExporter
+{
+public:
+  MetricsExporter() = default;
+
+  ~MetricsExporter();
+
+  MetricsExporter(const MetricsExporter& other) = delete;
+  MetricsExporter& operator=(const MetricsExporter& other) = delete;
+
+  /**
+   * Listen on 127.0.0.1:@port, 0 picks a free port, see GetPort. @metrics
+   * must outlive the exporter, or the call to Stop.
+   * @return False if the port could not be bound, or it is already running.
+   */
+  bool Start(const Metrics& metrics, const u16 port);
+
+  /**
+   * Stop serving and join the thread.
+   */
+  void Stop();
+
+  bool IsRunning() const { return thread_.joinable(); }
+
+  /**
+   * The port listened on, while running.
+   */
+  u16 GetPort() const { return port_; }
+
+private:
+  /**
+   * How long the thread waits for a connection before it checks if it should
+   * stop.
+   */
+  static constexpr int kPollTimeoutMs = 250;
+
+  void Serve(const Metrics& metrics);
+
+  void Respond(const Metrics& metrics, const int connection) const;
+
+  int socket_ = -1;
+  u16 port_ = 0;
+  std::atomic<bool> running_{ false };
+  std::thread thread_{};
+};
+
+}
+
+#endif // METRICS_EXPORTER_HPP_
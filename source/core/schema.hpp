@@ -0,0 +1,281 @@
+#ifndef SCHEMA_HPP_
+#define SCHEMA_HPP_
+
+#include "core/types.hpp"
+#include <alflib/memory/raw_memory_reader.hpp>
+#include <alflib/memory/raw_memory_writer.hpp>
+#include <cstring>
+#include <string>
+#include <tuple>
+#include <type_traits>
+
+namespace dib {
+
+/**
+ * Serialization of a type from the list of its fields, declared once.
+ *
+ * struct Example
+ * {
+ *   u32 id;
+ *   String name;
+ *
+ *   static constexpr auto GetSchema()
+ *   {
+ *     return MakeSchema(&Example::id, &Example::name);
+ *   }
+ * };
+ *
+ * Serializer<Example> then writes, reads and sizes the fields in the listed
+ * order. Fields must be listed in the order they are declared, at most once.
+ *
+ * The size of a type is known at compile time when all its fields are of
+ * fixed size. If those fields also cover the whole type, the wire layout is
+ * the memory layout and the type is copied with a single memcpy. Packed
+ * structs of plain values are written at memory bandwidth that way.
+ */
+template<typename TClass, typename... TFields>
+class Schema;
+
+/**
+ * How a type is written, read and sized. Types with a schema, types that are
+ * serialized as their bytes and String are handled here. Any other type must
+ * have SerializedSize(), ToBytes() and FromBytes().
+ */
+template<typename T, typename = void>
+struct Serializer
+{
+  static constexpr bool kIsFixedSize = false;
+  static constexpr std::size_t kFixedSize = 0;
+  static constexpr bool kIsBytes = false;
+
+  static std::size_t Size(const T& value) { return value.SerializedSize(); }
+
+  static bool Write(alflib::RawMemoryWriter& mw, const T& value)
+  {
+    return value.ToBytes(mw);
+  }
+
+  static T Read(alflib::RawMemoryReader& mr) { return T::FromBytes(mr); }
+};
+
+/**
+ * Specialize as true for trivially copyable types that are written as their
+ * bytes.
+ */
+template<typename T>
+struct IsSerializedAsBytes
+  : std::bool_constant<std::is_arithmetic_v<T> || std::is_enum_v<T>>
+{};
+
+template<>
+struct IsSerializedAsBytes<Vector2F> : std::true_type
+{};
+
+// ============================================================ //
+// Schema
+// ============================================================ //
+
+template<typename TClass, typename... TFields>
+class Schema
+{
+public:
+  /** If all fields are of fixed size. */
+  static constexpr bool kIsFixedSize =
+    (Serializer<TFields>::kIsFixedSize && ...);
+
+  /** Size of the fields, if they are of fixed size. */
+  static constexpr std::size_t kFixedSize =
+    (Serializer<TFields>::kFixedSize + ... + 0);
+
+  /** If the type is written as its bytes. */
+  static constexpr bool kIsBytes = std::is_trivially_copyable_v<TClass> &&
+                                   kIsFixedSize &&
+                                   kFixedSize == sizeof(TClass);
+
+  constexpr explicit Schema(TFields TClass::*... members)
+    : members_(members...)
+  {}
+
+  /**
+   * Call @function with the pointer to each member, in order.
+   */
+  template<typename TFunction>
+  constexpr void ForEachMember(TFunction&& function) const
+  {
+    std::apply([&](const auto... members) { (function(members), ...); },
+               members_);
+  }
+
+private:
+  std::tuple<TFields TClass::*...> members_;
+};
+
+/**
+ * Make the schema of a type from pointers to its members.
+ */
+template<typename TClass, typename... TFields>
+constexpr Schema<TClass, TFields...>
+MakeSchema(TFields TClass::*... members)
+{
+  return Schema<TClass, TFields...>{ members... };
+}
+
+// ============================================================ //
+// Serializers
+// ============================================================ //
+
+template<typename T>
+struct Serializer<T, std::enable_if_t<IsSerializedAsBytes<T>::value>>
+{
+  static_assert(std::is_trivially_copyable_v<T>,
+                "only trivially copyable types are serialized as bytes");
+
+  static constexpr bool kIsFixedSize = true;
+  static constexpr std::size_t kFixedSize = sizeof(T);
+  static constexpr bool kIsBytes = true;
+
+  static std::size_t Size(const T&) { return sizeof(T); }
+
+  static bool Write(alflib::RawMemoryWriter& mw, const T& value)
+  {
+    return mw.WriteBytes(reinterpret_cast<const u8*>(&value), sizeof(T));
+  }
+
+  static T Read(alflib::RawMemoryReader& mr)
+  {
+    T value;
+    std::memcpy(&value, mr.ReadBytes(sizeof(T)), sizeof(T));
+    return value;
+  }
+};
+
+/**
+ * A u32 byte count followed by the UTF-8 bytes.
+ */
+template<>
+struct Serializer<String>
+{
+  static constexpr bool kIsFixedSize = false;
+  static constexpr std::size_t kFixedSize = 0;
+  static constexpr bool kIsBytes = false;
+
+  static std::size_t Size(const String& value)
+  {
+    return sizeof(u32) + value.GetSize();
+  }
+
+  static bool Write(alflib::RawMemoryWriter& mw, const String& value)
+  {
+    const u32 size = static_cast<u32>(value.GetSize());
+    return Serializer<u32>::Write(mw, size) &&
+           mw.WriteBytes(reinterpret_cast<const u8*>(value.GetUTF8()), size);
+  }
+
+  static String Read(alflib::RawMemoryReader& mr)
+  {
+    const u32 size = Serializer<u32>::Read(mr);
+    const u8* bytes = mr.ReadBytes(size);
+    return String{
+      std::string(reinterpret_cast<const char8*>(bytes), size).c_str()
+    };
+  }
+};
+
+template<typename T>
+struct Serializer<T, std::void_t<decltype(T::GetSchema())>>
+{
+  using SchemaType = decltype(T::GetSchema());
+
+  static constexpr bool kIsFixedSize = SchemaType::kIsFixedSize;
+  static constexpr std::size_t kFixedSize = SchemaType::kFixedSize;
+  static constexpr bool kIsBytes = SchemaType::kIsBytes;
+
+  static std::size_t Size(const T& value)
+  {
+    if constexpr (kIsFixedSize) {
+      return kFixedSize;
+    } else {
+      std::size_t size = 0;
+      T::GetSchema().ForEachMember([&](const auto member) {
+        using Field = std::decay_t<decltype(value.*member)>;
+        if constexpr (Serializer<Field>::kIsFixedSize) {
+          size += Serializer<Field>::kFixedSize;
+        } else {
+          size += Serializer<Field>::Size(value.*member);
+        }
+      });
+      return size;
+    }
+  }
+
+  static bool Write(alflib::RawMemoryWriter& mw, const T& value)
+  {
+    if constexpr (kIsBytes) {
+      return mw.WriteBytes(reinterpret_cast<const u8*>(&value), sizeof(T));
+    } else {
+      bool ok = true;
+      T::GetSchema().ForEachMember([&](const auto member) {
+        ok = ok && WriteField(mw, value, member);
+      });
+      return ok;
+    }
+  }
+
+  static T Read(alflib::RawMemoryReader& mr)
+  {
+    T value{};
+    if constexpr (kIsBytes) {
+      std::memcpy(&value, mr.ReadBytes(sizeof(T)), sizeof(T));
+    } else {
+      T::GetSchema().ForEachMember(
+        [&](const auto member) { ReadField(mr, value, member); });
+    }
+    return value;
+  }
+
+private:
+  // Fields of packed types may be unaligned, so fields that are bytes are
+  // copied through their address instead of bound to a reference.
+
+  template<typename TField>
+  static bool WriteField(alflib::RawMemoryWriter& mw,
+                         const T& value,
+                         TField T::*member)
+  {
+    if constexpr (Serializer<TField>::kIsBytes) {
+      return mw.WriteBytes(reinterpret_cast<const u8*>(&(value.*member)),
+                           sizeof(TField));
+    } else {
+      return Serializer<TField>::Write(mw, value.*member);
+    }
+  }
+
+  template<typename TField>
+  static void ReadField(alflib::RawMemoryReader& mr,
+                        T& value,
+                        TField T::*member)
+  {
+    if constexpr (Serializer<TField>::kIsBytes) {
+      std::memcpy(
+        &(value.*member), mr.ReadBytes(sizeof(TField)), sizeof(TField));
+    } else {
+      value.*member = Serializer<TField>::Read(mr);
+    }
+  }
+};
+
+// ============================================================ //
+
+/**
+ * Exact number of bytes that @values are serialized into.
+ */
+template<typename... TValues>
+std::size_t
+SerializedSize(const TValues&... values)
+{
+  return (Serializer<TValues>::Size(values) + ... + 0);
+}
+
+}
+
+#endif // SCHEMA_HPP_
@@ -2,6 +2,7 @@
 #define UUID_HPP_
 
 #include "core/types.hpp"
+#include "core/schema.hpp"
 #include <alflib/memory/raw_memory_writer.hpp>
 #include <alflib/memory/raw_memory_reader.hpp>
 #include <uuid.h>
@@ -40,6 +41,11 @@ struct Uuid
     return uuid;
   }
 };
+
+template<>
+struct IsSerializedAsBytes<Uuid> : std::true_type
+{};
+
 }
 
 #endif // UUID_HPP_
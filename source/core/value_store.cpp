@@ -1,4 +1,5 @@
 #include "value_store.hpp"
+#include "core/schema.hpp"
 
 namespace dib {
 
@@ -37,31 +38,36 @@ ValueStore::Load(const String& key) const
   }
 }
 
+std::size_t
+ValueStore::SerializedSize() const
+{
+  std::size_t size = sizeof(u32);
+  for (const auto& item : map_) {
+    size += Serializer<String>::Size(item.first) + sizeof(u8);
+    size += std::visit(
+      [](const auto& value) {
+        return Serializer<std::decay_t<decltype(value)>>::Size(value);
+      },
+      item.second);
+  }
+  return size;
+}
+
 bool
 ValueStore::ToBytes(alflib::RawMemoryWriter& mw) const
 {
   const u32 size = map_.size();
-  mw.Write(size);
-
-  bool ok = true;
-  for (auto item : map_) {
-    mw.Write(item.first);
-    const u8 tag = VariantToTag(item.second);
-    mw.Write(tag);
-    switch (static_cast<VariantTag>(tag)) {
-      case VariantTag::kU64:
-        ok = mw.Write(std::get<static_cast<u8>(VariantTag::kU64)>(item.second));
-        break;
-
-      case VariantTag::kF64:
-        ok = mw.Write(std::get<static_cast<u8>(VariantTag::kF64)>(item.second));
-        break;
+  bool ok = Serializer<u32>::Write(mw, size);
 
-      case VariantTag::kString:
-        ok =
-          mw.Write(std::get<static_cast<u8>(VariantTag::kString)>(item.second));
-        break;
-    }
+  for (const auto& item : map_) {
+    ok = ok && Serializer<String>::Write(mw, item.first) &&
+         Serializer<u8>::Write(mw, VariantToTag(item.second)) &&
+         std::visit(
+           [&mw](const auto& value) {
+             return Serializer<std::decay_t<decltype(value)>>::Write(mw,
+                                                                     value);
+           },
+           item.second);
   }
   return ok;
 }
@@ -70,24 +76,24 @@ ValueStore
 ValueStore::FromBytes(alflib::RawMemoryReader& mr)
 {
   ValueStore vstore{};
-  u32 size = mr.Read<u32>();
+  u32 size = Serializer<u32>::Read(mr);
 
   bool ok = true;
   while (size-- > 0) {
-    auto key = mr.Read<String>();
-    const auto tag = static_cast<VariantTag>(mr.Read<u8>());
+    auto key = Serializer<String>::Read(mr);
+    const auto tag = static_cast<VariantTag>(Serializer<u8>::Read(mr));
 
     switch (tag) {
       case VariantTag::kU64:
-        ok = vstore.Store(std::move(key), mr.Read<u64>());
+        ok = vstore.Store(std::move(key), Serializer<u64>::Read(mr));
         break;
 
       case VariantTag::kF64:
-        ok = vstore.Store(std::move(key), mr.Read<f64>());
+        ok = vstore.Store(std::move(key), Serializer<f64>::Read(mr));
         break;
 
       case VariantTag::kString:
-        ok = vstore.Store(std::move(key), mr.Read<String>());
+        ok = vstore.Store(std::move(key), Serializer<String>::Read(mr));
     }
     if (!ok) {
       break;
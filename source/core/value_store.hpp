@@ -17,8 +17,7 @@ public:
    * How to add a variant type:
    * 1. Add it here and add it to the VariantTag.
    * 2. Make a operator() overload for it in the TagVisitor.
-   * 3. Add a case in the ToBytes method.
-   * 4. Add a case in the FromBytes method.
+   * 3. Add a case in the FromBytes method.
    */
   using Variant = std::variant<u64, f64, String>;
 
@@ -49,6 +48,12 @@ public:
   std::optional<std::tuple<Variant, VariantTag>> Load(const String& key) const;
 
   // Serialize //
+
+  /**
+   * Exact number of bytes that ToBytes writes.
+   */
+  std::size_t SerializedSize() const;
+
   bool ToBytes(alflib::RawMemoryWriter& mw) const;
   static ValueStore FromBytes(alflib::RawMemoryReader& mr);
 
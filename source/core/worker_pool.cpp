@@ -0,0 +1,116 @@
+#include "worker_pool.hpp"
+#include <algorithm>
+#include <atomic>
+
+namespace dib {
+
+WorkerPool::WorkerPool(const u32 thread_count)
+{
+  threads_.reserve(thread_count);
+  for (u32 i = 0; i < thread_count; i++) {
+    threads_.emplace_back([this, i]() { Work(i); });
+  }
+}
+
+WorkerPool::~WorkerPool()
+{
+  Wait();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  wake_.notify_all();
+  for (std::thread& thread : threads_) {
+    thread.join();
+  }
+}
+
+void
+WorkerPool::Submit(Task task)
+{
+  if (threads_.empty()) {
+    task(0);
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tasks_.push_back(std::move(task));
+    unfinished_++;
+  }
+  wake_.notify_one();
+}
+
+void
+WorkerPool::Wait()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_.wait(lock, [this]() { return unfinished_ == 0; });
+}
+
+void
+WorkerPool::ParallelFor(const u32 count,
+                        const std::function<void(u32, u32)>& work)
+{
+  const u32 helpers = std::min(GetThreadCount(), count > 0 ? count - 1 : 0);
+  if (helpers == 0) {
+    for (u32 i = 0; i < count; i++) {
+      work(i, GetThreadCount());
+    }
+    return;
+  }
+
+  // Indices are independent, each thread takes the next one until all have
+  // been taken. Only the helpers of this call are waited for, tasks that
+  // were submitted earlier keep running
+  std::atomic<u32> next{ 0 };
+  u32 running = helpers;
+  std::condition_variable finished;
+  const auto run = [&next, &work, count](const u32 thread) {
+    for (u32 i = next++; i < count; i = next++) {
+      work(i, thread);
+    }
+  };
+  for (u32 i = 0; i < helpers; i++) {
+    Submit([this, &run, &running, &finished](const u32 thread) {
+      run(thread);
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (--running == 0) {
+        finished.notify_one();
+      }
+    });
+  }
+  run(GetThreadCount());
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  finished.wait(lock, [&running]() { return running == 0; });
+}
+
+u32
+WorkerPool::DefaultThreadCount()
+{
+  const u32 hardware = std::thread::hardware_concurrency();
+  return hardware > 1 ? hardware - 1 : 0;
+}
+
+void
+WorkerPool::Work(const u32 thread)
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    wake_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+    if (tasks_.empty()) {
+      return;
+    }
+    Task task = std::move(tasks_.front());
+    tasks_.pop_front();
+    lock.unlock();
+    task(thread);
+    task = nullptr;
+    lock.lock();
+    if (--unfinished_ == 0) {
+      done_.notify_all();
+    }
+  }
+}
+
+}
@@ -0,0 +1,85 @@
+#ifndef WORKER_POOL_HPP_
+#define WORKER_POOL_HPP_
+
+#include "core/types.hpp"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dib {
+
+/**
+ * Fixed set of worker threads that live as long as the pool, so that work
+ * handed to them each tick does not pay for creating and joining threads.
+ *
+ * Every thread has an index in [0, GetThreadCount()), which tasks receive
+ * so that they can pick per-thread scratch memory. The thread that calls
+ * ParallelFor also takes part in the work, with the index GetThreadCount().
+ */
+class WorkerPool
+{
+public:
+  /**
+   * Function run by a worker, with the index of the thread running it.
+   */
+  using Task = std::function<void(u32 thread)>;
+
+  /**
+   * @param thread_count Number of worker threads, may be 0, in which case
+   * ParallelFor runs on the caller and Submit runs the task immediately.
+   */
+  explicit WorkerPool(u32 thread_count);
+
+  /**
+   * Finish every submitted task and join the threads.
+   */
+  ~WorkerPool();
+
+  WorkerPool(const WorkerPool& other) = delete;
+  WorkerPool& operator=(const WorkerPool& other) = delete;
+
+  /**
+   * Queue a task to run on one of the workers, returns immediately.
+   */
+  void Submit(Task task);
+
+  /**
+   * Block until every submitted task has finished.
+   */
+  void Wait();
+
+  /**
+   * Call @work(index, thread) for each index in [0, @count) and return when
+   * all calls have finished. The caller takes indices as well, so a count
+   * of 1 never wakes a worker.
+   */
+  void ParallelFor(u32 count, const std::function<void(u32, u32)>& work);
+
+  u32 GetThreadCount() const { return static_cast<u32>(threads_.size()); }
+
+  /**
+   * One less than the number of hardware threads, to leave room for the
+   * thread that owns the pool.
+   */
+  static u32 DefaultThreadCount();
+
+private:
+  void Work(u32 thread);
+
+  std::vector<std::thread> threads_{};
+
+  std::mutex mutex_{};
+  std::condition_variable wake_{};
+  std::condition_variable done_{};
+  std::deque<Task> tasks_{};
+  /** Tasks that are queued or running. */
+  u32 unfinished_{ 0 };
+  bool stopping_{ false };
+};
+
+}
+
+#endif // WORKER_POOL_HPP_
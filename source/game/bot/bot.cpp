@@ -0,0 +1,166 @@
+#include "game/bot/bot.hpp"
+
+// ========================================================================== //
+// Headers
+// ========================================================================== //
+
+#include "game/gameplay/moveable.hpp"
+#include "game/chat/chat_message.hpp"
+
+// ========================================================================== //
+// Bot Implementation
+// ========================================================================== //
+
+namespace dib::game {
+
+Bot::Bot(u32 id,
+         const String& address,
+         const BotScript& script,
+         const alflib::Buffer& world)
+  : mId(id)
+  , mAddress(address)
+  , mScript(script)
+  , mWorld(std::make_unique<World>())
+  , mRandom(id)
+{
+  // Movement is simulated on the client, so bots need the terrain to stand on
+  alflib::MemoryReader reader(world);
+  if (!mWorld->Load(reader)) {
+    DLOG_ERROR("bot {} failed to load the world", mId);
+  }
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+Bot::Update(f64 delta)
+{
+  mWorld->Update(delta);
+
+  // Wait before joining, either the first time or after leaving
+  if (!mJoined) {
+    mOfflineTimer -= delta;
+    if (mOfflineTimer <= 0.0) {
+      Join();
+    }
+    return;
+  }
+
+  if (!IsOnline()) {
+    // Try again if the server does not let us in, or has dropped us
+    mConnectTimer -= delta;
+    if (mConnectTimer <= 0.0) {
+      Leave();
+    }
+    return;
+  }
+  mConnectTimer = CONNECT_TIMEOUT;
+
+  Act(delta);
+
+  // Send what the bot did this update, instead of waiting for the next one
+  mWorld->GetNetwork().Flush();
+}
+
+// -------------------------------------------------------------------------- //
+
+bool
+Bot::IsOnline() const
+{
+  return mJoined && mWorld->GetNetwork().GetOurPlayerEntity().has_value();
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+Bot::Join()
+{
+  mWorld->GetNetwork().ConnectToServer(mAddress);
+  mJoined = true;
+  mConnectTimer = CONNECT_TIMEOUT;
+  mInputTimer = 0.0;
+  mChatTimer = RandomInterval(mScript.chatInterval);
+  mSessionTimer = RandomInterval(mScript.sessionLength);
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+Bot::Leave()
+{
+  mWorld->GetNetwork().Disconnect();
+  mJoined = false;
+  mOfflineTimer = RandomInterval(mScript.rejoinDelay);
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+Bot::Act(f64 delta)
+{
+  auto& network = mWorld->GetNetwork();
+  auto& registry = mWorld->GetEntityManager().GetRegistry();
+  Moveable& moveable = registry.get<Moveable>(*network.GetOurPlayerEntity());
+
+  // Walk in a random direction, and sometimes jump
+  mInputTimer -= delta;
+  if (mInputTimer <= 0.0) {
+    mInputTimer = RandomInterval(mScript.inputInterval);
+    mInput = PlayerInput{};
+    const u32 action = std::uniform_int_distribution<u32>(0, 2)(mRandom);
+    if (action == 0) {
+      mInput.ActionLeft();
+    } else if (action == 1) {
+      mInput.ActionRight();
+    }
+    if (std::bernoulli_distribution(0.25)(mRandom)) {
+      mInput.ActionJump();
+    }
+  }
+  moveable.input = mInput;
+
+  // Send the state like a real client does
+  mIncrementTimer += delta;
+  if (mIncrementTimer >= 1.0 / INCREMENTS_PER_SECOND) {
+    mIncrementTimer = 0.0;
+    Player::SendIncrement(*mWorld, moveable);
+  }
+
+  // Chat
+  if (mScript.chatInterval > 0.0) {
+    mChatTimer -= delta;
+    if (mChatTimer <= 0.0) {
+      mChatTimer = RandomInterval(mScript.chatInterval);
+      ChatMessage msg{};
+      msg.type = ChatType::kSay;
+      msg.uuid_from = (*network.GetOurPlayerData())->uuid;
+      const std::string text =
+        dlog::Format("bot {} says hello #{}", mId, mChatCount++);
+      msg.msg = String(text.c_str());
+      if (!mWorld->GetChat().SendMessage(msg)) {
+        DLOG_WARNING("bot {} failed to send a chat message", mId);
+      }
+    }
+  }
+
+  // Leave when the session is over
+  if (mScript.sessionLength > 0.0) {
+    mSessionTimer -= delta;
+    if (mSessionTimer <= 0.0) {
+      Leave();
+    }
+  }
+}
+
+// -------------------------------------------------------------------------- //
+
+f64
+Bot::RandomInterval(f64 mean)
+{
+  if (mean <= 0.0) {
+    return 0.0;
+  }
+  return std::exponential_distribution<f64>(1.0 / mean)(mRandom);
+}
+
+}
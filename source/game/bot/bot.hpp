@@ -0,0 +1,117 @@
+#pragma once
+
+// ========================================================================== //
+// Headers
+// ========================================================================== //
+
+#include "game/world.hpp"
+#include "game/gameplay/player.hpp"
+#include <memory>
+#include <random>
+
+// ========================================================================== //
+// BotScript Declaration
+// ========================================================================== //
+
+namespace dib::game {
+
+/** What a bot does while it is online. Intervals are means of exponential
+ * distributions, so that bots don't act in lockstep **/
+struct BotScript
+{
+  /** Seconds between changes of the input **/
+  f64 inputInterval = 0.5;
+
+  /** Seconds between chat messages, 0 to never chat **/
+  f64 chatInterval = 20.0;
+
+  /** Seconds online before leaving, 0 to never leave **/
+  f64 sessionLength = 0.0;
+
+  /** Seconds offline before joining again **/
+  f64 rejoinDelay = 3.0;
+};
+
+// ========================================================================== //
+// Bot Declaration
+// ========================================================================== //
+
+/** Headless client that plays by a script instead of by input from a person.
+ * Each bot has a world of its own, like a real client **/
+class Bot
+{
+public:
+  /** Seconds to wait for the server to accept us before trying again **/
+  static constexpr f64 CONNECT_TIMEOUT = 10.0;
+
+  /** Moveable increments sent per second, same as a real client **/
+  static constexpr f64 INCREMENTS_PER_SECOND = 60.0;
+
+private:
+  /** Id of the bot, only used for its chat messages **/
+  u32 mId;
+
+  /** Address of the server **/
+  String mAddress;
+
+  /** Script to follow **/
+  BotScript mScript;
+
+  /** World of the bot, on the heap since the network points at it **/
+  std::unique_ptr<World> mWorld;
+
+  /** Random number generator for the script **/
+  std::mt19937 mRandom;
+
+  /** Whether a connection has been requested **/
+  bool mJoined = false;
+
+  /** Time left until an action **/
+  f64 mConnectTimer = 0.0;
+  f64 mOfflineTimer = 0.0;
+  f64 mInputTimer = 0.0;
+  f64 mChatTimer = 0.0;
+  f64 mSessionTimer = 0.0;
+
+  /** Time since the last increment was sent **/
+  f64 mIncrementTimer = 0.0;
+
+  /** Current input **/
+  PlayerInput mInput;
+
+  /** Number of chat messages sent **/
+  u32 mChatCount = 0;
+
+public:
+  /** Construct a bot that joins the server at the given address on its first
+   * update. The world of the bot is loaded from the serialized world, which
+   * the swarm generates once for all bots **/
+  Bot(u32 id,
+      const String& address,
+      const BotScript& script,
+      const alflib::Buffer& world);
+
+  /** Update the world of the bot and act on the script **/
+  void Update(f64 delta);
+
+  /** Returns whether the bot has joined the server and got a player **/
+  bool IsOnline() const;
+
+  /** Returns the world of the bot **/
+  World& GetWorld() { return *mWorld; }
+
+private:
+  /** Connect to the server **/
+  void Join();
+
+  /** Disconnect from the server **/
+  void Leave();
+
+  /** Act on the script while online **/
+  void Act(f64 delta);
+
+  /** Returns a random interval with the given mean **/
+  f64 RandomInterval(f64 mean);
+};
+
+}
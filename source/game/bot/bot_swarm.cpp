@@ -0,0 +1,237 @@
+#include "game/bot/bot_swarm.hpp"
+
+// ========================================================================== //
+// Headers
+// ========================================================================== //
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <dutil/stopwatch.hpp>
+#include <tsl/robin_map.h>
+#include "game/gameplay/core_content.hpp"
+
+// ========================================================================== //
+// BotSwarm Implementation
+// ========================================================================== //
+
+namespace dib::game {
+
+BotSwarm::Descriptor
+BotSwarm::Descriptor::FromArgs(int argc, char** argv)
+{
+  Descriptor descriptor;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    const char8* option = argv[i];
+    const char8* value = argv[i + 1];
+    if (std::strcmp(option, "--bots") == 0) {
+      descriptor.botCount = u32(std::strtoul(value, nullptr, 10));
+    } else if (std::strcmp(option, "--connect") == 0) {
+      descriptor.address = value;
+    } else if (std::strcmp(option, "--spawn-rate") == 0) {
+      descriptor.spawnRate = std::strtod(value, nullptr);
+    } else if (std::strcmp(option, "--ups") == 0) {
+      descriptor.targetUps = u32(std::strtoul(value, nullptr, 10));
+    } else if (std::strcmp(option, "--report") == 0) {
+      descriptor.reportInterval = std::strtod(value, nullptr);
+    } else if (std::strcmp(option, "--duration") == 0) {
+      descriptor.duration = std::strtod(value, nullptr);
+    } else if (std::strcmp(option, "--input") == 0) {
+      descriptor.script.inputInterval = std::strtod(value, nullptr);
+    } else if (std::strcmp(option, "--chat") == 0) {
+      descriptor.script.chatInterval = std::strtod(value, nullptr);
+    } else if (std::strcmp(option, "--session") == 0) {
+      descriptor.script.sessionLength = std::strtod(value, nullptr);
+    } else if (std::strcmp(option, "--rejoin") == 0) {
+      descriptor.script.rejoinDelay = std::strtod(value, nullptr);
+    } else {
+      DLOG_WARNING("Unknown option {}", option);
+      PrintUsage();
+    }
+  }
+  descriptor.targetUps = std::max(1u, descriptor.targetUps);
+  return descriptor;
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+BotSwarm::Descriptor::PrintUsage()
+{
+  DLOG_RAW("Options:\n"
+           "  --bots N          number of bots\n"
+           "  --connect ADDR    server address, ip:port\n"
+           "  --spawn-rate R    bots created per second\n"
+           "  --ups N           updates per second\n"
+           "  --report S        seconds between reports\n"
+           "  --duration S      seconds to run, 0 runs until killed\n"
+           "  --input S         mean seconds between input changes\n"
+           "  --chat S          mean seconds between chat messages, 0 never\n"
+           "  --session S       mean seconds online, 0 never leaves\n"
+           "  --rejoin S        mean seconds offline before joining again\n");
+}
+
+// -------------------------------------------------------------------------- //
+
+BotSwarm::BotSwarm(const Descriptor& descriptor)
+  : mDescriptor(descriptor)
+{
+  CoreContent::Setup();
+  mBots.reserve(mDescriptor.botCount);
+
+  // Generate the terrain before running, each bot loads a copy of it
+  World world;
+  CoreContent::GenerateWorld(world);
+  alflib::MemoryWriter writer(mWorldData);
+  writer.Write(world);
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+BotSwarm::Run()
+{
+  dutil::Stopwatch sw;
+  sw.Start();
+
+  const f64 targetDelta = 1.0 / mDescriptor.targetUps;
+  f64 timeLast = sw.fnow_s();
+  mRunning = true;
+  while (mRunning) {
+    const f64 timeCurrent = sw.fnow_s();
+    const f64 timeDelta = timeCurrent - timeLast;
+    timeLast = timeCurrent;
+
+    Update(timeDelta);
+
+    // Sleep for what is left of the update
+    const f64 timeSpent = sw.fnow_s() - timeCurrent;
+    if (timeSpent < targetDelta) {
+      std::this_thread::sleep_for(
+        std::chrono::duration<f64>(targetDelta - timeSpent));
+    }
+  }
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+BotSwarm::Exit()
+{
+  mRunning = false;
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+BotSwarm::Update(f64 delta)
+{
+  // Ramp up
+  if (mBots.size() < mDescriptor.botCount) {
+    mSpawnAccumulator += delta * mDescriptor.spawnRate;
+    while (mSpawnAccumulator >= 1.0 && mBots.size() < mDescriptor.botCount) {
+      mSpawnAccumulator -= 1.0;
+      const u32 id = u32(mBots.size());
+      mBots.push_back(std::make_unique<Bot>(
+        id, mDescriptor.address, mDescriptor.script, mWorldData));
+
+      // The report includes what the handlers of each packet type cost
+      mBots.back()->GetWorld().GetNetwork().GetPacketHandler().SetTiming(true);
+    }
+  }
+
+  dutil::Stopwatch sw;
+  sw.Start();
+  for (auto& bot : mBots) {
+    bot->Update(delta);
+  }
+  sw.Stop();
+  mTickStats.RecordTick(sw.fs());
+
+  mElapsed += delta;
+  mReportTimer += delta;
+  if (mReportTimer >= mDescriptor.reportInterval) {
+    mReportTimer = 0.0;
+    Report();
+  }
+
+  if (mDescriptor.duration > 0.0 && mElapsed >= mDescriptor.duration) {
+    Report();
+    Exit();
+  }
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+BotSwarm::Report()
+{
+  struct HandlerCost
+  {
+    u64 count = 0;
+    u64 bytes = 0;
+    u64 nanoseconds = 0;
+  };
+
+  u32 online = 0;
+  f64 totalOut = 0.0;
+  f64 totalIn = 0.0;
+  s64 totalPing = 0;
+  s64 maxPing = 0;
+  tsl::robin_map<std::string, HandlerCost> costs;
+  for (auto& bot : mBots) {
+    auto& network = bot->GetWorld().GetNetwork();
+    if (bot->IsOnline()) {
+      online++;
+      if (const auto status = network.GetConnectionStatus(); status) {
+        totalOut += status->m_flOutBytesPerSec;
+        totalIn += status->m_flInBytesPerSec;
+        totalPing += status->m_nPing;
+        maxPing = std::max(maxPing, s64(status->m_nPing));
+      }
+    }
+
+    // Sum the handler costs of all bots by the name of the packet type
+    auto& packetHandler = network.GetPacketHandler();
+    for (auto& [type, meta] : packetHandler) {
+      if (meta.handled_count > 0) {
+        HandlerCost& cost = costs[meta.name.GetUTF8()];
+        cost.count += meta.handled_count;
+        cost.bytes += meta.handled_bytes;
+        cost.nanoseconds += meta.handled_nanoseconds;
+      }
+    }
+    packetHandler.ResetStats();
+  }
+  const f64 divisor = std::max(1u, online);
+
+  DLOG_RAW("\n*** Bots {}/{} online after {:.0f}s\n",
+           online,
+           mBots.size(),
+           mElapsed);
+  DLOG_RAW("update of all bots: {}\n", mTickStats.ToString());
+  DLOG_RAW("per bot: in {:.0f} B/s, out {:.0f} B/s, ping {:.0f}ms (max {}ms)\n",
+           totalIn / divisor,
+           totalOut / divisor,
+           totalPing / divisor,
+           maxPing);
+  DLOG_RAW("{:<20}{:>10}{:>12}{:>12}\n",
+           "PACKET TYPE",
+           "COUNT",
+           "BYTES",
+           "AVG US");
+  for (const auto& [name, cost] : costs) {
+    DLOG_RAW("{:<20}{:>10}{:>12}{:>12.2f}\n",
+             name,
+             cost.count,
+             cost.bytes,
+             cost.nanoseconds / 1e3 / cost.count);
+  }
+  DLOG_RAW("(server tick times: run 'stats' on the server)\n");
+
+  mTickStats.Reset();
+}
+
+}
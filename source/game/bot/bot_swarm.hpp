@@ -0,0 +1,104 @@
+#pragma once
+
+// ========================================================================== //
+// Headers
+// ========================================================================== //
+
+#include "app/app.hpp"
+#include "game/bot/bot.hpp"
+#include "game/tick_stats.hpp"
+#include <memory>
+#include <vector>
+
+// ========================================================================== //
+// BotSwarm Declaration
+// ========================================================================== //
+
+namespace dib::game {
+
+/** Headless application that runs many bots against one server, to find out
+ * how many players the server handles. All bots are updated on the main
+ * thread, each with a world and a connection of its own.
+ *
+ * The report shows what the bots see, the bandwidth and ping of each bot and
+ * what the packet handlers of the bots cost. The tick times and handler costs
+ * of the server are printed by the 'stats' command on the server **/
+class BotSwarm : public app::App
+{
+public:
+  /** Bot swarm descriptor **/
+  struct Descriptor
+  {
+    /** Number of bots **/
+    u32 botCount = 100;
+
+    /** Address of the server **/
+    String address = "127.0.0.1:24812";
+
+    /** Bots created per second, to ramp up the load **/
+    f64 spawnRate = 10.0;
+
+    /** Target 'updates per second' **/
+    u32 targetUps = 60;
+
+    /** Seconds between reports **/
+    f64 reportInterval = 10.0;
+
+    /** Seconds to run, 0 to run until killed **/
+    f64 duration = 0.0;
+
+    /** Script of every bot **/
+    BotScript script;
+
+    /** Read the descriptor from the command line, see 'PrintUsage' **/
+    static Descriptor FromArgs(int argc, char** argv);
+
+    /** Print the command line options **/
+    static void PrintUsage();
+  };
+
+private:
+  /** Descriptor **/
+  Descriptor mDescriptor;
+
+  /** World that every bot starts from, generated once instead of by each
+   * bot while the swarm is running **/
+  alflib::Buffer mWorldData{ 10 };
+
+  /** Bots **/
+  std::vector<std::unique_ptr<Bot>> mBots;
+
+  /** Fraction of a bot to spawn, carried between updates **/
+  f64 mSpawnAccumulator = 0.0;
+
+  /** Seconds since the last report **/
+  f64 mReportTimer = 0.0;
+
+  /** Seconds since start **/
+  f64 mElapsed = 0.0;
+
+  /** Durations of recent updates of all bots **/
+  TickStats mTickStats;
+
+  /** Whether application is running **/
+  bool mRunning = false;
+
+public:
+  /** Construct bot swarm **/
+  explicit BotSwarm(const Descriptor& descriptor);
+
+  /** Run the swarm, at the target UPS **/
+  void Run() override;
+
+  /** Exit application **/
+  void Exit() override;
+
+  /** Spawn and update bots **/
+  void Update(f64 delta) override;
+
+private:
+  /** Print and reset the statistics **/
+  void Report();
+};
+
+}
@@ -23,9 +23,7 @@ Chat::SendMessage(ChatMessage msg) const
   Packet packet{};
   auto& packet_handler = network.GetPacketHandler();
   packet_handler.BuildPacketHeader(packet, PacketHeaderStaticTypes::kChat);
-  auto mw = packet.GetMemoryWriter();
-  mw->Write(msg);
-  mw.Finalize();
+  packet.WritePayload(msg);
   network.PacketBroadcast(packet);
 
   return true;
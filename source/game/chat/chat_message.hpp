@@ -2,6 +2,7 @@
 #define CHAT_MESSAGE_HPP_
 
 #include "core/types.hpp"
+#include "core/schema.hpp"
 #include "core/uuid.hpp"
 #include <alflib/memory/raw_memory_reader.hpp>
 #include <alflib/memory/raw_memory_writer.hpp>
@@ -30,6 +31,16 @@ struct ChatMessage
   String to;
 
   // Serialize //
+  static constexpr auto GetSchema()
+  {
+    return MakeSchema(&ChatMessage::type,
+                      &ChatMessage::uuid_from,
+                      &ChatMessage::uuid_to,
+                      &ChatMessage::msg,
+                      &ChatMessage::from,
+                      &ChatMessage::to);
+  }
+
   bool ToBytes(alflib::RawMemoryWriter& mw) const;
 
   static ChatMessage FromBytes(alflib::RawMemoryReader& mr);
@@ -257,6 +257,15 @@ ClientCache::BuildItemAtlas()
 
 // -------------------------------------------------------------------------- //
 
+void
+ClientCache::LoadEntityTextures()
+{
+  mPlayerTexture = std::make_shared<graphics::Texture>("Wizard");
+  mPlayerTexture->Load(Path{ "./res/entity/wizard.tga" });
+}
+
+// -------------------------------------------------------------------------- //
+
 const std::vector<ClientCache::AtlasRegion>&
 ClientCache::GetTileSubResources(TileRegistry::TileID id)
 {
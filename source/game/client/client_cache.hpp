@@ -64,6 +64,9 @@ private:
   /** Inverse Item atlas size **/
   Vector2F mInverseItemAtlasSize;
 
+  /** Player texture **/
+  std::shared_ptr<graphics::Texture> mPlayerTexture;
+
 public:
   /** Construct a client cache **/
   ClientCache() = default;
@@ -77,6 +80,11 @@ public:
   /** Build the item atlas **/
   void BuildItemAtlas();
 
+  /** Load the entity textures. Like the atlases this must be done on the
+   * thread that owns the OpenGL context, the textures are afterwards only
+   * handed out **/
+  void LoadEntityTextures();
+
   /** Returns the list of sub-resources for a tile ID **/
   const std::vector<AtlasRegion>& GetTileSubResources(TileRegistry::TileID id);
 
@@ -137,6 +145,13 @@ public:
     return mItemAtlasTexture;
   }
 
+  /** Return the player texture **/
+  [[nodiscard]] const std::shared_ptr<graphics::Texture>& GetPlayerTexture()
+    const
+  {
+    return mPlayerTexture;
+  }
+
 private:
   static String CreateAtlasKey(const String& type,
                                u32 resourceIndex,
@@ -458,6 +458,17 @@ ShowWorldDebug(GameClient& gameClient)
       Path path = Path{ "./res" }.Join(Path{ nameBuffer });
       gameClient.GetWorld().Load(path);
     }
+
+    ImGui::Text("Terrain memory: %.2f MiB",
+                gameClient.GetWorld().GetTerrain().GetMemoryUsage() /
+                  (1024.0 * 1024.0));
+    ImGui::Text("Cached render chunks: %u",
+                gameClient.GetWorldRenderer().GetCachedChunkCount());
+    const TileEntityManager& tileEntities =
+      gameClient.GetWorld().GetTileEntityManager();
+    ImGui::Text("Tile entities: %u (%u awake)",
+                tileEntities.GetEntityCount(),
+                tileEntities.GetActiveCount());
   }
 }
 
@@ -4,8 +4,11 @@
 // Headers
 // ========================================================================== //
 
+#include <vector>
+
 #include "game/physics/units.hpp"
 #include "game/client/render_component.hpp"
+#include "game/ecs/components/player_data_component.hpp"
 #include "game/gameplay/moveable.hpp"
 
 // ========================================================================== //
@@ -14,28 +17,65 @@
 
 namespace dib::game {
 
+void
+AssignRenderComponents(World& world, const ClientCache& cache)
+{
+  auto& registry = world.GetEntityManager().GetRegistry();
+  registry.view<PlayerData, Moveable>().each(
+    [&](Entity entity, const PlayerData&, const Moveable&) {
+      if (!registry.has<RenderComponent>(entity)) {
+        registry.assign<RenderComponent>(entity, cache.GetPlayerTexture());
+      }
+    });
+}
+
+// -------------------------------------------------------------------------- //
+
 void
 RenderEntities(graphics::Renderer& renderer,
                const graphics::Camera& camera,
-               EntityManager& entityManager)
+               World& world,
+               std::vector<Entity>& visible)
 {
   renderer.GetSpriteBatch().Begin(&camera);
 
-  // Retrieve views of entities
-  auto view = entityManager.GetRegistry().view<Moveable, RenderComponent>();
+  // Find entities that are visible to the camera. Sprites are not drawn
+  // exactly at the bounds of the moveable, therefore the camera bounds are
+  // padded with a margin
+  const Vector3F& cameraPos = camera.GetPosition();
+  const f32 margin = TileToMeter(4);
+  const Position min{ PixelToMeter(cameraPos.x) - margin,
+                      PixelToMeter(cameraPos.y) - margin };
+  const Position max{
+    PixelToMeter(cameraPos.x + camera.GetViewWidth()) + margin,
+    PixelToMeter(cameraPos.y + camera.GetViewHeight()) + margin
+  };
+  visible.clear();
+  world.GetSpatialGrid().QueryRect(min, max, visible);
 
-  // Render each entity
-  for (auto entity : view) {
-    Moveable& movableComponent = view.get<Moveable>(entity);
-    RenderComponent& renderComponent = view.get<RenderComponent>(entity);
+  // Render each visible entity
+  auto& registry = world.GetEntityManager().GetRegistry();
+  for (auto entity : visible) {
+    if (!registry.valid(entity) ||
+        !registry.has<Moveable, RenderComponent>(entity)) {
+      continue;
+    }
+    Moveable& movableComponent = registry.get<Moveable>(entity);
+    RenderComponent& renderComponent = registry.get<RenderComponent>(entity);
 
+    // The entity is the sprite id, which lets the render thread interpolate
+    // the sprite between frames
     renderer.GetSpriteBatch().Submit(
       renderComponent.texture,
       Vector3F{ MeterToPixel(movableComponent.position.x),
                 MeterToPixel(movableComponent.position.y),
                 0.5f },
       Vector2F{ MeterToPixel(movableComponent.width),
-                MeterToPixel(movableComponent.height) });
+                MeterToPixel(movableComponent.height) },
+      Color::WHITE,
+      Vector2F{ 0.0f, 0.0f },
+      Vector2F{ 1.0f, 1.0f },
+      static_cast<u32>(entity));
   }
 
   // Done
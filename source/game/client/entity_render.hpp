@@ -4,7 +4,10 @@
 // Headers
 // ========================================================================== //
 
-#include "game/ecs/entity_manager.hpp"
+#include <vector>
+
+#include "game/world.hpp"
+#include "game/client/client_cache.hpp"
 #include "graphics/renderer.hpp"
 
 // ========================================================================== //
@@ -13,10 +16,20 @@
 
 namespace dib::game {
 
-/** Render all entities **/
+/** Give a RenderComponent to each player that does not have one yet. Players
+ * are created by the network code, which must not create textures since the
+ * OpenGL context may belong to the render thread. They instead share the
+ * textures that the client cache loaded up front **/
+void
+AssignRenderComponents(World& world, const ClientCache& cache);
+
+/** Render all entities that are visible to the camera. The visible entities
+ * are collected in 'visible', which is kept by the caller so that its memory
+ * is reused between frames **/
 void
 RenderEntities(graphics::Renderer& renderer,
                const graphics::Camera& camera,
-               EntityManager& entityManager);
+               World& world,
+               std::vector<Entity>& visible);
 
 }
\ No newline at end of file
@@ -4,6 +4,9 @@
 // Headers
 // ========================================================================== //
 
+#include <algorithm>
+#include <cmath>
+
 #include "game/constants.hpp"
 #include <imgui/imgui.h>
 #include "game/client/world_renderer.hpp"
@@ -23,13 +26,16 @@ GameClient::GameClient(const app::AppClient::Descriptor& descriptor)
   : AppClient(descriptor)
   , mModLoader(Path{ "./mods" })
   , mCamera(GetWidth(), GetHeight())
-  , mWorldRenderer(mWorld, mClientCache)
+  , mLightMap(mWorld)
+  , mTerrainLod(mWorld)
+  , mWorldRenderer(mWorld, mClientCache, mLightMap, mTerrainLod)
 {
   CoreContent::Setup();
 
   mClientCache.BuildItemAtlas();
   mClientCache.BuildTileAtlas();
   mClientCache.BuildWallAtlas();
+  mClientCache.LoadEntityTextures();
 
   CoreContent::GenerateWorld(mWorld);
 }
@@ -72,6 +78,8 @@ GameClient::Update(f64 delta)
     UpdateCamera(delta);
     Player::Update(*this, delta);
     mWorld.Update(delta);
+    AssignRenderComponents(mWorld, mClientCache);
+    mLightMap.Update();
   }
 }
 
@@ -83,7 +91,7 @@ GameClient::Render()
   mRenderer.NewFrame();
 
   mWorldRenderer.Render(mRenderer, mCamera);
-  RenderEntities(mRenderer, mCamera, mWorld.GetEntityManager());
+  RenderEntities(mRenderer, mCamera, mWorld, mVisibleEntities);
 }
 
 // -------------------------------------------------------------------------- //
@@ -96,6 +104,22 @@ GameClient::OnWindowResize(u32 width, u32 height)
 
 // -------------------------------------------------------------------------- //
 
+void
+GameClient::OnMouseScroll([[maybe_unused]] f64 deltaX, f64 deltaY)
+{
+  // Zoom around the center of the screen
+  const f32 oldWidth = mCamera.GetViewWidth();
+  const f32 oldHeight = mCamera.GetViewHeight();
+  const f32 zoom = std::clamp(
+    mCamera.GetZoom() * std::pow(1.25f, f32(deltaY)), MIN_ZOOM, MAX_ZOOM);
+  mCamera.SetZoom(zoom);
+  mCamera.Move(Vector3F((oldWidth - mCamera.GetViewWidth()) / 2.0f,
+                        (oldHeight - mCamera.GetViewHeight()) / 2.0f,
+                        0.0f));
+}
+
+// -------------------------------------------------------------------------- //
+
 void
 GameClient::UpdateCamera(f32 delta)
 {
@@ -118,8 +142,12 @@ GameClient::UpdateCamera(f32 delta)
 
   Vector3F minPos = Vector3F(0.0f, 0.0f, 0.0f);
   Vector3F maxPos = Vector3F(
-    mWorld.GetTerrain().GetWidth() * game::TILE_SIZE - mCamera.GetWidth(),
-    mWorld.GetTerrain().GetHeight() * game::TILE_SIZE - mCamera.GetHeight(),
+    std::max(0.0f,
+             mWorld.GetTerrain().GetWidth() * game::TILE_SIZE -
+               mCamera.GetViewWidth()),
+    std::max(0.0f,
+             mWorld.GetTerrain().GetHeight() * game::TILE_SIZE -
+               mCamera.GetViewHeight()),
     1.0f);
   mCamera.ClampPosition(minPos, maxPos);
 }
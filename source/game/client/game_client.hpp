@@ -7,6 +7,8 @@
 #include "app/client/app_client.hpp"
 #include "game/world.hpp"
 #include "game/client/client_cache.hpp"
+#include "game/client/light_map.hpp"
+#include "game/client/terrain_lod.hpp"
 #include "game/client/world_renderer.hpp"
 #include "game/gameplay/player.hpp"
 #include "game/gameplay/core_content.hpp"
@@ -23,6 +25,12 @@ namespace dib::game {
 /** Game client **/
 class GameClient : public app::AppClient
 {
+public:
+  /** Minimum camera zoom **/
+  static constexpr f32 MIN_ZOOM = 1.0f / 64.0f;
+  /** Maximum camera zoom **/
+  static constexpr f32 MAX_ZOOM = 4.0f;
+
 private:
   /** Game world **/
   World mWorld;
@@ -38,8 +46,15 @@ private:
   /** Client resource cache **/
   ClientCache mClientCache;
 
+  /** Light map **/
+  LightMap mLightMap;
+  /** Terrain LOD pyramid **/
+  TerrainLod mTerrainLod;
+
   /** World renderer **/
   WorldRenderer mWorldRenderer;
+  /** Entities that were visible to the camera in the last frame **/
+  std::vector<Entity> mVisibleEntities;
 
   Player mPlayer{};
 
@@ -55,6 +70,8 @@ public:
 
   void OnWindowResize(u32 width, u32 height) override;
 
+  void OnMouseScroll(f64 deltaX, f64 deltaY) override;
+
   /** Returns the world **/
   World& GetWorld() { return mWorld; }
 
@@ -68,7 +85,7 @@ public:
   const ModLoader& GetModLoader() const { return mModLoader; }
 
   /** Returns the renderer **/
-  graphics::Renderer& GetRenderer() { return mRenderer; }
+  graphics::Renderer& GetRenderer() override { return mRenderer; }
 
   /** Returns the renderer **/
   const graphics::Renderer& GetRenderer() const { return mRenderer; }
@@ -85,6 +102,15 @@ public:
   /** Returns the client cache **/
   const ClientCache& GetCache() const { return mClientCache; }
 
+  /** Returns the light map **/
+  LightMap& GetLightMap() { return mLightMap; }
+
+  /** Returns the light map **/
+  const LightMap& GetLightMap() const { return mLightMap; }
+
+  /** Returns the terrain LOD pyramid **/
+  const TerrainLod& GetTerrainLod() const { return mTerrainLod; }
+
   /** Returns the world renderer **/
   WorldRenderer& GetWorldRenderer() { return mWorldRenderer; }
 
@@ -0,0 +1,300 @@
+#include "game/client/light_map.hpp"
+
+// ========================================================================== //
+// Headers
+// ========================================================================== //
+
+#include <algorithm>
+#include <cstring>
+
+#include <microprofile/microprofile.h>
+
+// ========================================================================== //
+// LightMap Implementation
+// ========================================================================== //
+
+namespace dib::game {
+
+LightMap::LightMap(World& world)
+  : mWorld(world)
+  , mWorkers(WorkerPool::DefaultThreadCount())
+  , mScratches(mWorkers.GetThreadCount() + 1)
+{
+  Terrain& terrain = mWorld.GetTerrain();
+  terrain.RegisterChangeListener(this);
+  OnResize(terrain.GetWidth(), terrain.GetHeight());
+}
+
+// -------------------------------------------------------------------------- //
+
+LightMap::~LightMap()
+{
+  mWorld.GetTerrain().UnregisterChangeListener(this);
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+LightMap::Update()
+{
+  if (mDirtyChunks.empty()) {
+    return;
+  }
+  MICROPROFILE_SCOPEI("LightMap", "Update", MP_YELLOW);
+
+  // Each chunk only writes to its own cells, therefore the chunks can be
+  // calculated in any order and on any thread
+  const u32 count = u32(mDirtyChunks.size());
+  if (count <= INLINE_CHUNK_COUNT) {
+    for (u32 chunkIndex : mDirtyChunks) {
+      CalculateChunk(chunkIndex, mScratches.back());
+    }
+  } else {
+    mWorkers.ParallelFor(count, [this](u32 i, u32 thread) {
+      CalculateChunk(mDirtyChunks[i], mScratches[thread]);
+    });
+  }
+
+  for (u32 chunkIndex : mDirtyChunks) {
+    mDirtyChunkFlags[chunkIndex] = false;
+  }
+  mDirtyChunks.clear();
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+LightMap::Invalidate()
+{
+  // Recalculate the sky height of each column
+  for (u32 x = 0; x < mWidth; x++) {
+    u32 skyHeight = mHeight;
+    while (skyHeight > 0 && IsTransparent(WorldPos{ x, skyHeight - 1 })) {
+      skyHeight--;
+    }
+    mSkyHeights[x] = skyHeight;
+  }
+
+  MarkRegionDirty(0, 0, s64(mWidth) - 1, s64(mHeight) - 1);
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+LightMap::OnResize(u32 width, u32 height)
+{
+  mWidth = width;
+  mHeight = height;
+  mLights.assign(mWidth * mHeight, Light{});
+
+  // Resized terrain is filled with air, which means that every cell can see
+  // the sky
+  mSkyHeights.assign(mWidth, 0);
+
+  mChunkCountX = (mWidth + CHUNK_SIZE - 1) / CHUNK_SIZE;
+  mChunkCountY = (mHeight + CHUNK_SIZE - 1) / CHUNK_SIZE;
+  mDirtyChunkFlags.assign(mChunkCountX * mChunkCountY, false);
+  mDirtyChunks.clear();
+  MarkRegionDirty(0, 0, s64(mWidth) - 1, s64(mHeight) - 1);
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+LightMap::OnTileChanged(WorldPos pos)
+{
+  // Update the sky height of the column. The sky height can only be lowered by
+  // removing the top-most non-transparent tile, in which case we search
+  // downwards for the next one
+  u32& skyHeight = mSkyHeights[pos.X()];
+  const u32 oldSkyHeight = skyHeight;
+  if (!IsTransparent(pos)) {
+    if (pos.Y() >= skyHeight) {
+      skyHeight = pos.Y() + 1;
+    }
+  } else if (pos.Y() + 1 == skyHeight) {
+    while (skyHeight > 0 && IsTransparent(WorldPos{ pos.X(), skyHeight - 1 })) {
+      skyHeight--;
+    }
+  }
+
+  // Light can only travel 'LIGHT_RADIUS' cells, so only the chunks that are
+  // closer than that to the changed cells must be recalculated
+  const s64 minY = std::min({ pos.Y(), oldSkyHeight, skyHeight });
+  const s64 maxY = std::max({ pos.Y(), oldSkyHeight, skyHeight });
+  MarkRegionDirty(s64(pos.X()) - LIGHT_RADIUS,
+                  minY - LIGHT_RADIUS,
+                  s64(pos.X()) + LIGHT_RADIUS,
+                  maxY + LIGHT_RADIUS);
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+LightMap::OnWallChanged([[maybe_unused]] WorldPos pos)
+{
+  // Walls does not affect the light
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+LightMap::OnRegionChanged(WorldPos min, WorldPos max)
+{
+  // Recalculate the sky height of each column in the region from scratch
+  for (u32 x = min.X(); x <= max.X(); x++) {
+    u32 skyHeight = mHeight;
+    while (skyHeight > 0 && IsTransparent(WorldPos{ x, skyHeight - 1 })) {
+      skyHeight--;
+    }
+    mSkyHeights[x] = skyHeight;
+  }
+
+  // The sky height may have changed outside the region vertically, so the
+  // whole height of the columns are marked as dirty
+  MarkRegionDirty(s64(min.X()) - LIGHT_RADIUS,
+                  0,
+                  s64(max.X()) + LIGHT_RADIUS,
+                  s64(mHeight) - 1);
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+LightMap::MarkRegionDirty(s64 minX, s64 minY, s64 maxX, s64 maxY)
+{
+  if (mWidth == 0 || mHeight == 0) {
+    return;
+  }
+
+  minX = std::clamp(minX, s64(0), s64(mWidth) - 1);
+  maxX = std::clamp(maxX, s64(0), s64(mWidth) - 1);
+  minY = std::clamp(minY, s64(0), s64(mHeight) - 1);
+  maxY = std::clamp(maxY, s64(0), s64(mHeight) - 1);
+
+  for (u32 chunkY = u32(minY) / CHUNK_SIZE; chunkY <= u32(maxY) / CHUNK_SIZE;
+       chunkY++) {
+    for (u32 chunkX = u32(minX) / CHUNK_SIZE;
+         chunkX <= u32(maxX) / CHUNK_SIZE;
+         chunkX++) {
+      const u32 chunkIndex = chunkY * mChunkCountX + chunkX;
+      if (!mDirtyChunkFlags[chunkIndex]) {
+        mDirtyChunkFlags[chunkIndex] = true;
+        mDirtyChunks.push_back(chunkIndex);
+      }
+    }
+  }
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+LightMap::CalculateChunk(u32 chunkIndex, Scratch& scratch)
+{
+  std::vector<Light>& lights = scratch.lights;
+  std::vector<u8>& falloffs = scratch.falloffs;
+  std::vector<u32>& queue = scratch.queue;
+
+  Terrain& terrain = mWorld.GetTerrain();
+
+  // Cells of the chunk
+  const u32 minX = (chunkIndex % mChunkCountX) * CHUNK_SIZE;
+  const u32 minY = (chunkIndex / mChunkCountX) * CHUNK_SIZE;
+  const u32 maxX = std::min(minX + CHUNK_SIZE, mWidth);
+  const u32 maxY = std::min(minY + CHUNK_SIZE, mHeight);
+
+  // Cells that can affect the chunk
+  const u32 regionMinX = minX > LIGHT_RADIUS ? minX - LIGHT_RADIUS : 0;
+  const u32 regionMinY = minY > LIGHT_RADIUS ? minY - LIGHT_RADIUS : 0;
+  const u32 regionMaxX = std::min(maxX + LIGHT_RADIUS, mWidth);
+  const u32 regionMaxY = std::min(maxY + LIGHT_RADIUS, mHeight);
+  const u32 width = regionMaxX - regionMinX;
+  const u32 height = regionMaxY - regionMinY;
+
+  lights.assign(width * height, Light{});
+  falloffs.resize(width * height);
+  queue.clear();
+
+  // Gather falloff and light sources
+  for (u32 y = regionMinY; y < regionMaxY; y++) {
+    for (u32 x = regionMinX; x < regionMaxX; x++) {
+      const WorldPos pos{ x, y };
+      const u32 index = (y - regionMinY) * width + (x - regionMinX);
+      Tile* tile = terrain.GetTile(pos);
+
+      const f32 opacity =
+        std::clamp(tile->GetOpacity(mWorld, pos), 0.0f, 1.0f);
+      falloffs[index] =
+        u8(LIGHT_FALLOFF + u32(opacity * f32(LIGHT_FALLOFF_OPAQUE)));
+
+      Light light{};
+      if (y >= mSkyHeights[x]) {
+        light = Light{ MAX_LIGHT, MAX_LIGHT, MAX_LIGHT };
+      }
+      if (tile->IsLightEmitter(mWorld, pos)) {
+        const f32 strength =
+          std::clamp(tile->GetLightStrength(mWorld, pos), 0.0f, 1.0f);
+        const Color color = tile->GetLightColor(mWorld, pos);
+        light.r = std::max(light.r, u8(color.GetRed() * strength));
+        light.g = std::max(light.g, u8(color.GetGreen() * strength));
+        light.b = std::max(light.b, u8(color.GetBlue() * strength));
+      }
+      if (light.r || light.g || light.b) {
+        lights[index] = light;
+        queue.push_back(index);
+      }
+    }
+  }
+
+  // Flood-fill. A cell is only queued again if its light increased, which
+  // means that the fill terminates once no more light can be spread
+  auto spread = [&](const Light& source, u32 index) {
+    const u8 falloff = falloffs[index];
+    const u8 r = source.r > falloff ? source.r - falloff : 0;
+    const u8 g = source.g > falloff ? source.g - falloff : 0;
+    const u8 b = source.b > falloff ? source.b - falloff : 0;
+    Light& light = lights[index];
+    if (r > light.r || g > light.g || b > light.b) {
+      light.r = std::max(light.r, r);
+      light.g = std::max(light.g, g);
+      light.b = std::max(light.b, b);
+      queue.push_back(index);
+    }
+  };
+  for (u32 head = 0; head < queue.size(); head++) {
+    const u32 index = queue[head];
+    const Light source = lights[index];
+    const u32 x = index % width;
+    const u32 y = index / width;
+    if (x > 0) {
+      spread(source, index - 1);
+    }
+    if (x + 1 < width) {
+      spread(source, index + 1);
+    }
+    if (y > 0) {
+      spread(source, index - width);
+    }
+    if (y + 1 < height) {
+      spread(source, index + width);
+    }
+  }
+
+  // Only the cells of the chunk itself are written back
+  for (u32 y = minY; y < maxY; y++) {
+    const Light* source =
+      &lights[(y - regionMinY) * width + (minX - regionMinX)];
+    std::memcpy(
+      &mLights[y * mWidth + minX], source, sizeof(Light) * (maxX - minX));
+  }
+}
+
+// -------------------------------------------------------------------------- //
+
+bool
+LightMap::IsTransparent(WorldPos pos)
+{
+  return mWorld.GetTerrain().GetTile(pos)->GetOpacity(mWorld, pos) <= 0.0f;
+}
+
+}
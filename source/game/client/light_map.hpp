@@ -0,0 +1,155 @@
+#pragma once
+
+// ========================================================================== //
+// Headers
+// ========================================================================== //
+
+#include <vector>
+
+#include "core/types.hpp"
+#include "core/macros.hpp"
+#include "core/worker_pool.hpp"
+#include "game/world.hpp"
+#include "game/terrain.hpp"
+
+// ========================================================================== //
+// LightMap Declaration
+// ========================================================================== //
+
+namespace dib::game {
+
+/** Class that calculates the light of each cell in the terrain.
+ *
+ * Light is spread from light sources with a flood-fill where each step into a
+ * cell reduces the light by an amount determined by the opacity of the tile in
+ * that cell. Light sources are tiles that are light emitters and all cells that
+ * can see the sky (above the top-most non-transparent tile in each column).
+ *
+ * The terrain is divided into chunks. Since light can never travel further than
+ * 'LIGHT_RADIUS' cells the light of a chunk can be calculated exactly from the
+ * cells in the chunk together with a border of 'LIGHT_RADIUS' cells around it.
+ * This means that chunks can be calculated independently, which lets the work
+ * be split across threads, and that a change to the terrain only requires the
+ * chunks within 'LIGHT_RADIUS' of the change to be recalculated.
+ *
+ * Changes are only recorded when the terrain notifies the light map. The actual
+ * recalculation happens in 'LightMap::Update'.
+ *
+ * Note that the light properties of tiles are queried from the worker threads,
+ * which means that the functions 'Tile::IsLightEmitter',
+ * 'Tile::GetLightStrength', 'Tile::GetLightColor' and 'Tile::GetOpacity' must
+ * not modify any state.
+ * **/
+class LightMap : public Terrain::ChangeListener
+{
+public:
+  /** Width and height of a chunk in number of cells **/
+  static constexpr u32 CHUNK_SIZE = 32;
+  /** Maximum light value of a channel **/
+  static constexpr u32 MAX_LIGHT = 255;
+  /** Amount of light lost when light travels into a fully transparent cell **/
+  static constexpr u32 LIGHT_FALLOFF = 16;
+  /** Additional amount of light lost when light travels into a fully opaque
+   * cell. This is scaled by the opacity of the tile **/
+  static constexpr u32 LIGHT_FALLOFF_OPAQUE = 48;
+  /** Maximum number of cells that light can travel **/
+  static constexpr u32 LIGHT_RADIUS = MAX_LIGHT / LIGHT_FALLOFF;
+  /** Updates with at most this many dirty chunks are calculated on the
+   * calling thread, waking the workers costs more than it saves **/
+  static constexpr u32 INLINE_CHUNK_COUNT = 4;
+
+  /** Light of a single cell **/
+  struct Light
+  {
+    /** Light channels **/
+    u8 r = 0, g = 0, b = 0;
+
+    /** Returns the light as a color that can be used to tint sprites **/
+    [[nodiscard]] Color ToColor() const { return Color{ r, g, b, 255 }; }
+  };
+
+private:
+  /** Buffers used while calculating a chunk **/
+  struct Scratch
+  {
+    std::vector<Light> lights;
+    std::vector<u8> falloffs;
+    std::vector<u32> queue;
+  };
+
+  /** World **/
+  World& mWorld;
+
+  /** Width of the light map **/
+  u32 mWidth = 0;
+  /** Height of the light map **/
+  u32 mHeight = 0;
+  /** Light of each cell **/
+  std::vector<Light> mLights;
+
+  /** Lowest y-coordinate in each column that can see the sky **/
+  std::vector<u32> mSkyHeights;
+
+  /** Number of chunks horizontally **/
+  u32 mChunkCountX = 0;
+  /** Number of chunks vertically **/
+  u32 mChunkCountY = 0;
+  /** Flags for each chunk that determines if it needs to be recalculated **/
+  std::vector<bool> mDirtyChunkFlags;
+  /** List of chunks that needs to be recalculated **/
+  std::vector<u32> mDirtyChunks;
+
+  /** Threads that recalculate chunks together with the calling thread **/
+  WorkerPool mWorkers;
+  /** Scratch buffers of each thread, indexed like the threads of the pool **/
+  std::vector<Scratch> mScratches;
+
+public:
+  /** Construct light map for the terrain of a world **/
+  explicit LightMap(World& world);
+
+  /** Destruct **/
+  ~LightMap();
+
+  DIB_CLASS_NON_COPYABLE(LightMap);
+
+  /** Recalculate the light of all chunks that have been affected by changes to
+   * the terrain since the last update **/
+  void Update();
+
+  /** Mark the entire light map for recalculation **/
+  void Invalidate();
+
+  void OnResize(u32 width, u32 height) override;
+
+  void OnTileChanged(WorldPos pos) override;
+
+  void OnWallChanged(WorldPos pos) override;
+
+  void OnRegionChanged(WorldPos min, WorldPos max) override;
+
+  /** Returns the light at a position in the world **/
+  [[nodiscard]] const Light& GetLight(WorldPos pos) const
+  {
+    return mLights[mWidth * pos.Y() + pos.X()];
+  }
+
+  /** Returns the number of chunks that are waiting to be recalculated **/
+  [[nodiscard]] u32 GetDirtyChunkCount() const
+  {
+    return u32(mDirtyChunks.size());
+  }
+
+private:
+  /** Mark all chunks that overlaps the region (inclusive) as dirty **/
+  void MarkRegionDirty(s64 minX, s64 minY, s64 maxX, s64 maxY);
+
+  /** Recalculate the light of a chunk. The scratch buffers are reused between
+   * calls to avoid allocations **/
+  void CalculateChunk(u32 chunkIndex, Scratch& scratch);
+
+  /** Returns whether the tile at a position lets sky light through **/
+  bool IsTransparent(WorldPos pos);
+};
+
+}
@@ -0,0 +1,432 @@
+#include "game/client/terrain_lod.hpp"
+
+// ========================================================================== //
+// Headers
+// ========================================================================== //
+
+#include <microprofile/microprofile.h>
+
+#include "game/gameplay/core_content.hpp"
+
+// ========================================================================== //
+// Functions
+// ========================================================================== //
+
+namespace dib::game {
+
+/** Select the most common of four values. Ties are broken in favour of values
+ * that are not 'empty' **/
+template<typename T>
+static T
+SelectMajority(const T (&values)[4], T empty)
+{
+  T best = values[0];
+  u32 bestCount = 0;
+  for (u32 i = 0; i < 4; i++) {
+    u32 count = 0;
+    for (u32 j = 0; j < 4; j++) {
+      count += values[j] == values[i] ? 1 : 0;
+    }
+    if (count > bestCount || (count == bestCount && best == empty)) {
+      best = values[i];
+      bestCount = count;
+    }
+  }
+  return best;
+}
+
+// ========================================================================== //
+// TerrainLod Implementation
+// ========================================================================== //
+
+TerrainLod::TerrainLod(World& world)
+  : mWorld(world)
+{
+  Terrain& terrain = mWorld.GetTerrain();
+  terrain.RegisterChangeListener(this);
+  OnResize(terrain.GetWidth(), terrain.GetHeight());
+}
+
+// -------------------------------------------------------------------------- //
+
+TerrainLod::~TerrainLod()
+{
+  mWorld.GetTerrain().UnregisterChangeListener(this);
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+TerrainLod::OnResize(u32 width, u32 height)
+{
+  MICROPROFILE_SCOPEI("TerrainLod", "Resize", MP_GREEN);
+
+  // Count the levels until a single cell covers the terrain
+  mLevelCount = 0;
+  for (u32 w = width, h = height;
+       mLevelCount < MAX_LEVELS && (w > 1 || h > 1);
+       mLevelCount++) {
+    w = (w + 1) / 2;
+    h = (h + 1) / 2;
+  }
+  mChunkCountX = (width + Terrain::CHUNK_SIZE - 1) / Terrain::CHUNK_SIZE;
+  mChunkCountY = (height + Terrain::CHUNK_SIZE - 1) / Terrain::CHUNK_SIZE;
+
+  // Every summary is recalculated from the resized terrain the next time that
+  // it's used
+  mBlocks.clear();
+  mLevels.clear();
+  for (u32 level = CHUNK_LEVELS;
+       level == CHUNK_LEVELS || level <= mLevelCount;
+       level++) {
+    const u32 levelWidth = (width + (1u << level) - 1) >> level;
+    const u32 levelHeight = (height + (1u << level) - 1) >> level;
+    mLevels.push_back(Level{ levelWidth, levelHeight, {} });
+    mLevels.back().cells.assign(levelWidth * levelHeight, Cell{});
+  }
+  mDirtyChunks.assign(mChunkCountX * mChunkCountY, true);
+  mDirtyChunkList.resize(mDirtyChunks.size());
+  for (u32 i = 0; i < mDirtyChunkList.size(); i++) {
+    mDirtyChunkList[i] = i;
+  }
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+TerrainLod::OnTileChanged(WorldPos pos)
+{
+  Propagate(pos);
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+TerrainLod::OnWallChanged(WorldPos pos)
+{
+  Propagate(pos);
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+TerrainLod::OnRegionChanged(WorldPos min, WorldPos max)
+{
+  // Blocks in the region are rebuilt the next time they are used
+  for (u32 chunkY = min.Y() / Terrain::CHUNK_SIZE;
+       chunkY <= max.Y() / Terrain::CHUNK_SIZE;
+       chunkY++) {
+    for (u32 chunkX = min.X() / Terrain::CHUNK_SIZE;
+         chunkX <= max.X() / Terrain::CHUNK_SIZE;
+         chunkX++) {
+      const u32 chunkIndex = chunkY * mChunkCountX + chunkX;
+      auto it = mBlocks.find(chunkIndex);
+      if (it != mBlocks.end()) {
+        it->second->dirty = true;
+      }
+      MarkChunkDirty(chunkIndex);
+    }
+  }
+}
+
+// -------------------------------------------------------------------------- //
+
+TerrainLod::Cell
+TerrainLod::GetCell(u32 level, u32 x, u32 y)
+{
+  if (level >= CHUNK_LEVELS) {
+    UpdateDirtyChunks();
+    const Level& l = mLevels[level - CHUNK_LEVELS];
+    return l.cells[l.width * y + x];
+  }
+
+  const u32 chunkX = x >> (CHUNK_LEVELS - level);
+  const u32 chunkY = y >> (CHUNK_LEVELS - level);
+  Cell cell;
+  if (IsUniformChunk(chunkX, chunkY, cell)) {
+    return cell;
+  }
+  const Block& block = GetBlock(chunkX, chunkY);
+  const u32 size = Terrain::CHUNK_SIZE >> level;
+  return block.cells[GetBlockOffset(level) + (y % size) * size + x % size];
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+TerrainLod::EvictBlocks()
+{
+  if (mBlocks.size() > MAX_CACHED_BLOCKS) {
+    for (auto it = mBlocks.begin(); it != mBlocks.end();) {
+      if (it->second->lastUsedFrame != mFrame) {
+        it = mBlocks.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+  mFrame++;
+}
+
+// -------------------------------------------------------------------------- //
+
+TerrainLod::Block&
+TerrainLod::GetBlock(u32 chunkX, u32 chunkY)
+{
+  std::unique_ptr<Block>& block = mBlocks[chunkY * mChunkCountX + chunkX];
+  if (!block) {
+    block = std::make_unique<Block>();
+  }
+  if (block->dirty) {
+    BuildBlock(chunkX, chunkY, *block);
+  }
+  block->lastUsedFrame = mFrame;
+  return *block;
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+TerrainLod::BuildBlock(u32 chunkX, u32 chunkY, Block& block)
+{
+  MICROPROFILE_SCOPEI("TerrainLod", "BuildBlock", MP_GREEN);
+
+  ResolveAir();
+  for (u32 level = 1; level < CHUNK_LEVELS; level++) {
+    const u32 size = Terrain::CHUNK_SIZE >> level;
+    for (u32 y = 0; y < size; y++) {
+      for (u32 x = 0; x < size; x++) {
+        CalculateBlockCell(block, chunkX, chunkY, level, x, y);
+      }
+    }
+  }
+  block.dirty = false;
+}
+
+// -------------------------------------------------------------------------- //
+
+bool
+TerrainLod::IsUniformChunk(u32 chunkX, u32 chunkY, Cell& cell) const
+{
+  // Chunks on the edge are not uniform, as the cells outside of the terrain
+  // are treated as air
+  const Terrain& terrain = mWorld.GetTerrain();
+  if ((chunkX + 1) * Terrain::CHUNK_SIZE > terrain.GetWidth() ||
+      (chunkY + 1) * Terrain::CHUNK_SIZE > terrain.GetHeight()) {
+    return false;
+  }
+  const PaletteArray& tiles = terrain.GetChunkTiles(chunkX, chunkY);
+  const PaletteArray& walls = terrain.GetChunkWalls(chunkX, chunkY);
+  if (tiles.GetBitsPerEntry() != 0 || walls.GetBitsPerEntry() != 0) {
+    return false;
+  }
+  cell = Cell{ tiles.GetPalette()[0], walls.GetPalette()[0] };
+  return true;
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+TerrainLod::Propagate(WorldPos pos)
+{
+  const u32 chunkX = pos.X() / Terrain::CHUNK_SIZE;
+  const u32 chunkY = pos.Y() / Terrain::CHUNK_SIZE;
+  const u32 chunkIndex = chunkY * mChunkCountX + chunkX;
+
+  // Chunks without a clean block are summarized from scratch later
+  auto it = mBlocks.find(chunkIndex);
+  if (it != mBlocks.end() && !it->second->dirty) {
+    ResolveAir();
+    const u32 x = pos.X() % Terrain::CHUNK_SIZE;
+    const u32 y = pos.Y() % Terrain::CHUNK_SIZE;
+    for (u32 level = 1; level < CHUNK_LEVELS; level++) {
+      if (!CalculateBlockCell(
+            *it->second, chunkX, chunkY, level, x >> level, y >> level)) {
+        return;
+      }
+    }
+  }
+  MarkChunkDirty(chunkIndex);
+}
+
+// -------------------------------------------------------------------------- //
+
+bool
+TerrainLod::CalculateBlockCell(Block& block,
+                               u32 chunkX,
+                               u32 chunkY,
+                               u32 level,
+                               u32 x,
+                               u32 y)
+{
+  // Gather the four children. Children outside the terrain are treated as air
+  Cell children[4];
+  if (level == 1) {
+    const Terrain& terrain = mWorld.GetTerrain();
+    const PaletteArray& tiles = terrain.GetChunkTiles(chunkX, chunkY);
+    const PaletteArray& walls = terrain.GetChunkWalls(chunkX, chunkY);
+    const u32 countX = terrain.GetWidth() - chunkX * Terrain::CHUNK_SIZE;
+    const u32 countY = terrain.GetHeight() - chunkY * Terrain::CHUNK_SIZE;
+    for (u32 i = 0; i < 4; i++) {
+      const u32 childX = x * 2 + (i & 1);
+      const u32 childY = y * 2 + (i >> 1);
+      if (childX < countX && childY < countY) {
+        const u32 index = childY * Terrain::CHUNK_SIZE + childX;
+        children[i] = Cell{ tiles.Get(index), walls.Get(index) };
+      } else {
+        children[i] = Cell{ mAirTile, mAirWall };
+      }
+    }
+  } else {
+    const u32 size = Terrain::CHUNK_SIZE >> (level - 1);
+    const Cell* below = block.cells + GetBlockOffset(level - 1);
+    for (u32 i = 0; i < 4; i++) {
+      children[i] = below[(y * 2 + (i >> 1)) * size + x * 2 + (i & 1)];
+    }
+  }
+
+  const u32 size = Terrain::CHUNK_SIZE >> level;
+  return Summarize(children,
+                   block.cells[GetBlockOffset(level) + y * size + x]);
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+TerrainLod::UpdateDirtyChunks()
+{
+  if (mDirtyChunkList.empty()) {
+    return;
+  }
+  MICROPROFILE_SCOPEI("TerrainLod", "UpdateDirtyChunks", MP_GREEN);
+
+  ResolveAir();
+  for (u32 chunkIndex : mDirtyChunkList) {
+    mDirtyChunks[chunkIndex] = false;
+    const u32 chunkX = chunkIndex % mChunkCountX;
+    const u32 chunkY = chunkIndex / mChunkCountX;
+
+    // Summarize the chunk from its block. Chunks that have no block are built
+    // in the scratch block, so that chunks that are not visible never keep one
+    Cell summary;
+    if (!IsUniformChunk(chunkX, chunkY, summary)) {
+      Block* block;
+      auto it = mBlocks.find(chunkIndex);
+      if (it != mBlocks.end()) {
+        block = it->second.get();
+        if (block->dirty) {
+          BuildBlock(chunkX, chunkY, *block);
+        }
+      } else {
+        if (!mScratchBlock) {
+          mScratchBlock = std::make_unique<Block>();
+        }
+        block = mScratchBlock.get();
+        BuildBlock(chunkX, chunkY, *block);
+      }
+      const Cell* below = block->cells + GetBlockOffset(CHUNK_LEVELS - 1);
+      const Cell children[4] = { below[0], below[1], below[2], below[3] };
+      Summarize(children, summary);
+    }
+
+    // Recalculate the levels above until a summary is left unchanged
+    Cell& cell = mLevels[0].cells[chunkIndex];
+    if (summary.tile == cell.tile && summary.wall == cell.wall) {
+      continue;
+    }
+    cell = summary;
+    for (u32 level = CHUNK_LEVELS + 1; level <= mLevelCount; level++) {
+      const u32 shift = level - CHUNK_LEVELS;
+      if (!CalculateCell(level, chunkX >> shift, chunkY >> shift)) {
+        break;
+      }
+    }
+  }
+  mDirtyChunkList.clear();
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+TerrainLod::MarkChunkDirty(u32 chunkIndex)
+{
+  if (!mDirtyChunks[chunkIndex]) {
+    mDirtyChunks[chunkIndex] = true;
+    mDirtyChunkList.push_back(chunkIndex);
+  }
+}
+
+// -------------------------------------------------------------------------- //
+
+bool
+TerrainLod::CalculateCell(u32 level, u32 x, u32 y)
+{
+  // Gather the four children. Children outside the level below are treated
+  // as air
+  Cell children[4];
+  const Level& below = mLevels[level - CHUNK_LEVELS - 1];
+  for (u32 i = 0; i < 4; i++) {
+    const u32 childX = x * 2 + (i & 1);
+    const u32 childY = y * 2 + (i >> 1);
+    if (childX < below.width && childY < below.height) {
+      children[i] = below.cells[below.width * childY + childX];
+    } else {
+      children[i] = Cell{ mAirTile, mAirWall };
+    }
+  }
+
+  Level& current = mLevels[level - CHUNK_LEVELS];
+  return Summarize(children, current.cells[current.width * y + x]);
+}
+
+// -------------------------------------------------------------------------- //
+
+bool
+TerrainLod::Summarize(const Cell (&children)[4], Cell& cell) const
+{
+  TileRegistry::TileID tiles[4];
+  WallRegistry::WallID walls[4];
+  for (u32 i = 0; i < 4; i++) {
+    tiles[i] = children[i].tile;
+    walls[i] = children[i].wall;
+  }
+  const Cell summary{ SelectMajority(tiles, mAirTile),
+                      SelectMajority(walls, mAirWall) };
+  if (summary.tile == cell.tile && summary.wall == cell.wall) {
+    return false;
+  }
+  cell = summary;
+  return true;
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+TerrainLod::ResolveAir()
+{
+  if (mAirResolved) {
+    return;
+  }
+  Tile* airTile = CoreContent::GetTiles().air;
+  Wall* airWall = CoreContent::GetWalls().air;
+  if (airTile && airWall) {
+    mAirTile = TileRegistry::Instance().GetTileID(airTile);
+    mAirWall = WallRegistry::Instance().GetWallID(airWall);
+    mAirResolved = true;
+  }
+}
+
+// -------------------------------------------------------------------------- //
+
+u32
+TerrainLod::GetBlockOffset(u32 level)
+{
+  u32 offset = 0;
+  for (u32 l = 1; l < level; l++) {
+    const u32 size = Terrain::CHUNK_SIZE >> l;
+    offset += size * size;
+  }
+  return offset;
+}
+
+}
@@ -0,0 +1,220 @@
+#pragma once
+
+// ========================================================================== //
+// Headers
+// ========================================================================== //
+
+#include <memory>
+#include <vector>
+
+#include <tsl/robin_map.h>
+
+#include "core/types.hpp"
+#include "game/terrain.hpp"
+#include "game/world.hpp"
+
+// ========================================================================== //
+// TerrainLod Declaration
+// ========================================================================== //
+
+namespace dib::game {
+
+/** Mip-style level-of-detail pyramid of the terrain.
+ *
+ * Level 'L' of the pyramid stores one cell for each square of '2^L' x '2^L'
+ * tiles, starting at level 1. Each cell is a summary of the four cells below
+ * it, where the tile and wall that are most common are chosen. Ties are broken
+ * in favour of anything that is not air, so that thin layers of ground does not
+ * disappear when zooming out.
+ *
+ * The levels below 'CHUNK_LEVELS' are stored in one block for each terrain
+ * chunk. Blocks are only built for chunks whose cells are requested, that is
+ * chunks that are visible, and are evicted like the chunks of the world
+ * renderer. Chunks where every tile and every wall are the same, according to
+ * the palettes of the chunk, never need a block. Level 'CHUNK_LEVELS', which
+ * has one cell for each chunk, and the levels above it are small enough to be
+ * stored for the whole terrain.
+ *
+ * Edits of a chunk with a block only recalculate the cells above the changed
+ * tile and the update stops as soon as a summary is left unchanged. Edits of
+ * other chunks mark the chunk, and the summary of the chunk is recalculated
+ * the next time that a level above the blocks is requested. **/
+class TerrainLod : public Terrain::ChangeListener
+{
+public:
+  /** Maximum number of levels. The last level covers 1024 x 1024 tiles **/
+  static constexpr u32 MAX_LEVELS = 10;
+
+  /** Level that has one cell for each terrain chunk **/
+  static constexpr u32 CHUNK_LEVELS = 5;
+
+  /** Maximum number of blocks to keep. Blocks that were not used since the
+   * last eviction are evicted when there are more blocks than this **/
+  static constexpr u32 MAX_CACHED_BLOCKS = 256;
+
+  /** Summary of a square of tiles **/
+  struct Cell
+  {
+    /** Most common tile **/
+    TileRegistry::TileID tile = 0;
+    /** Most common wall **/
+    WallRegistry::WallID wall = 0;
+  };
+
+private:
+  static_assert((1u << CHUNK_LEVELS) == Terrain::CHUNK_SIZE,
+                "Level 'CHUNK_LEVELS' must have one cell for each chunk");
+
+  /** Number of cells in a block, for the levels from 1 to 'CHUNK_LEVELS - 1'
+   * (inclusive) **/
+  static constexpr u32 BLOCK_CELL_COUNT = (Terrain::CHUNK_CELL_COUNT - 4) / 3;
+
+  /** Levels below 'CHUNK_LEVELS' of a terrain chunk **/
+  struct Block
+  {
+    /** Cells of each level, level by level starting at level 1 **/
+    Cell cells[BLOCK_CELL_COUNT];
+    /** Whether the cells must be rebuilt before use **/
+    bool dirty = true;
+    /** Frame that the block was last used in, counted in calls to
+     * 'EvictBlocks' **/
+    u64 lastUsedFrame = 0;
+  };
+
+  /** Level of the pyramid that is stored for the whole terrain **/
+  struct Level
+  {
+    /** Width in number of cells **/
+    u32 width;
+    /** Height in number of cells **/
+    u32 height;
+    /** Cells **/
+    std::vector<Cell> cells;
+  };
+
+private:
+  /** World **/
+  World& mWorld;
+
+  /** Number of levels **/
+  u32 mLevelCount = 0;
+  /** Number of chunks horizontally **/
+  u32 mChunkCountX = 0;
+  /** Number of chunks vertically **/
+  u32 mChunkCountY = 0;
+
+  /** Blocks, keyed on the index of the terrain chunk **/
+  tsl::robin_map<u32, std::unique_ptr<Block>> mBlocks;
+  /** Block that summaries of chunks without a block are calculated in **/
+  std::unique_ptr<Block> mScratchBlock;
+  /** Number of calls to 'EvictBlocks' **/
+  u64 mFrame = 0;
+
+  /** Levels from 'CHUNK_LEVELS' and up. Index 0 holds level 'CHUNK_LEVELS'.
+   * The first level is always stored, even when the level count is lower **/
+  std::vector<Level> mLevels;
+  /** Whether the summary of the chunk with the index must be recalculated **/
+  std::vector<bool> mDirtyChunks;
+  /** Indices of the chunks whose summary must be recalculated **/
+  std::vector<u32> mDirtyChunkList;
+
+  /** ID of the air tile, resolved once the core content has been setup **/
+  TileRegistry::TileID mAirTile = 0;
+  /** ID of the air wall, resolved once the core content has been setup **/
+  WallRegistry::WallID mAirWall = 0;
+  /** Whether the air IDs have been resolved **/
+  bool mAirResolved = false;
+
+public:
+  /** Construct the pyramid for the terrain of a world **/
+  explicit TerrainLod(World& world);
+
+  /** Destruct **/
+  ~TerrainLod();
+
+  void OnResize(u32 width, u32 height) override;
+
+  void OnTileChanged(WorldPos pos) override;
+
+  void OnWallChanged(WorldPos pos) override;
+
+  void OnRegionChanged(WorldPos min, WorldPos max) override;
+
+  /** Returns the number of levels. Level 0 is the terrain itself and is not
+   * counted **/
+  [[nodiscard]] u32 GetLevelCount() const { return mLevelCount; }
+
+  /** Returns the width of a level in number of cells **/
+  [[nodiscard]] u32 GetLevelWidth(u32 level) const
+  {
+    return (mWorld.GetTerrain().GetWidth() + (1u << level) - 1) >> level;
+  }
+
+  /** Returns the height of a level in number of cells **/
+  [[nodiscard]] u32 GetLevelHeight(u32 level) const
+  {
+    return (mWorld.GetTerrain().GetHeight() + (1u << level) - 1) >> level;
+  }
+
+  /** Returns a cell of a level. The level must be between 1 and the level
+   * count (inclusive). The block of the chunk is built if it's needed and not
+   * cached or dirty **/
+  [[nodiscard]] Cell GetCell(u32 level, u32 x, u32 y);
+
+  /** Evict the blocks that were not used since the last call, if too many
+   * blocks are cached. Called once each frame that the pyramid is
+   * rendered **/
+  void EvictBlocks();
+
+  /** Returns the number of cached blocks **/
+  [[nodiscard]] u32 GetCachedBlockCount() const { return u32(mBlocks.size()); }
+
+private:
+  /** Returns the cached block of a chunk. The block is built if it's not
+   * cached or dirty **/
+  Block& GetBlock(u32 chunkX, u32 chunkY);
+
+  /** Build the cells of the block of a chunk from the palettes of the
+   * chunk **/
+  void BuildBlock(u32 chunkX, u32 chunkY, Block& block);
+
+  /** Returns whether every tile and every wall of a chunk are the same. The
+   * cell is set to the tile and wall if they are **/
+  bool IsUniformChunk(u32 chunkX, u32 chunkY, Cell& cell) const;
+
+  /** Recalculate the cells above a tile in the block of its chunk, if the
+   * chunk has a clean block, or otherwise mark the chunk **/
+  void Propagate(WorldPos pos);
+
+  /** Recalculate a cell in the block of a chunk from the level below, or from
+   * the palettes of the chunk for level 1. The position is relative to the
+   * chunk. Returns whether the cell changed **/
+  bool CalculateBlockCell(Block& block,
+                          u32 chunkX,
+                          u32 chunkY,
+                          u32 level,
+                          u32 x,
+                          u32 y);
+
+  /** Recalculate the summary of each marked chunk and the cells above it **/
+  void UpdateDirtyChunks();
+
+  /** Mark the summary of a chunk to be recalculated **/
+  void MarkChunkDirty(u32 chunkIndex);
+
+  /** Recalculate a cell of a level that is stored for the whole terrain, from
+   * the level below. Returns whether the cell changed **/
+  bool CalculateCell(u32 level, u32 x, u32 y);
+
+  /** Set a cell to the summary of four cells. Returns whether the cell
+   * changed **/
+  bool Summarize(const Cell (&children)[4], Cell& cell) const;
+
+  /** Resolve the IDs of air if the core content is available **/
+  void ResolveAir();
+
+  /** Returns the offset of the first cell of a level in a block **/
+  static u32 GetBlockOffset(u32 level);
+};
+
+}
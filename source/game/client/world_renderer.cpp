@@ -10,6 +10,7 @@
 #include "graphics/camera.hpp"
 #include "game/client/game_client.hpp"
 #include "game/constants.hpp"
+#include "game/gameplay/tile/tile_variant.hpp"
 
 // ========================================================================== //
 // TerrainRenderer Implementation
@@ -17,13 +18,16 @@
 
 namespace dib::game {
 
-WorldRenderer::WorldRenderer(World& world, ClientCache& clientCache)
+WorldRenderer::WorldRenderer(World& world,
+                             ClientCache& clientCache,
+                             const LightMap& lightMap,
+                             TerrainLod& terrainLod)
   : mWorld(world)
   , mClientCache(clientCache)
+  , mLightMap(lightMap)
+  , mTerrainLod(terrainLod)
 {
   mWorld.GetTerrain().RegisterChangeListener(this);
-  mDataCells =
-    new Cell[mWorld.GetTerrain().GetWidth() * mWorld.GetTerrain().GetHeight()];
 }
 
 // -------------------------------------------------------------------------- //
@@ -31,7 +35,6 @@ WorldRenderer::WorldRenderer(World& world, ClientCache& clientCache)
 WorldRenderer::~WorldRenderer()
 {
   mWorld.GetTerrain().UnregisterChangeListener(this);
-  delete mDataCells;
 }
 
 // -------------------------------------------------------------------------- //
@@ -41,78 +44,99 @@ WorldRenderer::Render(graphics::Renderer& renderer,
                       const graphics::Camera& camera)
 {
   MICROPROFILE_SCOPEI("WorldRenderer", "RenderTerrain", MP_SANDYBROWN);
+  mFrame++;
 
   // Retrieve objects
   Terrain& terrain = mWorld.GetTerrain();
 
+  // Switch to the coarsest level that is needed to stay within the budget
+  const f32 visibleX = std::ceil(camera.GetViewWidth() / TILE_SIZE);
+  const f32 visibleY = std::ceil(camera.GetViewHeight() / TILE_SIZE);
+  u32 level = 0;
+  while (level < mTerrainLod.GetLevelCount() &&
+         (visibleX / f32(1u << level)) * (visibleY / f32(1u << level)) >
+           f32(MAX_VISIBLE_CELLS)) {
+    level++;
+  }
+  if (level > 0) {
+    RenderLod(renderer, camera, level);
+    mTerrainLod.EvictBlocks();
+    EvictChunks();
+    return;
+  }
+
   // Retrieve batch and begin
   graphics::SpriteBatch& spriteBatch = renderer.GetSpriteBatch();
   spriteBatch.Begin(&camera);
 
-  // Calculate first tile in camera
+  // Calculate visible tiles
   const Vector3F& cameraPos = camera.GetPosition();
-  u32 minX = std::floor(camera.GetPosition().x / TILE_SIZE);
-  if (minX < 0) {
-    minX = 0;
-  }
-  u32 minY = std::floor(camera.GetPosition().y / TILE_SIZE);
-  if (minY < 0) {
-    minY = 0;
+  const u32 minX = u32(std::max(0.0f, std::floor(cameraPos.x / TILE_SIZE)));
+  const u32 minY = u32(std::max(0.0f, std::floor(cameraPos.y / TILE_SIZE)));
+  const u32 maxX =
+    std::min(terrain.GetWidth(),
+             minX + u32(std::ceil(camera.GetViewWidth() / TILE_SIZE)) + 2);
+  const u32 maxY =
+    std::min(terrain.GetHeight(),
+             minY + u32(std::ceil(camera.GetViewHeight() / TILE_SIZE)) + 2);
+  if (minX >= maxX || minY >= maxY) {
+    spriteBatch.End();
+    return;
   }
 
-  // Calculate number of tiles in camera
-  u32 countX = std::ceil(camera.GetWidth() / TILE_SIZE);
-  if (countX + minX > terrain.GetWidth()) {
-    countX = terrain.GetWidth() - minX;
-  }
-  u32 countY = std::ceil(camera.GetHeight() / TILE_SIZE);
-  if (countY + minY > terrain.GetHeight()) {
-    countY = terrain.GetHeight() - minY;
-  }
+  // Visit the visible cells chunk by chunk, so that each chunk is only looked
+  // up once
+  constexpr u32 CHUNK_SIZE = Terrain::CHUNK_SIZE;
+  auto forEachVisibleCell = [&](auto&& function) {
+    for (u32 chunkY = minY / CHUNK_SIZE; chunkY <= (maxY - 1) / CHUNK_SIZE;
+         chunkY++) {
+      for (u32 chunkX = minX / CHUNK_SIZE; chunkX <= (maxX - 1) / CHUNK_SIZE;
+           chunkX++) {
+        const Chunk& chunk = GetChunk(chunkX, chunkY);
+        const u32 endY = std::min(maxY, (chunkY + 1) * CHUNK_SIZE);
+        const u32 endX = std::min(maxX, (chunkX + 1) * CHUNK_SIZE);
+        for (u32 y = std::max(minY, chunkY * CHUNK_SIZE); y < endY; y++) {
+          for (u32 x = std::max(minX, chunkX * CHUNK_SIZE); x < endX; x++) {
+            function(
+              WorldPos{ x, y },
+              chunk.cells[(y % CHUNK_SIZE) * CHUNK_SIZE + x % CHUNK_SIZE]);
+          }
+        }
+      }
+    }
+  };
 
   // Render each tile
-  for (u32 y = minY; y < minY + countY + 2; y++) {
-    for (u32 x = minX; x < minX + countX + 2; x++) {
-      WorldPos worldPosition{ x, y };
-      Cell& cell = GetCell(worldPosition);
-      alflib::Color tint = alflib::Color::WHITE;
-
-      // Render tile
-      Vector3F renderPosition = Vector3F(
-        x * TILE_SIZE - cameraPos.x, y * TILE_SIZE - cameraPos.y, 0.0f);
-      spriteBatch.Submit(mClientCache.GetTileAtlasTexture(),
-                         renderPosition,
-                         Vector2F(TILE_SIZE, TILE_SIZE),
-                         tint,
-                         cell.texMinTile,
-                         cell.texMaxTile);
-    }
-  }
+  forEachVisibleCell([&](WorldPos worldPosition, const Cell& cell) {
+    alflib::Color tint = mLightMap.GetLight(worldPosition).ToColor();
+    Vector3F renderPosition = Vector3F(
+      worldPosition.X() * TILE_SIZE, worldPosition.Y() * TILE_SIZE, 0.0f);
+    spriteBatch.Submit(mClientCache.GetTileAtlasTexture(),
+                       renderPosition,
+                       Vector2F(TILE_SIZE, TILE_SIZE),
+                       tint,
+                       cell.texMinTile,
+                       cell.texMaxTile);
+  });
 
   // Render each wall
-  // TODO(Filip Björklund): Implement zooming
-  for (u32 y = minY; y < minY + countY + 2; y++) {
-    for (u32 x = minX; x < minX + countX + 2; x++) {
-      WorldPos worldPosition{ x, y };
-      Cell& cell = GetCell(worldPosition);
-      alflib::Color tint = alflib::Color::WHITE;
-
-      // Render wall
-      Vector3F renderPosWall =
-        Vector3F(f32(x * WALL_SIZE) - cameraPos.x - (WALL_SIZE / 2.0f),
-                 f32(y * WALL_SIZE) - cameraPos.y - (WALL_SIZE / 2.0f),
-                 -0.5f);
-      spriteBatch.Submit(mClientCache.GetWallAtlasTexture(),
-                         renderPosWall,
-                         Vector2F(WALL_SIZE * 2.0f, WALL_SIZE * 2.0f),
-                         tint,
-                         cell.texMinWall,
-                         cell.texMaxWall);
-    }
-  }
+  forEachVisibleCell([&](WorldPos worldPosition, const Cell& cell) {
+    alflib::Color tint = mLightMap.GetLight(worldPosition).ToColor();
+    Vector3F renderPosWall =
+      Vector3F(f32(worldPosition.X() * WALL_SIZE) - (WALL_SIZE / 2.0f),
+               f32(worldPosition.Y() * WALL_SIZE) - (WALL_SIZE / 2.0f),
+               -0.5f);
+    spriteBatch.Submit(mClientCache.GetWallAtlasTexture(),
+                       renderPosWall,
+                       Vector2F(WALL_SIZE * 2.0f, WALL_SIZE * 2.0f),
+                       tint,
+                       cell.texMinWall,
+                       cell.texMaxWall);
+  });
 
   // Done rendering
   spriteBatch.End();
+  EvictChunks();
 }
 
 // -------------------------------------------------------------------------- //
@@ -121,10 +145,10 @@ WorldPos
 WorldRenderer::PickScreenTile(const graphics::Camera& camera,
                               Vector2F mousePosition)
 {
-  // TODO(Filip Björklund): Implement support for zoom
   const Vector3F& cameraPos = camera.GetPosition();
-  WorldPos pos{ u32((cameraPos.x + mousePosition.x) / TILE_SIZE),
-                u32((cameraPos.y + mousePosition.y) / TILE_SIZE) };
+  const f32 zoom = camera.GetZoom();
+  WorldPos pos{ u32((cameraPos.x + mousePosition.x / zoom) / TILE_SIZE),
+                u32((cameraPos.y + mousePosition.y / zoom) / TILE_SIZE) };
   pos.X() = alflib::Clamp(pos.X(), 0u, mWorld.GetTerrain().GetWidth());
   pos.Y() = alflib::Clamp(pos.Y(), 0u, mWorld.GetTerrain().GetHeight());
   return pos;
@@ -133,10 +157,10 @@ WorldRenderer::PickScreenTile(const graphics::Camera& camera,
 // -------------------------------------------------------------------------- //
 
 void
-WorldRenderer::OnResize(u32 width, u32 height)
+WorldRenderer::OnResize([[maybe_unused]] u32 width,
+                        [[maybe_unused]] u32 height)
 {
-  delete mDataCells;
-  mDataCells = new Cell[width * height];
+  mChunks.clear();
 }
 
 // -------------------------------------------------------------------------- //
@@ -144,13 +168,20 @@ WorldRenderer::OnResize(u32 width, u32 height)
 void
 WorldRenderer::OnTileChanged(WorldPos pos)
 {
+  // Chunks that are not cached are built once they become visible
+  Cell* cell = FindCell(pos);
+  if (!cell) {
+    return;
+  }
+
   TileRegistry::TileID id = mWorld.GetTerrain().GetTileID(pos);
   Tile* tile = TileRegistry::Instance().GetTile(id);
-  Cell& cell = GetCell(pos);
 
-  mClientCache.GetTextureCoordinatesForTile(
-    id, tile->GetResourceIndex(mWorld, pos), cell.texMinTile, cell.texMaxTile);
-  std::swap(cell.texMinTile.x, cell.texMaxTile.x);
+  mClientCache.GetTextureCoordinatesForTile(id,
+                                            tile->GetResourceIndex(mWorld, pos),
+                                            cell->texMinTile,
+                                            cell->texMaxTile);
+  std::swap(cell->texMinTile.x, cell->texMaxTile.x);
 }
 
 // -------------------------------------------------------------------------- //
@@ -158,21 +189,237 @@ WorldRenderer::OnTileChanged(WorldPos pos)
 void
 WorldRenderer::OnWallChanged(WorldPos pos)
 {
+  Cell* cell = FindCell(pos);
+  if (!cell) {
+    return;
+  }
+
   WallRegistry::WallID id = mWorld.GetTerrain().GetWallID(pos);
   Wall* wall = WallRegistry::Instance().GetWall(id);
-  Cell& cell = GetCell(pos);
 
-  mClientCache.GetTextureCoordinatesForWall(
-    id, wall->GetResourceIndex(mWorld, pos), cell.texMinWall, cell.texMaxWall);
-  std::swap(cell.texMinWall.x, cell.texMaxWall.x);
+  mClientCache.GetTextureCoordinatesForWall(id,
+                                            wall->GetResourceIndex(mWorld, pos),
+                                            cell->texMinWall,
+                                            cell->texMaxWall);
+  std::swap(cell->texMinWall.x, cell->texMaxWall.x);
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+WorldRenderer::OnRegionChanged(WorldPos min, WorldPos max)
+{
+  // Cached chunks in the region are rebuilt the next time they are rendered
+  const Terrain& terrain = mWorld.GetTerrain();
+  const u32 chunkCountX =
+    (terrain.GetWidth() + Terrain::CHUNK_SIZE - 1) / Terrain::CHUNK_SIZE;
+  for (u32 chunkY = min.Y() / Terrain::CHUNK_SIZE;
+       chunkY <= max.Y() / Terrain::CHUNK_SIZE;
+       chunkY++) {
+    for (u32 chunkX = min.X() / Terrain::CHUNK_SIZE;
+         chunkX <= max.X() / Terrain::CHUNK_SIZE;
+         chunkX++) {
+      auto it = mChunks.find(chunkY * chunkCountX + chunkX);
+      if (it != mChunks.end()) {
+        it->second->dirty = true;
+      }
+    }
+  }
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+WorldRenderer::RenderLod(graphics::Renderer& renderer,
+                         const graphics::Camera& camera,
+                         u32 level)
+{
+  MICROPROFILE_SCOPEI("WorldRenderer", "RenderTerrainLod", MP_SANDYBROWN);
+
+  Terrain& terrain = mWorld.GetTerrain();
+  graphics::SpriteBatch& spriteBatch = renderer.GetSpriteBatch();
+  spriteBatch.Begin(&camera);
+
+  // Calculate visible cells of the level
+  const u32 tilesPerCell = 1u << level;
+  const f32 cellSize = f32(tilesPerCell * TILE_SIZE);
+  const Vector3F& cameraPos = camera.GetPosition();
+  const u32 minX = u32(std::max(0.0f, std::floor(cameraPos.x / cellSize)));
+  const u32 minY = u32(std::max(0.0f, std::floor(cameraPos.y / cellSize)));
+  const u32 maxX =
+    std::min(mTerrainLod.GetLevelWidth(level),
+             minX + u32(std::ceil(camera.GetViewWidth() / cellSize)) + 2);
+  const u32 maxY =
+    std::min(mTerrainLod.GetLevelHeight(level),
+             minY + u32(std::ceil(camera.GetViewHeight() / cellSize)) + 2);
+
+  // Cells are visited once per pass, so that each pass only uses a single
+  // atlas and is not flushed between sprites. The light is sampled at the
+  // center of the cell
+  const Vector2F size(cellSize, cellSize);
+  auto forEachVisibleCell = [&](auto&& function) {
+    for (u32 y = minY; y < maxY; y++) {
+      for (u32 x = minX; x < maxX; x++) {
+        const WorldPos lightPos{
+          std::min(x * tilesPerCell + tilesPerCell / 2, terrain.GetWidth() - 1),
+          std::min(y * tilesPerCell + tilesPerCell / 2,
+                   terrain.GetHeight() - 1)
+        };
+        function(Vector3F(x * cellSize, y * cellSize, 0.0f),
+                 mTerrainLod.GetCell(level, x, y),
+                 mLightMap.GetLight(lightPos).ToColor());
+      }
+    }
+  };
+
+  // Render each cell with the first resource of its tile
+  Vector2F texMin, texMax;
+  forEachVisibleCell(
+    [&](Vector3F position, const TerrainLod::Cell& cell, Color tint) {
+      mClientCache.GetTextureCoordinatesForTile(cell.tile, 0, texMin, texMax);
+      std::swap(texMin.x, texMax.x);
+      spriteBatch.Submit(mClientCache.GetTileAtlasTexture(),
+                         position,
+                         size,
+                         tint,
+                         texMin,
+                         texMax);
+    });
+
+  // Render each cell with the first resource of its wall
+  forEachVisibleCell(
+    [&](Vector3F position, const TerrainLod::Cell& cell, Color tint) {
+      mClientCache.GetTextureCoordinatesForWall(cell.wall, 0, texMin, texMax);
+      std::swap(texMin.x, texMax.x);
+      position.z = -0.5f;
+      spriteBatch.Submit(mClientCache.GetWallAtlasTexture(),
+                         position,
+                         size,
+                         tint,
+                         texMin,
+                         texMax);
+    });
+
+  spriteBatch.End();
+}
+
+// -------------------------------------------------------------------------- //
+
+WorldRenderer::Chunk&
+WorldRenderer::GetChunk(u32 chunkX, u32 chunkY)
+{
+  const Terrain& terrain = mWorld.GetTerrain();
+  const u32 chunkCountX =
+    (terrain.GetWidth() + Terrain::CHUNK_SIZE - 1) / Terrain::CHUNK_SIZE;
+  std::unique_ptr<Chunk>& chunk = mChunks[chunkY * chunkCountX + chunkX];
+  if (!chunk) {
+    chunk = std::make_unique<Chunk>();
+  }
+  if (chunk->dirty) {
+    BuildChunk(chunkX, chunkY, *chunk);
+  }
+  chunk->lastUsedFrame = mFrame;
+  return *chunk;
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+WorldRenderer::BuildChunk(u32 chunkX, u32 chunkY, Chunk& chunk)
+{
+  MICROPROFILE_SCOPEI("WorldRenderer", "BuildChunk", MP_SANDYBROWN);
+
+  // Update the variant flags if tiles have been registered since last time
+  const std::vector<Tile*>& tiles = TileRegistry::Instance().GetTiles();
+  if (mVariantTiles.size() != tiles.size()) {
+    mVariantTiles.resize(tiles.size());
+    for (u32 i = 0; i < tiles.size(); i++) {
+      mVariantTiles[i] = dynamic_cast<TileVariant*>(tiles[i]) != nullptr;
+    }
+  }
+
+  // Tiles are processed row by row. The masks are calculated for the whole
+  // row at once from the raw IDs and only tiles that are not variants need to
+  // be asked for their resource index
+  Terrain& terrain = mWorld.GetTerrain();
+  const u32 minX = chunkX * Terrain::CHUNK_SIZE;
+  const u32 minY = chunkY * Terrain::CHUNK_SIZE;
+  const u32 maxX = std::min(minX + Terrain::CHUNK_SIZE, terrain.GetWidth());
+  const u32 maxY = std::min(minY + Terrain::CHUNK_SIZE, terrain.GetHeight());
+  const u32 count = maxX - minX;
+  TileRegistry::TileID above[Terrain::CHUNK_SIZE + 2];
+  TileRegistry::TileID row[Terrain::CHUNK_SIZE + 2];
+  TileRegistry::TileID below[Terrain::CHUNK_SIZE + 2];
+  u8 masks[Terrain::CHUNK_SIZE];
+  terrain.GatherTileRow(s64(minY) - 1, minX, count, below);
+  terrain.GatherTileRow(s64(minY), minX, count, row);
+  for (u32 y = minY; y < maxY; y++) {
+    terrain.GatherTileRow(s64(y) + 1, minX, count, above);
+    TileVariant::CalculateNeighbourMasks(
+      above + 1, row + 1, below + 1, count, masks);
+
+    for (u32 i = 0; i < count; i++) {
+      const WorldPos pos{ minX + i, y };
+      const TileRegistry::TileID id = row[i + 1];
+      const u32 resourceIndex =
+        mVariantTiles[id]
+          ? TileVariant::LookupResourceIndex(masks[i])
+          : TileRegistry::Instance().GetTile(id)->GetResourceIndex(mWorld, pos);
+
+      Cell& cell = chunk.cells[(y - minY) * Terrain::CHUNK_SIZE + i];
+      mClientCache.GetTextureCoordinatesForTile(
+        id, resourceIndex, cell.texMinTile, cell.texMaxTile);
+      std::swap(cell.texMinTile.x, cell.texMaxTile.x);
+
+      const WallRegistry::WallID wallId = terrain.GetWallID(pos);
+      Wall* wall = WallRegistry::Instance().GetWall(wallId);
+      const u32 wallResourceIndex = wall->GetResourceIndex(mWorld, pos);
+      mClientCache.GetTextureCoordinatesForWall(
+        wallId, wallResourceIndex, cell.texMinWall, cell.texMaxWall);
+      std::swap(cell.texMinWall.x, cell.texMaxWall.x);
+    }
+
+    // Shift rows down
+    std::copy(std::begin(row), std::end(row), std::begin(below));
+    std::copy(std::begin(above), std::end(above), std::begin(row));
+  }
+  chunk.dirty = false;
 }
 
 // -------------------------------------------------------------------------- //
 
-WorldRenderer::Cell&
-WorldRenderer::GetCell(WorldPos pos)
+WorldRenderer::Cell*
+WorldRenderer::FindCell(WorldPos pos)
 {
-  return *(mDataCells + mWorld.GetTerrain().GetWidth() * pos.Y() + pos.X());
+  const Terrain& terrain = mWorld.GetTerrain();
+  const u32 chunkCountX =
+    (terrain.GetWidth() + Terrain::CHUNK_SIZE - 1) / Terrain::CHUNK_SIZE;
+  const u32 chunkIndex = (pos.Y() / Terrain::CHUNK_SIZE) * chunkCountX +
+                         pos.X() / Terrain::CHUNK_SIZE;
+  auto it = mChunks.find(chunkIndex);
+  if (it == mChunks.end() || it->second->dirty) {
+    return nullptr;
+  }
+  return &it->second->cells[(pos.Y() % Terrain::CHUNK_SIZE) *
+                              Terrain::CHUNK_SIZE +
+                            pos.X() % Terrain::CHUNK_SIZE];
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+WorldRenderer::EvictChunks()
+{
+  if (mChunks.size() <= MAX_CACHED_CHUNKS) {
+    return;
+  }
+  for (auto it = mChunks.begin(); it != mChunks.end();) {
+    if (it->second->lastUsedFrame != mFrame) {
+      it = mChunks.erase(it);
+    } else {
+      ++it;
+    }
+  }
 }
 
 }
\ No newline at end of file
@@ -4,10 +4,17 @@
 // Headers
 // ========================================================================== //
 
+#include <memory>
+#include <vector>
+
+#include <tsl/robin_map.h>
+
 #include "core/types.hpp"
 #include "core/macros.hpp"
 #include "game/world.hpp"
 #include "game/terrain.hpp"
+#include "game/client/light_map.hpp"
+#include "game/client/terrain_lod.hpp"
 
 // ========================================================================== //
 // Forward Declaration
@@ -31,6 +38,17 @@ DIB_FORWARD_DECLARE_CLASS(ClientCache);
 /** **/
 class WorldRenderer : public Terrain::ChangeListener
 {
+public:
+  /** Maximum number of cells to render for each of the tile and wall layers.
+   * When more tiles than this are visible the renderer switches to a level of
+   * the terrain LOD pyramid, which keeps the cost constant as zoom
+   * decreases **/
+  static constexpr u32 MAX_VISIBLE_CELLS = 160 * 90;
+
+  /** Maximum number of chunks to keep in the render cache. Chunks that are not
+   * visible are evicted when there are more chunks than this **/
+  static constexpr u32 MAX_CACHED_CHUNKS = 256;
+
 public:
   struct Cell
   {
@@ -38,7 +56,18 @@ public:
     Vector2F texMinTile, texMaxTile;
     /** Cached wall texture coordinates **/
     Vector2F texMinWall, texMaxWall;
-    /** Cached shadow information **/
+  };
+
+private:
+  /** Cached cells of a terrain chunk **/
+  struct Chunk
+  {
+    /** Cells **/
+    Cell cells[Terrain::CHUNK_CELL_COUNT];
+    /** Whether the cells must be rebuilt before use **/
+    bool dirty = true;
+    /** Frame that the chunk was last rendered in **/
+    u64 lastUsedFrame = 0;
   };
 
 private:
@@ -46,13 +75,27 @@ private:
   World& mWorld;
   /** Client cache **/
   ClientCache& mClientCache;
+  /** Light map that is sampled to tint tiles and walls **/
+  const LightMap& mLightMap;
+  /** Terrain LOD pyramid that is rendered when zoomed out **/
+  TerrainLod& mTerrainLod;
 
-  /** Cells **/
-  Cell* mDataCells;
+  /** Chunks that are cached, keyed on the index of the terrain chunk. Only
+   * chunks that have been visible recently are cached **/
+  tsl::robin_map<u32, std::unique_ptr<Chunk>> mChunks;
+  /** Number of rendered frames **/
+  u64 mFrame = 0;
+
+  /** Whether the tile with the ID of the index is a variant tile, which means
+   * that its resource index only depends on the neighbour mask **/
+  std::vector<bool> mVariantTiles;
 
 public:
   /** Construct world renderer **/
-  WorldRenderer(World& world, ClientCache& clientCache);
+  WorldRenderer(World& world,
+                ClientCache& clientCache,
+                const LightMap& lightMap,
+                TerrainLod& terrainLod);
 
   /** Destruct **/
   ~WorldRenderer();
@@ -71,8 +114,31 @@ public:
 
   void OnWallChanged(WorldPos pos) override;
 
-  /** Returns a cell in the world data **/
-  Cell& GetCell(WorldPos pos);
+  void OnRegionChanged(WorldPos min, WorldPos max) override;
+
+  /** Returns the number of cached chunks **/
+  [[nodiscard]] u32 GetCachedChunkCount() const { return u32(mChunks.size()); }
+
+private:
+  /** Returns the cached chunk at the chunk coordinates. The chunk is built if
+   * it's not cached or dirty **/
+  Chunk& GetChunk(u32 chunkX, u32 chunkY);
+
+  /** Build the cells of a chunk **/
+  void BuildChunk(u32 chunkX, u32 chunkY, Chunk& chunk);
+
+  /** Returns the cached cell at a position, or nullptr if the chunk of the cell
+   * is not cached or is dirty **/
+  Cell* FindCell(WorldPos pos);
+
+  /** Evict chunks that were not rendered this frame, if too many chunks are
+   * cached **/
+  void EvictChunks();
+
+  /** Render a level of the terrain LOD pyramid **/
+  void RenderLod(graphics::Renderer& renderer,
+                 const graphics::Camera& camera,
+                 u32 level);
 };
 
 }
\ No newline at end of file
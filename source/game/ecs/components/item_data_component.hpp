@@ -4,6 +4,7 @@
 #include <alflib/memory/raw_memory_writer.hpp>
 #include <alflib/memory/raw_memory_reader.hpp>
 #include "core/types.hpp"
+#include "core/schema.hpp"
 #include "core/uuid.hpp"
 
 namespace dib {
@@ -17,18 +18,19 @@ struct ItemData
 
   bool operator!=(const ItemData& other) const { return !(operator==(other)); }
 
+  static constexpr auto GetSchema()
+  {
+    return MakeSchema(&ItemData::uuid /*, &ItemData::item_stack */);
+  }
+
   bool ToBytes(alflib::RawMemoryWriter& mw) const
   {
-    return mw.Write(uuid);
-    // return mw.Write(item_stack);
+    return Serializer<ItemData>::Write(mw, *this);
   }
 
   static ItemData FromBytes(alflib::RawMemoryReader& mr)
   {
-    ItemData data{};
-    data.uuid = mr.Read<decltype(uuid)>();
-    // data.ItemStack = mr.Read<decltype(item_stack)>();
-    return data;
+    return Serializer<ItemData>::Read(mr);
   }
 };
 
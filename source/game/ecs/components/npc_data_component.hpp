@@ -4,6 +4,7 @@
 #include <alflib/memory/raw_memory_writer.hpp>
 #include <alflib/memory/raw_memory_reader.hpp>
 #include "core/types.hpp"
+#include "core/schema.hpp"
 #include "core/uuid.hpp"
 #include "core/value_store.hpp"
 
@@ -19,20 +20,21 @@ struct NpcData
 
   bool operator!=(const NpcData& other) const { return !(operator==(other)); }
 
+  static constexpr auto GetSchema()
+  {
+    return MakeSchema(&NpcData::uuid,
+                      &NpcData::npc_id,
+                      &NpcData::dynamic_state);
+  }
+
   bool ToBytes(alflib::RawMemoryWriter& mw) const
   {
-    mw.Write(uuid);
-    mw.Write(npc_id);
-    return mw.Write(dynamic_state);
+    return Serializer<NpcData>::Write(mw, *this);
   }
 
   static NpcData FromBytes(alflib::RawMemoryReader& mr)
   {
-    NpcData data{};
-    data.uuid = mr.Read<decltype(uuid)>();
-    data.npc_id = mr.Read<decltype(npc_id)>();
-    data.dynamic_state = mr.Read<decltype(dynamic_state)>();
-    return data;
+    return Serializer<NpcData>::Read(mr);
   }
 };
 
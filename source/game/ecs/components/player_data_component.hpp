@@ -4,6 +4,7 @@
 #include <alflib/memory/raw_memory_writer.hpp>
 #include <alflib/memory/raw_memory_reader.hpp>
 #include "core/types.hpp"
+#include "core/schema.hpp"
 #include "core/uuid.hpp"
 #include "network/connection_id.hpp"
 #include "core/value_store.hpp"
@@ -37,28 +38,31 @@ struct PlayerData
     return !(operator==(other));
   }
 
+  // ============================================================ //
+  // Serialize
+  // ============================================================ //
+
+  /**
+   * The connection_id is local to the server and not serialized.
+   */
+  static constexpr auto GetSchema()
+  {
+    return MakeSchema(&PlayerData::uuid,
+                      &PlayerData::ping,
+                      &PlayerData::con_quality_local,
+                      &PlayerData::con_quality_remote,
+                      &PlayerData::name,
+                      &PlayerData::dynamic_state);
+  }
+
   bool ToBytes(alflib::RawMemoryWriter& mw) const
   {
-    mw.Write(uuid);
-    mw.Write(ping);
-    mw.Write(con_quality_local);
-    mw.Write(con_quality_remote);
-    mw.Write(name);
-    // TODO write moveable entity
-    return mw.Write(dynamic_state);
+    return Serializer<PlayerData>::Write(mw, *this);
   }
 
   static PlayerData FromBytes(alflib::RawMemoryReader& mr)
   {
-    PlayerData data{};
-    data.uuid = mr.Read<decltype(uuid)>();
-    data.ping = mr.Read<decltype(ping)>();
-    data.con_quality_local = mr.Read<decltype(con_quality_local)>();
-    data.con_quality_remote = mr.Read<decltype(con_quality_remote)>();
-    data.name = mr.Read<decltype(name)>();
-    // TODO read moveable entity
-    data.dynamic_state = mr.Read<decltype(dynamic_state)>();
-    return data;
+    return Serializer<PlayerData>::Read(mr);
   }
 
   String ToString() const
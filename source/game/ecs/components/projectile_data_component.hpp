@@ -4,6 +4,7 @@
 #include <alflib/memory/raw_memory_writer.hpp>
 #include <alflib/memory/raw_memory_reader.hpp>
 #include "core/types.hpp"
+#include "core/schema.hpp"
 #include "core/uuid.hpp"
 #include "core/value_store.hpp"
 
@@ -24,20 +25,21 @@ struct ProjectileData
     return !(operator==(other));
   }
 
+  static constexpr auto GetSchema()
+  {
+    return MakeSchema(&ProjectileData::uuid,
+                      &ProjectileData::projectile_id,
+                      &ProjectileData::dynamic_state);
+  }
+
   bool ToBytes(alflib::RawMemoryWriter& mw) const
   {
-    mw.Write(uuid);
-    mw.Write(projectile_id);
-    return mw.Write(dynamic_state);
+    return Serializer<ProjectileData>::Write(mw, *this);
   }
 
   static ProjectileData FromBytes(alflib::RawMemoryReader& mr)
   {
-    ProjectileData data{};
-    data.uuid = mr.Read<decltype(uuid)>();
-    data.projectile_id = mr.Read<decltype(projectile_id)>();
-    data.dynamic_state = mr.Read<decltype(dynamic_state)>();
-    return data;
+    return Serializer<ProjectileData>::Read(mr);
   }
 };
 }
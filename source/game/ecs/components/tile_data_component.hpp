@@ -4,6 +4,7 @@
 #include <alflib/memory/raw_memory_writer.hpp>
 #include <alflib/memory/raw_memory_reader.hpp>
 #include "core/types.hpp"
+#include "core/schema.hpp"
 #include "core/uuid.hpp"
 #include "core/value_store.hpp"
 
@@ -19,20 +20,21 @@ struct TileData
 
   bool operator!=(const TileData& other) const { return !(operator==(other)); }
 
+  static constexpr auto GetSchema()
+  {
+    return MakeSchema(&TileData::uuid,
+                      &TileData::tile_id,
+                      &TileData::dynamic_state);
+  }
+
   bool ToBytes(alflib::RawMemoryWriter& mw) const
   {
-    mw.Write(uuid);
-    mw.Write(tile_id);
-    return mw.Write(dynamic_state);
+    return Serializer<TileData>::Write(mw, *this);
   }
 
   static TileData FromBytes(alflib::RawMemoryReader& mr)
   {
-    TileData data{};
-    data.uuid = mr.Read<decltype(uuid)>();
-    data.tile_id = mr.Read<decltype(tile_id)>();
-    data.dynamic_state = mr.Read<decltype(dynamic_state)>();
-    return data;
+    return Serializer<TileData>::Read(mr);
   }
 };
 }
@@ -58,65 +58,72 @@ CoreContent::GenerateWorld(World& world)
 
   MICROPROFILE_SCOPEI("CoreGame", "WorldGen", MP_BROWN2);
 
-  for (u32 y = 0; y < world.GetTerrain().GetHeight(); y++) {
-    for (u32 x = 0; x < world.GetTerrain().GetWidth(); x++) {
-      if (y == 15) {
-        world.GetTerrain().GenSetTile(WorldPos{ x, y }, instance.mTiles.grass);
-        // world.GetTerrain().GenSetWall(WorldPos{ x, y },
-        // instance.mWalls.stone);
-      } else if (y < 15 && y > 5) {
-        world.GetTerrain().GenSetTile(WorldPos{ x, y }, instance.mTiles.dirt);
-        // world.GetTerrain().GenSetWall(WorldPos{ x, y },
-        // instance.mWalls.stone);
-      } else if (y <= 5) {
-        world.GetTerrain().GenSetTile(WorldPos{ x, y }, instance.mTiles.rock);
-        // world.GetTerrain().GenSetWall(WorldPos{ x, y },
-        // instance.mWalls.stone);
-      } else {
-        world.GetTerrain().GenSetTile(WorldPos{ x, y }, instance.mTiles.air);
-        // world.GetTerrain().GenSetWall(WorldPos{ x, y }, instance.mWalls.air);
+  {
+    // Listeners re-cache the whole world once generation is done
+    Terrain::EditBatch batch(world.GetTerrain());
+
+    for (u32 y = 0; y < world.GetTerrain().GetHeight(); y++) {
+      for (u32 x = 0; x < world.GetTerrain().GetWidth(); x++) {
+        if (y == 15) {
+          world.GetTerrain().GenSetTile(WorldPos{ x, y },
+                                        instance.mTiles.grass);
+          // world.GetTerrain().GenSetWall(WorldPos{ x, y },
+          // instance.mWalls.stone);
+        } else if (y < 15 && y > 5) {
+          world.GetTerrain().GenSetTile(WorldPos{ x, y }, instance.mTiles.dirt);
+          // world.GetTerrain().GenSetWall(WorldPos{ x, y },
+          // instance.mWalls.stone);
+        } else if (y <= 5) {
+          world.GetTerrain().GenSetTile(WorldPos{ x, y }, instance.mTiles.rock);
+          // world.GetTerrain().GenSetWall(WorldPos{ x, y },
+          // instance.mWalls.stone);
+        } else {
+          world.GetTerrain().GenSetTile(WorldPos{ x, y }, instance.mTiles.air);
+          // world.GetTerrain().GenSetWall(WorldPos{ x, y },
+          // instance.mWalls.air);
+        }
+
+        world.GetTerrain().GenSetWall(WorldPos{ x, y }, instance.mWalls.air);
       }
-
-      world.GetTerrain().GenSetWall(WorldPos{ x, y }, instance.mWalls.air);
     }
-  }
 
-  world.GetTerrain().GenSetWall(WorldPos{ 25, 25 }, instance.mWalls.stone);
+    world.GetTerrain().GenSetWall(WorldPos{ 25, 25 }, instance.mWalls.stone);
 
 #if 0
-  for (u32 i = 0; i < 256; i++) {
-    u32 x = 20 + (i % 16) * 4;
-    u32 y = 20 + (i / 16) * 4;
+    for (u32 i = 0; i < 256; i++) {
+      u32 x = 20 + (i % 16) * 4;
+      u32 y = 20 + (i / 16) * 4;
 
-    WorldPos p{ x, y };
-    world.GetTerrain().GenSetTile(p, instance.mTileDungeon);
+      WorldPos p{ x, y };
+      world.GetTerrain().GenSetTile(p, instance.mTileDungeon);
 
-    if (i & Bit(0)) {
-      world.GetTerrain().GenSetTile(p.TopLeft(), instance.mTileDungeon);
-    }
-    if (i & Bit(1)) {
-      world.GetTerrain().GenSetTile(p.Top(), instance.mTileDungeon);
-    }
-    if (i & Bit(2)) {
-      world.GetTerrain().GenSetTile(p.TopRight(), instance.mTileDungeon);
-    }
-    if (i & Bit(3)) {
-      world.GetTerrain().GenSetTile(p.Left(), instance.mTileDungeon);
-    }
-    if (i & Bit(4)) {
-      world.GetTerrain().GenSetTile(p.Right(), instance.mTileDungeon);
-    }
-    if (i & Bit(5)) {
-      world.GetTerrain().GenSetTile(p.BottomLeft(), instance.mTileDungeon);
-    }
-    if (i & Bit(6)) {
-      world.GetTerrain().GenSetTile(p.Bottom(), instance.mTileDungeon);
-    }
-    if (i & Bit(7)) {
-      world.GetTerrain().GenSetTile(p.BottomRight(), instance.mTileDungeon);
+      if (i & Bit(0)) {
+        world.GetTerrain().GenSetTile(p.TopLeft(), instance.mTileDungeon);
+      }
+      if (i & Bit(1)) {
+        world.GetTerrain().GenSetTile(p.Top(), instance.mTileDungeon);
+      }
+      if (i & Bit(2)) {
+        world.GetTerrain().GenSetTile(p.TopRight(), instance.mTileDungeon);
+      }
+      if (i & Bit(3)) {
+        world.GetTerrain().GenSetTile(p.Left(), instance.mTileDungeon);
+      }
+      if (i & Bit(4)) {
+        world.GetTerrain().GenSetTile(p.Right(), instance.mTileDungeon);
+      }
+      if (i & Bit(5)) {
+        world.GetTerrain().GenSetTile(p.BottomLeft(), instance.mTileDungeon);
+      }
+      if (i & Bit(6)) {
+        world.GetTerrain().GenSetTile(p.Bottom(), instance.mTileDungeon);
+      }
+      if (i & Bit(7)) {
+        world.GetTerrain().GenSetTile(p.BottomRight(), instance.mTileDungeon);
+      }
     }
-  }
 #endif
+  }
 
   sw.Stop();
   f64 seconds = sw.fs();
@@ -1,4 +1,6 @@
 #include "moveable.hpp"
+#include <algorithm>
+#include <vector>
 #include <dutil/misc.hpp>
 #include <dutil/stopwatch.hpp>
 #include "game/world.hpp"
@@ -10,25 +12,13 @@ namespace dib::game {
 bool
 MoveableIncrement::ToBytes(alflib::RawMemoryWriter& mw) const
 {
-  mw.Write(horizontal_velocity);
-  mw.Write(vertical_velocity);
-  mw.Write(jumping);
-  mw.Write(position.x);
-  mw.Write(position.y);
-  return mw.Write(input);
+  return Serializer<MoveableIncrement>::Write(mw, *this);
 }
 
 MoveableIncrement
 MoveableIncrement::FromBytes(alflib::RawMemoryReader& mr)
 {
-  MoveableIncrement data{};
-  data.horizontal_velocity = mr.Read<f32>();
-  data.vertical_velocity = mr.Read<f32>();
-  data.jumping = mr.Read<u8>();
-  data.position.x = mr.Read<f32>();
-  data.position.y = mr.Read<f32>();
-  data.input = mr.Read<PlayerInput>();
-  return data;
+  return Serializer<MoveableIncrement>::Read(mr);
 }
 
 // ============================================================ //
@@ -48,6 +38,13 @@ Moveable::ToIncrement() const
 void
 Moveable::FromIncrement(const MoveableIncrement& m)
 {
+  // clients send increments even when idle, so only a change wakes it up
+  if (horizontal_velocity != m.horizontal_velocity ||
+      vertical_velocity != m.vertical_velocity ||
+      position.x != m.position.x || position.y != m.position.y ||
+      input != m.input) {
+    sleeping = 0;
+  }
   horizontal_velocity = m.horizontal_velocity;
   vertical_velocity = m.vertical_velocity;
   jumping = m.jumping;
@@ -58,37 +55,13 @@ Moveable::FromIncrement(const MoveableIncrement& m)
 bool
 Moveable::ToBytes(alflib::RawMemoryWriter& mw) const
 {
-  mw.Write(horizontal_velocity);
-  mw.Write(vertical_velocity);
-  mw.Write(velocity_input);
-  mw.Write(velocity_max);
-  mw.Write(velocity_jump);
-  mw.Write(jumping);
-  mw.Write(position.x);
-  mw.Write(position.y);
-  mw.Write(input);
-  mw.Write(width);
-  mw.Write(height);
-  return mw.Write(collideable);
+  return Serializer<Moveable>::Write(mw, *this);
 }
 
 Moveable
 Moveable::FromBytes(alflib::RawMemoryReader& mr)
 {
-  Moveable data{};
-  data.horizontal_velocity = mr.Read<f32>();
-  data.vertical_velocity = mr.Read<f32>();
-  data.velocity_input = mr.Read<f32>();
-  data.velocity_max = mr.Read<f32>();
-  data.velocity_jump = mr.Read<decltype(velocity_jump)>();
-  data.jumping = mr.Read<decltype(jumping)>();
-  data.position.x = mr.Read<f32>();
-  data.position.y = mr.Read<f32>();
-  data.input = mr.Read<PlayerInput>();
-  data.width = mr.Read<f32>();
-  data.height = mr.Read<f32>();
-  data.collideable = mr.Read<Collideable>();
-  return data;
+  return Serializer<Moveable>::Read(mr);
 }
 
 // ============================================================ //
@@ -295,6 +268,50 @@ UpdateMoveable(const World& world, const f64 delta, Moveable& moveable)
   SimulateMoveable(world, delta, moveable);
 }
 
+/**
+ * Update the moveable unless it is sleeping, and put it to sleep once it
+ * rests on the ground.
+ */
+static void
+StepMoveable(const World& world, const f64 delta, Moveable& moveable)
+{
+  if (moveable.sleeping) {
+    if (!moveable.input.Any()) {
+      return;
+    }
+    moveable.sleeping = 0;
+  }
+
+  UpdateMoveable(world, delta, moveable);
+
+  if (moveable.horizontal_velocity == 0.0f &&
+      moveable.vertical_velocity == 0.0f && !moveable.input.Any() &&
+      OnGround(world, moveable)) {
+    moveable.sleeping = 1;
+    moveable.rest_sent = 0;
+  }
+}
+
+// ============================================================ //
+
+void
+MoveableWaker::OnTileChanged(const WorldPos pos)
+{
+  OnRegionChanged(pos, pos);
+}
+
+void
+MoveableWaker::OnRegionChanged(const WorldPos min, const WorldPos max)
+{
+  // widened by a pixel so that the tile right below the feet is included
+  WakeMoveables(
+    *world_,
+    Position{ TileToMeter(min.X()) - kPixelInMeter,
+              TileToMeter(min.Y()) - kPixelInMeter },
+    Position{ TileToMeter(max.X() + 1) + kPixelInMeter,
+              TileToMeter(max.Y() + 1) + kPixelInMeter });
+}
+
 // ============================================================ //
 
 void
@@ -302,33 +319,109 @@ UpdateMoveables(World& world, const f64 delta)
 {
   MICROPROFILE_SCOPEI("player", "simulate moveables", MP_PURPLE);
   auto& registry = world.GetEntityManager().GetRegistry();
+  auto& spatial_grid = world.GetSpatialGrid();
+  Position min, max;
 
   if constexpr (kSide == Side::kClient) {
     auto view = registry.view<Moveable>();
     for (const auto entity : view) {
       MICROPROFILE_SCOPEI("player", "simulate moveable", MP_PURPLE1);
       Moveable& moveable = view.get(entity);
-      UpdateMoveable(world, delta, moveable);
+      StepMoveable(world, delta, moveable);
+      MoveableBounds(moveable, min, max);
+      spatial_grid.Update(entity, min, max);
     }
+    spatial_grid.RemoveUntouched();
   } else {
     auto view = registry.view<PlayerData, Moveable>();
-    Packet packet{};
-    world.GetNetwork().GetPacketHandler().BuildPacketHeader(
-      packet, PacketHeaderStaticTypes::kPlayerIncrement);
-    auto mw = packet.GetMemoryWriter();
-    mw->Write(static_cast<u32>(view.size()));
     for (const auto entity : view) {
       MICROPROFILE_SCOPEI("player", "simulate moveable", MP_PURPLE1);
       Moveable& moveable = view.get<Moveable>(entity);
       // TODO do we need to simulate on server?
-      UpdateMoveable(world, delta, moveable);
-      mw->Write(moveable.ToIncrement());
-      mw->Write(view.get<PlayerData>(entity).uuid);
+      StepMoveable(world, delta, moveable);
+      MoveableBounds(moveable, min, max);
+      spatial_grid.Update(entity, min, max);
     }
-    mw.Finalize();
+    spatial_grid.RemoveUntouched();
+
+    // each player only gets the increments of the players close to them,
+    // and sleeping players are only sent once after falling asleep
+    MoveableBroadcast& broadcast = world.GetMoveableBroadcast();
+    const auto send_increments = [&]() {
+      MICROPROFILE_SCOPEI("player", "send moveable increments", MP_PURPLE2);
+      Packet packet{};
+      world.GetNetwork().GetPacketHandler().BuildPacketHeader(
+        packet, PacketHeaderStaticTypes::kPlayerIncrement);
+      const auto resting = [&](const Entity entity) {
+        const Moveable& moveable = view.get<Moveable>(entity);
+        return moveable.sleeping && moveable.rest_sent &&
+               (broadcast.count + static_cast<u32>(entity)) %
+                   kSleepingRefreshInterval !=
+                 0;
+      };
+      std::vector<Entity> nearby{};
+      for (const auto entity : view) {
+        const Moveable& moveable = view.get<Moveable>(entity);
+        nearby.clear();
+        spatial_grid.QueryRadius(moveable.position, kInterestRadius, nearby);
+        nearby.erase(std::remove_if(nearby.begin(), nearby.end(), resting),
+                     nearby.end());
+        if (nearby.empty()) {
+          continue;
+        }
+
+        // increments and uuids are of fixed size, so grow the packet once
+        constexpr std::size_t kEntrySize =
+          Serializer<MoveableIncrement>::kFixedSize +
+          Serializer<Uuid>::kFixedSize;
+        packet.ClearPayload();
+        packet.ReservePayload(sizeof(u32) + nearby.size() * kEntrySize);
+        auto mw = packet.GetMemoryWriter();
+        mw->Write(static_cast<u32>(nearby.size()));
+        for (const auto other : nearby) {
+          mw->Write(view.get<Moveable>(other).ToIncrement());
+          mw->Write(view.get<PlayerData>(other).uuid);
+        }
+        mw.Finalize();
+        world.GetNetwork().PacketUnicast(
+          packet, view.get<PlayerData>(entity).connection_id);
+      }
 
-    dutil::FixedTimeUpdate(
-      60, [&]() { world.GetNetwork().PacketBroadcast(packet); });
+      for (const auto entity : view) {
+        Moveable& moveable = view.get<Moveable>(entity);
+        if (moveable.sleeping) {
+          moveable.rest_sent = 1;
+        }
+      }
+      broadcast.count++;
+    };
+
+    if (broadcast.simulated_time) {
+      // at most once a tick, when the simulated time enters a new interval
+      broadcast.ticks++;
+      const f64 time = static_cast<f64>(broadcast.ticks) * delta;
+      const auto interval = static_cast<u64>(time * kBroadcastRate + 1e-6);
+      if (interval != broadcast.interval) {
+        broadcast.interval = interval;
+        send_increments();
+      }
+    } else {
+      dutil::FixedTimeUpdate(kBroadcastRate, send_increments);
+    }
+  }
+}
+
+void
+WakeMoveables(World& world, const Position min, const Position max)
+{
+  auto& registry = world.GetEntityManager().GetRegistry();
+  std::vector<Entity> entities{};
+  world.GetSpatialGrid().QueryRect(min, max, entities);
+  for (const auto entity : entities) {
+    // the grid may still hold entities that were destroyed this frame
+    if (registry.valid(entity) && registry.has<Moveable>(entity)) {
+      registry.get<Moveable>(entity).sleeping = 0;
+    }
   }
 }
 
@@ -337,6 +430,7 @@ ForceOnMoveable(Moveable& moveable,
                 const f32 horizontal_force,
                 const f32 vertical_force)
 {
+  moveable.sleeping = 0;
   moveable.horizontal_velocity += horizontal_force;
   moveable.vertical_velocity += vertical_force;
 }
@@ -354,4 +448,96 @@ ApplyMoveableIncrement(Moveable& moveable,
     moveable.FromIncrement(increment);
   }
 }
+
+// ============================================================ //
+
+bool
+WriteIncrements(BitWriter& bw,
+                const MoveableIncrement* increments,
+                const u32 count)
+{
+  // gather each field, so that it is quantized in one pass
+  std::vector<f32> values(count);
+  const auto WriteField = [&](const auto get,
+                              const f32 min,
+                              const f32 max,
+                              const u32 bits) {
+    for (u32 i = 0; i < count; i++) {
+      values[i] = get(increments[i]);
+    }
+    return bw.WriteQuantized(values.data(), count, min, max, bits);
+  };
+
+  bool ok =
+    WriteField([](const MoveableIncrement& m) { return m.horizontal_velocity; },
+               -kIncrementVelocityLimit,
+               kIncrementVelocityLimit,
+               kIncrementVelocityBits) &&
+    WriteField([](const MoveableIncrement& m) { return m.vertical_velocity; },
+               -kIncrementVelocityLimit,
+               kIncrementVelocityLimit,
+               kIncrementVelocityBits) &&
+    WriteField([](const MoveableIncrement& m) { return m.position.x; },
+               0.0f,
+               kIncrementPositionLimit,
+               kIncrementPositionBits) &&
+    WriteField([](const MoveableIncrement& m) { return m.position.y; },
+               0.0f,
+               kIncrementPositionLimit,
+               kIncrementPositionBits);
+  for (u32 i = 0; i < count && ok; i++) {
+    ok = bw.WriteBool(increments[i].jumping != 0) &&
+         bw.WriteBits(increments[i].input.GetBits(), PlayerInput::kBitCount);
+  }
+  return ok;
+}
+
+bool
+ReadIncrements(BitReader& br, MoveableIncrement* increments, const u32 count)
+{
+  std::vector<f32> values(count);
+  const auto ReadField = [&](const auto set,
+                             const f32 min,
+                             const f32 max,
+                             const u32 bits) {
+    br.ReadQuantized(values.data(), count, min, max, bits);
+    for (u32 i = 0; i < count; i++) {
+      set(increments[i], values[i]);
+    }
+  };
+
+  ReadField(
+    [](MoveableIncrement& m, const f32 v) { m.horizontal_velocity = v; },
+    -kIncrementVelocityLimit,
+    kIncrementVelocityLimit,
+    kIncrementVelocityBits);
+  ReadField([](MoveableIncrement& m, const f32 v) { m.vertical_velocity = v; },
+            -kIncrementVelocityLimit,
+            kIncrementVelocityLimit,
+            kIncrementVelocityBits);
+  ReadField([](MoveableIncrement& m, const f32 v) { m.position.x = v; },
+            0.0f,
+            kIncrementPositionLimit,
+            kIncrementPositionBits);
+  ReadField([](MoveableIncrement& m, const f32 v) { m.position.y = v; },
+            0.0f,
+            kIncrementPositionLimit,
+            kIncrementPositionBits);
+  for (u32 i = 0; i < count; i++) {
+    increments[i].jumping = br.ReadBool() ? 1 : 0;
+    increments[i].input = PlayerInput::FromBits(
+      static_cast<u8>(br.ReadBits(PlayerInput::kBitCount)));
+  }
+  return !br.HasError();
+}
+
+void
+MoveableBounds(const Moveable& moveable, Position& min, Position& max)
+{
+  CollideableBounds(moveable.collideable, moveable.position, min, max);
+  min.x = std::min(min.x, moveable.position.x - moveable.width / 2.0f);
+  max.x = std::max(max.x, moveable.position.x + moveable.width / 2.0f);
+  max.y = std::max(max.y, moveable.position.y + moveable.height);
+}
+
 }
@@ -4,7 +4,10 @@
 #include <alflib/memory/raw_memory_writer.hpp>
 #include <alflib/memory/raw_memory_reader.hpp>
 #include "game/physics/units.hpp"
+#include "game/terrain.hpp"
 #include "core/types.hpp"
+#include "core/schema.hpp"
+#include "core/bit_stream.hpp"
 #include "game/physics/collideable.hpp"
 #include "game/gameplay/player.hpp"
 
@@ -23,15 +26,26 @@ struct MoveableIncrement
 {
   f32 horizontal_velocity;
   f32 vertical_velocity;
-  u8 jumping : 1;
+  u8 jumping;
   Position position;
   PlayerInput input;
 
+  static constexpr auto GetSchema()
+  {
+    return MakeSchema(&MoveableIncrement::horizontal_velocity,
+                      &MoveableIncrement::vertical_velocity,
+                      &MoveableIncrement::jumping,
+                      &MoveableIncrement::position,
+                      &MoveableIncrement::input);
+  }
+
   bool ToBytes(alflib::RawMemoryWriter& mw) const;
 
   static MoveableIncrement FromBytes(alflib::RawMemoryReader& mr);
 };
 #pragma pack(pop)
+static_assert(decltype(MoveableIncrement::GetSchema())::kIsBytes,
+              "increments are sent often and should be copied as bytes");
 
 // ============================================================ //
 
@@ -53,7 +67,19 @@ struct Moveable
   f32 velocity_input;
   f32 velocity_max;
   f32 velocity_jump;
-  u8 jumping : 1;
+  u8 jumping;
+
+  /**
+   * Set when the moveable rests on the ground without velocity or input, in
+   * which case it is not simulated until it is woken up.
+   */
+  u8 sleeping : 1;
+
+  /**
+   * Set when the resting state has been broadcast by the server, after which
+   * the moveable is left out of the increments.
+   */
+  u8 rest_sent : 1;
 
   /**
    * position is specified in meters
@@ -81,12 +107,106 @@ struct Moveable
 
   void FromIncrement(const MoveableIncrement& m);
 
+  /**
+   * Sleeping and rest_sent are local to each side and not serialized.
+   */
+  static constexpr auto GetSchema()
+  {
+    return MakeSchema(&Moveable::horizontal_velocity,
+                      &Moveable::vertical_velocity,
+                      &Moveable::velocity_input,
+                      &Moveable::velocity_max,
+                      &Moveable::velocity_jump,
+                      &Moveable::jumping,
+                      &Moveable::position,
+                      &Moveable::input,
+                      &Moveable::width,
+                      &Moveable::height,
+                      &Moveable::collideable);
+  }
+
   bool ToBytes(alflib::RawMemoryWriter& mw) const;
 
   static Moveable FromBytes(alflib::RawMemoryReader& mr);
 };
 #pragma pack(pop)
 
+// ============================================================ //
+// Constants
+// ============================================================ //
+
+/**
+ * Server only sends moveable increments of moveables within this distance
+ * of the receiving player, specified in meters.
+ */
+constexpr f32 kInterestRadius = TileToMeter(96);
+
+/**
+ * Sleeping moveables are still sent once every this many increments, so that
+ * players that were out of range when they fell asleep see where they are.
+ */
+constexpr u32 kSleepingRefreshInterval = 60;
+
+/**
+ * Number of times per second that the server broadcasts moveable increments.
+ */
+constexpr u32 kBroadcastRate = 60;
+
+/**
+ * Range and precision of the bit packed increments. Velocities are in m/s
+ * and positions in meters, both are quantized finer than a pixel.
+ */
+constexpr f32 kIncrementVelocityLimit = 64.0f;
+constexpr u32 kIncrementVelocityBits = 16;
+constexpr f32 kIncrementPositionLimit = TileToMeter(32768);
+constexpr u32 kIncrementPositionBits = 23;
+
+// ============================================================ //
+// Classes
+// ============================================================ //
+
+/**
+ * Wakes up the sleeping moveables whose bounds overlap a changed tile, so
+ * that they fall when the ground below them is removed.
+ */
+class MoveableWaker : public Terrain::ChangeListener
+{
+public:
+  explicit MoveableWaker(World* world)
+      : world_(world)
+  {}
+
+  void OnResize(u32, u32) override {}
+
+  void OnTileChanged(WorldPos pos) override;
+
+  void OnWallChanged(WorldPos) override {}
+
+  void OnRegionChanged(WorldPos min, WorldPos max) override;
+
+private:
+  World* world_;
+};
+
+/**
+ * State of the broadcast of moveable increments from the server, one for
+ * each world.
+ */
+struct MoveableBroadcast
+{
+  /** Number of broadcasts sent, staggers the refreshes of sleeping
+   * moveables. */
+  u32 count{ 0 };
+  /** Broadcast on simulated time, the number of ticks times their fixed
+   * length, instead of on wall-clock time. Set when benchmarking or
+   * replaying, so that runs send the same packets however fast they are. */
+  bool simulated_time{ false };
+  /** Ticks updated with simulated time. */
+  u64 ticks{ 0 };
+  /** Broadcast interval of the last broadcast on simulated time. */
+  u64 interval{ 0 };
+};
+
 // ============================================================ //
 // Functions
 // ============================================================ //
@@ -97,9 +217,17 @@ struct Moveable
 void
 UpdateMoveables(World& world, f64 delta);
 
+/**
+ * Wake up all sleeping moveables whose bounds overlap the rectangle.
+ * @param min Bottom left corner, in meters.
+ * @param max Top right corner, in meters.
+ */
+void
+WakeMoveables(World& world, Position min, Position max);
+
 /**
  * Apply a force to a moveable. This means, instantly, modifying the entities
- * velocity.
+ * velocity. Wakes the moveable up.
  */
 void
 ForceOnMoveable(Moveable& moveable, f32 horizontal_force, f32 vertical_force);
@@ -112,6 +240,32 @@ ApplyMoveableIncrement(Moveable& moveable,
                        MoveableIncrement increment,
                        bool is_our_moveable);
 
+/**
+ * Write @count increments bit packed, in a little over half the bytes of the
+ * raw ones. Each field is written for all increments before the next, so that
+ * the fields are quantized in bulk.
+ * @return False if they do not fit.
+ */
+bool
+WriteIncrements(BitWriter& bw,
+                const MoveableIncrement* increments,
+                u32 count);
+
+/**
+ * Read @count increments written by WriteIncrements.
+ * @return False if the data was not valid.
+ */
+bool
+ReadIncrements(BitReader& br, MoveableIncrement* increments, u32 count);
+
+/**
+ * Get the bounds of the moveable and its collideable, in meters. Used for the
+ * spatial grid, which the contact detector relies on to find every entity
+ * whose collideable can overlap a rect.
+ */
+void
+MoveableBounds(const Moveable& moveable, Position& min, Position& max);
+
 /**
  * To be removed when players can be created and stored in a better way.
  */
@@ -1,13 +1,17 @@
 #include "player.hpp"
 
 #include "game/physics/units.hpp"
+#if !defined(DIB_IS_BOT)
 #include "game/client/game_client.hpp"
+#endif
 #include "game/gameplay/moveable.hpp"
+#include "game/world.hpp"
 #include <microprofile/microprofile.h>
 #include <dutil/stopwatch.hpp>
 
 namespace dib::game {
 
+#if !defined(DIB_IS_BOT)
 void
 Player::Update(GameClient& game, [[maybe_unused]] const f64 delta)
 {
@@ -32,18 +36,22 @@ Player::Update(GameClient& game, [[maybe_unused]] const f64 delta)
         moveable.input.ActionJump();
       }
 
-      dutil::FixedTimeUpdate(60, [&]() {
-        Packet packet{};
-        const auto& packet_handler = network.GetPacketHandler();
-        packet_handler.BuildPacketHeader(
-          packet, PacketHeaderStaticTypes::kPlayerIncrement);
-        auto mw = packet.GetMemoryWriter();
-        mw->Write(moveable.ToIncrement());
-        mw.Finalize();
-        network.PacketBroadcast(packet);
-      });
+      dutil::FixedTimeUpdate(60, [&]() { SendIncrement(world, moveable); });
     }
   }
 }
+#endif
+
+void
+Player::SendIncrement(World& world, const Moveable& moveable)
+{
+  auto& network = world.GetNetwork();
+  Packet packet{};
+  const auto& packet_handler = network.GetPacketHandler();
+  packet_handler.BuildPacketHeader(packet,
+                                   PacketHeaderStaticTypes::kPlayerIncrement);
+  packet.WritePayload(moveable.ToIncrement());
+  network.PacketBroadcast(packet);
+}
 
 }
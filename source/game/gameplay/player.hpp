@@ -4,39 +4,54 @@
 #include <alflib/memory/raw_memory_writer.hpp>
 #include <alflib/memory/raw_memory_reader.hpp>
 #include "core/types.hpp"
-#include <bitset>
+#include "core/schema.hpp"
 
 namespace dib::game {
 
 class GameClient;
+class World;
+struct Moveable;
 
 class PlayerInput
 {
 public:
-  bool Left() const { return b_[kLeft]; }
-  bool Right() const { return b_[kRight]; }
-  bool Jump() const { return b_[kJump]; }
+  bool Left() const { return (b_ & kLeft) != 0; }
+  bool Right() const { return (b_ & kRight) != 0; }
+  bool Jump() const { return (b_ & kJump) != 0; }
+  bool Any() const { return b_ != 0; }
 
-  void ActionLeft() { b_.set(kLeft); }
-  void ActionRight() { b_.set(kRight); }
-  void ActionJump() { b_.set(kJump); }
+  void ActionLeft() { b_ |= kLeft; }
+  void ActionRight() { b_ |= kRight; }
+  void ActionJump() { b_ |= kJump; }
 
-private:
-  static constexpr u32 kLeft = 0;
-  static constexpr u32 kRight = 1;
-  static constexpr u32 kJump = 2;
-  std::bitset<3> b_;
+  bool operator==(const PlayerInput& other) const { return b_ == other.b_; }
+  bool operator!=(const PlayerInput& other) const { return b_ != other.b_; }
 
-public:
-  bool ToBytes(alflib::RawMemoryWriter& mw) const
+  /** Number of input bits, for bit packing. */
+  static constexpr u32 kBitCount = 3;
+
+  u8 GetBits() const { return b_; }
+
+  static PlayerInput FromBits(const u8 bits)
   {
-    return mw.Write(b_.to_ulong());
+    PlayerInput p{};
+    p.b_ = bits & ((1u << kBitCount) - 1);
+    return p;
   }
 
+private:
+  static constexpr u8 kLeft = 1u << 0u;
+  static constexpr u8 kRight = 1u << 1u;
+  static constexpr u8 kJump = 1u << 2u;
+  u8 b_{ 0 };
+
+public:
+  bool ToBytes(alflib::RawMemoryWriter& mw) const { return mw.Write(b_); }
+
   static PlayerInput FromBytes(alflib::RawMemoryReader& mr)
   {
     PlayerInput p{};
-    p.b_ = mr.Read<unsigned long>();
+    p.b_ = mr.Read<u8>();
     return p;
   }
 };
@@ -50,8 +65,22 @@ public:
    */
   static void Update(GameClient& game, const f64 delta);
 
+  /**
+   * Send the state of our moveable to the server.
+   */
+  static void SendIncrement(World& world, const Moveable& moveable);
+
 private:
 };
 }
 
+namespace dib {
+
+/** One byte of input bits. */
+template<>
+struct IsSerializedAsBytes<game::PlayerInput> : std::true_type
+{};
+
+}
+
 #endif // PLAYER_HPP_
@@ -4,6 +4,8 @@
 // Headers
 // ========================================================================== //
 
+#include <array>
+
 #include "game/world.hpp"
 #include "game/terrain.hpp"
 
@@ -13,98 +15,20 @@
 
 namespace dib::game {
 
-u8
-CalculateNeighbourMask(TileVariant* tile, Terrain& terrain, WorldPos pos)
-{
-  //  1 -  2 -   4
-  //  8 -    -  16
-  // 32 - 64 - 128
-
-  u8 mask = 0;
-
-  // Top
-  if (terrain.IsValidPosition(pos.TopLeft()) &&
-      terrain.GetTile(pos.TopLeft()) == tile) {
-    mask |= TileVariant::kTopLeft;
-  }
-  if (terrain.IsValidPosition(pos.Top()) &&
-      terrain.GetTile(pos.Top()) == tile) {
-    mask |= TileVariant::kTop;
-  }
-  if (terrain.IsValidPosition(pos.TopRight()) &&
-      terrain.GetTile(pos.TopRight()) == tile) {
-    mask |= TileVariant::kTopRight;
-  }
-
-  // Center
-  if (terrain.IsValidPosition(pos.Left()) &&
-      terrain.GetTile(pos.Left()) == tile) {
-    mask |= TileVariant::kLeft;
-  }
-  if (terrain.IsValidPosition(pos.Right()) &&
-      terrain.GetTile(pos.Right()) == tile) {
-    mask |= TileVariant::kRight;
-  }
-
-  // Bottom
-  if (terrain.IsValidPosition(pos.BottomLeft()) &&
-      terrain.GetTile(pos.BottomLeft()) == tile) {
-    mask |= TileVariant::kBottomLeft;
-  }
-  if (terrain.IsValidPosition(pos.Bottom()) &&
-      terrain.GetTile(pos.Bottom()) == tile) {
-    mask |= TileVariant::kBottom;
-  }
-  if (terrain.IsValidPosition(pos.BottomRight()) &&
-      terrain.GetTile(pos.BottomRight()) == tile) {
-    mask |= TileVariant::kBottomRight;
-  }
-
-  return mask;
-}
-
-}
-
-// ==========================================================================
-// // TileVariant Implementation
-// ==========================================================================
-// //
-
-namespace dib::game {
-
-TileVariant::TileVariant(const ResourcePath& resourcePath,
-                         const String& translationKey)
-  : Tile(resourcePath, translationKey)
-{}
-
-// --------------------------------------------------------------------------
-// //
-
-u32
-TileVariant::GetResourceIndex(World& world, WorldPos pos)
+/** Build the table that maps a neighbour mask to a resource index **/
+constexpr std::array<u32, 256>
+BuildResourceTable()
 {
-  //  1 -  2 -   4
-  //  8 -    -  16
-  // 32 - 64 - 128
-
-  // A -> 0 * 13 = 0
-  // B -> 1 * 13 = 13
-  // C -> 2 * 13 = 26
-  // D -> 3 * 13 = 39
-  // E -> 4 * 13 = 52
+  constexpr u8 kTopLeft = TileVariant::kTopLeft;
+  constexpr u8 kTop = TileVariant::kTop;
+  constexpr u8 kTopRight = TileVariant::kTopRight;
+  constexpr u8 kLeft = TileVariant::kLeft;
+  constexpr u8 kRight = TileVariant::kRight;
+  constexpr u8 kBottomLeft = TileVariant::kBottomLeft;
+  constexpr u8 kBottom = TileVariant::kBottom;
+  constexpr u8 kBottomRight = TileVariant::kBottomRight;
 
-  Terrain& terrain = world.GetTerrain();
-  u8 mask = CalculateNeighbourMask(this, terrain, pos);
-  u32 index = LookupResourceIndex(mask);
-  return index;
-}
-
-// -------------------------------------------------------------------------- //
-
-u32
-TileVariant::LookupResourceIndex(u8 mask)
-{
-  static u32 resourceTable[256u];
+  std::array<u32, 256> resourceTable{};
 
   // 0.
   resourceTable[0] = 15;
@@ -669,7 +593,101 @@ TileVariant::LookupResourceIndex(u8 mask)
   resourceTable[kBottomRight | kBottom | kBottomLeft | kRight | kLeft |
                 kTopLeft | kTop | kTopRight] = 12;
 
-  return resourceTable[mask];
+  return resourceTable;
 }
 
-}
\ No newline at end of file
+// -------------------------------------------------------------------------- //
+
+/** Resource index for each neighbour mask **/
+static constexpr std::array<u32, 256> kResourceTable = BuildResourceTable();
+static_assert(kResourceTable[0] == 15 && kResourceTable[255] == 12,
+              "Resource table must be built at compile-time");
+
+// -------------------------------------------------------------------------- //
+
+u8
+CalculateNeighbourMask(Terrain& terrain, WorldPos pos)
+{
+  //  1 -  2 -   4
+  //  8 -    -  16
+  // 32 - 64 - 128
+
+  // Gather the three rows around the tile and run the row kernel on the single
+  // tile. Positions outside the terrain never match
+  TileRegistry::TileID above[3];
+  TileRegistry::TileID row[3];
+  TileRegistry::TileID below[3];
+  terrain.GatherTileRow(s64(pos.Y()) + 1, pos.X(), 1, above);
+  terrain.GatherTileRow(s64(pos.Y()), pos.X(), 1, row);
+  terrain.GatherTileRow(s64(pos.Y()) - 1, pos.X(), 1, below);
+
+  u8 mask;
+  TileVariant::CalculateNeighbourMasks(above + 1, row + 1, below + 1, 1, &mask);
+  return mask;
+}
+}
+
+// ==========================================================================
+// // TileVariant Implementation
+// ==========================================================================
+// //
+
+namespace dib::game {
+
+TileVariant::TileVariant(const ResourcePath& resourcePath,
+                         const String& translationKey)
+  : Tile(resourcePath, translationKey)
+{}
+
+// --------------------------------------------------------------------------
+// //
+
+u32
+TileVariant::GetResourceIndex(World& world, WorldPos pos)
+{
+  //  1 -  2 -   4
+  //  8 -    -  16
+  // 32 - 64 - 128
+
+  // A -> 0 * 13 = 0
+  // B -> 1 * 13 = 13
+  // C -> 2 * 13 = 26
+  // D -> 3 * 13 = 39
+  // E -> 4 * 13 = 52
+
+  Terrain& terrain = world.GetTerrain();
+  u8 mask = CalculateNeighbourMask(terrain, pos);
+  u32 index = LookupResourceIndex(mask);
+  return index;
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+TileVariant::CalculateNeighbourMasks(const TileRegistry::TileID* above,
+                                     const TileRegistry::TileID* row,
+                                     const TileRegistry::TileID* below,
+                                     u32 count,
+                                     u8* masks)
+{
+  // Branch-free so that the compiler is able to vectorize the loop
+  for (u32 i = 0; i < count; i++) {
+    const TileRegistry::TileID id = row[i];
+    masks[i] = u8((above[i - 1] == id ? kTopLeft : 0u) |
+                  (above[i] == id ? kTop : 0u) |
+                  (above[i + 1] == id ? kTopRight : 0u) |
+                  (row[i - 1] == id ? kLeft : 0u) |
+                  (row[i + 1] == id ? kRight : 0u) |
+                  (below[i - 1] == id ? kBottomLeft : 0u) |
+                  (below[i] == id ? kBottom : 0u) |
+                  (below[i + 1] == id ? kBottomRight : 0u));
+  }
+}
+
+// -------------------------------------------------------------------------- //
+
+u32
+TileVariant::LookupResourceIndex(u8 mask)
+{
+  return kResourceTable[mask];
+}
@@ -5,6 +5,7 @@
 // ========================================================================== //
 
 #include "game/tile/tile.hpp"
+#include "game/tile/tile_registry.hpp"
 
 // ========================================================================== //
 // TileVariant Declaration
@@ -30,7 +31,20 @@ public:
 
   u32 GetResourceIndex(World& world, WorldPos pos) override;
 
-private:
-  u32 LookupResourceIndex(u8 mask);
+  /** Calculate the neighbour masks of a row of tiles from the raw IDs of the
+   * row and the rows above and below it. A bit in the mask is set when the
+   * neighbour has the same ID as the tile itself.
+   *
+   * Each of the rows must be readable one ID before and one ID after the
+   * 'count' IDs, use 'Terrain::GatherTileRow' to retrieve padded rows **/
+  static void CalculateNeighbourMasks(const TileRegistry::TileID* above,
+                                      const TileRegistry::TileID* row,
+                                      const TileRegistry::TileID* below,
+                                      u32 count,
+                                      u8* masks);
+
+  /** Returns the resource index for a neighbour mask. The table is built at
+   * compile-time **/
+  static u32 LookupResourceIndex(u8 mask);
 };
 }
\ No newline at end of file
@@ -0,0 +1,152 @@
+#include "game/palette_array.hpp"
+
+// ========================================================================== //
+// Headers
+// ========================================================================== //
+
+#include <algorithm>
+
+// ========================================================================== //
+// PaletteArray Implementation
+// ========================================================================== //
+
+namespace dib::game {
+
+PaletteArray::PaletteArray(u32 size, u16 value)
+  : mSize(size)
+{
+  mPalette.push_back(value);
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+PaletteArray::Set(u32 index, u16 value)
+{
+  // Find the value in the palette. Palettes are small, a linear search is
+  // faster than a map
+  const auto it = std::find(mPalette.begin(), mPalette.end(), value);
+  u32 paletteIndex = u32(it - mPalette.begin());
+  if (it == mPalette.end()) {
+    if (mPalette.size() >= (u64(1) << mBits)) {
+      Rebuild(1);
+    }
+    paletteIndex = u32(mPalette.size());
+    mPalette.push_back(value);
+  }
+  SetPaletteIndex(index, paletteIndex);
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+PaletteArray::Fill(u16 value)
+{
+  mBits = 0;
+  mPalette.assign(1, value);
+  mData = std::vector<u64>();
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+PaletteArray::Assign(const u16* values)
+{
+  // Build a sorted palette of the distinct values
+  std::vector<u16> palette(values, values + mSize);
+  std::sort(palette.begin(), palette.end());
+  palette.erase(std::unique(palette.begin(), palette.end()), palette.end());
+  if (palette.size() <= 1) {
+    Fill(mSize > 0 ? values[0] : 0);
+    return;
+  }
+
+  // Pack entries
+  mPalette = std::move(palette);
+  mBits = CalculateBits(u32(mPalette.size()));
+  mData.assign((u64(mSize) * mBits + 63) / 64, 0);
+  for (u32 i = 0; i < mSize; i++) {
+    const auto it =
+      std::lower_bound(mPalette.begin(), mPalette.end(), values[i]);
+    SetPaletteIndex(i, u32(it - mPalette.begin()));
+  }
+}
+
+// -------------------------------------------------------------------------- //
+
+u64
+PaletteArray::GetMemoryUsage() const
+{
+  return sizeof(PaletteArray) + mPalette.capacity() * sizeof(u16) +
+         mData.capacity() * sizeof(u64);
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+PaletteArray::SetPaletteIndex(u32 index, u32 paletteIndex)
+{
+  if (mBits == 0) {
+    return;
+  }
+  const u32 bit = index * mBits;
+  const u64 mask = (u64(1) << mBits) - 1;
+  u64& word = mData[bit >> 6u];
+  word = (word & ~(mask << (bit & 63u))) |
+         (u64(paletteIndex) << (bit & 63u));
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+PaletteArray::Rebuild(u32 reserve)
+{
+  // Decode entries
+  std::vector<u16> values(mSize);
+  for (u32 i = 0; i < mSize; i++) {
+    values[i] = Get(i);
+  }
+
+  // Drop unused values from the palette and repack with enough bits for the
+  // reserved values
+  Assign(values.data());
+  const u32 bits = CalculateBits(u32(mPalette.size()) + reserve);
+  if (bits == mBits) {
+    return;
+  }
+  std::vector<u64> data((u64(mSize) * bits + 63) / 64, 0);
+  const u64 mask = (u64(1) << bits) - 1;
+  for (u32 i = 0; i < mSize; i++) {
+    const auto it =
+      std::lower_bound(mPalette.begin(), mPalette.end(), values[i]);
+    const u32 bit = i * bits;
+    data[bit >> 6u] |= (u64(it - mPalette.begin()) & mask) << (bit & 63u);
+  }
+  mBits = bits;
+  mData = std::move(data);
+}
+
+// -------------------------------------------------------------------------- //
+
+u32
+PaletteArray::CalculateBits(u32 paletteSize)
+{
+  if (paletteSize <= 1) {
+    return 0;
+  }
+  if (paletteSize <= 2) {
+    return 1;
+  }
+  if (paletteSize <= 4) {
+    return 2;
+  }
+  if (paletteSize <= 16) {
+    return 4;
+  }
+  if (paletteSize <= 256) {
+    return 8;
+  }
+  return 16;
+}
+
+}
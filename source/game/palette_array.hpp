@@ -0,0 +1,92 @@
+#pragma once
+
+// ========================================================================== //
+// Headers
+// ========================================================================== //
+
+#include <vector>
+
+#include "core/types.hpp"
+
+// ========================================================================== //
+// PaletteArray Declaration
+// ========================================================================== //
+
+namespace dib::game {
+
+/** Fixed-size array of 16-bit values that is compressed with a palette.
+ *
+ * Each entry is stored as an index into a palette of the distinct values of
+ * the array, using as few bits per entry as possible (0, 1, 2, 4, 8 or 16).
+ * The number of bits is a power of two so that an entry never straddles two
+ * words, which keeps decoding to a shift and a mask. An array where every
+ * entry has the same value stores no entries at all, only the palette.
+ *
+ * The palette is not shrunk when values are overwritten. Instead it's compacted
+ * when it would otherwise have to grow to more bits per entry. **/
+class PaletteArray
+{
+private:
+  /** Number of entries **/
+  u32 mSize = 0;
+  /** Number of bits per entry **/
+  u32 mBits = 0;
+  /** Palette of values **/
+  std::vector<u16> mPalette;
+  /** Packed palette indices **/
+  std::vector<u64> mData;
+
+public:
+  /** Construct an array of 'size' entries that are all set to 'value' **/
+  explicit PaletteArray(u32 size = 0, u16 value = 0);
+
+  /** Returns the value of an entry **/
+  [[nodiscard]] u16 Get(u32 index) const
+  {
+    if (mBits == 0) {
+      return mPalette[0];
+    }
+    const u32 bit = index * mBits;
+    const u64 mask = (u64(1) << mBits) - 1;
+    return mPalette[(mData[bit >> 6u] >> (bit & 63u)) & mask];
+  }
+
+  /** Set the value of an entry **/
+  void Set(u32 index, u16 value);
+
+  /** Set all entries to the same value **/
+  void Fill(u16 value);
+
+  /** Set all entries from an array of 'GetSize()' values. This is faster than
+   * setting each of the entries separately **/
+  void Assign(const u16* values);
+
+  /** Returns the number of entries **/
+  [[nodiscard]] u32 GetSize() const { return mSize; }
+
+  /** Returns the number of bits used for each entry **/
+  [[nodiscard]] u32 GetBitsPerEntry() const { return mBits; }
+
+  /** Returns the number of values in the palette **/
+  [[nodiscard]] u32 GetPaletteSize() const { return u32(mPalette.size()); }
+
+  /** Returns the palette. As the palette is not shrunk when values are
+   * overwritten it may contain values that are no longer in use **/
+  [[nodiscard]] const std::vector<u16>& GetPalette() const { return mPalette; }
+
+  /** Returns the number of bytes allocated by the array **/
+  [[nodiscard]] u64 GetMemoryUsage() const;
+
+private:
+  /** Write the palette index of an entry **/
+  void SetPaletteIndex(u32 index, u32 paletteIndex);
+
+  /** Rebuild the palette from the values that are in use, with room for at
+   * least 'reserve' more values, and repack the entries **/
+  void Rebuild(u32 reserve);
+
+  /** Returns the number of bits needed for a palette of the specified size **/
+  static u32 CalculateBits(u32 paletteSize);
+};
+
+}
@@ -2,6 +2,7 @@
 #define COLLIDEABLE_HPP_
 
 #include "core/types.hpp"
+#include "core/schema.hpp"
 #include <alflib/memory/raw_memory_writer.hpp>
 #include <alflib/memory/raw_memory_reader.hpp>
 
@@ -60,15 +61,13 @@ struct Collideable
 
   bool ToBytes(alflib::RawMemoryWriter& mw) const
   {
-    mw.Write(static_cast<u32>(type));
-    return mw.WriteBytes(reserved, kDataSize);
+    return mw.WriteBytes(reinterpret_cast<const u8*>(this), sizeof(*this));
   }
 
   static Collideable FromBytes(alflib::RawMemoryReader& mr)
   {
     Collideable data{};
-    data.type = static_cast<CollisionType>(mr.Read<u32>());
-    std::memcpy(data.reserved, mr.ReadBytes(kDataSize), kDataSize);
+    std::memcpy(&data, mr.ReadBytes(sizeof(data)), sizeof(data));
     return data;
   }
 };
@@ -97,4 +96,12 @@ static_assert(sizeof(Collideable) == sizeof(CollideableRect2));
 
 }
 
+namespace dib {
+
+template<>
+struct IsSerializedAsBytes<game::Collideable> : std::true_type
+{};
+
+}
+
 #endif // COLLIDEABLE_HPP_
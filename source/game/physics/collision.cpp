@@ -1,10 +1,16 @@
 #include "collision.hpp"
 #include "game/world.hpp"
 #include <dutil/misc.hpp>
+#include <algorithm>
 #include <cmath>
 
 namespace dib::game {
 
+/**
+ * Counted per thread, so that counting is a plain increment.
+ */
+static thread_local CollisionQueryCounts query_counts{};
+
 /**
  * Axis-Aligned Bounding Box Collision Detection - Are two boxes colliding?
  */
@@ -142,6 +148,7 @@ CollidesOnPosition(const World& world,
                    const Collideable& collideable,
                    const Position position)
 {
+  query_counts.tile_queries++;
   if (collideable.type == CollisionType::kRect) {
     const auto c = reinterpret_cast<const CollideableRect*>(&collideable);
     return CollidesOnPosition(world, c, position);
@@ -154,6 +161,78 @@ CollidesOnPosition(const World& world,
   }
 }
 
+/**
+ * Put the rectangles of @collideable when on @position in @rects.
+ * @return Number of rectangles.
+ */
+static u32
+CollideableRects(const Collideable& collideable,
+                 const Position position,
+                 CollisionRect (&rects)[2])
+{
+  if (collideable.type == CollisionType::kRect) {
+    const auto c = reinterpret_cast<const CollideableRect*>(&collideable);
+    rects[0] = { position.x, position.y, c->rect.width, c->rect.height };
+    return 1;
+  } else if (collideable.type == CollisionType::kRect2) {
+    const auto c = reinterpret_cast<const CollideableRect2*>(&collideable);
+    rects[0] = { position.x, position.y, c->rect1.width, c->rect1.height };
+    rects[1] = { position.x + c->rect2.x,
+                 position.y + c->rect2.y,
+                 c->rect2.width,
+                 c->rect2.height };
+    return 2;
+  } else {
+    AlfAssert(false, "cannot get rects for given CollisionType");
+    return 0;
+  }
+}
+
+void
+CollideableBounds(const Collideable& collideable,
+                  const Position position,
+                  Position& min,
+                  Position& max)
+{
+  CollisionRect rects[2];
+  const u32 count = CollideableRects(collideable, position, rects);
+  min = position;
+  max = position;
+  for (u32 i = 0; i < count; i++) {
+    min.x = std::min(min.x, rects[i].x);
+    min.y = std::min(min.y, rects[i].y);
+    max.x = std::max(max.x, rects[i].x + rects[i].width);
+    max.y = std::max(max.y, rects[i].y + rects[i].height);
+  }
+}
+
+bool
+CollideablesOverlap(const Collideable& a,
+                    const Position a_position,
+                    const Collideable& b,
+                    const Position b_position)
+{
+  query_counts.overlap_tests++;
+  CollisionRect a_rects[2];
+  CollisionRect b_rects[2];
+  const u32 a_count = CollideableRects(a, a_position, a_rects);
+  const u32 b_count = CollideableRects(b, b_position, b_rects);
+  for (u32 i = 0; i < a_count; i++) {
+    for (u32 j = 0; j < b_count; j++) {
+      if (AABBCollisionDetection(a_rects[i], b_rects[j])) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+CollisionQueryCounts
+GetCollisionQueryCounts()
+{
+  return query_counts;
+}
+
 bool
 OnGround(const World& world, const Moveable& moveable)
 {
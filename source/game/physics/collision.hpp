@@ -28,6 +28,18 @@ struct CollisionInfo
   operator bool() const { return HorizontalCollision() or VerticalCollision(); }
 };
 
+/**
+ * Number of collision queries, see GetCollisionQueryCounts.
+ */
+struct CollisionQueryCounts
+{
+  /** Calls to CollidesOnPosition, each a collideable against the tiles. */
+  u64 tile_queries = 0;
+
+  /** Calls to CollideablesOverlap, each a pair of collideables. */
+  u64 overlap_tests = 0;
+};
+
 /**
  * Is the @collidable colliding with any tiles when on @position?
  */
@@ -36,6 +48,32 @@ CollidesOnPosition(const World& world,
                    const Collideable& collideable,
                    Position position);
 
+/**
+ * Get the bounds of the @collideable when on @position, in meters.
+ */
+void
+CollideableBounds(const Collideable& collideable,
+                  Position position,
+                  Position& min,
+                  Position& max);
+
+/**
+ * Are the two collideables overlapping when on their positions? Touching
+ * edges are not overlapping.
+ */
+bool
+CollideablesOverlap(const Collideable& a,
+                    Position a_position,
+                    const Collideable& b,
+                    Position b_position);
+
+/**
+ * Collision queries made on this thread since it started. Read before and
+ * after a tick to get the queries of the tick.
+ */
+CollisionQueryCounts
+GetCollisionQueryCounts();
+
 /**
  * Is the moveable touching the ground, aka standing, aka not falling.
  */
@@ -0,0 +1,107 @@
+#include "contact_detector.hpp"
+#include "game/world.hpp"
+#include "game/gameplay/moveable.hpp"
+#include "game/physics/collision.hpp"
+#include <microprofile/microprofile.h>
+#include <algorithm>
+
+namespace dib::game {
+
+ContactDetector::ContactDetector(World* world)
+    : world_(world)
+{}
+
+void
+ContactDetector::Update()
+{
+  MICROPROFILE_SCOPEI("physics", "contacts", MP_ORANGE2);
+  auto& registry = world_->GetEntityManager().GetRegistry();
+  auto view = registry.view<Moveable>();
+  const SpatialGrid& spatial_grid = world_->GetSpatialGrid();
+
+  std::swap(pairs_, previous_pairs_);
+  pairs_.clear();
+  Position min, max;
+  for (const auto entity : view) {
+    const Moveable& moveable = view.get(entity);
+    CollideableBounds(moveable.collideable, moveable.position, min, max);
+
+    // broadphase, when both moveables are in the grid each finds the other,
+    // so only the lower entity checks the pair. One that is not in the grid
+    // checks every pair that it finds, since the other one cannot find it
+    candidates_.clear();
+    spatial_grid.QueryRect(min, max, candidates_);
+    const bool in_grid = spatial_grid.Contains(entity);
+    for (const Entity other : candidates_) {
+      if (other == entity || (in_grid && other < entity) ||
+          !registry.valid(other) || !registry.has<Moveable>(other)) {
+        continue;
+      }
+
+      // narrowphase
+      const Moveable& other_moveable = view.get(other);
+      if (CollideablesOverlap(moveable.collideable,
+                              moveable.position,
+                              other_moveable.collideable,
+                              other_moveable.position)) {
+        pairs_.push_back(PairKey(entity, other));
+      }
+    }
+  }
+  std::sort(pairs_.begin(), pairs_.end());
+
+  contacts_.clear();
+  MergePairs();
+  if (!contacts_.empty()) {
+    for (const auto& callback : callbacks_) {
+      callback(*world_, contacts_);
+    }
+  }
+}
+
+void
+ContactDetector::AddCallback(Callback callback)
+{
+  callbacks_.push_back(std::move(callback));
+}
+
+bool
+ContactDetector::IsTouching(const Entity a, const Entity b) const
+{
+  return std::binary_search(pairs_.begin(), pairs_.end(), PairKey(a, b));
+}
+
+u64
+ContactDetector::PairKey(const Entity a, const Entity b)
+{
+  const u64 x = static_cast<u32>(a);
+  const u64 y = static_cast<u32>(b);
+  return x < y ? (x << 32) | y : (y << 32) | x;
+}
+
+void
+ContactDetector::MergePairs()
+{
+  const auto make_contact = [](const u64 key, const ContactPhase phase) {
+    return Contact{ static_cast<Entity>(static_cast<u32>(key >> 32)),
+                    static_cast<Entity>(static_cast<u32>(key)),
+                    phase };
+  };
+
+  auto current = pairs_.begin();
+  auto previous = previous_pairs_.begin();
+  while (current != pairs_.end() || previous != previous_pairs_.end()) {
+    if (previous == previous_pairs_.end() ||
+        (current != pairs_.end() && *current < *previous)) {
+      contacts_.push_back(make_contact(*current++, ContactPhase::kEnter));
+    } else if (current == pairs_.end() || *previous < *current) {
+      contacts_.push_back(make_contact(*previous++, ContactPhase::kExit));
+    } else {
+      contacts_.push_back(make_contact(*current, ContactPhase::kStay));
+      ++current;
+      ++previous;
+    }
+  }
+}
+
+}
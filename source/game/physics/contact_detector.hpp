@@ -0,0 +1,123 @@
+#ifndef CONTACT_DETECTOR_HPP_
+#define CONTACT_DETECTOR_HPP_
+
+#include "core/types.hpp"
+#include "game/physics/units.hpp"
+#include "game/ecs/entity_manager.hpp"
+#include <functional>
+#include <vector>
+
+namespace dib::game {
+
+class World;
+
+// ============================================================ //
+// Structs
+// ============================================================ //
+
+enum class ContactPhase : u8
+{
+  /** The entities started overlapping this tick. */
+  kEnter = 0,
+  /** The entities overlapped last tick and still do. */
+  kStay,
+  /** The entities overlapped last tick but no longer do. */
+  kExit
+};
+
+/**
+ * Two entities whose collideables overlap. The entity with the lowest id is
+ * always @a.
+ */
+struct Contact
+{
+  Entity a;
+  Entity b;
+  ContactPhase phase;
+};
+
+// ============================================================ //
+// Classes
+// ============================================================ //
+
+/**
+ * Finds the overlapping pairs of all moveables once each tick.
+ *
+ * The broadphase queries the spatial grid of the world with the bounds of the
+ * collideable of each moveable, so only entities that are close are compared.
+ * The grid is updated by UpdateMoveables, which runs right before, and its
+ * bounds cover the collideables, see MoveableBounds. A moveable that is not
+ * in the grid is still found by the ones that are, but two such moveables are
+ * never compared. The narrowphase then checks the rectangles of the
+ * collideables against each other.
+ *
+ * The pairs are kept sorted, which lets the pairs of this tick be merged with
+ * the pairs of the last tick in linear time to find the ones that entered,
+ * stayed or exited. All contacts of a tick are handed to the callbacks in a
+ * single batch.
+ */
+class ContactDetector
+{
+public:
+  using Callback =
+    std::function<void(World& world, const std::vector<Contact>& contacts)>;
+
+  // ============================================================ //
+
+  explicit ContactDetector(World* world);
+
+  /**
+   * Find the contacts of this tick and call the callbacks with them.
+   */
+  void Update();
+
+  /**
+   * Add a callback that is called each tick that has any contacts. Exit
+   * contacts can name entities that have been destroyed.
+   */
+  void AddCallback(Callback callback);
+
+  /**
+   * Contacts from the last update.
+   */
+  const std::vector<Contact>& GetContacts() const { return contacts_; }
+
+  /**
+   * Did the collideables of the two entities overlap during the last update?
+   */
+  bool IsTouching(Entity a, Entity b) const;
+
+  std::size_t GetPairCount() const { return pairs_.size(); }
+
+  // ============================================================ //
+
+private:
+  static u64 PairKey(Entity a, Entity b);
+
+  /**
+   * Append the contacts found by merging the pairs of this and last tick.
+   */
+  void MergePairs();
+
+  // ============================================================ //
+
+private:
+  World* world_;
+
+  /** Entities found by the spatial grid for the moveable being checked. */
+  std::vector<Entity> candidates_{};
+
+  /** Sorted keys of the overlapping pairs of this tick. */
+  std::vector<u64> pairs_{};
+
+  /** Sorted keys of the overlapping pairs of the last tick. */
+  std::vector<u64> previous_pairs_{};
+
+  std::vector<Contact> contacts_{};
+
+  std::vector<Callback> callbacks_{};
+};
+
+}
+
+#endif // CONTACT_DETECTOR_HPP_
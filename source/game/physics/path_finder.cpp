@@ -0,0 +1,809 @@
+#include "path_finder.hpp"
+#include "game/world.hpp"
+#include "game/physics/collideable.hpp"
+#include "game/tile/tile_registry.hpp"
+#include <microprofile/microprofile.h>
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <tuple>
+
+namespace dib::game {
+
+PathFinder::PathFinder(World* world)
+    : world_(world)
+{
+  auto closed = std::make_shared<Solid>();
+  closed->bits.fill(~u64{ 0 });
+  closed_ = std::move(closed);
+}
+
+PathFinder::~PathFinder()
+{
+  workers_.reset();
+}
+
+PathFinder::Ticket
+PathFinder::RequestPath(const WorldPos from, const WorldPos to)
+{
+  requested_ = true;
+  const Ticket ticket = next_ticket_++;
+  if (next_ticket_ == 0) {
+    next_ticket_ = 1;
+  }
+  queue_.push_back(Query{ ticket, from, to, changes_ });
+  answers_.insert({ ticket, Answer{ Status::kPending, {} } });
+  return ticket;
+}
+
+PathFinder::Status
+PathFinder::PollPath(const Ticket ticket, std::vector<WorldPos>& path)
+{
+  auto it = answers_.find(ticket);
+  if (it == answers_.end()) {
+    return Status::kUnknown;
+  }
+  const Status status = it->second.status;
+  if (status != Status::kPending) {
+    path = std::move(it.value().path);
+    answers_.erase(it);
+  }
+  return status;
+}
+
+void
+PathFinder::CancelPath(const Ticket ticket)
+{
+  // The query is left in the queue and is skipped once it is reached
+  answers_.erase(ticket);
+}
+
+void
+PathFinder::Update()
+{
+  MICROPROFILE_SCOPEI("PathFinder", "Update", MP_SEAGREEN);
+  if (!requested_) {
+    return;
+  }
+  if (!workers_) {
+    workers_ = std::make_unique<WorkerPool>(WorkerPool::DefaultThreadCount());
+    scratches_.resize(workers_->GetThreadCount() + 1);
+  }
+
+  CollectAnswers();
+
+  // The graphs need the portals of the neighbours, so they are built once
+  // every portal is done, and the snapshot is swapped in after that
+  if (build_ && build_->remaining.load(std::memory_order_acquire) == 0) {
+    if (build_->phase == Build::Phase::kPortals) {
+      build_->phase = Build::Phase::kGraphs;
+      SubmitBuild();
+    }
+  }
+  if (build_ && build_->phase == Build::Phase::kGraphs &&
+      build_->remaining.load(std::memory_order_acquire) == 0) {
+    snapshot_ = std::move(build_->snapshot);
+    build_.reset();
+  }
+  if (!build_ && (!snapshot_ || snapshot_->changes != changes_)) {
+    StartBuild();
+  }
+
+  // Searches keep the snapshot that they started with alive, so a new one
+  // can be swapped in while they run
+  while (snapshot_ && !queue_.empty() &&
+         searches_.size() < kMaxQueriesInFlight) {
+    const Query query = queue_.front();
+    if (query.changes > snapshot_->changes) {
+      break;
+    }
+    queue_.pop_front();
+    if (answers_.find(query.ticket) == answers_.end()) {
+      continue;
+    }
+
+    auto search = std::make_shared<Search>();
+    search->query = query;
+    searches_.push_back(search);
+    workers_->Submit(
+      [this, search, snapshot = snapshot_](const u32 thread) {
+        Answer& answer = search->answer;
+        const bool found = snapshot->FindPath(search->query.from,
+                                              search->query.to,
+                                              answer.path,
+                                              scratches_[thread]);
+        answer.status = found ? Status::kFound : Status::kNotFound;
+        search->done.store(true, std::memory_order_release);
+      });
+  }
+}
+
+bool
+PathFinder::FindPath(const WorldPos from,
+                     const WorldPos to,
+                     std::vector<WorldPos>& path)
+{
+  requested_ = true;
+  path.clear();
+  return snapshot_ &&
+         snapshot_->FindPath(from, to, path, scratches_.back());
+}
+
+bool
+PathFinder::IsStandable(const WorldPos pos) const
+{
+  return snapshot_ && snapshot_->IsStandable(pos);
+}
+
+// ============================================================ //
+
+void
+PathFinder::OnResize(const u32 width, const u32 height)
+{
+  // Searches and builds that are running keep what they use alive, their
+  // results are simply not used
+  width_ = width;
+  height_ = height;
+  cluster_count_x_ = (width + kClusterSize - 1) / kClusterSize;
+  cluster_count_y_ = (height + kClusterSize - 1) / kClusterSize;
+  snapshot_.reset();
+  build_.reset();
+  changes_++;
+
+  cluster_states_.clear();
+  cluster_states_.resize(cluster_count_x_ * cluster_count_y_);
+  dirty_clusters_.clear();
+  changed_clusters_.clear();
+  if (width != 0 && height != 0) {
+    MarkDirty(0, 0, s64{ width } - 1, s64{ height } - 1);
+    MarkChanged(WorldPos{ 0, 0 }, WorldPos{ width - 1, height - 1 });
+  }
+}
+
+void
+PathFinder::OnTileChanged(const WorldPos pos)
+{
+  // The edges of a cell depend on the column on each side of it, from the
+  // longest fall below it to the highest jump above its head
+  changes_++;
+  MarkChanged(pos, pos);
+  const s64 x = pos.X();
+  const s64 y = pos.Y();
+  MarkDirty(x - 1,
+            y - kAgentHeight - kMaxJumpHeight + 1,
+            x + 1,
+            y + kMaxFallHeight + 1);
+}
+
+void
+PathFinder::OnWallChanged(const WorldPos)
+{}
+
+void
+PathFinder::OnRegionChanged(const WorldPos min, const WorldPos max)
+{
+  changes_++;
+  MarkChanged(min, max);
+  MarkDirty(s64{ min.X() } - 1,
+            s64{ min.Y() } - kAgentHeight - kMaxJumpHeight + 1,
+            s64{ max.X() } + 1,
+            s64{ max.Y() } + kMaxFallHeight + 1);
+}
+
+// ============================================================ //
+
+std::shared_ptr<const PathFinder::Solid>
+PathFinder::ReadSolid(const u32 cluster) const
+{
+  const auto& collision_table = TileRegistry::Instance().GetCollisionTable();
+  const PaletteArray& tiles = world_->GetTerrain().GetChunkTiles(
+    cluster % cluster_count_x_, cluster / cluster_count_x_);
+
+  // Most chunks are all sky or all rock, which the palette tells at once
+  bool any_open = false;
+  bool any_solid = false;
+  for (const u16 id : tiles.GetPalette()) {
+    (collision_table[id] != CollisionType::kNone ? any_solid : any_open) =
+      true;
+  }
+  if (!any_solid) {
+    return open_;
+  }
+  if (!any_open) {
+    return closed_;
+  }
+
+  auto solid = std::make_shared<Solid>();
+  for (u32 local = 0; local < kClusterCells; local++) {
+    if (collision_table[tiles.Get(local)] != CollisionType::kNone) {
+      solid->bits[local / 64] |= u64{ 1 } << (local % 64);
+    }
+  }
+  return solid;
+}
+
+void
+PathFinder::StartBuild()
+{
+  auto build = std::make_shared<Build>();
+  if (snapshot_) {
+    build->snapshot = std::make_shared<Snapshot>(*snapshot_);
+  } else {
+    const u32 cluster_count = cluster_count_x_ * cluster_count_y_;
+    build->snapshot = std::make_shared<Snapshot>();
+    build->snapshot->solid.resize(cluster_count);
+    build->snapshot->portals.resize(cluster_count);
+    build->snapshot->graphs.resize(cluster_count);
+  }
+  Snapshot& snapshot = *build->snapshot;
+  snapshot.width = width_;
+  snapshot.height = height_;
+  snapshot.cluster_count_x = cluster_count_x_;
+  snapshot.cluster_count_y = cluster_count_y_;
+  snapshot.changes = changes_;
+
+  for (const u32 cluster : changed_clusters_) {
+    snapshot.solid[cluster] = ReadSolid(cluster);
+    cluster_states_[cluster].changed = false;
+  }
+  changed_clusters_.clear();
+
+  build->clusters = std::move(dirty_clusters_);
+  dirty_clusters_.clear();
+  for (const u32 cluster : build->clusters) {
+    cluster_states_[cluster].dirty = false;
+  }
+
+  // The graph of a cluster has nodes for the portals of its neighbours that
+  // lead into it, so the neighbours must be rebuilt as well
+  for (const u32 cluster : build->clusters) {
+    const s64 cx = cluster % cluster_count_x_;
+    const s64 cy = cluster / cluster_count_x_;
+    for (s64 y = std::max<s64>(cy - 1, 0);
+         y <= std::min<s64>(cy + 1, cluster_count_y_ - 1);
+         y++) {
+      for (s64 x = std::max<s64>(cx - 1, 0);
+           x <= std::min<s64>(cx + 1, cluster_count_x_ - 1);
+           x++) {
+        build->graphs.push_back(static_cast<u32>(y * cluster_count_x_ + x));
+      }
+    }
+  }
+  std::sort(build->graphs.begin(), build->graphs.end());
+  build->graphs.erase(
+    std::unique(build->graphs.begin(), build->graphs.end()),
+    build->graphs.end());
+
+  build_ = std::move(build);
+  SubmitBuild();
+}
+
+void
+PathFinder::SubmitBuild()
+{
+  // Each task writes the parts of its own clusters only, and the tasks keep
+  // the build alive in case it is dropped by a resize
+  const std::vector<u32>& clusters = build_->phase == Build::Phase::kPortals
+                                       ? build_->clusters
+                                       : build_->graphs;
+  const auto count = static_cast<u32>(clusters.size());
+  const u32 task_count = (count + kClustersPerTask - 1) / kClustersPerTask;
+  build_->remaining.store(task_count, std::memory_order_release);
+  for (u32 task = 0; task < task_count; task++) {
+    workers_->Submit([this, build = build_, task, count](const u32 thread) {
+      Snapshot& snapshot = *build->snapshot;
+      const u32 end = std::min(count, (task + 1) * kClustersPerTask);
+      for (u32 i = task * kClustersPerTask; i < end; i++) {
+        if (build->phase == Build::Phase::kPortals) {
+          const u32 cluster = build->clusters[i];
+          snapshot.portals[cluster] =
+            std::make_shared<const Portals>(snapshot.BuildPortals(cluster));
+        } else {
+          const u32 cluster = build->graphs[i];
+          snapshot.graphs[cluster] = std::make_shared<const Graph>(
+            snapshot.BuildGraph(cluster, scratches_[thread]));
+        }
+      }
+      build->remaining.fetch_sub(1, std::memory_order_acq_rel);
+    });
+  }
+}
+
+void
+PathFinder::CollectAnswers()
+{
+  const auto collect = [this](const std::shared_ptr<Search>& search) {
+    if (!search->done.load(std::memory_order_acquire)) {
+      return false;
+    }
+    auto it = answers_.find(search->query.ticket);
+    if (it != answers_.end()) {
+      it.value() = std::move(search->answer);
+    }
+    return true;
+  };
+  searches_.erase(std::remove_if(searches_.begin(), searches_.end(), collect),
+                  searches_.end());
+}
+
+void
+PathFinder::MarkDirty(s64 min_x, s64 min_y, s64 max_x, s64 max_y)
+{
+  min_x = std::max<s64>(min_x, 0);
+  min_y = std::max<s64>(min_y, 0);
+  max_x = std::min<s64>(max_x, s64{ width_ } - 1);
+  max_y = std::min<s64>(max_y, s64{ height_ } - 1);
+  if (min_x > max_x || min_y > max_y) {
+    return;
+  }
+
+  for (s64 cy = min_y / kClusterSize; cy <= max_y / kClusterSize; cy++) {
+    for (s64 cx = min_x / kClusterSize; cx <= max_x / kClusterSize; cx++) {
+      const auto index = static_cast<u32>(cy * cluster_count_x_ + cx);
+      ClusterState& state = cluster_states_[index];
+      if (!state.dirty) {
+        state.dirty = true;
+        dirty_clusters_.push_back(index);
+      }
+    }
+  }
+}
+
+void
+PathFinder::MarkChanged(const WorldPos min, const WorldPos max)
+{
+  if (width_ == 0 || height_ == 0) {
+    return;
+  }
+  const u32 max_x = std::min(max.X(), width_ - 1);
+  const u32 max_y = std::min(max.Y(), height_ - 1);
+  for (u32 cy = min.Y() / kClusterSize; cy <= max_y / kClusterSize; cy++) {
+    for (u32 cx = min.X() / kClusterSize; cx <= max_x / kClusterSize; cx++) {
+      const u32 index = cy * cluster_count_x_ + cx;
+      ClusterState& state = cluster_states_[index];
+      if (!state.changed) {
+        state.changed = true;
+        changed_clusters_.push_back(index);
+      }
+    }
+  }
+}
+
+// ============================================================ //
+
+bool
+PathFinder::Snapshot::IsSolid(const s64 x, const s64 y) const
+{
+  if (x < 0 || y < 0 || x >= width || y >= height) {
+    return true;
+  }
+  const u64 cluster =
+    (y / kClusterSize) * cluster_count_x + x / kClusterSize;
+  const u64 local = (y % kClusterSize) * kClusterSize + x % kClusterSize;
+  return ((solid[cluster]->bits[local / 64] >> (local % 64)) & 1u) != 0;
+}
+
+bool
+PathFinder::Snapshot::IsStandable(const WorldPos pos) const
+{
+  const s64 x = pos.X();
+  const s64 y = pos.Y();
+  for (u32 i = 0; i < kAgentHeight; i++) {
+    if (IsSolid(x, y + i)) {
+      return false;
+    }
+  }
+  return IsSolid(x, y - 1);
+}
+
+void
+PathFinder::Snapshot::GatherEdges(const WorldPos pos,
+                                  std::vector<Edge>& out) const
+{
+  const s64 x = pos.X();
+  const s64 y = pos.Y();
+  for (const s64 nx : { x - 1, x + 1 }) {
+    if (nx < 0 || nx >= width) {
+      continue;
+    }
+
+    // Walk over to the next column and fall until there is ground below
+    bool fits = true;
+    for (u32 i = 0; i < kAgentHeight && fits; i++) {
+      fits = !IsSolid(nx, y + i);
+    }
+    if (fits) {
+      for (u32 d = 0; d <= kMaxFallHeight; d++) {
+        if (IsSolid(nx, y - d - 1)) {
+          out.push_back(Edge{ CellIndex(WorldPos{ static_cast<u32>(nx),
+                                                  static_cast<u32>(y - d) }),
+                              1 + d });
+          break;
+        }
+      }
+      continue;
+    }
+
+    // Jump up onto the first ledge, as long as nothing is above the head
+    for (u32 k = 1; k <= kMaxJumpHeight; k++) {
+      if (IsSolid(x, y + kAgentHeight + k - 1)) {
+        break;
+      }
+      const WorldPos target{ static_cast<u32>(nx), static_cast<u32>(y + k) };
+      if (IsStandable(target)) {
+        out.push_back(Edge{ CellIndex(target), 1 + k });
+        break;
+      }
+    }
+  }
+}
+
+u32
+PathFinder::Snapshot::ClusterOf(const u32 cell) const
+{
+  const WorldPos pos = CellPosition(cell);
+  return (pos.Y() / kClusterSize) * cluster_count_x + pos.X() / kClusterSize;
+}
+
+void
+PathFinder::Snapshot::SearchCluster(const u32 cluster,
+                                    const u32 from,
+                                    Scratch& scratch) const
+{
+  scratch.costs.assign(kClusterCells, kNoCost);
+  scratch.parents.assign(kClusterCells, kNoParent);
+  scratch.heap.clear();
+
+  const auto local_from = static_cast<u16>(LocalIndex(from));
+  scratch.costs[local_from] = 0;
+  scratch.heap.emplace_back(0, local_from);
+
+  const std::greater<std::pair<u32, u16>> order{};
+  while (!scratch.heap.empty()) {
+    std::pop_heap(scratch.heap.begin(), scratch.heap.end(), order);
+    const auto [cost, local] = scratch.heap.back();
+    scratch.heap.pop_back();
+    if (cost > scratch.costs[local]) {
+      continue;
+    }
+
+    scratch.edges.clear();
+    GatherEdges(CellPosition(GlobalIndex(cluster, local)), scratch.edges);
+    for (const Edge& edge : scratch.edges) {
+      if (ClusterOf(edge.target) != cluster) {
+        continue;
+      }
+      const auto next = static_cast<u16>(LocalIndex(edge.target));
+      const u32 next_cost = cost + edge.cost;
+      if (next_cost < scratch.costs[next]) {
+        scratch.costs[next] = next_cost;
+        scratch.parents[next] = local;
+        scratch.heap.emplace_back(next_cost, next);
+        std::push_heap(scratch.heap.begin(), scratch.heap.end(), order);
+      }
+    }
+  }
+}
+
+void
+PathFinder::Snapshot::TracePath(const u32 to,
+                                const Scratch& scratch,
+                                std::vector<WorldPos>& path) const
+{
+  const u32 cluster = ClusterOf(to);
+  const std::size_t begin = path.size();
+  for (u16 local = static_cast<u16>(LocalIndex(to));
+       scratch.parents[local] != kNoParent;
+       local = scratch.parents[local]) {
+    path.push_back(CellPosition(GlobalIndex(cluster, local)));
+  }
+  std::reverse(path.begin() + begin, path.end());
+}
+
+u32
+PathFinder::Snapshot::LocalIndex(const u32 cell) const
+{
+  const WorldPos pos = CellPosition(cell);
+  return (pos.Y() % kClusterSize) * kClusterSize + pos.X() % kClusterSize;
+}
+
+u32
+PathFinder::Snapshot::GlobalIndex(const u32 cluster, const u32 local) const
+{
+  const u32 x = (cluster % cluster_count_x) * kClusterSize +
+                local % kClusterSize;
+  const u32 y = (cluster / cluster_count_x) * kClusterSize +
+                local / kClusterSize;
+  return CellIndex(WorldPos{ x, y });
+}
+
+bool
+PathFinder::Snapshot::Snap(const WorldPos pos, WorldPos& out) const
+{
+  if (pos.X() >= width || pos.Y() >= height) {
+    return false;
+  }
+  for (s64 y = pos.Y(); y >= 0; y--) {
+    if (IsSolid(pos.X(), y)) {
+      return false;
+    }
+    const WorldPos below{ pos.X(), static_cast<u32>(y) };
+    if (IsStandable(below)) {
+      out = below;
+      return true;
+    }
+  }
+  return false;
+}
+
+PathFinder::Portals
+PathFinder::Snapshot::BuildPortals(const u32 cluster) const
+{
+  /** Low-level edge that leaves the cluster. **/
+  struct Crossing
+  {
+    u32 target_cluster;
+    s64 dx;
+    s64 dy;
+    /** Coordinate along the border that the edge crosses. **/
+    u32 fixed;
+    /** Coordinate that consecutive edges along the border differ in. **/
+    u32 varying;
+    u32 source;
+    Edge edge;
+
+    auto Key() const { return std::tie(target_cluster, dx, dy, fixed); }
+  };
+
+  std::vector<Crossing> crossings;
+  std::vector<Edge> edges;
+  for (u32 local = 0; local < kClusterCells; local++) {
+    const u32 x = (cluster % cluster_count_x) * kClusterSize +
+                  local % kClusterSize;
+    const u32 y = (cluster / cluster_count_x) * kClusterSize +
+                  local / kClusterSize;
+    const WorldPos pos{ x, y };
+    if (x >= width || y >= height || !IsStandable(pos)) {
+      continue;
+    }
+
+    edges.clear();
+    GatherEdges(pos, edges);
+    for (const Edge& edge : edges) {
+      const u32 target_cluster = ClusterOf(edge.target);
+      if (target_cluster == cluster) {
+        continue;
+      }
+      const WorldPos target = CellPosition(edge.target);
+      const bool horizontal =
+        x / kClusterSize != target.X() / kClusterSize;
+      crossings.push_back(Crossing{ target_cluster,
+                                    s64{ target.X() } - x,
+                                    s64{ target.Y() } - y,
+                                    horizontal ? x : y,
+                                    horizontal ? y : x,
+                                    CellIndex(pos),
+                                    edge });
+    }
+  }
+
+  std::sort(crossings.begin(),
+            crossings.end(),
+            [](const Crossing& a, const Crossing& b) {
+              return std::make_tuple(a.target_cluster, a.dx, a.dy, a.fixed,
+                                     a.varying) <
+                     std::make_tuple(b.target_cluster, b.dx, b.dy, b.fixed,
+                                     b.varying);
+            });
+
+  // Each run of consecutive crossings is an entrance, the middle crossing of
+  // which becomes the portal
+  Portals portals;
+  std::size_t begin = 0;
+  for (std::size_t i = 1; i <= crossings.size(); i++) {
+    if (i < crossings.size() &&
+        crossings[i].Key() == crossings[i - 1].Key() &&
+        crossings[i].varying == crossings[i - 1].varying + 1) {
+      continue;
+    }
+    const Crossing& middle = crossings[(begin + i - 1) / 2];
+    portals.emplace_back(middle.source, middle.edge);
+    begin = i;
+  }
+  return portals;
+}
+
+PathFinder::Graph
+PathFinder::Snapshot::BuildGraph(const u32 cluster, Scratch& scratch) const
+{
+  // Nodes are the sources of the portals leaving the cluster and the targets
+  // of the portals of the neighbours entering it
+  std::vector<u32> nodes;
+  for (const auto& [source, edge] : *portals[cluster]) {
+    nodes.push_back(source);
+  }
+  const s64 cx = cluster % cluster_count_x;
+  const s64 cy = cluster / cluster_count_x;
+  for (s64 y = std::max<s64>(cy - 1, 0);
+       y <= std::min<s64>(cy + 1, cluster_count_y - 1);
+       y++) {
+    for (s64 x = std::max<s64>(cx - 1, 0);
+         x <= std::min<s64>(cx + 1, cluster_count_x - 1);
+         x++) {
+      const u32 neighbour = static_cast<u32>(y * cluster_count_x + x);
+      if (neighbour == cluster) {
+        continue;
+      }
+      for (const auto& [source, edge] : *portals[neighbour]) {
+        if (ClusterOf(edge.target) == cluster) {
+          nodes.push_back(edge.target);
+        }
+      }
+    }
+  }
+  std::sort(nodes.begin(), nodes.end());
+  nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
+
+  Graph graph;
+  for (const u32 node : nodes) {
+    SearchCluster(cluster, node, scratch);
+    std::vector<Edge> edges;
+    for (const u32 other : nodes) {
+      const u32 cost = scratch.costs[LocalIndex(other)];
+      if (other != node && cost != kNoCost) {
+        edges.push_back(Edge{ other, cost });
+      }
+    }
+    for (const auto& [source, edge] : *portals[cluster]) {
+      if (source == node) {
+        edges.push_back(edge);
+      }
+    }
+    graph.insert({ node, std::move(edges) });
+  }
+  return graph;
+}
+
+bool
+PathFinder::Snapshot::FindPath(const WorldPos from,
+                               const WorldPos to,
+                               std::vector<WorldPos>& path,
+                               Scratch& scratch) const
+{
+  MICROPROFILE_SCOPEI("PathFinder", "FindPath", MP_SEAGREEN);
+  path.clear();
+
+  WorldPos start, goal;
+  if (graphs.empty() || !Snap(from, start) || !Snap(to, goal)) {
+    return false;
+  }
+  const u32 start_cell = CellIndex(start);
+  const u32 goal_cell = CellIndex(goal);
+  const u32 start_cluster = ClusterOf(start_cell);
+  const u32 goal_cluster = ClusterOf(goal_cell);
+  const u32 goal_local = LocalIndex(goal_cell);
+
+  // Most paths are short, try to stay inside of the cluster first
+  SearchCluster(start_cluster, start_cell, scratch);
+  if (start_cluster == goal_cluster && scratch.costs[goal_local] != kNoCost) {
+    path.push_back(start);
+    TracePath(goal_cell, scratch, path);
+    return true;
+  }
+
+  // Connect the start and the goal to the abstract graph of their clusters
+  std::vector<Edge> start_edges;
+  for (const auto& [node, edges] : *graphs[start_cluster]) {
+    const u32 cost = scratch.costs[LocalIndex(node)];
+    if (cost != kNoCost) {
+      start_edges.push_back(Edge{ node, cost });
+    }
+  }
+  tsl::robin_map<u32, u32> goal_costs;
+  for (const auto& [node, edges] : *graphs[goal_cluster]) {
+    SearchCluster(goal_cluster, node, scratch);
+    if (scratch.costs[goal_local] != kNoCost) {
+      goal_costs.insert({ node, scratch.costs[goal_local] });
+    }
+  }
+  if (start_edges.empty() || goal_costs.empty()) {
+    return false;
+  }
+
+  // A* over the abstract graph, where the goal is a virtual node that every
+  // node that can reach the goal inside of its cluster is connected to
+  const auto heuristic = [this, goal](const u32 cell) -> u32 {
+    if (cell == kNoCost) {
+      return 0;
+    }
+    const WorldPos pos = CellPosition(cell);
+    const s64 dx = s64{ pos.X() } - goal.X();
+    const s64 dy = s64{ pos.Y() } - goal.Y();
+    return static_cast<u32>(std::abs(dx) + std::abs(dy));
+  };
+
+  tsl::robin_map<u32, u32> costs;
+  tsl::robin_map<u32, u32> parents;
+  std::vector<std::pair<u32, u32>> open;
+  const std::greater<std::pair<u32, u32>> order{};
+  costs.insert({ start_cell, 0 });
+  open.emplace_back(heuristic(start_cell), start_cell);
+
+  u32 expanded = 0;
+  bool found = false;
+  while (!open.empty()) {
+    std::pop_heap(open.begin(), open.end(), order);
+    const u32 estimate = open.back().first;
+    const u32 node = open.back().second;
+    open.pop_back();
+    const u32 cost = costs.find(node)->second;
+    if (estimate > cost + heuristic(node)) {
+      continue;
+    }
+    if (node == kNoCost) {
+      found = true;
+      break;
+    }
+    if (++expanded > kMaxExpandedNodes) {
+      return false;
+    }
+
+    const auto relax = [&](const u32 target, const u32 edge_cost) {
+      const u32 target_cost = cost + edge_cost;
+      auto it = costs.find(target);
+      if (it == costs.end() || target_cost < it->second) {
+        costs[target] = target_cost;
+        parents[target] = node;
+        open.emplace_back(target_cost + heuristic(target), target);
+        std::push_heap(open.begin(), open.end(), order);
+      }
+    };
+    if (node == start_cell) {
+      for (const Edge& edge : start_edges) {
+        relax(edge.target, edge.cost);
+      }
+    }
+    const Graph& graph = *graphs[ClusterOf(node)];
+    const auto edges = graph.find(node);
+    if (edges != graph.end()) {
+      for (const Edge& edge : edges->second) {
+        relax(edge.target, edge.cost);
+      }
+    }
+    const auto goal_cost = goal_costs.find(node);
+    if (goal_cost != goal_costs.end()) {
+      relax(kNoCost, goal_cost->second);
+    }
+  }
+  if (!found) {
+    return false;
+  }
+
+  // Refine the abstract path. Portals are single steps, every other abstract
+  // edge stays inside of one cluster and is searched again
+  std::vector<u32> nodes{ goal_cell };
+  for (u32 node = parents.find(kNoCost)->second; node != start_cell;
+       node = parents.find(node)->second) {
+    nodes.push_back(node);
+  }
+  nodes.push_back(start_cell);
+  std::reverse(nodes.begin(), nodes.end());
+
+  path.push_back(start);
+  for (std::size_t i = 1; i < nodes.size(); i++) {
+    const u32 cluster = ClusterOf(nodes[i - 1]);
+    if (cluster != ClusterOf(nodes[i])) {
+      path.push_back(CellPosition(nodes[i]));
+      continue;
+    }
+    SearchCluster(cluster, nodes[i - 1], scratch);
+    if (scratch.costs[LocalIndex(nodes[i])] == kNoCost) {
+      path.clear();
+      return false;
+    }
+    TracePath(nodes[i], scratch, path);
+  }
+  return true;
+}
+
+}
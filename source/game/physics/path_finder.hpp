@@ -0,0 +1,395 @@
+#ifndef PATH_FINDER_HPP_
+#define PATH_FINDER_HPP_
+
+#include "core/types.hpp"
+#include "core/worker_pool.hpp"
+#include "game/terrain.hpp"
+#include "game/world_pos.hpp"
+#include <tsl/robin_map.h>
+#include <array>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace dib::game {
+
+class World;
+
+/**
+ * Hierarchical path finding (HPA*) over the terrain for agents that walk,
+ * jump and fall.
+ *
+ * The terrain is divided into square clusters. Low-level edges that cross
+ * from one cluster to another are grouped into runs along the border, and the
+ * middle edge of each run becomes a portal. The abstract graph of a cluster
+ * connects the portal cells inside of it with the cost of the shortest path
+ * between them that stays inside of the cluster. A query searches the
+ * abstract graph and then refines each abstract edge into cells.
+ *
+ * Searches read a snapshot of the terrain and the graphs, which is never
+ * changed once it has been swapped in. Terrain changes mark the nearby
+ * clusters as dirty. During 'Update' the dirty clusters are copied into a new
+ * snapshot, which the workers rebuild while the game goes on, and which is
+ * swapped in once they are done. Queries are queued and handed to the workers
+ * during 'Update', and their answers are picked up by a later 'Update'
+ * without waiting for the workers. A query is not handed out before the
+ * snapshot includes every terrain change made before it was requested.
+ *
+ * Nothing is built until the first query. The solidity of each cluster is
+ * kept as a bitset that is read from the palette of its chunk, and clusters
+ * where every cell is solid, or none is, share a single bitset.
+ *
+ * Positions are the cell that the feet of the agent is in. A cell is
+ * standable if the agent fits in it and the cell below is solid.
+ */
+class PathFinder : public Terrain::ChangeListener
+{
+public:
+  /**
+   * Height of the agent, in tiles.
+   */
+  static constexpr u32 kAgentHeight = 3;
+
+  /**
+   * Highest ledge that the agent can jump up to, in tiles.
+   */
+  static constexpr u32 kMaxJumpHeight = 3;
+
+  /**
+   * Longest drop that the agent is willing to fall, in tiles.
+   */
+  static constexpr u32 kMaxFallHeight = 8;
+
+  /**
+   * Width and height of a cluster, in tiles. Clusters are the chunks of the
+   * terrain, so that their solidity can be read from the chunk palettes.
+   */
+  static constexpr u32 kClusterSize = Terrain::CHUNK_SIZE;
+
+  /**
+   * Number of clusters that each build task handles.
+   */
+  static constexpr u32 kClustersPerTask = 16;
+
+  /**
+   * Maximum number of queries that the workers answer at once.
+   */
+  static constexpr u32 kMaxQueriesInFlight = 64;
+
+  /**
+   * Maximum number of abstract nodes that a query expands before giving up.
+   */
+  static constexpr u32 kMaxExpandedNodes = 1u << 14u;
+
+  using Ticket = u32;
+
+  enum class Status : u8
+  {
+    /** The query has not been answered yet. */
+    kPending = 0,
+    /** A path was found. */
+    kFound,
+    /** There is no path, or the search gave up. */
+    kNotFound,
+    /** The ticket is not known. */
+    kUnknown
+  };
+
+  // ============================================================ //
+
+  explicit PathFinder(World* world);
+
+  /**
+   * Waits for the workers, which use the scratch memory of the finder.
+   */
+  ~PathFinder();
+
+  PathFinder(const PathFinder& other) = delete;
+
+  PathFinder& operator=(const PathFinder& other) = delete;
+
+  /**
+   * Queue a query for a path between two cells.
+   * @return Ticket used to poll for the path.
+   */
+  Ticket RequestPath(WorldPos from, WorldPos to);
+
+  /**
+   * Poll for the result of a query. When the query has been answered the
+   * path is moved to @path and the ticket is forgotten.
+   * @param path Cells from start to goal, including both.
+   */
+  Status PollPath(Ticket ticket, std::vector<WorldPos>& path);
+
+  /**
+   * Forget a query, whether it has been answered or not.
+   */
+  void CancelPath(Ticket ticket);
+
+  /**
+   * Pick up the answers and the snapshot that the workers have finished,
+   * start rebuilding the dirty clusters and hand queued queries to the
+   * workers. Never waits for the workers.
+   */
+  void Update();
+
+  /**
+   * Find a path immediately on the calling thread, in the current snapshot.
+   * @return True if a path was found.
+   */
+  bool FindPath(WorldPos from, WorldPos to, std::vector<WorldPos>& path);
+
+  /**
+   * Is the cell a position that the agent can stand on, in the current
+   * snapshot? False before the first snapshot has been built.
+   */
+  bool IsStandable(WorldPos pos) const;
+
+  std::size_t GetPendingCount() const
+  {
+    return queue_.size() + searches_.size();
+  }
+
+  std::size_t GetDirtyClusterCount() const { return dirty_clusters_.size(); }
+
+  // ============================================================ //
+
+  void OnResize(u32 width, u32 height) override;
+
+  void OnTileChanged(WorldPos pos) override;
+
+  void OnWallChanged(WorldPos pos) override;
+
+  void OnRegionChanged(WorldPos min, WorldPos max) override;
+
+  // ============================================================ //
+
+private:
+  static constexpr u32 kClusterCells = kClusterSize * kClusterSize;
+  static constexpr u32 kNoCost = ~0u;
+  static constexpr u16 kNoParent = 0xFFFF;
+
+  struct Edge
+  {
+    /** Cell index of the target. */
+    u32 target;
+    u32 cost;
+  };
+
+  /**
+   * Whether each cell of a cluster is solid, one bit per cell.
+   */
+  struct Solid
+  {
+    std::array<u64, kClusterCells / 64> bits{};
+  };
+
+  /** Edges that leave a cluster, source is the key. */
+  using Portals = std::vector<std::pair<u32, Edge>>;
+
+  /** Abstract graph of a cluster, keyed by the cell index of each node. */
+  using Graph = tsl::robin_map<u32, std::vector<Edge>>;
+
+  /**
+   * Per-thread memory for searches inside of a single cluster.
+   */
+  struct Scratch
+  {
+    std::vector<u32> costs{};
+    std::vector<u16> parents{};
+    std::vector<std::pair<u32, u16>> heap{};
+    std::vector<Edge> edges{};
+  };
+
+  /**
+   * Everything that a search reads. The parts of each cluster are shared
+   * between snapshots until the cluster is rebuilt.
+   */
+  struct Snapshot
+  {
+    u32 width{ 0 };
+    u32 height{ 0 };
+    u32 cluster_count_x{ 0 };
+    u32 cluster_count_y{ 0 };
+    /** Value of the change counter of the finder when it was taken. */
+    u64 changes{ 0 };
+    std::vector<std::shared_ptr<const Solid>> solid{};
+    std::vector<std::shared_ptr<const Portals>> portals{};
+    std::vector<std::shared_ptr<const Graph>> graphs{};
+
+    bool IsSolid(s64 x, s64 y) const;
+
+    bool IsStandable(WorldPos pos) const;
+
+    /**
+     * Append the low-level edges leaving a standable cell to @out.
+     */
+    void GatherEdges(WorldPos pos, std::vector<Edge>& out) const;
+
+    u32 CellIndex(WorldPos pos) const { return pos.Y() * width + pos.X(); }
+
+    WorldPos CellPosition(u32 index) const
+    {
+      return WorldPos{ index % width, index / width };
+    }
+
+    u32 ClusterOf(u32 cell) const;
+
+    u32 LocalIndex(u32 cell) const;
+
+    u32 GlobalIndex(u32 cluster, u32 local) const;
+
+    /**
+     * Search every standable cell of a cluster from @from, without leaving
+     * the cluster. Costs and parents are written to @scratch.
+     */
+    void SearchCluster(u32 cluster, u32 from, Scratch& scratch) const;
+
+    /**
+     * Append the cells on the path from the source of the last search to
+     * @to, excluding the source.
+     */
+    void TracePath(u32 to,
+                   const Scratch& scratch,
+                   std::vector<WorldPos>& path) const;
+
+    /**
+     * Move a position down onto the ground, for agents that are in the air.
+     */
+    bool Snap(WorldPos pos, WorldPos& out) const;
+
+    Portals BuildPortals(u32 cluster) const;
+
+    /**
+     * Needs the portals of the cluster and of its neighbours.
+     */
+    Graph BuildGraph(u32 cluster, Scratch& scratch) const;
+
+    bool FindPath(WorldPos from,
+                  WorldPos to,
+                  std::vector<WorldPos>& path,
+                  Scratch& scratch) const;
+  };
+
+  /**
+   * Snapshot that the workers are building, first the portals of the dirty
+   * clusters and then the graphs of those and of their neighbours.
+   */
+  struct Build
+  {
+    enum class Phase : u8
+    {
+      kPortals = 0,
+      kGraphs
+    };
+
+    std::shared_ptr<Snapshot> snapshot{};
+    std::vector<u32> clusters{};
+    std::vector<u32> graphs{};
+    Phase phase{ Phase::kPortals };
+    /** Tasks of the phase that have not finished. */
+    std::atomic<u32> remaining{ 0 };
+  };
+
+  struct Query
+  {
+    Ticket ticket;
+    WorldPos from;
+    WorldPos to;
+    /** Value of the change counter when the query was requested. */
+    u64 changes;
+  };
+
+  struct Answer
+  {
+    Status status;
+    std::vector<WorldPos> path;
+  };
+
+  /**
+   * Query that has been handed to the workers.
+   */
+  struct Search
+  {
+    Query query;
+    Answer answer{ Status::kPending, {} };
+    std::atomic<bool> done{ false };
+  };
+
+  struct ClusterState
+  {
+    /** The portals and graphs around the cluster must be rebuilt. */
+    bool dirty{ false };
+    /** Cells of the cluster changed, so its solidity must be read again. */
+    bool changed{ false };
+  };
+
+  // ============================================================ //
+
+  /**
+   * Read the solidity of a cluster from the palette of its chunk.
+   */
+  std::shared_ptr<const Solid> ReadSolid(u32 cluster) const;
+
+  /**
+   * Start building a snapshot with the changes since the current one.
+   */
+  void StartBuild();
+
+  /**
+   * Hand the current phase of the build to the workers.
+   */
+  void SubmitBuild();
+
+  /**
+   * Move the answers of the searches that the workers have finished to the
+   * tickets that are still known.
+   */
+  void CollectAnswers();
+
+  void MarkDirty(s64 min_x, s64 min_y, s64 max_x, s64 max_y);
+
+  void MarkChanged(WorldPos min, WorldPos max);
+
+  // ============================================================ //
+
+private:
+  World* world_;
+
+  u32 width_{ 0 };
+  u32 height_{ 0 };
+  u32 cluster_count_x_{ 0 };
+  u32 cluster_count_y_{ 0 };
+
+  /** Counts the terrain changes, to tell which snapshot includes them. */
+  u64 changes_{ 0 };
+  /** Whether a path has been requested, nothing is built before. */
+  bool requested_{ false };
+
+  std::vector<ClusterState> cluster_states_{};
+  std::vector<u32> dirty_clusters_{};
+  std::vector<u32> changed_clusters_{};
+
+  /** Solidity shared by the clusters where no cell, or every cell, is solid. */
+  std::shared_ptr<const Solid> open_{ std::make_shared<Solid>() };
+  std::shared_ptr<const Solid> closed_{};
+
+  /** Snapshot that searches read, null until the first build is done. */
+  std::shared_ptr<const Snapshot> snapshot_{};
+  std::shared_ptr<Build> build_{};
+
+  Ticket next_ticket_{ 1 };
+  std::deque<Query> queue_{};
+  tsl::robin_map<Ticket, Answer> answers_{};
+  std::vector<std::shared_ptr<Search>> searches_{};
+
+  /** Scratch memory for each worker, the last one is for the caller. */
+  std::vector<Scratch> scratches_ = std::vector<Scratch>(1);
+  /** Created on the first update, the client never updates its finder. */
+  std::unique_ptr<WorkerPool> workers_{};
+};
+
+}
+
+#endif // PATH_FINDER_HPP_
@@ -0,0 +1,138 @@
+#include "spatial_grid.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace dib::game {
+
+void
+SpatialGrid::Update(const Entity entity, const Position min, const Position max)
+{
+  max_extent_.x = std::max(max_extent_.x, max.x - min.x);
+  max_extent_.y = std::max(max_extent_.y, max.y - min.y);
+
+  const u64 cell = CellKey(CellCoord(min.x), CellCoord(min.y));
+  auto it = entries_.find(entity);
+  if (it == entries_.end()) {
+    entries_.insert({ entity, Entry{ cell, min, max, touched_ } });
+    cells_[cell].push_back(entity);
+    return;
+  }
+
+  Entry& entry = it.value();
+  if (entry.cell != cell) {
+    RemoveFromCell(entry.cell, entity);
+    cells_[cell].push_back(entity);
+    entry.cell = cell;
+  }
+  entry.min = min;
+  entry.max = max;
+  entry.touched = touched_;
+}
+
+void
+SpatialGrid::Remove(const Entity entity)
+{
+  const auto it = entries_.find(entity);
+  if (it != entries_.end()) {
+    RemoveFromCell(it->second.cell, entity);
+    entries_.erase(it);
+  }
+}
+
+void
+SpatialGrid::RemoveUntouched()
+{
+  for (auto it = entries_.begin(); it != entries_.end();) {
+    if (it->second.touched != touched_) {
+      RemoveFromCell(it->second.cell, it->first);
+      it = entries_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  touched_++;
+}
+
+void
+SpatialGrid::QueryRect(const Position min,
+                       const Position max,
+                       std::vector<Entity>& out) const
+{
+  // entities are stored by their min corner, so an entity that overlaps the
+  // rect can have its min corner up to max_extent_ below and left of it.
+  const s64 min_x = CellCoord(min.x - max_extent_.x);
+  const s64 min_y = CellCoord(min.y - max_extent_.y);
+  const s64 max_x = CellCoord(max.x);
+  const s64 max_y = CellCoord(max.y);
+
+  for (s64 y = min_y; y <= max_y; y++) {
+    for (s64 x = min_x; x <= max_x; x++) {
+      const auto cell = cells_.find(CellKey(x, y));
+      if (cell == cells_.end()) {
+        continue;
+      }
+      for (const Entity entity : cell->second) {
+        const Entry& entry = entries_.find(entity)->second;
+        if (entry.min.x <= max.x && entry.max.x >= min.x &&
+            entry.min.y <= max.y && entry.max.y >= min.y) {
+          out.push_back(entity);
+        }
+      }
+    }
+  }
+}
+
+void
+SpatialGrid::QueryRadius(const Position center,
+                         const f32 radius,
+                         std::vector<Entity>& out) const
+{
+  const std::size_t first = out.size();
+  QueryRect(Position{ center.x - radius, center.y - radius },
+            Position{ center.x + radius, center.y + radius },
+            out);
+
+  // narrow the rect down to a circle, using the closest point on the bounds
+  const f32 radius_sq = radius * radius;
+  const auto outside = [&](const Entity entity) {
+    const Entry& entry = entries_.find(entity)->second;
+    const f32 dx = center.x - std::clamp(center.x, entry.min.x, entry.max.x);
+    const f32 dy = center.y - std::clamp(center.y, entry.min.y, entry.max.y);
+    return dx * dx + dy * dy > radius_sq;
+  };
+  out.erase(std::remove_if(out.begin() + first, out.end(), outside),
+            out.end());
+}
+
+u64
+SpatialGrid::CellKey(const s64 x, const s64 y)
+{
+  return (static_cast<u64>(static_cast<u32>(x)) << 32) |
+         static_cast<u64>(static_cast<u32>(y));
+}
+
+s64
+SpatialGrid::CellCoord(const f32 meters)
+{
+  return static_cast<s64>(std::floor(meters / kCellSize));
+}
+
+void
+SpatialGrid::RemoveFromCell(const u64 cell, const Entity entity)
+{
+  auto it = cells_.find(cell);
+  if (it == cells_.end()) {
+    return;
+  }
+  auto& entities = it.value();
+  const auto pos = std::find(entities.begin(), entities.end(), entity);
+  if (pos != entities.end()) {
+    *pos = entities.back();
+    entities.pop_back();
+  }
+  if (entities.empty()) {
+    cells_.erase(it);
+  }
+}
+
+}
@@ -0,0 +1,111 @@
+#ifndef SPATIAL_GRID_HPP_
+#define SPATIAL_GRID_HPP_
+
+#include "core/types.hpp"
+#include "game/physics/units.hpp"
+#include "game/ecs/entity_manager.hpp"
+#include <tsl/robin_map.h>
+#include <vector>
+
+namespace dib::game {
+
+/**
+ * Uniform grid over entity bounds, used to find entities close to a position
+ * without looking at every entity in the world.
+ *
+ * Entities are placed in the single cell that contains the minimum corner of
+ * their bounds. Queries are therefore widened by the largest entity size that
+ * has been inserted, which makes the grid "loose" but keeps updates to a
+ * simple cell swap.
+ *
+ * Only cells that contain entities are stored, so the grid does not need to
+ * know the size of the world.
+ */
+class SpatialGrid
+{
+public:
+  /**
+   * Size of a cell, specified in meters.
+   */
+  static constexpr f32 kCellSize = TileToMeter(16);
+
+  // ============================================================ //
+
+  /**
+   * Insert the entity, or move it if it already is in the grid.
+   * @param min Bottom left corner of the entity, in meters.
+   * @param max Top right corner of the entity, in meters.
+   */
+  void Update(Entity entity, Position min, Position max);
+
+  /**
+   * Remove the entity, does nothing if the entity is not in the grid.
+   */
+  void Remove(Entity entity);
+
+  /**
+   * Remove all entities that has not been updated since the last call to
+   * this function. Used to drop entities that have been destroyed without
+   * hooking into the registry.
+   */
+  void RemoveUntouched();
+
+  /**
+   * Append all entities whose bounds overlap the rectangle to @out.
+   */
+  void QueryRect(Position min, Position max, std::vector<Entity>& out) const;
+
+  /**
+   * Append all entities whose bounds are within @radius of @center to @out.
+   */
+  void QueryRadius(Position center,
+                   f32 radius,
+                   std::vector<Entity>& out) const;
+
+  /**
+   * Is the entity in the grid?
+   */
+  bool Contains(Entity entity) const
+  {
+    return entries_.find(entity) != entries_.end();
+  }
+
+  std::size_t GetEntityCount() const { return entries_.size(); }
+
+  std::size_t GetCellCount() const { return cells_.size(); }
+
+  // ============================================================ //
+
+private:
+  struct Entry
+  {
+    u64 cell;
+    Position min;
+    Position max;
+    u32 touched;
+  };
+
+  static u64 CellKey(s64 x, s64 y);
+
+  static s64 CellCoord(f32 meters);
+
+  void RemoveFromCell(u64 cell, Entity entity);
+
+  // ============================================================ //
+
+private:
+  tsl::robin_map<u64, std::vector<Entity>> cells_{};
+
+  tsl::robin_map<Entity, Entry> entries_{};
+
+  /**
+   * Largest width and height of any inserted entity.
+   */
+  Position max_extent_{ 0.0f, 0.0f };
+
+  u32 touched_{ 0 };
+};
+
+}
+
+#endif // SPATIAL_GRID_HPP_
@@ -0,0 +1,152 @@
+#include "game/server/allocation_counter.hpp"
+
+// ========================================================================== //
+// Headers
+// ========================================================================== //
+
+#include <cstdlib>
+#include <new>
+
+// ========================================================================== //
+// Counters
+// ========================================================================== //
+
+namespace {
+
+/** Per thread, so that counting is a plain increment. Trivial types, so
+ * they are usable before any constructor has run **/
+thread_local dib::u64 allocationCount = 0;
+thread_local dib::u64 allocatedBytes = 0;
+
+// -------------------------------------------------------------------------- //
+
+void*
+Allocate(std::size_t size)
+{
+  allocationCount++;
+  allocatedBytes += size;
+  return std::malloc(size > 0 ? size : 1);
+}
+
+// -------------------------------------------------------------------------- //
+
+void*
+AllocateOrThrow(std::size_t size)
+{
+  void* pointer = Allocate(size);
+  while (pointer == nullptr) {
+    std::new_handler handler = std::get_new_handler();
+    if (handler == nullptr) {
+      throw std::bad_alloc();
+    }
+    handler();
+    pointer = std::malloc(size > 0 ? size : 1);
+  }
+  return pointer;
+}
+
+}
+
+// ========================================================================== //
+// Functions
+// ========================================================================== //
+
+namespace dib::game {
+
+u64
+GetAllocationCount()
+{
+  return allocationCount;
+}
+
+// -------------------------------------------------------------------------- //
+
+u64
+GetAllocatedBytes()
+{
+  return allocatedBytes;
+}
+
+}
+
+// ========================================================================== //
+// Global Operators
+// ========================================================================== //
+
+void*
+operator new(std::size_t size)
+{
+  return AllocateOrThrow(size);
+}
+
+// -------------------------------------------------------------------------- //
+
+void*
+operator new[](std::size_t size)
+{
+  return AllocateOrThrow(size);
+}
+
+// -------------------------------------------------------------------------- //
+
+void*
+operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+  return Allocate(size);
+}
+
+// -------------------------------------------------------------------------- //
+
+void*
+operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+  return Allocate(size);
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+operator delete(void* pointer) noexcept
+{
+  std::free(pointer);
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+operator delete[](void* pointer) noexcept
+{
+  std::free(pointer);
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+operator delete(void* pointer, std::size_t) noexcept
+{
+  std::free(pointer);
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+operator delete[](void* pointer, std::size_t) noexcept
+{
+  std::free(pointer);
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+operator delete(void* pointer, const std::nothrow_t&) noexcept
+{
+  std::free(pointer);
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+operator delete[](void* pointer, const std::nothrow_t&) noexcept
+{
+  std::free(pointer);
+}
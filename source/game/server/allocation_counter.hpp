@@ -0,0 +1,25 @@
+#pragma once
+
+// ========================================================================== //
+// Headers
+// ========================================================================== //
+
+#include "core/types.hpp"
+
+// ========================================================================== //
+// Functions
+// ========================================================================== //
+
+namespace dib::game {
+
+/** Allocations made with operator new on this thread since it started. The
+ * server replaces the global operator new to count them, over-aligned
+ * allocations are not counted **/
+u64
+GetAllocationCount();
+
+/** Bytes requested by the allocations of 'GetAllocationCount' **/
+u64
+GetAllocatedBytes();
+
+}
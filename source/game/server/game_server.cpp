@@ -1,14 +1,132 @@
 #include "game/server/game_server.hpp"
 
+// ========================================================================== //
+// Headers
+// ========================================================================== //
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <utility>
+#include <alflib/file/file_io.hpp>
+#include <dutil/stopwatch.hpp>
+#include "core/memory.hpp"
+#include "game/ecs/components/item_data_component.hpp"
+#include "game/ecs/components/npc_data_component.hpp"
+#include "game/ecs/components/player_data_component.hpp"
+#include "game/ecs/components/projectile_data_component.hpp"
+#include "game/ecs/systems/generic_system.hpp"
+#include "game/gameplay/moveable.hpp"
+#include "game/physics/collision.hpp"
+#include "game/server/allocation_counter.hpp"
+#include "network/packet_capture.hpp"
+
 // ========================================================================== //
 // Client Implementation
 // ========================================================================== //
 
 namespace dib::game {
 
-GameServer::GameServer(const AppServer::Descriptor& descriptor)
+namespace {
+
+/** Terrain sizes by their name on the command line **/
+constexpr std::pair<const char8*, Terrain::Size> kTerrainSizes[] = {
+  { "tiny", Terrain::Size::kTiny },     { "small", Terrain::Size::kSmall },
+  { "normal", Terrain::Size::kNormal }, { "large", Terrain::Size::kLarge },
+  { "huge", Terrain::Size::kHuge },
+};
+
+// -------------------------------------------------------------------------- //
+
+const char8*
+TerrainSizeName(Terrain::Size size)
+{
+  for (const auto& [name, value] : kTerrainSizes) {
+    if (value == size) {
+      return name;
+    }
+  }
+  return "unknown";
+}
+
+}
+
+// -------------------------------------------------------------------------- //
+
+GameServer::Descriptor
+GameServer::Descriptor::FromArgs(int argc, char** argv)
+{
+  Descriptor descriptor;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    const char8* option = argv[i];
+    const char8* value = argv[i + 1];
+    if (std::strcmp(option, "--ups") == 0) {
+      descriptor.targetUps = u32(std::strtoul(value, nullptr, 10));
+    } else if (std::strcmp(option, "--capture") == 0) {
+      descriptor.capturePath = value;
+    } else if (std::strcmp(option, "--replay") == 0) {
+      descriptor.replayPath = value;
+    } else if (std::strcmp(option, "--replay-speed") == 0) {
+      descriptor.replaySpeed = std::max(0.0, std::strtod(value, nullptr));
+    } else if (std::strcmp(option, "--metrics-port") == 0) {
+      descriptor.metricsPort = u16(std::strtoul(value, nullptr, 10));
+    } else if (std::strcmp(option, "--world-size") == 0) {
+      bool found = false;
+      for (const auto& [name, size] : kTerrainSizes) {
+        if (std::strcmp(value, name) == 0) {
+          descriptor.worldSize = size;
+          found = true;
+        }
+      }
+      if (!found) {
+        DLOG_WARNING("Unknown world size {}", value);
+      }
+    } else if (std::strcmp(option, "--bench") == 0) {
+      descriptor.benchTicks = u32(std::strtoul(value, nullptr, 10));
+    } else if (std::strcmp(option, "--bench-moveables") == 0) {
+      descriptor.benchMoveables = u32(std::strtoul(value, nullptr, 10));
+    } else if (std::strcmp(option, "--bench-output") == 0) {
+      descriptor.benchOutput = value;
+    } else {
+      DLOG_WARNING("Unknown option {}", option);
+      PrintUsage();
+    }
+  }
+  descriptor.targetUps = std::max(1u, descriptor.targetUps);
+  return descriptor;
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+GameServer::Descriptor::PrintUsage()
+{
+  DLOG_RAW("Options:\n"
+           "  --ups N             updates per second\n"
+           "  --capture FILE      capture the received packets to FILE\n"
+           "  --replay FILE       replay a capture instead of serving\n"
+           "  --replay-speed X    1 replays as captured, 0 as fast as "
+           "possible\n"
+           "  --metrics-port N    serve metrics on localhost:N, 0 to not "
+           "serve them\n"
+           "  --world-size SIZE   tiny, small, normal, large or huge\n"
+           "  --bench N           run N ticks with synthetic players instead "
+           "of serving\n"
+           "  --bench-moveables N number of synthetic players\n"
+           "  --bench-output FILE write the benchmark results as JSON to "
+           "FILE\n");
+}
+
+// -------------------------------------------------------------------------- //
+
+GameServer::GameServer(const Descriptor& descriptor)
   : AppServer(descriptor)
-  , mWorld()
+  , mDescriptor(descriptor)
+  , mWorld(descriptor.worldSize)
   , mModLoader(Path{ "./mods" })
 {
   CoreContent::Setup();
@@ -16,6 +134,30 @@ GameServer::GameServer(const AppServer::Descriptor& descriptor)
   RegisterCommands();
 
   CoreContent::GenerateWorld(mWorld);
+
+  SetupMetrics();
+
+  // A replay or benchmark has no sockets
+  if (IsServing()) {
+    mWorld.GetNetwork().StartServer();
+    if (mDescriptor.capturePath.GetSize() != 0) {
+      mWorld.GetNetwork().StartCapture(Path{ mDescriptor.capturePath });
+    }
+  }
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+GameServer::Run()
+{
+  if (mDescriptor.benchTicks != 0) {
+    RunBench();
+  } else if (mDescriptor.replayPath.GetSize() != 0) {
+    RunReplay();
+  } else {
+    AppServer::Run();
+  }
 }
 
 // -------------------------------------------------------------------------- //
@@ -24,7 +166,86 @@ void
 GameServer::Update(f64 delta)
 {
   mCLI.Update();
+
+  dutil::Stopwatch sw;
+  sw.Start();
   mWorld.Update(delta);
+  sw.Stop();
+  mTickStats.RecordTick(sw.fs());
+  mTickMetric->Observe(sw.fs());
+
+  PollPathRequests();
+
+  mEntityMetricsTimer -= delta;
+  if (mEntityMetricsTimer <= 0.0) {
+    mEntityMetricsTimer = 1.0;
+    UpdateEntityMetrics();
+  }
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+GameServer::SetupMetrics()
+{
+  mTickMetric = &mMetrics.AddHistogram(
+    "dib_tick_duration_seconds",
+    "Duration of a world update.",
+    Histogram::ExponentialBounds(0.00025, 2.0, 12));
+
+  const std::string entitiesHelp = "Entities with a component, by component.";
+  mPlayersMetric = &mMetrics.AddGauge("dib_players", "Players in the world.");
+  mMoveablesMetric = &mMetrics.AddGauge(
+    "dib_entities", entitiesHelp, { { "component", "moveable" } });
+  mNpcsMetric = &mMetrics.AddGauge(
+    "dib_entities", entitiesHelp, { { "component", "npc" } });
+  mItemsMetric = &mMetrics.AddGauge(
+    "dib_entities", entitiesHelp, { { "component", "item" } });
+  mProjectilesMetric = &mMetrics.AddGauge(
+    "dib_entities", entitiesHelp, { { "component", "projectile" } });
+
+  // Memory is read on each scrape, from the exporter thread
+  Gauge& residentMetric = mMetrics.AddGauge(
+    "dib_resident_memory_bytes", "Resident set size of the process.");
+  Gauge& virtualMetric = mMetrics.AddGauge(
+    "dib_virtual_memory_bytes", "Virtual memory size of the process.");
+  mMetrics.AddCollector([&residentMetric, &virtualMetric]() {
+    f64 virtualKb = 0.0;
+    f64 residentKb = 0.0;
+    core::GetVirtualMemoryUsage(virtualKb, residentKb);
+    residentMetric.Set(residentKb * 1024.0);
+    virtualMetric.Set(virtualKb * 1024.0);
+  });
+
+  mWorld.GetNetwork().GetPacketHandler().EnableMetrics(mMetrics);
+  UpdateEntityMetrics();
+
+  // A replay or benchmark is not a server to watch
+  if (mDescriptor.metricsPort != 0 && IsServing()) {
+    mMetricsExporter.Start(mMetrics, mDescriptor.metricsPort);
+  }
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+GameServer::UpdateEntityMetrics()
+{
+  auto& registry = mWorld.GetEntityManager().GetRegistry();
+  mPlayersMetric->Set(f64(system::CountEntities<PlayerData>(registry)));
+  mMoveablesMetric->Set(f64(system::CountEntities<Moveable>(registry)));
+  mNpcsMetric->Set(f64(system::CountEntities<NpcData>(registry)));
+  mItemsMetric->Set(f64(system::CountEntities<ItemData>(registry)));
+  mProjectilesMetric->Set(
+    f64(system::CountEntities<ProjectileData>(registry)));
+}
+
+// -------------------------------------------------------------------------- //
+
+bool
+GameServer::IsServing() const
+{
+  return mDescriptor.replayPath.GetSize() == 0 && mDescriptor.benchTicks == 0;
 }
 
 // -------------------------------------------------------------------------- //
@@ -69,6 +290,361 @@ GameServer::RegisterCommands()
     InputCommandCategory::kInfo, "packet_types", [&](const std::string_view) {
       mWorld.GetNetwork().GetPacketHandler().PrintPacketTypes();
     });
+
+  // Command: Load statistics
+  mCLI.AddCommand(
+    InputCommandCategory::kInfo,
+    "stats",
+    std::bind(&GameServer::OnCommandStats, this, std::placeholders::_1));
+
+  // Command: Metrics, as served to the scraper
+  mCLI.AddCommand(
+    InputCommandCategory::kInfo, "metrics", [&](const std::string_view) {
+      DLOG_RAW("{}", mMetrics.ToText());
+    });
+
+  // Command: Packet capture
+  mCLI.AddCommand(
+    InputCommandCategory::kSystem,
+    "capture",
+    std::bind(&GameServer::OnCommandCapture, this, std::placeholders::_1));
+
+  // Command: Path between two cells
+  mCLI.AddCommand(
+    InputCommandCategory::kInfo,
+    "path",
+    std::bind(&GameServer::OnCommandPath, this, std::placeholders::_1));
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+GameServer::OnCommandStats(std::string_view input)
+{
+  auto& packetHandler = mWorld.GetNetwork().GetPacketHandler();
+  if (input == "reset") {
+    mTickStats.Reset();
+    packetHandler.ResetStats();
+    mWorld.GetNetwork().GetOutbox().ResetStats();
+    DLOG_INFO("Statistics reset");
+    return;
+  }
+  if (input == "timing") {
+    packetHandler.SetTiming(!packetHandler.IsTiming());
+    DLOG_INFO("Packet handler timing {}",
+              packetHandler.IsTiming() ? "on" : "off");
+    return;
+  }
+
+  // Bandwidth as reported by the sockets for each player
+  u32 playerCount = 0;
+  f64 totalOut = 0.0;
+  f64 totalIn = 0.0;
+  f64 maxOut = 0.0;
+  mWorld.GetEntityManager().GetRegistry().view<PlayerData>().each(
+    [&](const PlayerData& playerData) {
+      const auto status =
+        mWorld.GetNetwork().GetConnectionStatus(playerData.connection_id);
+      if (status) {
+        playerCount++;
+        totalOut += status->m_flOutBytesPerSec;
+        totalIn += status->m_flInBytesPerSec;
+        maxOut = std::max(maxOut, f64(status->m_flOutBytesPerSec));
+      }
+    });
+  const f64 divisor = std::max(1u, playerCount);
+
+  DLOG_RAW("\n*** Tick\n{}\n", mTickStats.ToString());
+  DLOG_RAW("\n*** Bandwidth, {} players\n", playerCount);
+  DLOG_RAW("out {:.0f} B/s per player (max {:.0f} B/s), in {:.0f} B/s per "
+           "player, out {:.0f} B/s total\n",
+           totalOut / divisor,
+           maxOut,
+           totalIn / divisor,
+           totalOut);
+  const Outbox& outbox = mWorld.GetNetwork().GetOutbox();
+  DLOG_RAW("{} packets sent in {} datagrams\n",
+           outbox.GetPacketCount(),
+           outbox.GetDatagramCount());
+  DLOG_RAW("\n*** Packet handlers\n{}\n", packetHandler.PacketStatsToString());
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+GameServer::OnCommandCapture(std::string_view input)
+{
+  if (input.empty()) {
+    DLOG_INFO("Usage: capture <file>, or capture stop");
+    return;
+  }
+  if (input == "stop") {
+    mWorld.GetNetwork().StopCapture();
+    return;
+  }
+  const String path{ std::string(input).c_str() };
+  if (!mWorld.GetNetwork().StartCapture(Path{ path })) {
+    DLOG_WARNING("Could not start capturing to ({})", path);
+  }
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+GameServer::OnCommandPath(std::string_view input)
+{
+  const std::string args(input);
+  u32 fromX, fromY, toX, toY;
+  if (std::sscanf(args.c_str(), "%u %u %u %u", &fromX, &fromY, &toX, &toY) !=
+      4) {
+    DLOG_INFO("Usage: path <from x> <from y> <to x> <to y>");
+    return;
+  }
+  mPathRequests.push_back(mWorld.GetPathFinder().RequestPath(
+    WorldPos{ fromX, fromY }, WorldPos{ toX, toY }));
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+GameServer::PollPathRequests()
+{
+  PathFinder& pathFinder = mWorld.GetPathFinder();
+  std::vector<WorldPos> path;
+  const auto answered = [&](const PathFinder::Ticket ticket) {
+    const PathFinder::Status status = pathFinder.PollPath(ticket, path);
+    if (status == PathFinder::Status::kPending) {
+      return false;
+    }
+    if (status == PathFinder::Status::kFound) {
+      DLOG_INFO("Path {}: {} cells from ({}, {}) to ({}, {})",
+                ticket,
+                path.size(),
+                path.front().X(),
+                path.front().Y(),
+                path.back().X(),
+                path.back().Y());
+    } else {
+      DLOG_INFO("Path {}: no path found", ticket);
+    }
+    return true;
+  };
+  mPathRequests.erase(
+    std::remove_if(mPathRequests.begin(), mPathRequests.end(), answered),
+    mPathRequests.end());
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+GameServer::RunReplay()
+{
+  PacketCaptureReader reader(Path{ mDescriptor.replayPath });
+  if (!reader.IsValid()) {
+    DLOG_ERROR("Cannot replay ({})", mDescriptor.replayPath);
+    return;
+  }
+
+  // Ticks have a fixed length and the increments are broadcast on the
+  // simulated time, so that a capture is replayed the same way every time
+  const f64 delta = 1.0 / mDescriptor.targetUps;
+  mWorld.GetMoveableBroadcast().simulated_time = true;
+  auto& network = mWorld.GetNetwork();
+
+  // The replay prints what each packet type cost
+  network.GetPacketHandler().SetTiming(true);
+  Packet packet{};
+  CaptureRecord record{};
+  bool more = reader.Next(record, packet);
+  u64 packetCount = 0;
+  u64 tickCount = 0;
+  f64 tickEnd = 0.0;
+
+  dutil::Stopwatch sw;
+  sw.Start();
+  while (more) {
+    tickEnd += delta;
+
+    // Handle the packets received during the tick, then update the world
+    dutil::Stopwatch tickSw;
+    tickSw.Start();
+    while (more && f64(record.time) < tickEnd * 1e6) {
+      if (record.disconnect) {
+        network.ReplayDisconnect(record.connection);
+      } else {
+        network.ReplayPacket(packet);
+        packetCount++;
+      }
+      more = reader.Next(record, packet);
+    }
+    mWorld.Update(delta);
+    tickSw.Stop();
+    mTickStats.RecordTick(tickSw.fs());
+    tickCount++;
+
+    // Wait for the time of the next tick, unless as fast as possible
+    if (mDescriptor.replaySpeed > 0.0) {
+      const f64 ahead = tickEnd / mDescriptor.replaySpeed - sw.fnow_s();
+      if (ahead > 0.0) {
+        std::this_thread::sleep_for(std::chrono::duration<f64>(ahead));
+      }
+    }
+  }
+  sw.Stop();
+
+  DLOG_RAW("\n*** Replay\n{} packets in {} ticks, {:.2f}s captured, "
+           "replayed in {:.2f}s\n",
+           packetCount,
+           tickCount,
+           tickEnd,
+           sw.fs());
+  DLOG_RAW("\n*** Tick\n{}\n", mTickStats.ToString());
+  DLOG_RAW("\n*** Packet handlers\n{}\n",
+           network.GetPacketHandler().PacketStatsToString());
 }
 
+// -------------------------------------------------------------------------- //
+
+void
+GameServer::RunBench()
+{
+  auto& registry = mWorld.GetEntityManager().GetRegistry();
+  const u32 width = mWorld.GetTerrain().GetWidth();
+  const u32 moveableCount = mDescriptor.benchMoveables;
+
+  // Synthetic players standing on the ground, spread over the world. Their
+  // connections do not exist, so the packets to them are built and then
+  // dropped when flushed
+  for (u32 i = 0; i < moveableCount; i++) {
+    PlayerData playerData{};
+    playerData.uuid.GenerateUuid();
+    playerData.connection_id = ConnectionId(i + 1);
+    playerData.name = "bench";
+    Moveable moveable = MoveableMakeDefault();
+    const u64 tile = 8 + (u64(i) * 7919) % (width - 16);
+    moveable.position.x = TileToMeter(u32(tile));
+    moveable.position.y = TileToMeter(16);
+    const auto entity = registry.create();
+    system::Assign(registry, entity, playerData);
+    system::Assign(registry, entity, moveable);
+  }
+
+  // Each player walks left, walks right, jumps to the right and rests, a
+  // second at a time. The phases are shifted between players so that some
+  // always move and some always rest
+  const auto ScriptInput = [&](const u64 tick) {
+    u64 index = 0;
+    registry.view<PlayerData, Moveable>().each(
+      [&](const PlayerData&, Moveable& moveable) {
+        PlayerInput input{};
+        switch ((tick / mDescriptor.targetUps + index) % 4) {
+          case 0: {
+            input.ActionLeft();
+            break;
+          }
+          case 1: {
+            input.ActionRight();
+            break;
+          }
+          case 2: {
+            input.ActionRight();
+            input.ActionJump();
+            break;
+          }
+          default: {
+            break;
+          }
+        }
+        moveable.input = input;
+        index++;
+      });
+  };
+
+  // Ticks have a fixed length and the increments are broadcast on the
+  // simulated time, so that runs can be compared
+  const f64 delta = 1.0 / mDescriptor.targetUps;
+  mWorld.GetMoveableBroadcast().simulated_time = true;
+  const u64 tickCount = mDescriptor.benchTicks;
+  const CollisionQueryCounts queriesBefore = GetCollisionQueryCounts();
+  const u64 allocationsBefore = GetAllocationCount();
+  const u64 bytesBefore = GetAllocatedBytes();
+
+  dutil::Stopwatch sw;
+  sw.Start();
+  for (u64 tick = 0; tick < tickCount; tick++) {
+    dutil::Stopwatch tickSw;
+    tickSw.Start();
+    ScriptInput(tick);
+    mWorld.Update(delta);
+    tickSw.Stop();
+    mTickStats.RecordTick(tickSw.fs());
+  }
+  sw.Stop();
+
+  const CollisionQueryCounts queriesAfter = GetCollisionQueryCounts();
+  const f64 ticks = f64(tickCount);
+  const f64 tileQueries =
+    f64(queriesAfter.tile_queries - queriesBefore.tile_queries) / ticks;
+  const f64 overlapTests =
+    f64(queriesAfter.overlap_tests - queriesBefore.overlap_tests) / ticks;
+  const f64 allocations = f64(GetAllocationCount() - allocationsBefore) / ticks;
+  const f64 allocatedBytes = f64(GetAllocatedBytes() - bytesBefore) / ticks;
+
+  DLOG_RAW("\n*** Benchmark\n{} players on a {} world ({}x{}), {} ticks "
+           "in {:.2f}s\n",
+           moveableCount,
+           TerrainSizeName(mDescriptor.worldSize),
+           width,
+           mWorld.GetTerrain().GetHeight(),
+           tickCount,
+           sw.fs());
+  DLOG_RAW("\n*** Tick\n{}\n", mTickStats.ToString());
+  DLOG_RAW("\n*** Per tick\n{:.1f} tile collision queries, {:.1f} overlap "
+           "tests, {:.1f} allocations ({:.0f} bytes)\n",
+           tileQueries,
+           overlapTests,
+           allocations,
+           allocatedBytes);
+
+  // One object on one line, for tracking the results in CI. Percentiles are
+  // over the last TickStats::kWindowSize ticks
+  const std::string json = dlog::Format(
+    "{{\"world_size\": \"{}\", \"moveables\": {}, \"ticks\": {}, "
+    "\"delta_s\": {}, \"total_s\": {}, \"tick_p50_s\": {}, "
+    "\"tick_p90_s\": {}, \"tick_p99_s\": {}, \"tick_max_s\": {}, "
+    "\"tile_queries_per_tick\": {}, \"overlap_tests_per_tick\": {}, "
+    "\"allocations_per_tick\": {}, \"allocated_bytes_per_tick\": {}}}\n",
+    TerrainSizeName(mDescriptor.worldSize),
+    moveableCount,
+    tickCount,
+    delta,
+    sw.fs(),
+    mTickStats.GetPercentile(50),
+    mTickStats.GetPercentile(90),
+    mTickStats.GetPercentile(99),
+    mTickStats.GetMax(),
+    tileQueries,
+    overlapTests,
+    allocations,
+    allocatedBytes);
+
+  if (mDescriptor.benchOutput.GetSize() == 0) {
+    DLOG_RAW("\n{}", json);
+    return;
+  }
+  const Path path{ mDescriptor.benchOutput };
+  alflib::FileIO io(path);
+  const alflib::FileIO::Flag flags = alflib::FileIO::Flag::kWrite |
+                                     alflib::FileIO::Flag::kCreate |
+                                     alflib::FileIO::Flag::kOverwrite;
+  const auto* data = reinterpret_cast<const u8*>(json.data());
+  u64 written;
+  if (io.Open(flags) != alflib::FileResult::kSuccess ||
+      io.Write(data, json.size(), written) != alflib::FileResult::kSuccess) {
+    DLOG_ERROR("Could not write the benchmark results to ({})",
+               mDescriptor.benchOutput);
+    DLOG_RAW("\n{}", json);
+  }
 }
+
+}
\ No newline at end of file
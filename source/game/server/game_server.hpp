@@ -5,11 +5,14 @@
 // ========================================================================== //
 
 #include "app/server/app_server.hpp"
+#include "core/metrics.hpp"
+#include "core/metrics_exporter.hpp"
 #include "game/world.hpp"
 #include "game/mod/mod_loader.hpp"
 #include "game/server/cli_input.hpp"
 #include "game/item/item_registry.hpp"
 #include "game/gameplay/core_content.hpp"
+#include "game/tick_stats.hpp"
 
 // ========================================================================== //
 // Client Declaration
@@ -20,7 +23,67 @@ namespace dib::game {
 /** Game server **/
 class GameServer : public app::AppServer
 {
+public:
+  /** Game server descriptor **/
+  struct Descriptor : AppServer::Descriptor
+  {
+    /** Capture the received packets to this file, if set **/
+    String capturePath;
+
+    /** Replay the packets of this capture file instead of serving, if set **/
+    String replayPath;
+
+    /** Replay speed, 1 is as fast as the packets were captured and 0 is as
+     * fast as possible **/
+    f64 replaySpeed = 0.0;
+
+    /** Serve the metrics on this port of localhost, 0 to not serve them **/
+    u16 metricsPort = 24813;
+
+    /** Size of the generated world **/
+    Terrain::Size worldSize = Terrain::Size::kNormal;
+
+    /** Run this many ticks with synthetic players instead of serving, and
+     * print what they cost, if not 0 **/
+    u32 benchTicks = 0;
+
+    /** Number of synthetic players in the benchmark **/
+    u32 benchMoveables = 1000;
+
+    /** Write the benchmark results as JSON to this file, or print them if
+     * not set **/
+    String benchOutput;
+
+    /** Read the descriptor from the command line, see 'PrintUsage' **/
+    static Descriptor FromArgs(int argc, char** argv);
+
+    /** Print the command line options **/
+    static void PrintUsage();
+  };
+
 private:
+  /** Descriptor **/
+  Descriptor mDescriptor;
+
+  /** Server metrics, outlives the world that counts packets in it **/
+  Metrics mMetrics;
+
+  /** Serves the metrics over HTTP **/
+  MetricsExporter mMetricsExporter;
+
+  /** Durations of world updates **/
+  Histogram* mTickMetric = nullptr;
+
+  /** Players, and entities of each kind. Counted once a second **/
+  Gauge* mPlayersMetric = nullptr;
+  Gauge* mMoveablesMetric = nullptr;
+  Gauge* mNpcsMetric = nullptr;
+  Gauge* mItemsMetric = nullptr;
+  Gauge* mProjectilesMetric = nullptr;
+
+  /** Seconds until the entities are counted again **/
+  f64 mEntityMetricsTimer = 0.0;
+
   /** Game world **/
   World mWorld;
 
@@ -30,9 +93,19 @@ private:
   /** Input handler **/
   CLIInputHandler mCLI;
 
+  /** Durations of recent world updates **/
+  TickStats mTickStats;
+
+  /** Paths requested from the command line that are not answered yet **/
+  std::vector<PathFinder::Ticket> mPathRequests;
+
 public:
   /** Construct game server **/
-  explicit GameServer(const AppServer::Descriptor& descriptor);
+  explicit GameServer(const Descriptor& descriptor);
+
+  /** Run the server, or replay a capture or run the benchmark if the
+   * descriptor has one **/
+  void Run() override;
 
   /** Update server **/
   void Update(f64 delta) override;
@@ -50,8 +123,45 @@ public:
   const ModLoader& GetModLoader() const { return mModLoader; }
 
 private:
+  /** Returns whether the server listens for connections, it does not when
+   * replaying or benchmarking **/
+  bool IsServing() const;
+
   /** Register all available commands **/
   void RegisterCommands();
+
+  /** Print tick times, bandwidth per player and packet handler costs. With
+   * "reset" the statistics are cleared instead, and with "timing" the
+   * measuring of packet handler times is turned on or off **/
+  void OnCommandStats(std::string_view input);
+
+  /** Add the server metrics, and serve them unless replaying **/
+  void SetupMetrics();
+
+  /** Count the players and entities into their gauges **/
+  void UpdateEntityMetrics();
+
+  /** Start capturing the received packets to the file given as input, or
+   * stop with "stop" **/
+  void OnCommandCapture(std::string_view input);
+
+  /** Request a path between the two cells given as input, "x y x y". The
+   * path is printed once it has been found **/
+  void OnCommandPath(std::string_view input);
+
+  /** Print the paths requested from the command line that were answered
+   * since the last tick **/
+  void PollPathRequests();
+
+  /** Feed the packets of the replay capture to the world, in ticks of fixed
+   * length, without sockets. Prints the tick times and packet handler costs
+   * at the end **/
+  void RunReplay();
+
+  /** Spawn the synthetic players and update the world with scripted input
+   * for a fixed number of ticks, without networking. Prints the tick times,
+   * collision queries and allocations per tick, and writes them as JSON **/
+  void RunBench();
 };
 
 }
\ No newline at end of file
@@ -4,8 +4,14 @@
 // Headers
 // ========================================================================== //
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <random>
 
+#include <microprofile/microprofile.h>
+
+#include "core/assert.hpp"
 #include "game/world.hpp"
 
 // ========================================================================== //
@@ -14,6 +20,34 @@
 
 namespace dib::game {
 
+void
+Terrain::ChangeListener::OnRegionChanged(WorldPos min, WorldPos max)
+{
+  for (u32 y = min.Y(); y <= max.Y(); y++) {
+    for (u32 x = min.X(); x <= max.X(); x++) {
+      OnTileChanged(WorldPos{ x, y });
+      OnWallChanged(WorldPos{ x, y });
+    }
+  }
+}
+
+// -------------------------------------------------------------------------- //
+
+Terrain::EditBatch::EditBatch(Terrain& terrain)
+  : mTerrain(terrain)
+{
+  mTerrain.BeginBatch();
+}
+
+// -------------------------------------------------------------------------- //
+
+Terrain::EditBatch::~EditBatch()
+{
+  mTerrain.EndBatch();
+}
+
+// -------------------------------------------------------------------------- //
+
 Terrain::Terrain(World* world, u32 width, u32 height)
   : mWorld(world)
   , mWidth(width)
@@ -68,18 +102,19 @@ Terrain::Terrain(Terrain&& other) noexcept
   : mWorld(other.mWorld)
   , mWidth(other.mWidth)
   , mHeight(other.mHeight)
-  , mTerrainCells(other.mTerrainCells)
+  , mChunkCountX(other.mChunkCountX)
+  , mChunkCountY(other.mChunkCountY)
+  , mChunks(std::move(other.mChunks))
   , mChangeListeners(std::move(other.mChangeListeners))
-{
-  other.mTerrainCells = nullptr;
-}
+  , mTickScheduler(std::move(other.mTickScheduler))
+  , mRandomTickChunks(std::move(other.mRandomTickChunks))
+  , mRandomTickCursor(other.mRandomTickCursor)
+  , mRandom(other.mRandom)
+{}
 
 // -------------------------------------------------------------------------- //
 
-Terrain::~Terrain()
-{
-  delete mTerrainCells;
-}
+Terrain::~Terrain() = default;
 
 // -------------------------------------------------------------------------- //
 
@@ -90,9 +125,14 @@ Terrain::operator=(Terrain&& other) noexcept
     mWorld = other.mWorld;
     mWidth = other.mWidth;
     mHeight = other.mHeight;
-    mTerrainCells = other.mTerrainCells;
+    mChunkCountX = other.mChunkCountX;
+    mChunkCountY = other.mChunkCountY;
+    mChunks = std::move(other.mChunks);
     mChangeListeners = other.mChangeListeners;
-    other.mTerrainCells = nullptr;
+    mTickScheduler = std::move(other.mTickScheduler);
+    mRandomTickChunks = std::move(other.mRandomTickChunks);
+    mRandomTickCursor = other.mRandomTickCursor;
+    mRandom = other.mRandom;
   }
   return *this;
 }
@@ -105,13 +145,6 @@ Terrain::GetTile(WorldPos pos) const
   return TileRegistry::Instance().GetTile(GetTileID(pos));
 }
 
-// -------------------------------------------------------------------------- //
-
-TileRegistry::TileID
-Terrain::GetTileID(WorldPos pos) const
-{
-  return (mTerrainCells + mWidth * pos.Y() + pos.X())->tile;
-}
 
 // -------------------------------------------------------------------------- //
 
@@ -121,13 +154,6 @@ Terrain::GetWall(WorldPos pos) const
   return WallRegistry::Instance().GetWall(GetWallID(pos));
 }
 
-// -------------------------------------------------------------------------- //
-
-WallRegistry::WallID
-Terrain::GetWallID(WorldPos pos) const
-{
-  return (mTerrainCells + mWidth * pos.Y() + pos.X())->wall;
-}
 
 // -------------------------------------------------------------------------- //
 
@@ -176,12 +202,12 @@ Terrain::GenSetTile(WorldPos pos,
                     TileRegistry::TileID id,
                     bool updateNeighbours)
 {
-  Cell& cell = GetCell(pos);
-  Tile* tile = TileRegistry::Instance().GetTile(cell.tile);
+  Tile* tile = GetTile(pos);
   tile->OnDestroyed(*mWorld, pos);
 
   tile = TileRegistry::Instance().GetTile(id);
-  cell.tile = id;
+  SetTileID(pos, id);
+  mWorld->GetTileEntityManager().OnTileChanged(pos);
   tile->OnPlaced(*mWorld, pos);
   UpdateCachedTileIndices(pos, updateNeighbours);
 }
@@ -201,12 +227,11 @@ Terrain::GenSetWall(WorldPos pos,
                     WallRegistry::WallID id,
                     bool updateNeighbours)
 {
-  Cell& cell = GetCell(pos);
-  Wall* wall = WallRegistry::Instance().GetWall(cell.wall);
+  Wall* wall = GetWall(pos);
   wall->OnDestroyed(*mWorld, pos);
 
   wall = WallRegistry::Instance().GetWall(id);
-  cell.wall = id;
+  SetWallID(pos, id);
   wall->OnPlaced(*mWorld, pos);
   UpdateCachedWallIndices(pos, updateNeighbours);
 }
@@ -229,14 +254,175 @@ Terrain::RemoveTile(WorldPos pos, TileRegistry::TileID replacementId)
 
 // -------------------------------------------------------------------------- //
 
+void
+Terrain::NotifyRegionChanged(WorldPos min, WorldPos max)
+{
+  for (auto& listener : mChangeListeners) {
+    listener->OnRegionChanged(min, max);
+  }
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+Terrain::GatherTileRow(s64 y,
+                       u32 x,
+                       u32 count,
+                       TileRegistry::TileID* out) const
+{
+  if (y < 0 || y >= s64(mHeight)) {
+    std::fill(out, out + count + 2, INVALID_TILE_ID);
+    return;
+  }
+
+  // Copy the part of the row that is inside the terrain
+  const s64 first = s64(x) - 1;
+  for (u32 i = 0; i < count + 2; i++) {
+    const s64 cellX = first + i;
+    out[i] = cellX >= 0 && cellX < s64(mWidth)
+               ? GetTileID(WorldPos{ u32(cellX), u32(y) })
+               : INVALID_TILE_ID;
+  }
+}
+
+// -------------------------------------------------------------------------- //
+
+bool
+Terrain::Raycast(const Ray& ray, RaycastHit& hit) const
+{
+  return Raycast(
+    ray, TileRegistry::Instance().GetCollisionTable().data(), hit);
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+Terrain::Raycast(const Ray* rays, u32 count, RaycastHit* hits) const
+{
+  const CollisionType* collisionTable =
+    TileRegistry::Instance().GetCollisionTable().data();
+  for (u32 i = 0; i < count; i++) {
+    Raycast(rays[i], collisionTable, hits[i]);
+  }
+}
+
+// -------------------------------------------------------------------------- //
+
+bool
+Terrain::LineOfSight(Vector2F from, Vector2F to) const
+{
+  const Vector2F direction = to - from;
+  RaycastHit hit;
+  return !Raycast(Ray{ from, direction, glm::length(direction) }, hit);
+}
+
+// -------------------------------------------------------------------------- //
+
+bool
+Terrain::Raycast(const Ray& ray,
+                 const CollisionType* collisionTable,
+                 RaycastHit& hit) const
+{
+  hit.hit = false;
+  const f32 length = glm::length(ray.direction);
+  if (length <= 0.0f || mWidth == 0 || mHeight == 0) {
+    return false;
+  }
+  const Vector2F direction = ray.direction / length;
+  const Vector2F size{ f32(mWidth), f32(mHeight) };
+
+  // Clip the ray against the bounds of the terrain, so that the walk starts
+  // at the first cell inside of it
+  f32 minT = 0.0f;
+  f32 maxT = ray.maxDistance;
+  s32 enterAxis = -1;
+  for (s32 axis = 0; axis < 2; axis++) {
+    if (direction[axis] == 0.0f) {
+      if (ray.origin[axis] < 0.0f || ray.origin[axis] >= size[axis]) {
+        return false;
+      }
+      continue;
+    }
+    f32 t0 = -ray.origin[axis] / direction[axis];
+    f32 t1 = (size[axis] - ray.origin[axis]) / direction[axis];
+    if (t0 > t1) {
+      std::swap(t0, t1);
+    }
+    if (t0 > minT) {
+      minT = t0;
+      enterAxis = axis;
+    }
+    maxT = std::min(maxT, t1);
+  }
+  if (minT > maxT) {
+    return false;
+  }
+
+  // Setup the walk from the first cell. 'next' is the distance along the ray
+  // to the next cell boundary on each axis and 'delta' the distance between
+  // two boundaries
+  const Vector2F start = ray.origin + direction * minT;
+  const s64 width = mWidth;
+  const s64 height = mHeight;
+  s64 x = std::clamp(s64(std::floor(start.x)), s64(0), width - 1);
+  s64 y = std::clamp(s64(std::floor(start.y)), s64(0), height - 1);
+  const s64 stepX = direction.x > 0.0f ? 1 : (direction.x < 0.0f ? -1 : 0);
+  const s64 stepY = direction.y > 0.0f ? 1 : (direction.y < 0.0f ? -1 : 0);
+  constexpr f32 INF = std::numeric_limits<f32>::infinity();
+  const f32 deltaX = stepX != 0 ? 1.0f / std::abs(direction.x) : INF;
+  const f32 deltaY = stepY != 0 ? 1.0f / std::abs(direction.y) : INF;
+  f32 nextX = stepX != 0
+                ? (f32(x + (stepX > 0 ? 1 : 0)) - ray.origin.x) / direction.x
+                : INF;
+  f32 nextY = stepY != 0
+                ? (f32(y + (stepY > 0 ? 1 : 0)) - ray.origin.y) / direction.y
+                : INF;
+
+  f32 t = minT;
+  Vector2I normal{ 0, 0 };
+  if (enterAxis == 0) {
+    normal.x = s32(-stepX);
+  } else if (enterAxis == 1) {
+    normal.y = s32(-stepY);
+  }
+
+  while (true) {
+    const WorldPos pos{ u32(x), u32(y) };
+    if (collisionTable[GetTileID(pos)] != CollisionType::kNone) {
+      hit.hit = true;
+      hit.pos = pos;
+      hit.point = ray.origin + direction * t;
+      hit.normal = normal;
+      hit.distance = t;
+      return true;
+    }
+
+    // Step to the closest boundary
+    if (nextX < nextY) {
+      x += stepX;
+      t = nextX;
+      nextX += deltaX;
+      normal = Vector2I{ s32(-stepX), 0 };
+    } else {
+      y += stepY;
+      t = nextY;
+      nextY += deltaY;
+      normal = Vector2I{ 0, s32(-stepY) };
+    }
+    if (t > maxT || x < 0 || x >= width || y < 0 || y >= height) {
+      return false;
+    }
+  }
+}
+
+// -------------------------------------------------------------------------- //
+
 void
 Terrain::Resize(u32 width, u32 height)
 {
-  delete mTerrainCells;
   mWidth = width;
   mHeight = height;
-  mTerrainCells = new Cell[mWidth * mHeight];
-  memset(mTerrainCells, 0, sizeof(Cell) * mWidth * mHeight);
+  InitTerrain();
   for (auto& listener : mChangeListeners) {
     listener->OnResize(width, height);
   }
@@ -244,6 +430,35 @@ Terrain::Resize(u32 width, u32 height)
 
 // -------------------------------------------------------------------------- //
 
+void
+Terrain::Update()
+{
+  MICROPROFILE_SCOPEI("Terrain", "Update", MP_BROWN);
+  EditBatch batch(*this);
+  UpdateScheduledTicks();
+  UpdateRandomTicks();
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+Terrain::ScheduleTick(WorldPos pos, u32 delay)
+{
+  if (IsValidPosition(pos)) {
+    mTickScheduler.Schedule(GetCellIndex(pos), delay);
+  }
+}
+
+// -------------------------------------------------------------------------- //
+
+bool
+Terrain::IsTickScheduled(WorldPos pos) const
+{
+  return mTickScheduler.IsScheduled(GetCellIndex(pos));
+}
+
+// -------------------------------------------------------------------------- //
+
 bool
 Terrain::IsValidPosition(WorldPos pos)
 {
@@ -255,7 +470,7 @@ Terrain::IsValidPosition(WorldPos pos)
 u8
 Terrain::GetMetadata(WorldPos pos)
 {
-  return GetCell(pos).metadata;
+  return u8(GetChunk(pos).metadata.Get(GetChunkLocalIndex(pos)));
 }
 
 // -------------------------------------------------------------------------- //
@@ -263,7 +478,7 @@ Terrain::GetMetadata(WorldPos pos)
 void
 Terrain::SetMetadata(WorldPos pos, u8 metadata)
 {
-  GetCell(pos).metadata = metadata;
+  GetChunk(pos).metadata.Set(GetChunkLocalIndex(pos), metadata);
 }
 
 // -------------------------------------------------------------------------- //
@@ -287,10 +502,28 @@ Terrain::UnregisterChangeListener(Terrain::ChangeListener* changeListener)
 
 // -------------------------------------------------------------------------- //
 
-Terrain::Cell&
-Terrain::GetCell(WorldPos pos)
+Terrain::Cell
+Terrain::GetCell(WorldPos pos) const
 {
-  return *(mTerrainCells + mWidth * pos.Y() + pos.X());
+  const Chunk& chunk = GetChunk(pos);
+  const u32 index = GetChunkLocalIndex(pos);
+  return Cell{ chunk.tiles.Get(index),
+               chunk.walls.Get(index),
+               u8(chunk.metadata.Get(index)) };
+}
+
+// -------------------------------------------------------------------------- //
+
+u64
+Terrain::GetMemoryUsage() const
+{
+  u64 usage = mChunks.capacity() * sizeof(Chunk);
+  for (const Chunk& chunk : mChunks) {
+    usage += chunk.tiles.GetMemoryUsage() - sizeof(PaletteArray);
+    usage += chunk.walls.GetMemoryUsage() - sizeof(PaletteArray);
+    usage += chunk.metadata.GetMemoryUsage() - sizeof(PaletteArray);
+  }
+  return usage;
 }
 
 // -------------------------------------------------------------------------- //
@@ -298,8 +531,185 @@ Terrain::GetCell(WorldPos pos)
 void
 Terrain::InitTerrain()
 {
-  mTerrainCells = new Cell[mWidth * mHeight];
-  memset(mTerrainCells, 0, sizeof(Cell) * mWidth * mHeight);
+  // Every chunk starts out as a single value (zero) in each layer
+  mChunkCountX = (mWidth + CHUNK_SIZE - 1) / CHUNK_SIZE;
+  mChunkCountY = (mHeight + CHUNK_SIZE - 1) / CHUNK_SIZE;
+  mChunks = std::vector<Chunk>(mChunkCountX * mChunkCountY);
+
+  // Scheduled ticks are keyed by cell index, which depends on the size
+  mTickScheduler.Clear();
+  mRandomTickChunks.clear();
+  mRandomTickCursor = 0;
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+Terrain::SetTileID(WorldPos pos, TileRegistry::TileID id)
+{
+  Chunk& chunk = GetChunk(pos);
+  chunk.tiles.Set(GetChunkLocalIndex(pos), id);
+  if (!chunk.hasRandomTicks &&
+      TileRegistry::Instance().GetTile(id)->HasRandomTick()) {
+    chunk.hasRandomTicks = true;
+    mRandomTickChunks.push_back((pos.Y() / CHUNK_SIZE) * mChunkCountX +
+                                pos.X() / CHUNK_SIZE);
+  }
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+Terrain::SetWallID(WorldPos pos, WallRegistry::WallID id)
+{
+  GetChunk(pos).walls.Set(GetChunkLocalIndex(pos), id);
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+Terrain::LoadCells(const u8* source)
+{
+  // Decode the cells of one chunk at a time so that each layer can be
+  // assigned in one go
+  std::vector<u16> tiles(CHUNK_CELL_COUNT);
+  std::vector<u16> walls(CHUNK_CELL_COUNT);
+  std::vector<u16> metadata(CHUNK_CELL_COUNT);
+  for (u32 chunkY = 0; chunkY < mChunkCountY; chunkY++) {
+    for (u32 chunkX = 0; chunkX < mChunkCountX; chunkX++) {
+      std::fill(tiles.begin(), tiles.end(), 0);
+      std::fill(walls.begin(), walls.end(), 0);
+      std::fill(metadata.begin(), metadata.end(), 0);
+
+      const u32 minX = chunkX * CHUNK_SIZE;
+      const u32 minY = chunkY * CHUNK_SIZE;
+      const u32 maxX = std::min(minX + CHUNK_SIZE, mWidth);
+      const u32 maxY = std::min(minY + CHUNK_SIZE, mHeight);
+      for (u32 y = minY; y < maxY; y++) {
+        for (u32 x = minX; x < maxX; x++) {
+          Cell cell;
+          memcpy(&cell,
+                 source + (u64(y) * mWidth + x) * sizeof(Cell),
+                 sizeof(Cell));
+          const u32 index = (y - minY) * CHUNK_SIZE + (x - minX);
+          tiles[index] = cell.tile;
+          walls[index] = cell.wall;
+          metadata[index] = cell.metadata;
+        }
+      }
+
+      Chunk& chunk = mChunks[chunkY * mChunkCountX + chunkX];
+      chunk.tiles.Assign(tiles.data());
+      chunk.walls.Assign(walls.data());
+      chunk.metadata.Assign(metadata.data());
+      TrackRandomTicks(chunkY * mChunkCountX + chunkX);
+    }
+  }
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+Terrain::TrackRandomTicks(u32 chunkIndex)
+{
+  Chunk& chunk = mChunks[chunkIndex];
+  if (chunk.hasRandomTicks) {
+    return;
+  }
+  const TileRegistry& registry = TileRegistry::Instance();
+  for (TileRegistry::TileID id : chunk.tiles.GetPalette()) {
+    if (registry.GetTile(id)->HasRandomTick()) {
+      chunk.hasRandomTicks = true;
+      mRandomTickChunks.push_back(chunkIndex);
+      return;
+    }
+  }
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+Terrain::UpdateScheduledTicks()
+{
+  mTickScheduler.Advance();
+  if (mTickScheduler.GetReadyCount() == 0) {
+    return;
+  }
+
+  mDueTicks.clear();
+  mTickScheduler.PopReady(MAX_SCHEDULED_TICKS_PER_UPDATE, mDueTicks);
+  for (u32 index : mDueTicks) {
+    const WorldPos pos = GetCellPosition(index);
+    GetTile(pos)->OnScheduledTick(*mWorld, pos);
+  }
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+Terrain::UpdateRandomTicks()
+{
+  const TileRegistry& registry = TileRegistry::Instance();
+  const u32 chunkCount =
+    std::min(u32(mRandomTickChunks.size()),
+             MAX_RANDOM_TICKS_PER_UPDATE / RANDOM_TICKS_PER_CHUNK);
+  for (u32 i = 0; i < chunkCount && !mRandomTickChunks.empty(); i++) {
+    if (mRandomTickCursor >= mRandomTickChunks.size()) {
+      mRandomTickCursor = 0;
+    }
+    const u32 chunkIndex = mRandomTickChunks[mRandomTickCursor];
+    Chunk& chunk = mChunks[chunkIndex];
+
+    // Chunks where the tiles with random ticks have been removed are dropped
+    // from the list
+    const std::vector<u16>& palette = chunk.tiles.GetPalette();
+    const bool hasRandomTicks =
+      std::any_of(palette.begin(), palette.end(), [&](u16 id) {
+        return registry.GetTile(id)->HasRandomTick();
+      });
+    if (!hasRandomTicks) {
+      chunk.hasRandomTicks = false;
+      mRandomTickChunks[mRandomTickCursor] = mRandomTickChunks.back();
+      mRandomTickChunks.pop_back();
+      continue;
+    }
+
+    const u32 minX = (chunkIndex % mChunkCountX) * CHUNK_SIZE;
+    const u32 minY = (chunkIndex / mChunkCountX) * CHUNK_SIZE;
+    for (u32 j = 0; j < RANDOM_TICKS_PER_CHUNK; j++) {
+      const u32 index = u32(mRandom() % CHUNK_CELL_COUNT);
+      const WorldPos pos{ minX + index % CHUNK_SIZE,
+                          minY + index / CHUNK_SIZE };
+      if (pos.X() >= mWidth || pos.Y() >= mHeight) {
+        continue;
+      }
+      Tile* tile = registry.GetTile(chunk.tiles.Get(index));
+      if (tile->HasRandomTick()) {
+        tile->OnRandomTick(*mWorld, pos);
+      }
+    }
+    mRandomTickCursor++;
+  }
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+Terrain::StoreCells(alflib::MemoryWriter& writer) const
+{
+  // Write one row at a time, padding is zeroed to keep the output stable
+  std::vector<Cell> row(mWidth);
+  for (u32 y = 0; y < mHeight; y++) {
+    memset(row.data(), 0, sizeof(Cell) * mWidth);
+    for (u32 x = 0; x < mWidth; x++) {
+      const Cell cell = GetCell(WorldPos{ x, y });
+      row[x].tile = cell.tile;
+      row[x].wall = cell.wall;
+      row[x].metadata = cell.metadata;
+    }
+    writer.WriteBytes(reinterpret_cast<u8*>(row.data()),
+                      sizeof(Cell) * mWidth);
+  }
 }
 
 // -------------------------------------------------------------------------- //
@@ -310,10 +720,11 @@ Terrain::SetTileAdvanced(WorldPos pos,
                          bool ignoreReplaceCheck,
                          bool updateNeighbour)
 {
-  Cell& cell = GetCell(pos);
+  // Multi-tile structures edit several cells, which are all updated at once
+  EditBatch batch(*this);
 
   // Notify old tile
-  Tile* tile = TileRegistry::Instance().GetTile(cell.tile);
+  Tile* tile = GetTile(pos);
   if (!ignoreReplaceCheck && !tile->CanBeReplaced(*mWorld, pos)) {
     return false;
   }
@@ -328,14 +739,15 @@ Terrain::SetTileAdvanced(WorldPos pos,
 
   // Set new tile
   tile = TileRegistry::Instance().GetTile(id);
-  u32 oldId = cell.tile;
-  cell.tile = id;
+  const TileRegistry::TileID oldId = GetTileID(pos);
+  SetTileID(pos, id);
   if (tile->IsMultiTile(*mWorld, pos)) {
     if (!tile->PlaceMultiTile(*mWorld, pos)) {
-      cell.tile = oldId;
+      SetTileID(pos, oldId);
       return false;
     }
   }
+  mWorld->GetTileEntityManager().OnTileChanged(pos);
   tile->OnPlaced(*mWorld, pos);
   UpdateCachedTileIndices(pos, updateNeighbour);
   return true;
@@ -349,6 +761,7 @@ Terrain::SafeNeighbourTileUpdate(WorldPos pos)
   if (IsValidPosition(pos)) {
     Tile* tile = GetTile(pos);
     tile->OnNeighbourChange(*mWorld, pos);
+    mWorld->GetTileEntityManager().Wake(pos);
     for (auto& listener : mChangeListeners) {
       listener->OnTileChanged(pos);
     }
@@ -360,6 +773,12 @@ Terrain::SafeNeighbourTileUpdate(WorldPos pos)
 void
 Terrain::UpdateCachedTileIndices(WorldPos pos, bool updateNeighbours)
 {
+  // Updates are deferred to the end of the edit batch
+  if (mBatchDepth > 0) {
+    RecordBatchEdit(pos, updateNeighbours, mBatchTiles, mBatchTileNeighbours);
+    return;
+  }
+
   // Update center tile
   for (auto& listener : mChangeListeners) {
     listener->OnTileChanged(pos);
@@ -386,10 +805,8 @@ Terrain::SetWallAdvanced(WorldPos pos,
                          bool ignoreReplaceCheck,
                          bool updateNeighbour)
 {
-  Cell& cell = GetCell(pos);
-
   // Notify old tile
-  Wall* wall = WallRegistry::Instance().GetWall(cell.wall);
+  Wall* wall = GetWall(pos);
   if (!ignoreReplaceCheck && !wall->CanBeReplaced(*mWorld, pos)) {
     return false;
   }
@@ -397,7 +814,7 @@ Terrain::SetWallAdvanced(WorldPos pos,
 
   // Set new tile
   wall = WallRegistry::Instance().GetWall(id);
-  cell.wall = id;
+  SetWallID(pos, id);
   wall->OnPlaced(*mWorld, pos);
   UpdateCachedWallIndices(pos, updateNeighbour);
   return true;
@@ -422,6 +839,12 @@ Terrain::SafeNeighbourWallUpdate(WorldPos pos)
 void
 Terrain::UpdateCachedWallIndices(WorldPos pos, bool updateNeighbours)
 {
+  // Updates are deferred to the end of the edit batch
+  if (mBatchDepth > 0) {
+    RecordBatchEdit(pos, updateNeighbours, mBatchWalls, mBatchWallNeighbours);
+    return;
+  }
+
   // Update center tile
   for (auto& listener : mChangeListeners) {
     listener->OnWallChanged(pos);
@@ -440,4 +863,148 @@ Terrain::UpdateCachedWallIndices(WorldPos pos, bool updateNeighbours)
   }
 }
 
+// -------------------------------------------------------------------------- //
+
+void
+Terrain::BeginBatch()
+{
+  if (mBatchDepth++ == 0) {
+    mBatchDirty = false;
+    mBatchOverflow = false;
+  }
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+Terrain::EndBatch()
+{
+  DIB_ASSERT(mBatchDepth > 0, "Unmatched end of terrain edit batch");
+  if (--mBatchDepth > 0 || !mBatchDirty) {
+    return;
+  }
+  MICROPROFILE_SCOPEI("Terrain", "ApplyEditBatch", MP_BROWN);
+  mBatchDirty = false;
+
+  // Take the recorded cells and region, the neighbour callbacks are allowed to
+  // edit the terrain again and may start batches of their own
+  std::vector<u32> tiles, walls, tileNeighbours, wallNeighbours;
+  std::swap(tiles, mBatchTiles);
+  std::swap(walls, mBatchWalls);
+  std::swap(tileNeighbours, mBatchTileNeighbours);
+  std::swap(wallNeighbours, mBatchWallNeighbours);
+  const u32 batchMinX = mBatchMinX;
+  const u32 batchMinY = mBatchMinY;
+  const u32 batchMaxX = mBatchMaxX;
+  const u32 batchMaxY = mBatchMaxY;
+  const bool overflow = mBatchOverflow;
+
+  // Notify each neighbour once, tile entities are woken up by the change
+  TileEntityManager& tileEntities = mWorld->GetTileEntityManager();
+  std::vector<u32> cells;
+  auto sortUnique = [](std::vector<u32>& vector) {
+    std::sort(vector.begin(), vector.end());
+    vector.erase(std::unique(vector.begin(), vector.end()), vector.end());
+  };
+  GatherNeighbourIndices(tileNeighbours, cells);
+  sortUnique(cells);
+  for (u32 index : cells) {
+    const WorldPos pos = GetCellPosition(index);
+    GetTile(pos)->OnNeighbourChange(*mWorld, pos);
+    tileEntities.Wake(pos);
+  }
+  cells.clear();
+  GatherNeighbourIndices(wallNeighbours, cells);
+  sortUnique(cells);
+  for (u32 index : cells) {
+    const WorldPos pos = GetCellPosition(index);
+    GetWall(pos)->OnNeighbourChange(*mWorld, pos);
+  }
+
+  // The cached indices of the neighbours depend on the edited cells, so they
+  // are included in the listener update
+  const WorldPos min{ batchMinX > 0 ? batchMinX - 1 : 0,
+                      batchMinY > 0 ? batchMinY - 1 : 0 };
+  const WorldPos max{ std::min(batchMaxX + 1, mWidth - 1),
+                      std::min(batchMaxY + 1, mHeight - 1) };
+  const u64 area = u64(max.X() - min.X() + 1) * (max.Y() - min.Y() + 1);
+  if (!overflow) {
+    GatherNeighbourIndices(tiles, tiles);
+    GatherNeighbourIndices(walls, walls);
+    sortUnique(tiles);
+    sortUnique(walls);
+  }
+  if (overflow || (tiles.size() + walls.size()) >= area) {
+    NotifyRegionChanged(min, max);
+    return;
+  }
+  for (auto& listener : mChangeListeners) {
+    for (u32 index : tiles) {
+      listener->OnTileChanged(GetCellPosition(index));
+    }
+    for (u32 index : walls) {
+      listener->OnWallChanged(GetCellPosition(index));
+    }
+  }
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+Terrain::RecordBatchEdit(WorldPos pos,
+                         bool updateNeighbours,
+                         std::vector<u32>& cells,
+                         std::vector<u32>& neighbourCells)
+{
+  // Grow region
+  if (!mBatchDirty) {
+    mBatchMinX = mBatchMaxX = pos.X();
+    mBatchMinY = mBatchMaxY = pos.Y();
+    mBatchDirty = true;
+  } else {
+    mBatchMinX = std::min(mBatchMinX, pos.X());
+    mBatchMinY = std::min(mBatchMinY, pos.Y());
+    mBatchMaxX = std::max(mBatchMaxX, pos.X());
+    mBatchMaxY = std::max(mBatchMaxY, pos.Y());
+  }
+
+  // Large batches, like world generation, only keep track of the region
+  const u32 index = GetCellIndex(pos);
+  if (!mBatchOverflow) {
+    cells.push_back(index);
+    if (mBatchTiles.size() + mBatchWalls.size() > MAX_BATCH_TRACKED_CELLS) {
+      mBatchOverflow = true;
+      mBatchTiles = std::vector<u32>();
+      mBatchWalls = std::vector<u32>();
+    }
+  }
+  if (updateNeighbours) {
+    neighbourCells.push_back(index);
+  }
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+Terrain::GatherNeighbourIndices(const std::vector<u32>& cells,
+                                std::vector<u32>& out) const
+{
+  // 'out' is allowed to be the same vector as 'cells'
+  const std::size_t count = cells.size();
+  for (std::size_t i = 0; i < count; i++) {
+    const u32 x = cells[i] % mWidth;
+    const u32 y = cells[i] / mWidth;
+    for (s32 dy = -1; dy <= 1; dy++) {
+      for (s32 dx = -1; dx <= 1; dx++) {
+        const s64 nx = s64(x) + dx;
+        const s64 ny = s64(y) + dy;
+        if ((dx != 0 || dy != 0) && nx >= 0 && nx < s64(mWidth) && ny >= 0 &&
+            ny < s64(mHeight)) {
+          out.push_back(u32(ny) * mWidth + u32(nx));
+        }
+      }
+    }
+  }
+}
+
 }
\ No newline at end of file
@@ -5,10 +5,16 @@
 // ========================================================================== //
 
 #include <array>
+#include <random>
+#include <vector>
+
+#include <alflib/memory/memory_writer.hpp>
 
 #include "core/types.hpp"
 #include "core/macros.hpp"
 #include "graphics/camera.hpp"
+#include "game/palette_array.hpp"
+#include "game/tick_scheduler.hpp"
 #include "game/tile/tile_registry.hpp"
 #include "game/wall/wall_registry.hpp"
 
@@ -41,7 +47,15 @@ public:
     kHuge
   };
 
-  /** Cell in the world **/
+  /** Width and height of a chunk in number of cells **/
+  static constexpr u32 CHUNK_SIZE = 32;
+
+  /** Number of cells in a chunk **/
+  static constexpr u32 CHUNK_CELL_COUNT = CHUNK_SIZE * CHUNK_SIZE;
+
+  /** Cell in the world. The terrain does not store cells like this, instead
+   * each layer is stored compressed in chunks. This is however the format of
+   * cells when serialized **/
   struct Cell
   {
     TileRegistry::TileID tile;
@@ -50,6 +64,36 @@ public:
     u8 metadata;
   };
 
+  /** Ray through the terrain. Positions and distances are specified in
+   * tiles, not in meters, where the cell (x, y) covers the area from (x, y)
+   * to (x+1, y+1). Positions of moveables and projectiles are in meters and
+   * must be divided by 'kTileInMeters' first **/
+  struct Ray
+  {
+    /** Start of the ray, in tiles **/
+    Vector2F origin;
+    /** Direction of the ray, does not need to be normalized **/
+    Vector2F direction;
+    /** Maximum distance that the ray travels, in tiles **/
+    f32 maxDistance;
+  };
+
+  /** Result of a raycast **/
+  struct RaycastHit
+  {
+    /** Whether the ray hit a solid cell **/
+    bool hit = false;
+    /** Cell that was hit **/
+    WorldPos pos;
+    /** Point where the ray entered the cell, in tiles **/
+    Vector2F point;
+    /** Normal of the side of the cell that was hit. This is zero if the ray
+     * started inside of the cell **/
+    Vector2I normal;
+    /** Distance from the origin to the point, in tiles **/
+    f32 distance = 0.0f;
+  };
+
   /** Change listener **/
   class ChangeListener
   {
@@ -62,8 +106,76 @@ public:
 
     /** Called when a wall in the world changed **/
     virtual void OnWallChanged(WorldPos pos) = 0;
+
+    /** Called when every tile and wall in a region changed, for example after
+     * the world has been loaded or generated. Both 'min' and 'max' are
+     * inclusive. The default implementation calls 'OnTileChanged' and
+     * 'OnWallChanged' for each cell, listeners can override it to process the
+     * region row by row instead **/
+    virtual void OnRegionChanged(WorldPos min, WorldPos max);
+  };
+
+  /** Batch of terrain edits.
+   *
+   * While a batch is alive the edits to the terrain does not notify the
+   * neighbours or listeners directly. Instead the edited cells are recorded
+   * and when the batch is destroyed each neighbour is sent a single
+   * 'OnNeighbourChange', no matter how many of its neighbours changed, and
+   * each affected cell is sent to the listeners once. If the affected cells
+   * cover most of their bounding region the listeners are instead notified of
+   * the region with 'OnRegionChanged'.
+   *
+   * Batches can be nested, in which case only the outermost batch applies the
+   * updates.
+   *
+   * Example:
+   * {
+   *   Terrain::EditBatch batch(terrain);
+   *   for (WorldPos pos : crater) {
+   *     terrain.SetTile(pos, air);
+   *   }
+   * } // Neighbours and listeners are updated here
+   * **/
+  class EditBatch
+  {
+  private:
+    /** Terrain **/
+    Terrain& mTerrain;
+
+  public:
+    /** Begin a batch of edits to a terrain **/
+    explicit EditBatch(Terrain& terrain);
+
+    /** Apply the deferred updates of the batch **/
+    ~EditBatch();
+
+    /** Deleted copy-constructor **/
+    EditBatch(const EditBatch&) = delete;
+
+    /** Deleted copy-assignment **/
+    EditBatch& operator=(const EditBatch&) = delete;
   };
 
+  /** Value written by 'GatherTileRow' for positions outside the terrain. It
+   * never matches the ID of a registered tile **/
+  static constexpr TileRegistry::TileID INVALID_TILE_ID = 0xFFFF;
+
+  /** Maximum number of cells that an edit batch tracks individually. Larger
+   * batches notify the listeners of their bounding region instead **/
+  static constexpr u32 MAX_BATCH_TRACKED_CELLS = 1u << 16u;
+
+  /** Number of cells of each chunk that are picked for random ticks each
+   * update **/
+  static constexpr u32 RANDOM_TICKS_PER_CHUNK = 3;
+
+  /** Maximum number of random ticks each update. If there are more chunks
+   * with random ticks than fits in the budget they take turns **/
+  static constexpr u32 MAX_RANDOM_TICKS_PER_UPDATE = 4096;
+
+  /** Maximum number of scheduled ticks each update. Ticks that do not fit in
+   * the budget are delayed to the following updates **/
+  static constexpr u32 MAX_SCHEDULED_TICKS_PER_UPDATE = 1024;
+
 private:
   /** World **/
   World* mWorld;
@@ -73,12 +185,57 @@ private:
   /** Height of terrain **/
   u32 mHeight;
 
-  /** Terrain cells **/
-  Cell* mTerrainCells = nullptr;
+  /** Square chunk of cells, where each layer is compressed separately **/
+  struct Chunk
+  {
+    /** Tile IDs **/
+    PaletteArray tiles{ CHUNK_CELL_COUNT };
+    /** Wall IDs **/
+    PaletteArray walls{ CHUNK_CELL_COUNT };
+    /** Metadata **/
+    PaletteArray metadata{ CHUNK_CELL_COUNT };
+    /** Whether the chunk is in the list of chunks with random ticks **/
+    bool hasRandomTicks = false;
+  };
+
+  /** Number of chunks horizontally **/
+  u32 mChunkCountX;
+  /** Number of chunks vertically **/
+  u32 mChunkCountY;
+  /** Chunks, row by row **/
+  std::vector<Chunk> mChunks;
 
   /** Change listeners **/
   std::vector<ChangeListener*> mChangeListeners;
 
+  /** Number of live edit batches **/
+  u32 mBatchDepth = 0;
+  /** Region that has been modified during the current batch **/
+  u32 mBatchMinX, mBatchMinY, mBatchMaxX, mBatchMaxY;
+  /** Whether any cell has been modified during the current batch **/
+  bool mBatchDirty = false;
+  /** Whether more cells were edited than what is tracked individually **/
+  bool mBatchOverflow = false;
+  /** Indices of the cells whose tile changed during the current batch **/
+  std::vector<u32> mBatchTiles;
+  /** Indices of the cells whose wall changed during the current batch **/
+  std::vector<u32> mBatchWalls;
+  /** Indices of the cells whose tile neighbours must be notified **/
+  std::vector<u32> mBatchTileNeighbours;
+  /** Indices of the cells whose wall neighbours must be notified **/
+  std::vector<u32> mBatchWallNeighbours;
+
+  /** Scheduled ticks, keyed by cell index **/
+  TickScheduler mTickScheduler;
+  /** Cell indices of the scheduled ticks that are run this update **/
+  std::vector<u32> mDueTicks;
+  /** Indices of the chunks that may contain tiles with random ticks **/
+  std::vector<u32> mRandomTickChunks;
+  /** Index in 'mRandomTickChunks' of the next chunk to random tick **/
+  u32 mRandomTickCursor = 0;
+  /** Random number generator for random ticks **/
+  std::minstd_rand mRandom;
+
 public:
   /** Construct a world of the specified dimensions **/
   Terrain(World* world, u32 width, u32 height);
@@ -99,13 +256,33 @@ public:
   [[nodiscard]] Tile* GetTile(WorldPos pos) const;
 
   /** Returns the ID of the tile at the specified location in the world **/
-  [[nodiscard]] TileRegistry::TileID GetTileID(WorldPos pos) const;
+  [[nodiscard]] TileRegistry::TileID GetTileID(WorldPos pos) const
+  {
+    return GetChunk(pos).tiles.Get(GetChunkLocalIndex(pos));
+  }
+
+  /** Returns the tile IDs of the chunk at the specified chunk coordinates.
+   * Cells are stored row by row, starting at the bottom left of the chunk **/
+  [[nodiscard]] const PaletteArray& GetChunkTiles(u32 chunkX, u32 chunkY) const
+  {
+    return mChunks[chunkY * mChunkCountX + chunkX].tiles;
+  }
 
   /** Returns the wall at the specified location in the world **/
   [[nodiscard]] Wall* GetWall(WorldPos pos) const;
 
   /** Returns the ID of the wall at the specified location in the world **/
-  [[nodiscard]] WallRegistry::WallID GetWallID(WorldPos pos) const;
+  [[nodiscard]] WallRegistry::WallID GetWallID(WorldPos pos) const
+  {
+    return GetChunk(pos).walls.Get(GetChunkLocalIndex(pos));
+  }
+
+  /** Returns the wall IDs of the chunk at the specified chunk coordinates.
+   * Cells are stored row by row, starting at the bottom left of the chunk **/
+  [[nodiscard]] const PaletteArray& GetChunkWalls(u32 chunkX, u32 chunkY) const
+  {
+    return mChunks[chunkY * mChunkCountX + chunkX].walls;
+  }
 
   /** Sets the tile at the specified location in the world. The function returns
    * false if the tile could not be placed **/
@@ -167,6 +344,19 @@ public:
    * replaced with the specified tile **/
   void RemoveTile(WorldPos pos, TileRegistry::TileID replacementId);
 
+  /** Notify all listeners that every cell in a region changed. Both 'min' and
+   * 'max' are inclusive **/
+  void NotifyRegionChanged(WorldPos min, WorldPos max);
+
+  /** Copy the IDs of a row of tiles to 'out'. One extra ID is written before
+   * and after the 'count' tiles starting at 'x', so 'out' must have room for
+   * 'count + 2' IDs. Positions outside the terrain, including the whole row if
+   * 'y' is outside, are written as 'INVALID_TILE_ID' **/
+  void GatherTileRow(s64 y,
+                     u32 x,
+                     u32 count,
+                     TileRegistry::TileID* out) const;
+
   /** Resize the terrain. This throws away all old data **/
   void Resize(u32 width, u32 height);
 
@@ -186,7 +376,10 @@ public:
   void UnregisterChangeListener(ChangeListener* changeListener);
 
   /** Returns a cell in the world data **/
-  Cell& GetCell(WorldPos pos);
+  [[nodiscard]] Cell GetCell(WorldPos pos) const;
+
+  /** Returns the number of bytes allocated for the terrain cells **/
+  [[nodiscard]] u64 GetMemoryUsage() const;
 
   /** Returns the width of the terrain in number of tiles. Zero (0) is left **/
   [[nodiscard]] u32 GetWidth() const { return mWidth; };
@@ -195,10 +388,89 @@ public:
    * bottom **/
   [[nodiscard]] u32 GetHeight() const { return mHeight; };
 
+  /** Run the scheduled and random ticks of one update. Edits made by the
+   * ticks are applied as a single edit batch **/
+  void Update();
+
+  /** Schedule a call to 'Tile::OnScheduledTick' for the tile at a position
+   * after 'delay' updates. If a tick is already scheduled for the position the
+   * earliest of the two is kept **/
+  void ScheduleTick(WorldPos pos, u32 delay);
+
+  /** Returns whether a tick is scheduled for a position **/
+  [[nodiscard]] bool IsTickScheduled(WorldPos pos) const;
+
+  /** Returns the number of updates that the terrain has run **/
+  [[nodiscard]] u64 GetTick() const { return mTickScheduler.GetTick(); }
+
+  /** Cast a ray and find the first cell that it enters whose tile has
+   * collision, according to the collision table of the tile registry. Every
+   * cell along the ray is visited exactly once. Returns whether a cell was
+   * hit **/
+  bool Raycast(const Ray& ray, RaycastHit& hit) const;
+
+  /** Cast 'count' rays and write the result of each to 'hits' **/
+  void Raycast(const Ray* rays, u32 count, RaycastHit* hits) const;
+
+  /** Returns whether the segment between two points does not pass through any
+   * cell whose tile has collision. Points are specified in tiles, not in
+   * meters **/
+  [[nodiscard]] bool LineOfSight(Vector2F from, Vector2F to) const;
+
 private:
   /** Initialize the terrain layers **/
   void InitTerrain();
 
+  /** Implementation of 'Raycast' that reads collision from a table **/
+  bool Raycast(const Ray& ray,
+               const CollisionType* collisionTable,
+               RaycastHit& hit) const;
+
+  /** Returns the chunk that contains a position **/
+  [[nodiscard]] Chunk& GetChunk(WorldPos pos)
+  {
+    const u32 chunkX = pos.X() / CHUNK_SIZE;
+    const u32 chunkY = pos.Y() / CHUNK_SIZE;
+    return mChunks[chunkY * mChunkCountX + chunkX];
+  }
+
+  /** Returns the chunk that contains a position **/
+  [[nodiscard]] const Chunk& GetChunk(WorldPos pos) const
+  {
+    const u32 chunkX = pos.X() / CHUNK_SIZE;
+    const u32 chunkY = pos.Y() / CHUNK_SIZE;
+    return mChunks[chunkY * mChunkCountX + chunkX];
+  }
+
+  /** Returns the index of a position inside of its chunk **/
+  [[nodiscard]] static u32 GetChunkLocalIndex(WorldPos pos)
+  {
+    return (pos.Y() % CHUNK_SIZE) * CHUNK_SIZE + pos.X() % CHUNK_SIZE;
+  }
+
+  /** Set the ID of the tile at a position without notifying anyone **/
+  void SetTileID(WorldPos pos, TileRegistry::TileID id);
+
+  /** Set the ID of the wall at a position without notifying anyone **/
+  void SetWallID(WorldPos pos, WallRegistry::WallID id);
+
+  /** Add a chunk to the list of chunks with random ticks if any tile in its
+   * palette has random ticks **/
+  void TrackRandomTicks(u32 chunkIndex);
+
+  /** Run the scheduled ticks that are due **/
+  void UpdateScheduledTicks();
+
+  /** Run the random ticks of the chunks whose turn it is **/
+  void UpdateRandomTicks();
+
+  /** Set all cells from serialized cells, one for each position in the
+   * terrain **/
+  void LoadCells(const u8* source);
+
+  /** Serialize all cells **/
+  void StoreCells(alflib::MemoryWriter& writer) const;
+
   /** Implementation of 'SetTile' with more flags to determine how it works **/
   bool SetTileAdvanced(WorldPos pos,
                        TileRegistry::TileID id,
@@ -222,6 +494,35 @@ private:
 
   /** Update sub-resource indices **/
   void UpdateCachedWallIndices(WorldPos pos, bool updateNeighbours = true);
+
+  /** Returns the index of a cell **/
+  [[nodiscard]] u32 GetCellIndex(WorldPos pos) const
+  {
+    return mWidth * pos.Y() + pos.X();
+  }
+
+  /** Returns the position of a cell index **/
+  [[nodiscard]] WorldPos GetCellPosition(u32 index) const
+  {
+    return WorldPos{ index % mWidth, index / mWidth };
+  }
+
+  /** Begin an edit batch **/
+  void BeginBatch();
+
+  /** End an edit batch and apply the deferred updates if it was the outermost
+   * batch **/
+  void EndBatch();
+
+  /** Record an edit of the tile or wall of a cell in the current batch **/
+  void RecordBatchEdit(WorldPos pos,
+                       bool updateNeighbours,
+                       std::vector<u32>& cells,
+                       std::vector<u32>& neighbourCells);
+
+  /** Append the indices of the valid neighbours of each cell to 'out' **/
+  void GatherNeighbourIndices(const std::vector<u32>& cells,
+                              std::vector<u32>& out) const;
 };
 
 }
\ No newline at end of file
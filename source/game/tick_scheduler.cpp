@@ -0,0 +1,128 @@
+#include "game/tick_scheduler.hpp"
+
+// ========================================================================== //
+// Headers
+// ========================================================================== //
+
+#include <algorithm>
+
+// ========================================================================== //
+// TickScheduler Implementation
+// ========================================================================== //
+
+namespace dib::game {
+
+void
+TickScheduler::Schedule(u32 key, u64 delay)
+{
+  const u64 tick = mTick + std::clamp(delay, u64(1), MAX_DELAY);
+  auto it = mScheduled.find(key);
+  if (it != mScheduled.end()) {
+    if (it->second <= tick) {
+      return;
+    }
+    // The old entry is left in the wheel and is dropped once reached
+    it.value() = tick;
+  } else {
+    mScheduled.insert({ key, tick });
+  }
+  Insert(Entry{ key, tick });
+}
+
+// -------------------------------------------------------------------------- //
+
+bool
+TickScheduler::IsScheduled(u32 key) const
+{
+  return mScheduled.find(key) != mScheduled.end();
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+TickScheduler::Advance()
+{
+  mTick++;
+
+  // Move the entries of the slots that has been reached one level down,
+  // starting from the top so that they can cascade all the way to level zero
+  for (u32 level = LEVEL_COUNT - 1; level > 0; level--) {
+    const u64 mask = (u64(1) << (SLOT_BITS * level)) - 1;
+    if ((mTick & mask) != 0) {
+      continue;
+    }
+    Slot& slot =
+      mLevels[level][(mTick >> (SLOT_BITS * level)) & (SLOT_COUNT - 1)];
+    Slot entries;
+    std::swap(entries, slot);
+    for (const Entry& entry : entries) {
+      Insert(entry);
+    }
+  }
+
+  // Every entry in the current slot of level zero is due now
+  Slot& slot = mLevels[0][mTick & (SLOT_COUNT - 1)];
+  for (const Entry& entry : slot) {
+    auto it = mScheduled.find(entry.key);
+    if (it != mScheduled.end() && it->second == entry.tick) {
+      mScheduled.erase(it);
+      mReady.push_back(entry.key);
+    }
+  }
+  slot.clear();
+}
+
+// -------------------------------------------------------------------------- //
+
+u32
+TickScheduler::PopReady(u32 maxCount, std::vector<u32>& out)
+{
+  const u32 count = std::min(maxCount, GetReadyCount());
+  out.insert(out.end(),
+             mReady.begin() + mReadyHead,
+             mReady.begin() + mReadyHead + count);
+  mReadyHead += count;
+
+  // Drop the popped keys once they make up most of the queue
+  if (mReadyHead == mReady.size()) {
+    mReady.clear();
+    mReadyHead = 0;
+  } else if (mReadyHead > mReady.size() / 2) {
+    mReady.erase(mReady.begin(), mReady.begin() + mReadyHead);
+    mReadyHead = 0;
+  }
+  return count;
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+TickScheduler::Clear()
+{
+  for (auto& level : mLevels) {
+    for (Slot& slot : level) {
+      slot.clear();
+    }
+  }
+  mScheduled.clear();
+  mReady.clear();
+  mReadyHead = 0;
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+TickScheduler::Insert(const Entry& entry)
+{
+  // Lowest level that can hold the delay
+  const u64 delay = entry.tick - mTick;
+  u32 level = 0;
+  while (level + 1 < LEVEL_COUNT &&
+         delay >= (u64(1) << (SLOT_BITS * (level + 1)))) {
+    level++;
+  }
+  const u64 slot = (entry.tick >> (SLOT_BITS * level)) & (SLOT_COUNT - 1);
+  mLevels[level][slot].push_back(entry);
+}
+
+}
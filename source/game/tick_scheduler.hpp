@@ -0,0 +1,109 @@
+#pragma once
+
+// ========================================================================== //
+// Headers
+// ========================================================================== //
+
+#include <array>
+#include <vector>
+
+#include <tsl/robin_map.h>
+
+#include "core/types.hpp"
+
+// ========================================================================== //
+// TickScheduler Declaration
+// ========================================================================== //
+
+namespace dib::game {
+
+/** Hierarchical timing wheel of keys that are due at a future tick.
+ *
+ * Each level of the wheel has 'SLOT_COUNT' slots, where a slot in level N
+ * covers SLOT_COUNT^N ticks. Entries are placed in the lowest level that can
+ * hold their delay and are moved down one level when the wheel reaches their
+ * slot, which means that both scheduling and advancing is constant time per
+ * entry.
+ *
+ * Each key can only be scheduled once. Scheduling a key again keeps the
+ * earliest of the two ticks. Keys that are due are moved to a ready queue,
+ * which is drained at a limited rate so that a burst of due keys is spread
+ * out over several ticks **/
+class TickScheduler
+{
+public:
+  /** Number of bits of the tick that each level covers **/
+  static constexpr u32 SLOT_BITS = 6;
+  /** Number of slots in each level **/
+  static constexpr u32 SLOT_COUNT = 1u << SLOT_BITS;
+  /** Number of levels **/
+  static constexpr u32 LEVEL_COUNT = 4;
+  /** Maximum delay, longer delays are clamped **/
+  static constexpr u64 MAX_DELAY = (u64(1) << (SLOT_BITS * LEVEL_COUNT)) - 1;
+
+private:
+  /** Scheduled key **/
+  struct Entry
+  {
+    /** Key **/
+    u32 key;
+    /** Tick that the key is due **/
+    u64 tick;
+  };
+
+  /** Slot of entries **/
+  using Slot = std::vector<Entry>;
+
+  /** Current tick **/
+  u64 mTick = 0;
+  /** Levels of slots **/
+  std::array<std::array<Slot, SLOT_COUNT>, LEVEL_COUNT> mLevels;
+  /** Tick of each scheduled key. Entries whose tick does not match this are
+   * stale and are dropped when their slot is reached **/
+  tsl::robin_map<u32, u64> mScheduled;
+
+  /** Keys that are due but have not been popped yet **/
+  std::vector<u32> mReady;
+  /** Index of the first key in the ready queue **/
+  u32 mReadyHead = 0;
+
+public:
+  /** Schedule a key to be due after 'delay' ticks. A delay of zero is treated
+   * as a delay of one tick **/
+  void Schedule(u32 key, u64 delay);
+
+  /** Returns whether a key is scheduled and not yet due **/
+  [[nodiscard]] bool IsScheduled(u32 key) const;
+
+  /** Advance the wheel one tick and move the keys that are due to the ready
+   * queue **/
+  void Advance();
+
+  /** Pop at most 'maxCount' keys from the ready queue and append them to
+   * 'out'. Returns the number of keys popped **/
+  u32 PopReady(u32 maxCount, std::vector<u32>& out);
+
+  /** Remove all scheduled and ready keys **/
+  void Clear();
+
+  /** Returns the current tick **/
+  [[nodiscard]] u64 GetTick() const { return mTick; }
+
+  /** Returns the number of scheduled keys that are not yet due **/
+  [[nodiscard]] u32 GetScheduledCount() const
+  {
+    return u32(mScheduled.size());
+  }
+
+  /** Returns the number of keys in the ready queue **/
+  [[nodiscard]] u32 GetReadyCount() const
+  {
+    return u32(mReady.size()) - mReadyHead;
+  }
+
+private:
+  /** Place an entry in the slot that matches its tick **/
+  void Insert(const Entry& entry);
+};
+
+}
@@ -0,0 +1,63 @@
+#include "tick_stats.hpp"
+#include <dlog.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace dib::game {
+
+void
+TickStats::RecordTick(const f64 seconds)
+{
+  if (durations_.size() < kWindowSize) {
+    durations_.push_back(static_cast<f32>(seconds));
+  } else {
+    durations_[next_] = static_cast<f32>(seconds);
+    next_ = (next_ + 1) % kWindowSize;
+  }
+  tick_count_++;
+}
+
+f64
+TickStats::GetPercentile(const f64 percentile) const
+{
+  if (durations_.empty()) {
+    return 0.0;
+  }
+  sorted_ = durations_;
+  const f64 rank =
+    std::clamp(percentile, 0.0, 100.0) / 100.0 * (sorted_.size() - 1);
+  const auto index = static_cast<std::size_t>(std::lround(rank));
+  std::nth_element(sorted_.begin(), sorted_.begin() + index, sorted_.end());
+  return sorted_[index];
+}
+
+f64
+TickStats::GetMax() const
+{
+  if (durations_.empty()) {
+    return 0.0;
+  }
+  return *std::max_element(durations_.begin(), durations_.end());
+}
+
+void
+TickStats::Reset()
+{
+  durations_.clear();
+  next_ = 0;
+  tick_count_ = 0;
+}
+
+std::string
+TickStats::ToString() const
+{
+  return dlog::Format(
+    "ticks {}, p50 {:.2f}ms, p90 {:.2f}ms, p99 {:.2f}ms, max {:.2f}ms",
+    tick_count_,
+    GetPercentile(50) * 1000.0,
+    GetPercentile(90) * 1000.0,
+    GetPercentile(99) * 1000.0,
+    GetMax() * 1000.0);
+}
+
+}
@@ -0,0 +1,59 @@
+#ifndef TICK_STATS_HPP_
+#define TICK_STATS_HPP_
+
+#include "core/types.hpp"
+#include <string>
+#include <vector>
+
+namespace dib::game {
+
+/**
+ * Keeps the durations of the most recent ticks and answers percentiles over
+ * them, for finding out how close a tick is to its budget under load.
+ */
+class TickStats
+{
+public:
+  /**
+   * Number of ticks that the percentiles are computed over.
+   */
+  static constexpr u32 kWindowSize = 1u << 14u;
+
+  // ============================================================ //
+
+  void RecordTick(f64 seconds);
+
+  /**
+   * @param percentile In [0, 100].
+   * @return Duration in seconds, or 0 if no ticks have been recorded.
+   */
+  f64 GetPercentile(f64 percentile) const;
+
+  f64 GetMax() const;
+
+  /**
+   * Number of ticks recorded since the last reset, not limited by the window.
+   */
+  u64 GetTickCount() const { return tick_count_; }
+
+  void Reset();
+
+  /**
+   * "ticks 1234, p50 1.20ms, p90 2.00ms, p99 4.10ms, max 9.00ms"
+   */
+  std::string ToString() const;
+
+  // ============================================================ //
+
+private:
+  std::vector<f32> durations_{};
+  u32 next_{ 0 };
+  u64 tick_count_{ 0 };
+
+  /** Sorted copy of the window, reused between queries. */
+  mutable std::vector<f32> sorted_{};
+};
+
+}
+
+#endif // TICK_STATS_HPP_
@@ -58,6 +58,19 @@ Tile::OnNeighbourChange([[maybe_unused]] World& world,
 
 // -------------------------------------------------------------------------- //
 
+void
+Tile::OnScheduledTick([[maybe_unused]] World& world,
+                      [[maybe_unused]] WorldPos pos)
+{}
+
+// -------------------------------------------------------------------------- //
+
+void
+Tile::OnRandomTick([[maybe_unused]] World& world, [[maybe_unused]] WorldPos pos)
+{}
+
+// -------------------------------------------------------------------------- //
+
 bool
 Tile::IsMultiTile([[maybe_unused]] World& world, [[maybe_unused]] WorldPos pos)
 {
@@ -182,6 +195,14 @@ Tile::SetCollisionType(CollisionType collisionType)
 
 // -------------------------------------------------------------------------- //
 
+CollisionType
+Tile::GetCollisionType() const
+{
+  return mCollisionType;
+}
+
+// -------------------------------------------------------------------------- //
+
 f32
 Tile::GetHardness([[maybe_unused]] World& world, [[maybe_unused]] WorldPos pos)
 {
@@ -268,6 +289,23 @@ Tile::SetCanBeReplaced(bool canBeReplaced)
 
 // -------------------------------------------------------------------------- //
 
+bool
+Tile::HasRandomTick()
+{
+  return mHasRandomTick;
+}
+
+// -------------------------------------------------------------------------- //
+
+Tile*
+Tile::SetHasRandomTick(bool hasRandomTick)
+{
+  mHasRandomTick = hasRandomTick;
+  return this;
+}
+
+// -------------------------------------------------------------------------- //
+
 bool
 Tile::HasTileEntity([[maybe_unused]] World& world,
                     [[maybe_unused]] WorldPos pos)
@@ -46,11 +46,16 @@ DIB_FORWARD_DECLARE_CLASS(World);
  *   A light emitter emits light of a given strength and color. The strength and
  *   color are other properties of a tile
  *
- * - LightStrength:
+ * - LightStrength: Strength of the emitted light in the range [0, 1].
  *
- * - LightColor:
+ * - LightColor: Color of the emitted light.
  *
- * - Opacity:
+ * - Opacity: How much the tile blocks light in the range [0, 1]. Only fully
+ *   transparent tiles lets sky light through.
+ *
+ *   Note that the light properties are queried from the threads of the light
+ *   map, which means that overrides of these functions must not modify any
+ *   state.
  *
  * - Collision:
  *
@@ -65,6 +70,11 @@ DIB_FORWARD_DECLARE_CLASS(World);
  * - CanBeReplaced: This property determines if the tile can be replaced with
  *   another tile without it first being removed.
  *
+ * - HasRandomTick: This property determines if the tile receives random ticks.
+ *   Each update a few random cells of each chunk that contains such a tile are
+ *   picked and 'OnRandomTick' is called for them, which is suitable for slow
+ *   processes like growth.
+ *
  *
  * **/
 class Tile
@@ -100,6 +110,8 @@ protected:
   bool mIsDestructible = true;
   /** Whether the tile can be replaced **/
   bool mCanBeReplaced = false;
+  /** Whether the tile receives random ticks **/
+  bool mHasRandomTick = false;
 
 public:
   /** Construct a tile by specifying the path to the resource. This resource
@@ -128,6 +140,14 @@ public:
   /** Called when one of the neighbouring eight (8) tiles has changed **/
   virtual void OnNeighbourChange(World& world, WorldPos pos);
 
+  /** Called when a tick that was scheduled with 'Terrain::ScheduleTick' for
+   * the position is due **/
+  virtual void OnScheduledTick(World& world, WorldPos pos);
+
+  /** Called when the tile has been picked for a random tick. Only called if
+   * the tile has random ticks **/
+  virtual void OnRandomTick(World& world, WorldPos pos);
+
   /** Returns whether or not the tile is a multi-tile object **/
   virtual bool IsMultiTile(World& world, WorldPos pos);
 
@@ -183,6 +203,10 @@ public:
   /** Sets the collision type of the tile **/
   virtual Tile* SetCollisionType(CollisionType collisionType);
 
+  /** Returns the collision type that was set with 'SetCollisionType'. This is
+   * the type that is stored in the collision table of the tile registry **/
+  [[nodiscard]] CollisionType GetCollisionType() const;
+
   /** Returns the hardness of the tile at the given position in the world **/
   [[nodiscard]] virtual f32 GetHardness(World& world, WorldPos pos);
 
@@ -213,6 +237,12 @@ public:
   /** Sets whether or not the tile can be replaced **/
   virtual Tile* SetCanBeReplaced(bool canBeReplaced);
 
+  /** Returns whether or not the tile receives random ticks **/
+  [[nodiscard]] virtual bool HasRandomTick();
+
+  /** Sets whether or not the tile receives random ticks **/
+  virtual Tile* SetHasRandomTick(bool hasRandomTick);
+
   /** Returns whether or not this tile has a corresponding tile entity **/
   virtual bool HasTileEntity(World& world, WorldPos pos);
 
@@ -6,6 +6,8 @@
 
 namespace dib::game {
 
-TileEntity::TileEntity([[maybe_unused]] WorldPos pos) {}
+TileEntity::TileEntity(WorldPos pos)
+  : mPosition(pos)
+{}
 
-}
\ No newline at end of file
+}
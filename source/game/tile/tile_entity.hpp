@@ -13,9 +13,25 @@
 namespace dib::game {
 
 /** Class that represents an entity connected to a single tile in the world.
- * This is used to implement special behaviour for tiles **/
+ * This is used to implement special behaviour for tiles.
+ *
+ * Tile entities are owned by the 'TileEntityManager' of the world. A tile
+ * entity is awake when created and is updated each tick until it calls
+ * 'Sleep'. It is then not updated again until it is woken up by the manager,
+ * for example when a neighbouring cell changes **/
 class TileEntity
 {
+  friend class TileEntityManager;
+
+private:
+  /** Position of the tile **/
+  WorldPos mPosition;
+  /** Whether the tile entity is awake **/
+  bool mAwake = false;
+  /** Whether the tile entity is in the active set of the manager. A sleeping
+   * tile entity stays in the set until the end of the next update **/
+  bool mInActiveSet = false;
+
 public:
   /** Construct tile entity at position **/
   TileEntity(WorldPos pos);
@@ -26,11 +42,25 @@ public:
   /** Called to update the tile entity **/
   virtual void Update(){};
 
+  /** Called when the tile entity has been woken up **/
+  virtual void OnWake(){};
+
   /** Called when the tile entity should be loaded from a value-store **/
   virtual void OnLoad([[maybe_unused]] ValueStore& valueStore){};
 
   /** Called when the tile entity should be saved to a value-store **/
   virtual void OnStore([[maybe_unused]] ValueStore& valueStore){};
+
+  /** Returns the position of the tile **/
+  [[nodiscard]] WorldPos GetPosition() const { return mPosition; }
+
+  /** Returns whether the tile entity is awake **/
+  [[nodiscard]] bool IsAwake() const { return mAwake; }
+
+protected:
+  /** Stop updating the tile entity until it is woken up. Idle tile entities
+   * should call this from 'Update' **/
+  void Sleep() { mAwake = false; }
 };
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,378 @@
+#include "game/tile/tile_entity_manager.hpp"
+
+// ========================================================================== //
+// Headers
+// ========================================================================== //
+
+#include <algorithm>
+
+#include <alflib/memory/raw_memory_reader.hpp>
+#include <alflib/memory/raw_memory_writer.hpp>
+#include <microprofile/microprofile.h>
+
+#include "core/assert.hpp"
+#include "core/schema.hpp"
+#include "core/value_store.hpp"
+#include "game/terrain.hpp"
+#include "game/tile/tile.hpp"
+#include "game/tile/tile_entity.hpp"
+
+// ========================================================================== //
+// TileEntityManager Implementation
+// ========================================================================== //
+
+namespace dib::game {
+
+TileEntityManager::TileEntityManager(World* world)
+  : mWorld(world)
+{}
+
+// -------------------------------------------------------------------------- //
+
+TileEntityManager::TileEntityManager(TileEntityManager&& other) noexcept
+  : mWorld(other.mWorld)
+  , mChunks(std::move(other.mChunks))
+  , mUnloadedChunks(std::move(other.mUnloadedChunks))
+  , mActive(std::move(other.mActive))
+  , mEntityCount(other.mEntityCount)
+{
+  other.mEntityCount = 0;
+}
+
+// -------------------------------------------------------------------------- //
+
+TileEntityManager::~TileEntityManager() = default;
+
+// -------------------------------------------------------------------------- //
+
+TileEntityManager&
+TileEntityManager::operator=(TileEntityManager&& other) noexcept
+{
+  if (this != &other) {
+    mWorld = other.mWorld;
+    mChunks = std::move(other.mChunks);
+    mUnloadedChunks = std::move(other.mUnloadedChunks);
+    mActive = std::move(other.mActive);
+    mEntityCount = other.mEntityCount;
+    other.mEntityCount = 0;
+  }
+  return *this;
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+TileEntityManager::Update()
+{
+  if (mActive.empty()) {
+    return;
+  }
+  MICROPROFILE_SCOPEI("TileEntityManager", "Update", MP_ORANGE);
+
+  // Tile entities that are woken up during the update are appended to the
+  // active set and are first updated during the next tick
+  mUpdating = true;
+  const std::size_t count = mActive.size();
+  for (std::size_t i = 0; i < count; i++) {
+    TileEntity* entity = mActive[i];
+    if (entity->mAwake) {
+      entity->Update();
+    }
+  }
+  mUpdating = false;
+
+  // Remove the tile entities that went to sleep or were removed
+  auto sleeping = [](TileEntity* entity) {
+    if (entity->mAwake) {
+      return false;
+    }
+    entity->mInActiveSet = false;
+    return true;
+  };
+  mActive.erase(std::remove_if(mActive.begin(), mActive.end(), sleeping),
+                mActive.end());
+  mRemoved.clear();
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+TileEntityManager::OnTileChanged(WorldPos pos)
+{
+  // Editing the terrain of an unloaded chunk would otherwise leave stale tile
+  // entities in its stored data
+  if (!mUnloadedChunks.empty()) {
+    LoadChunk(GetChunkKey(pos));
+  }
+
+  Remove(pos);
+  Create(pos);
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+TileEntityManager::Wake(WorldPos pos)
+{
+  TileEntity* entity = Get(pos);
+  if (entity && !entity->mAwake) {
+    Activate(entity);
+    entity->OnWake();
+  }
+}
+
+// -------------------------------------------------------------------------- //
+
+TileEntity*
+TileEntityManager::Get(WorldPos pos) const
+{
+  const auto chunk = mChunks.find(GetChunkKey(pos));
+  if (chunk == mChunks.end()) {
+    return nullptr;
+  }
+  const auto entity = chunk->second.find(GetCellKey(pos));
+  return entity != chunk->second.end() ? entity->second.get() : nullptr;
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+TileEntityManager::Clear()
+{
+  DIB_ASSERT(!mUpdating, "Tile entities cannot be cleared during update");
+  mActive.clear();
+  mChunks.clear();
+  mUnloadedChunks.clear();
+  mEntityCount = 0;
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+TileEntityManager::UnloadChunk(ChunkKey chunk)
+{
+  auto it = mChunks.find(chunk);
+  if (it == mChunks.end()) {
+    return;
+  }
+
+  std::vector<u8> data;
+  StoreChunk(it->second, data);
+  mUnloadedChunks[chunk] = std::move(data);
+
+  Chunk entities = std::move(it.value());
+  mChunks.erase(it);
+  for (auto entity = entities.begin(); entity != entities.end(); ++entity) {
+    Destroy(std::move(entity.value()));
+  }
+  mEntityCount -= u32(entities.size());
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+TileEntityManager::LoadChunk(ChunkKey chunk)
+{
+  auto it = mUnloadedChunks.find(chunk);
+  if (it == mUnloadedChunks.end()) {
+    return;
+  }
+
+  const std::vector<u8> data = std::move(it.value());
+  mUnloadedChunks.erase(it);
+  LoadChunkData(chunk, data.data(), data.size());
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+TileEntityManager::Store(alflib::MemoryWriter& writer) const
+{
+  writer.Write(u32(mChunks.size() + mUnloadedChunks.size()));
+
+  std::vector<u8> data;
+  for (const auto& [chunk, entities] : mChunks) {
+    StoreChunk(entities, data);
+    writer.Write(chunk);
+    writer.Write(u32(data.size()));
+    writer.WriteBytes(data.data(), data.size());
+  }
+  for (const auto& [chunk, stored] : mUnloadedChunks) {
+    writer.Write(chunk);
+    writer.Write(u32(stored.size()));
+    writer.WriteBytes(const_cast<u8*>(stored.data()), stored.size());
+  }
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+TileEntityManager::Load(alflib::MemoryReader& reader)
+{
+  Clear();
+
+  const u32 chunkCount = reader.Read<u32>();
+  for (u32 i = 0; i < chunkCount; i++) {
+    const ChunkKey chunk = reader.Read<ChunkKey>();
+    const u32 size = reader.Read<u32>();
+    const u8* data = reader.ReadBytes(size);
+    LoadChunkData(chunk, data, size);
+  }
+}
+
+// -------------------------------------------------------------------------- //
+
+TileEntityManager::ChunkKey
+TileEntityManager::GetChunkKey(WorldPos pos)
+{
+  const u32 chunkX = pos.X() / Terrain::CHUNK_SIZE;
+  const u32 chunkY = pos.Y() / Terrain::CHUNK_SIZE;
+  return (chunkY << 16u) | chunkX;
+}
+
+// -------------------------------------------------------------------------- //
+
+TileEntityManager::CellKey
+TileEntityManager::GetCellKey(WorldPos pos)
+{
+  return CellKey((pos.Y() % Terrain::CHUNK_SIZE) * Terrain::CHUNK_SIZE +
+                 pos.X() % Terrain::CHUNK_SIZE);
+}
+
+// -------------------------------------------------------------------------- //
+
+WorldPos
+TileEntityManager::GetCellPosition(ChunkKey chunk, CellKey cell)
+{
+  return WorldPos{ (chunk & 0xFFFFu) * Terrain::CHUNK_SIZE +
+                     cell % Terrain::CHUNK_SIZE,
+                   (chunk >> 16u) * Terrain::CHUNK_SIZE +
+                     cell / Terrain::CHUNK_SIZE };
+}
+
+// -------------------------------------------------------------------------- //
+
+TileEntity*
+TileEntityManager::Create(WorldPos pos)
+{
+  Tile* tile = mWorld->GetTerrain().GetTile(pos);
+  if (!tile->HasTileEntity(*mWorld, pos)) {
+    return nullptr;
+  }
+  std::unique_ptr<TileEntity> entity = tile->CreateTileEntity(*mWorld, pos);
+  if (!entity) {
+    return nullptr;
+  }
+
+  TileEntity* result = entity.get();
+  mChunks[GetChunkKey(pos)][GetCellKey(pos)] = std::move(entity);
+  mEntityCount++;
+  Activate(result);
+  return result;
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+TileEntityManager::Remove(WorldPos pos)
+{
+  auto chunk = mChunks.find(GetChunkKey(pos));
+  if (chunk == mChunks.end()) {
+    return;
+  }
+  auto it = chunk.value().find(GetCellKey(pos));
+  if (it == chunk.value().end()) {
+    return;
+  }
+
+  std::unique_ptr<TileEntity> entity = std::move(it.value());
+  chunk.value().erase(it);
+  if (chunk->second.empty()) {
+    mChunks.erase(chunk);
+  }
+  mEntityCount--;
+  Destroy(std::move(entity));
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+TileEntityManager::Activate(TileEntity* entity)
+{
+  entity->mAwake = true;
+  if (!entity->mInActiveSet) {
+    entity->mInActiveSet = true;
+    mActive.push_back(entity);
+  }
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+TileEntityManager::Destroy(std::unique_ptr<TileEntity> entity)
+{
+  // The active set is compacted at the end of the update, the tile entity must
+  // therefore be alive until then
+  if (mUpdating) {
+    entity->mAwake = false;
+    mRemoved.push_back(std::move(entity));
+    return;
+  }
+
+  if (entity->mInActiveSet) {
+    const auto it = std::find(mActive.begin(), mActive.end(), entity.get());
+    *it = mActive.back();
+    mActive.pop_back();
+  }
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+TileEntityManager::StoreChunk(const Chunk& chunk, std::vector<u8>& out)
+{
+  // Store the entities first so that the exact size is known
+  std::vector<std::pair<CellKey, ValueStore>> stored;
+  stored.reserve(chunk.size());
+  u64 size = sizeof(u32);
+  for (const auto& [cell, entity] : chunk) {
+    ValueStore valueStore;
+    entity->OnStore(valueStore);
+    size += sizeof(CellKey) + valueStore.SerializedSize();
+    stored.emplace_back(cell, std::move(valueStore));
+  }
+
+  out.resize(size);
+  alflib::RawMemoryWriter mw(out.data(), out.size());
+  bool ok = Serializer<u32>::Write(mw, u32(stored.size()));
+  for (const auto& [cell, valueStore] : stored) {
+    ok = ok && Serializer<CellKey>::Write(mw, cell) && valueStore.ToBytes(mw);
+  }
+  AlfAssert(ok && mw.GetOffset() == size, "tile entity size was not exact");
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+TileEntityManager::LoadChunkData(ChunkKey chunk, const u8* data, u64 size)
+{
+  alflib::RawMemoryReader mr(data, size);
+  const u32 count = Serializer<u32>::Read(mr);
+  for (u32 i = 0; i < count; i++) {
+    const CellKey cell = Serializer<CellKey>::Read(mr);
+    ValueStore valueStore = ValueStore::FromBytes(mr);
+
+    // The tile may have changed since the tile entity was stored, in which
+    // case the stored state is dropped
+    const WorldPos pos = GetCellPosition(chunk, cell);
+    if (!mWorld->GetTerrain().IsValidPosition(pos)) {
+      continue;
+    }
+    Remove(pos);
+    if (TileEntity* entity = Create(pos)) {
+      entity->OnLoad(valueStore);
+    }
+  }
+}
+
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+// ========================================================================== //
+// Headers
+// ========================================================================== //
+
+#include <memory>
+#include <vector>
+
+#include <alflib/memory/memory_reader.hpp>
+#include <alflib/memory/memory_writer.hpp>
+#include <tsl/robin_map.h>
+
+#include "core/types.hpp"
+#include "core/macros.hpp"
+#include "game/world_pos.hpp"
+
+// ========================================================================== //
+// TileEntityManager Declaration
+// ========================================================================== //
+
+namespace dib::game {
+
+DIB_FORWARD_DECLARE_CLASS(World);
+DIB_FORWARD_DECLARE_CLASS(TileEntity);
+
+/** Owner of all tile entities in a world.
+ *
+ * Tile entities are stored sparsely in hash maps keyed by their position and
+ * grouped by terrain chunk, so that the cost of a world without furnaces or
+ * chests is zero. Only tile entities in the active set are updated each tick.
+ * A tile entity leaves the active set by calling 'TileEntity::Sleep' and is
+ * woken up again when a neighbouring cell changes or when 'Wake' is called.
+ *
+ * Chunks can be unloaded, in which case the tile entities of the chunk are
+ * stored as value-stores in the same format as in the world save and are not
+ * kept in memory as objects **/
+class TileEntityManager
+{
+public:
+  /** Key of a chunk **/
+  using ChunkKey = u32;
+  /** Key of a cell inside of a chunk **/
+  using CellKey = u16;
+
+private:
+  /** Tile entities of a loaded chunk **/
+  using Chunk = tsl::robin_map<CellKey, std::unique_ptr<TileEntity>>;
+
+  /** World **/
+  World* mWorld;
+
+  /** Loaded chunks that contain at least one tile entity **/
+  tsl::robin_map<ChunkKey, Chunk> mChunks;
+  /** Serialized tile entities of unloaded chunks **/
+  tsl::robin_map<ChunkKey, std::vector<u8>> mUnloadedChunks;
+
+  /** Tile entities that are awake **/
+  std::vector<TileEntity*> mActive;
+  /** Tile entities that were removed during the update and must be kept alive
+   * until it has finished **/
+  std::vector<std::unique_ptr<TileEntity>> mRemoved;
+  /** Whether the active set is currently being updated **/
+  bool mUpdating = false;
+
+  /** Number of loaded tile entities **/
+  u32 mEntityCount = 0;
+
+public:
+  /** Construct manager for a world **/
+  explicit TileEntityManager(World* world);
+
+  /** Move-construct **/
+  TileEntityManager(TileEntityManager&& other) noexcept;
+
+  /** Destruct **/
+  ~TileEntityManager();
+
+  /** Move-assign **/
+  TileEntityManager& operator=(TileEntityManager&& other) noexcept;
+
+  /** Update all tile entities that are awake **/
+  void Update();
+
+  /** Called when the tile at a position has been replaced. The old tile entity
+   * is removed and a new one is created if the new tile has a tile entity **/
+  void OnTileChanged(WorldPos pos);
+
+  /** Wake up the tile entity at a position, does nothing if there is no tile
+   * entity there **/
+  void Wake(WorldPos pos);
+
+  /** Returns the tile entity at a position, or nullptr if there is none or if
+   * the chunk has been unloaded **/
+  [[nodiscard]] TileEntity* Get(WorldPos pos) const;
+
+  /** Remove all tile entities, including the unloaded ones **/
+  void Clear();
+
+  /** Serialize the tile entities of a chunk and destroy them. The tile
+   * entities are recreated when the chunk is loaded again **/
+  void UnloadChunk(ChunkKey chunk);
+
+  /** Recreate the tile entities of an unloaded chunk **/
+  void LoadChunk(ChunkKey chunk);
+
+  /** Store all tile entities **/
+  void Store(alflib::MemoryWriter& writer) const;
+
+  /** Load tile entities that was stored with 'Store' **/
+  void Load(alflib::MemoryReader& reader);
+
+  /** Returns the number of loaded tile entities **/
+  [[nodiscard]] u32 GetEntityCount() const { return mEntityCount; }
+
+  /** Returns the number of tile entities that are awake **/
+  [[nodiscard]] u32 GetActiveCount() const { return u32(mActive.size()); }
+
+  /** Returns the key of the chunk that contains a position **/
+  [[nodiscard]] static ChunkKey GetChunkKey(WorldPos pos);
+
+private:
+  /** Returns the key of a position inside of its chunk **/
+  [[nodiscard]] static CellKey GetCellKey(WorldPos pos);
+
+  /** Returns the position of a cell in a chunk **/
+  [[nodiscard]] static WorldPos GetCellPosition(ChunkKey chunk, CellKey cell);
+
+  /** Create the tile entity for the tile at a position. Returns nullptr if the
+   * tile does not have a tile entity **/
+  TileEntity* Create(WorldPos pos);
+
+  /** Remove the tile entity at a position **/
+  void Remove(WorldPos pos);
+
+  /** Wake up a tile entity and add it to the active set **/
+  void Activate(TileEntity* entity);
+
+  /** Destroy a tile entity that has been removed from its chunk. This is
+   * deferred to the end of the update if the manager is updating **/
+  void Destroy(std::unique_ptr<TileEntity> entity);
+
+  /** Serialize the tile entities of a chunk **/
+  static void StoreChunk(const Chunk& chunk, std::vector<u8>& out);
+
+  /** Create the tile entities of a chunk from serialized data **/
+  void LoadChunkData(ChunkKey chunk, const u8* data, u64 size);
+};
+
+}
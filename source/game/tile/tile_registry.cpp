@@ -62,6 +62,7 @@ TileRegistry::RegisterTile(const String& registryKey, Tile* tile)
 
   // Register tile with next ID
   mTiles.push_back(tile);
+  mCollisionTable.push_back(tile->GetCollisionType());
   const TileID id = mTiles.size() - 1;
 
   // Setup maps
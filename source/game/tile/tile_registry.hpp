@@ -31,6 +31,8 @@ public:
 private:
   /** List of registered tiles. Indices in the array are their IDs **/
   std::vector<Tile*> mTiles;
+  /** Collision type of each registered tile, indexed by ID **/
+  std::vector<CollisionType> mCollisionTable;
   /** Map of tiles from their register-key to their IDs **/
   tsl::robin_map<String, TileID> mTileRegistryMap;
   /** Map of tiles from themselves to their IDs **/
@@ -77,6 +79,16 @@ public:
    * tile **/
   [[nodiscard]] const std::vector<Tile*>& GetTiles() const { return mTiles; }
 
+  /** Returns the collision type of each registered tile, indexed by ID. The
+   * table is filled in when the tiles are registered, which means that the
+   * collision type of a tile must be set before it's registered. Tiles that
+   * override 'Tile::GetCollision' per position are not reflected in the
+   * table **/
+  [[nodiscard]] const std::vector<CollisionType>& GetCollisionTable() const
+  {
+    return mCollisionTable;
+  }
+
   /** Returns the map of registered tiles. Keys are the registry names and the
    * value is the ID of the tile. This ID can then be used to index the vector
    * returned from 'GetTiles()'**/
@@ -19,30 +19,21 @@
 namespace dib::game {
 
 World::World()
-  : mTerrain(this, Terrain::Size::kNormal)
+  : World(Terrain::Size::kNormal)
 {}
 
 // -------------------------------------------------------------------------- //
 
-World::World(World&& other)
-  : mTerrain(std::move(other.mTerrain))
-  , entity_manager_(std::move(other.entity_manager_))
-  , network_(std::move(other.network_))
-  , chat_(std::move(other.chat_))
-{}
-
-// -------------------------------------------------------------------------- //
-
-World&
-World::operator=(World&& other)
+World::World(const Terrain::Size size)
+  : mTerrain(this, size)
 {
-  if (this != &other) {
-    mTerrain = std::move(other.mTerrain);
-    entity_manager_ = std::move(other.entity_manager_);
-    network_ = std::move(other.network_);
-    chat_ = std::move(other.chat_);
+  mTerrain.RegisterChangeListener(&moveable_waker_);
+
+  // Only the server moves agents along paths
+  if constexpr (kSide == Side::kServer) {
+    mTerrain.RegisterChangeListener(&path_finder_);
+    path_finder_.OnResize(mTerrain.GetWidth(), mTerrain.GetHeight());
   }
-  return *this;
 }
 
 // -------------------------------------------------------------------------- //
@@ -52,7 +43,14 @@ World::Update(const f64 delta)
 {
   MICROPROFILE_SCOPEI("world", "update", MP_BLUE);
   network_.Update();
+  mTerrain.Update();
   UpdateMoveables(*this, delta);
+  contact_detector_.Update();
+  tile_entity_manager_.Update();
+  if constexpr (kSide == Side::kServer) {
+    path_finder_.Update();
+  }
+  network_.Flush();
 }
 
 // -------------------------------------------------------------------------- //
@@ -125,6 +123,10 @@ World::Load(const Path& path)
 
   // Read world data
   u64 size = io.GetFile().GetSize();
+  if (size < sizeof(SAVE_MAGIC) + sizeof(SAVE_VERSION)) {
+    DLOG_WARNING("World file ({}) is too small", path.GetPathString());
+    return false;
+  }
   alflib::Buffer buffer(size);
   u64 read;
   result = io.Read(buffer.GetData(), size, read);
@@ -148,6 +150,21 @@ World::Load(const Path& path)
 bool
 World::Load(alflib::MemoryReader& reader)
 {
+  // Read header
+  for (char8 c : SAVE_MAGIC) {
+    if (reader.Read<u8>() != u8(c)) {
+      DLOG_WARNING("Failed to load world, the data is not a world");
+      return false;
+    }
+  }
+  const u32 version = reader.Read<u32>();
+  if (version != SAVE_VERSION) {
+    DLOG_WARNING("Failed to load world with version {}, expected {}",
+                 version,
+                 SAVE_VERSION);
+    return false;
+  }
+
   // Read tile table
   {
     u32 tileCount = reader.Read<u32>();
@@ -188,16 +205,15 @@ World::Load(alflib::MemoryReader& reader)
 
   u64 terrainSize = sizeof(Terrain::Cell) * width * height;
   const u8* source = reader.ReadBytes(terrainSize);
-  memcpy(mTerrain.mTerrainCells, source, terrainSize);
-
-  for (u32 y = 0; y < height; y++) {
-    for (u32 x = 0; x < width; x++) {
-      for (auto& listener : mTerrain.mChangeListeners) {
-        WorldPos pos{ x, y };
-        listener->OnTileChanged(pos);
-        listener->OnWallChanged(pos);
-      }
-    }
+  mTerrain.LoadCells(source);
+
+  // Tile entities are created after the cells, as they are created from the
+  // tiles
+  tile_entity_manager_.Load(reader);
+
+  if (width > 0 && height > 0) {
+    mTerrain.NotifyRegionChanged(WorldPos{ 0, 0 },
+                                 WorldPos{ width - 1, height - 1 });
   }
   return true;
 }
@@ -215,6 +231,12 @@ World::GetEntityManager()
 bool
 World::ToBytes(alflib::MemoryWriter& writer) const
 {
+  // Write header
+  for (char8 c : SAVE_MAGIC) {
+    writer.Write(u8(c));
+  }
+  writer.Write(SAVE_VERSION);
+
   // Write tile table
   writer.Write(u32(TileRegistry::Instance().GetRegistryMap().size()));
   for (const auto& entry : TileRegistry::Instance().GetRegistryMap()) {
@@ -241,20 +263,10 @@ World::ToBytes(alflib::MemoryWriter& writer) const
   writer.Write(mTerrain.mHeight);
 
   // Write data
-  writer.WriteBytes((u8*)mTerrain.mTerrainCells,
-                    sizeof(Terrain::Cell) * mTerrain.mWidth * mTerrain.mHeight);
+  mTerrain.StoreCells(writer);
+  tile_entity_manager_.Store(writer);
 
   return true;
 }
 
-// -------------------------------------------------------------------------- //
-
-World
-World::FromBytes(alflib::MemoryReader& reader)
-{
-  World world;
-  world.Load(reader);
-  return world;
-}
-
 }
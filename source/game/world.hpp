@@ -13,7 +13,12 @@
 #include "network/network.hpp"
 #include "network/side.hpp"
 #include "game/ecs/entity_manager.hpp"
+#include "game/gameplay/moveable.hpp"
 #include "game/terrain.hpp"
+#include "game/physics/contact_detector.hpp"
+#include "game/physics/path_finder.hpp"
+#include "game/physics/spatial_grid.hpp"
+#include "game/tile/tile_entity_manager.hpp"
 #include "game/chat/chat.hpp"
 #include "game/tile/tile_registry.hpp"
 
@@ -26,12 +31,24 @@ namespace dib::game {
 /** Class representing the game world **/
 class World
 {
+public:
+  /** Bytes that serialized worlds start with **/
+  static constexpr char8 SAVE_MAGIC[] = { 'D', 'I', 'B', 'W', 'L', 'D' };
+  /** Version of the serialized world, which follows the magic. Bump it when
+   * the format changes **/
+  static constexpr u32 SAVE_VERSION = 1;
+
 public:
   World();
 
-  World(World&& other);
+  /** Construct a world with terrain of the given size **/
+  explicit World(Terrain::Size size);
+
+  /** Worlds cannot be moved, the terrain listeners, contact detector, tile
+   * entity manager and path finder all point back at the world **/
+  World(World&& other) = delete;
 
-  World& operator=(World&& other);
+  World& operator=(World&& other) = delete;
 
   void Update(f64 delta);
 
@@ -47,7 +64,8 @@ public:
   /** Load world from path **/
   bool Load(const Path& path);
 
-  /** Load world from memory reader **/
+  /** Load world from memory reader. Fails if the data does not start with
+   * the magic and the version of 'SAVE_MAGIC' and 'SAVE_VERSION' **/
   bool Load(alflib::MemoryReader& reader);
 
   /** Returns the terrain of the world **/
@@ -59,19 +77,52 @@ public:
   /** Returns the entity manager **/
   dib::EntityManager& GetEntityManager();
 
+  /** Returns the spatial grid over all moveables **/
+  SpatialGrid& GetSpatialGrid() { return spatial_grid_; }
+
+  /** Returns the spatial grid over all moveables **/
+  const SpatialGrid& GetSpatialGrid() const { return spatial_grid_; }
+
+  /** Returns the detector of overlapping moveables **/
+  ContactDetector& GetContactDetector() { return contact_detector_; }
+
+  /** Returns the manager of all tile entities **/
+  TileEntityManager& GetTileEntityManager() { return tile_entity_manager_; }
+
+  /** Returns the manager of all tile entities **/
+  const TileEntityManager& GetTileEntityManager() const
+  {
+    return tile_entity_manager_;
+  }
+
+  /** Returns the path finder for agents walking on the terrain **/
+  PathFinder& GetPathFinder() { return path_finder_; }
+
+  /** Returns the state of the moveable broadcast of the server **/
+  MoveableBroadcast& GetMoveableBroadcast() { return moveable_broadcast_; }
+
   game::Chat& GetChat() { return chat_; }
 
   bool ToBytes(alflib::MemoryWriter& writer) const;
 
-public:
-  static World FromBytes(alflib::MemoryReader& reader);
-
 private:
   /** Terrain **/
   Terrain mTerrain;
 
   dib::EntityManager entity_manager_{};
 
+  SpatialGrid spatial_grid_{};
+
+  ContactDetector contact_detector_{ this };
+
+  TileEntityManager tile_entity_manager_{ this };
+
+  PathFinder path_finder_{ this };
+
+  MoveableWaker moveable_waker_{ this };
+
+  MoveableBroadcast moveable_broadcast_{};
+
   Network<kSide> network_{ this };
 
   game::Chat chat_{ this };
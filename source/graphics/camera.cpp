@@ -16,11 +16,7 @@ Camera::Camera(u32 width, u32 height)
   : mWidth(width)
   , mHeight(height)
 {
-  mProjectionMatrix =
-    glm::ortho(0.0f, f32(width), 0.0f, f32(height), -1.0f, 1.0f);
-  mViewMatrix = Matrix4F(1.0f);
-  glm::translate(mViewMatrix, Vector3F(0.0f, 0.0f, 0.0f));
-  mMatrix = mProjectionMatrix * mViewMatrix;
+  UpdateMatrices();
 }
 
 // -------------------------------------------------------------------------- //
@@ -38,11 +34,7 @@ Camera::Resize(u32 width, u32 height)
 {
   mWidth = width;
   mHeight = height;
-  mProjectionMatrix =
-    glm::ortho(0.0f, f32(width), 0.0f, f32(height), -1.0f, 1.0f);
-  mViewMatrix = Matrix4F(1.0f);
-  glm::translate(mViewMatrix, Vector3F(0.0f, 0.0f, 0.0f));
-  mMatrix = mProjectionMatrix * mViewMatrix;
+  UpdateMatrices();
 }
 
 // -------------------------------------------------------------------------- //
@@ -51,9 +43,7 @@ void
 Camera::Move(const Vector3F& distance)
 {
   mPosition += distance;
-  mViewMatrix = Matrix4F(1.0f);
-  glm::translate(mViewMatrix, mPosition);
-  mMatrix = mProjectionMatrix * mViewMatrix;
+  UpdateMatrices();
 }
 
 // -------------------------------------------------------------------------- //
@@ -64,6 +54,38 @@ Camera::ClampPosition(const Vector3F& min, const Vector3F& max)
   mPosition.x = alflib::Clamp(mPosition.x, min.x, max.x);
   mPosition.y = alflib::Clamp(mPosition.y, min.y, max.y);
   mPosition.z = alflib::Clamp(mPosition.z, min.z, max.z);
+  UpdateMatrices();
 }
 
-}
\ No newline at end of file
+// -------------------------------------------------------------------------- //
+
+void
+Camera::SetZoom(f32 zoom)
+{
+  mZoom = zoom;
+  UpdateMatrices();
+}
+
+// -------------------------------------------------------------------------- //
+
+Matrix4F
+Camera::CalculateViewProjectMatrix(f32 viewWidth,
+                                   f32 viewHeight,
+                                   const Vector3F& position)
+{
+  return glm::ortho(0.0f, viewWidth, 0.0f, viewHeight, -1.0f, 1.0f) *
+         glm::translate(Matrix4F(1.0f), -position);
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+Camera::UpdateMatrices()
+{
+  mProjectionMatrix =
+    glm::ortho(0.0f, GetViewWidth(), 0.0f, GetViewHeight(), -1.0f, 1.0f);
+  mViewMatrix = glm::translate(Matrix4F(1.0f), -mPosition);
+  mMatrix = mProjectionMatrix * mViewMatrix;
+}
+
+}
@@ -23,6 +23,9 @@ private:
 
   /** Position **/
   Vector3F mPosition = Vector3F(0.0f, 0.0f, 0.0f);
+  /** Zoom. This is the number of pixels on screen for each pixel in the
+   * world **/
+  f32 mZoom = 1.0f;
 
   /** View matrix **/
   Matrix4F mViewMatrix;
@@ -48,14 +51,37 @@ public:
   /** Clamp the camera position **/
   void ClampPosition(const Vector3F& min, const Vector3F& max);
 
+  /** Set the zoom **/
+  void SetZoom(f32 zoom);
+
+  /** Returns the zoom **/
+  [[nodiscard]] f32 GetZoom() const { return mZoom; }
+
   /** Returns the viewport width **/
   [[nodiscard]] u32 GetWidth() const { return mWidth; }
 
   /** Returns the viewport height **/
   [[nodiscard]] u32 GetHeight() const { return mHeight; }
 
+  /** Returns the width of the area of the world that is visible, in pixels **/
+  [[nodiscard]] f32 GetViewWidth() const { return f32(mWidth) / mZoom; }
+
+  /** Returns the height of the area of the world that is visible, in
+   * pixels **/
+  [[nodiscard]] f32 GetViewHeight() const { return f32(mHeight) / mZoom; }
+
   /** Returns the position **/
   const Vector3F& GetPosition() const { return mPosition; }
+
+  /** Calculate the concatenated view and projection matrix of a camera with
+   * the specified visible area and position **/
+  static Matrix4F CalculateViewProjectMatrix(f32 viewWidth,
+                                             f32 viewHeight,
+                                             const Vector3F& position);
+
+private:
+  /** Update the matrices after the viewport, position or zoom changed **/
+  void UpdateMatrices();
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,44 @@
+#include "graphics/render_snapshot.hpp"
+
+// ========================================================================== //
+// RenderSnapshot Implementation
+// ========================================================================== //
+
+namespace dib::graphics {
+
+void
+RenderSnapshot::Clear()
+{
+  mVertices.resize(0);
+  mBatches.resize(0);
+  mSpriteIds.resize(0);
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+RenderSnapshot::AddBatch(const std::shared_ptr<Texture>& texture,
+                         const Camera& camera,
+                         const std::vector<SpriteBatch::Vertex>& vertices,
+                         u32 spriteCount,
+                         const std::vector<std::pair<u32, u32>>& spriteIds)
+{
+  Batch batch;
+  batch.texture = texture;
+  batch.cameraPosition = camera.GetPosition();
+  batch.cameraViewSize =
+    Vector2F(camera.GetViewWidth(), camera.GetViewHeight());
+  batch.vertexOffset = u32(mVertices.size());
+  batch.spriteCount = spriteCount;
+  batch.spriteIdOffset = u32(mSpriteIds.size());
+  batch.spriteIdCount = u32(spriteIds.size());
+  mBatches.push_back(batch);
+
+  for (const auto& [id, sprite] : spriteIds) {
+    mSpriteIds.push_back(SpriteId{ id, batch.vertexOffset + sprite * 4 });
+  }
+
+  mVertices.insert(mVertices.end(), vertices.begin(), vertices.end());
+}
+
+}
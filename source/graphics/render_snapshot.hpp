@@ -0,0 +1,109 @@
+#pragma once
+
+// ========================================================================== //
+// Headers
+// ========================================================================== //
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "core/types.hpp"
+#include "graphics/sprite_batch.hpp"
+#include "graphics/texture.hpp"
+
+// ========================================================================== //
+// RenderSnapshot Declaration
+// ========================================================================== //
+
+namespace dib::graphics {
+
+/** Recorded frame of sprite batches. A snapshot is filled on the game thread
+ * while the renderer is recording and is afterwards only read by the render
+ * thread, which replays it with the GPU.
+ *
+ * The camera of each batch is stored separately from the vertices so that the
+ * render thread can interpolate the camera between two snapshots. Sprites
+ * that were submitted with an id are also recorded, so that the render thread
+ * can interpolate their positions as well **/
+class RenderSnapshot
+{
+public:
+  /** Batch of sprites that share texture and camera **/
+  struct Batch
+  {
+    /** Texture **/
+    std::shared_ptr<Texture> texture;
+    /** Camera position **/
+    Vector3F cameraPosition;
+    /** Size of the area visible to the camera **/
+    Vector2F cameraViewSize;
+    /** Index of the first vertex of the batch **/
+    u32 vertexOffset;
+    /** Number of sprites in the batch **/
+    u32 spriteCount;
+    /** Index of the first sprite id of the batch **/
+    u32 spriteIdOffset;
+    /** Number of sprite ids of the batch **/
+    u32 spriteIdCount;
+  };
+
+  /** Sprite that was submitted with an id **/
+  struct SpriteId
+  {
+    /** Id of the sprite **/
+    u32 id;
+    /** Index of the first vertex of the sprite **/
+    u32 vertex;
+  };
+
+private:
+  /** Color to clear the back buffer to **/
+  Color mClearColor = Color::CORNFLOWER_BLUE;
+
+  /** Vertices of all batches **/
+  std::vector<SpriteBatch::Vertex> mVertices;
+  /** Batches **/
+  std::vector<Batch> mBatches;
+  /** Sprite ids of all batches **/
+  std::vector<SpriteId> mSpriteIds;
+
+public:
+  /** Clear the snapshot so that it can be recorded again. Allocated memory is
+   * kept to avoid allocations each frame **/
+  void Clear();
+
+  /** Record a batch. The sprite ids are pairs of id and the index of the
+   * sprite in the batch **/
+  void AddBatch(const std::shared_ptr<Texture>& texture,
+                const Camera& camera,
+                const std::vector<SpriteBatch::Vertex>& vertices,
+                u32 spriteCount,
+                const std::vector<std::pair<u32, u32>>& spriteIds);
+
+  /** Set the clear color **/
+  void SetClearColor(Color color) { mClearColor = color; }
+
+  /** Returns the clear color **/
+  [[nodiscard]] Color GetClearColor() const { return mClearColor; }
+
+  /** Returns the recorded vertices **/
+  [[nodiscard]] const std::vector<SpriteBatch::Vertex>& GetVertices() const
+  {
+    return mVertices;
+  }
+
+  /** Returns the recorded batches **/
+  [[nodiscard]] const std::vector<Batch>& GetBatches() const
+  {
+    return mBatches;
+  }
+
+  /** Returns the recorded sprite ids **/
+  [[nodiscard]] const std::vector<SpriteId>& GetSpriteIds() const
+  {
+    return mSpriteIds;
+  }
+};
+
+}
@@ -15,6 +15,13 @@ Renderer::Renderer()
 void
 Renderer::NewFrame()
 {
+  // Clearing is done when the snapshot is replayed
+  if (mRecordTarget) {
+    mRecordTarget->SetClearColor(mClearColor);
+    mSpriteBatch.NewFrame();
+    return;
+  }
+
   // Clear buffers
   glClearColor(mClearColor.GetRedF32(),
                mClearColor.GetGreenF32(),
@@ -27,4 +34,94 @@ Renderer::NewFrame()
   mSpriteBatch.NewFrame();
 }
 
+// -------------------------------------------------------------------------- //
+
+void
+Renderer::BeginRecording(RenderSnapshot* snapshot)
+{
+  mRecordTarget = snapshot;
+  mRecordTarget->Clear();
+  mSpriteBatch.SetRecordTarget(mRecordTarget);
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+Renderer::EndRecording()
+{
+  mSpriteBatch.SetRecordTarget(nullptr);
+  mRecordTarget = nullptr;
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+Renderer::Replay(const RenderSnapshot& snapshot,
+                 const RenderSnapshot* previous,
+                 f32 alpha)
+{
+  // Clear buffers
+  const Color clearColor = snapshot.GetClearColor();
+  glClearColor(clearColor.GetRedF32(),
+               clearColor.GetGreenF32(),
+               clearColor.GetBlueF32(),
+               clearColor.GetAlphaF32());
+  glClearDepth(1.0f);
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+
+  // Sprites with an id are matched with the previous snapshot by their id
+  mPreviousSprites.clear();
+  if (previous) {
+    for (const RenderSnapshot::SpriteId& sprite : previous->GetSpriteIds()) {
+      mPreviousSprites[sprite.id] = sprite.vertex;
+    }
+  }
+
+  // Render batches. Batches are matched with the previous snapshot by index,
+  // which holds as long as the game renders the same passes each frame
+  const auto& batches = snapshot.GetBatches();
+  for (u32 i = 0; i < batches.size(); i++) {
+    const RenderSnapshot::Batch& batch = batches[i];
+    Vector3F cameraPosition = batch.cameraPosition;
+    if (previous && i < previous->GetBatches().size()) {
+      cameraPosition = glm::mix(
+        previous->GetBatches()[i].cameraPosition, cameraPosition, alpha);
+    }
+
+    // Move the sprites back towards where they were in the previous snapshot
+    const SpriteBatch::Vertex* vertices =
+      snapshot.GetVertices().data() + batch.vertexOffset;
+    if (batch.spriteIdCount > 0 && !mPreviousSprites.empty()) {
+      mReplayVertices.assign(vertices, vertices + batch.spriteCount * 4);
+      for (u32 j = 0; j < batch.spriteIdCount; j++) {
+        const RenderSnapshot::SpriteId& sprite =
+          snapshot.GetSpriteIds()[batch.spriteIdOffset + j];
+        const auto it = mPreviousSprites.find(sprite.id);
+        if (it == mPreviousSprites.end()) {
+          continue;
+        }
+        const Vector3F offset =
+          (previous->GetVertices()[it->second].position -
+           snapshot.GetVertices()[sprite.vertex].position) *
+          (1.0f - alpha);
+        for (u32 k = 0; k < 4; k++) {
+          Vector3F& position =
+            mReplayVertices[sprite.vertex - batch.vertexOffset + k].position;
+          position.x += offset.x;
+          position.y += offset.y;
+        }
+      }
+      vertices = mReplayVertices.data();
+    }
+
+    mSpriteBatch.Draw(batch.texture,
+                      Camera::CalculateViewProjectMatrix(
+                        batch.cameraViewSize.x,
+                        batch.cameraViewSize.y,
+                        cameraPosition),
+                      vertices,
+                      batch.spriteCount);
+  }
+}
+
 }
\ No newline at end of file
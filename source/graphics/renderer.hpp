@@ -5,9 +5,12 @@
 // ========================================================================== //
 
 #include <alflib/graphics/color.hpp>
+#include <tsl/robin_map.h>
+#include <vector>
 
 #include "graphics/debug_draw.hpp"
 #include "graphics/sprite_batch.hpp"
+#include "graphics/render_snapshot.hpp"
 #include "graphics/texture.hpp"
 #include "game/terrain.hpp"
 
@@ -30,6 +33,15 @@ private:
   /** Debug draw **/
   DebugDraw mDebugDraw;
 
+  /** Snapshot that is being recorded, null if not recording **/
+  RenderSnapshot* mRecordTarget = nullptr;
+
+  /** First vertex of each sprite with an id in the previous snapshot, used
+   * while replaying **/
+  tsl::robin_map<u32, u32> mPreviousSprites;
+  /** Vertices of a batch with interpolated sprites, used while replaying **/
+  std::vector<SpriteBatch::Vertex> mReplayVertices;
+
 public:
   /** Construct renderer **/
   Renderer();
@@ -37,6 +49,22 @@ public:
   /** Begin a new frame **/
   void NewFrame();
 
+  /** Begin recording the frame to a snapshot instead of rendering it. This
+   * makes it possible to call the render functions from a thread that does not
+   * own the OpenGL context **/
+  void BeginRecording(RenderSnapshot* snapshot);
+
+  /** End recording **/
+  void EndRecording();
+
+  /** Render a recorded snapshot. If a previous snapshot is given then the
+   * camera of each batch, and each sprite that has an id in both snapshots,
+   * is interpolated between the previous and the current snapshot by the
+   * factor alpha **/
+  void Replay(const RenderSnapshot& snapshot,
+              const RenderSnapshot* previous,
+              f32 alpha);
+
   /** Returns the sprite batch **/
   SpriteBatch& GetSpriteBatch() { return mSpriteBatch; }
 
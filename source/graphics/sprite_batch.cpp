@@ -6,6 +6,7 @@
 
 #include <cstddef>
 #include "graphics/sprite.hpp"
+#include "graphics/render_snapshot.hpp"
 
 // ========================================================================== //
 // SpriteBatch Implementation
@@ -42,6 +43,7 @@ SpriteBatch::Begin(const Camera* camera)
   mCamera = camera;
   mData.resize(0);
   mDataCount = 0;
+  mSpriteIds.resize(0);
 }
 
 // -------------------------------------------------------------------------- //
@@ -57,24 +59,43 @@ SpriteBatch::End()
   // Assert precondition
   AlfAssert(mCamera != nullptr, "'Begin' must have been called before 'End'");
 
+  // Either record the batch to be rendered later or render it directly
+  if (mRecordTarget) {
+    mRecordTarget->AddBatch(
+      mCurrentTexture, *mCamera, mData, mDataCount, mSpriteIds);
+  } else {
+    Draw(mCurrentTexture,
+         mCamera->GetViewProjectMatrix(),
+         mData.data(),
+         mDataCount);
+  }
+
+  mDrawCallCount++;
+  mDrawSpriteCount += mDataCount;
+}
+
+// -------------------------------------------------------------------------- //
+
+void
+SpriteBatch::Draw(const std::shared_ptr<Texture>& texture,
+                  const Matrix4F& viewProjectMatrix,
+                  const Vertex* vertices,
+                  u32 spriteCount)
+{
   glEnable(GL_BLEND);
   glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-  mVertexBuffer.Upload(reinterpret_cast<const u8*>(mData.data()),
-                       mData.size() * sizeof(Vertex));
-  mCurrentTexture->Bind(0);
+  mVertexBuffer.Upload(reinterpret_cast<const u8*>(vertices),
+                       spriteCount * 4 * sizeof(Vertex));
+  texture->Bind(0);
   mShaderProgram->Bind();
-  mShaderProgram->SetUniformMatrix4("u_view_proj",
-                                    mCamera->GetViewProjectMatrix());
+  mShaderProgram->SetUniformMatrix4("u_view_proj", viewProjectMatrix);
   mShaderProgram->SetUniformS32("u_sampler", 0);
   glBindVertexArray(mVAO);
 
   glEnable(GL_DEPTH_TEST);
   glDepthFunc(GL_LEQUAL);
-  glDrawElements(GL_TRIANGLES, mDataCount * 6, GL_UNSIGNED_INT, nullptr);
-
-  mDrawCallCount++;
-  mDrawSpriteCount += mDataCount;
+  glDrawElements(GL_TRIANGLES, spriteCount * 6, GL_UNSIGNED_INT, nullptr);
 }
 
 // -------------------------------------------------------------------------- //
@@ -148,7 +169,8 @@ SpriteBatch::Submit(const std::shared_ptr<Texture>& texture,
                     Vector2F size,
                     alflib::Color color,
                     Vector2F texMin,
-                    Vector2F texMax)
+                    Vector2F texMax,
+                    u32 id)
 {
   // Flush if max limix reached
   if (mDataCount >= MAX_SPRITES) {
@@ -160,6 +182,9 @@ SpriteBatch::Submit(const std::shared_ptr<Texture>& texture,
     Flush();
   }
   mCurrentTexture = texture;
+  if (id != NO_SPRITE_ID) {
+    mSpriteIds.emplace_back(id, mDataCount);
+  }
 
   // Bottom-left
   Vertex vertex;
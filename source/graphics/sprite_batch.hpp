@@ -21,6 +21,7 @@
 namespace dib::graphics {
 
 DIB_FORWARD_DECLARE_CLASS(Sprite);
+DIB_FORWARD_DECLARE_CLASS(RenderSnapshot);
 
 /** Class that is used for batching submissions of sprites together so that they
  * all can be rendered together **/
@@ -41,7 +42,9 @@ public:
   /** Index of texture-coordinate attribute **/
   static constexpr u32 VERTEX_ATTRIBUTE_UV = 2;
 
-private:
+  /** Id of sprites that are not tracked between frames **/
+  static constexpr u32 NO_SPRITE_ID = ~0u;
+
   /** Vertex structure **/
   struct Vertex
   {
@@ -68,12 +71,19 @@ private:
   std::vector<Vertex> mData;
   /** Number of sprites that are represented in data **/
   u32 mDataCount;
+  /** Id and index in the batch of each sprite that was submitted with an
+   * id **/
+  std::vector<std::pair<u32, u32>> mSpriteIds;
 
   /** Currently bound texture **/
   std::shared_ptr<Texture> mCurrentTexture;
   /** Current camera **/
   const Camera* mCamera = nullptr;
 
+  /** Snapshot that batches are recorded to instead of being rendered. Null
+   * when not recording **/
+  RenderSnapshot* mRecordTarget = nullptr;
+
   /** Number of draw calls done this frame **/
   u32 mDrawCallCount = 0;
   /** Number of sprites drawn this frame **/
@@ -99,13 +109,27 @@ public:
   /** Submit a sprite for rendering **/
   void Submit(const Sprite& sprite);
 
-  /** Submit a textured rectangle **/
+  /** Submit a textured rectangle. Sprites with an id are matched between
+   * recorded frames by it, which lets the render thread interpolate their
+   * position **/
   void Submit(const std::shared_ptr<Texture>& texture,
               Vector3F position,
               Vector2F size = Vector2F(16.0f, 16.0f),
               alflib::Color color = alflib::Color::WHITE,
               Vector2F texMin = Vector2F(0.0f, 0.0f),
-              Vector2F texMax = Vector2F(1.0f, 1.0f));
+              Vector2F texMax = Vector2F(1.0f, 1.0f),
+              u32 id = NO_SPRITE_ID);
+
+  /** Set the snapshot to record batches to. While recording no GPU work is
+   * done. Pass null to stop recording **/
+  void SetRecordTarget(RenderSnapshot* snapshot) { mRecordTarget = snapshot; }
+
+  /** Render sprites directly with the GPU. This is used to replay batches from
+   * a snapshot **/
+  void Draw(const std::shared_ptr<Texture>& texture,
+            const Matrix4F& viewProjectMatrix,
+            const Vertex* vertices,
+            u32 spriteCount);
 
   /** Returns the number of draw calls made since new frame **/
   u32 GetDrawCallCount() const { return mDrawCallCount; }
@@ -9,6 +9,8 @@
 
 #if defined(DIB_IS_SERVER)
 #include "game/server/game_server.hpp"
+#elif defined(DIB_IS_BOT)
+#include "game/bot/bot_swarm.hpp"
 #else
 #include "game/client/game_client.hpp"
 #endif
@@ -18,7 +20,7 @@
 // ========================================================================== //
 
 int
-main(int, char**)
+main([[maybe_unused]] int argc, [[maybe_unused]] char** argv)
 {
   using namespace dib;
 
@@ -26,17 +28,26 @@ main(int, char**)
   DLOG_SET_LEVEL(dlog::Level::kVerbose);
   DLOG_INFO("¸,ø¤º°`°º¤ø,¸  D I A B A S  ¸,ø¤º°`°º¤ø,¸");
 
-  // Run either client or server
-#if !defined(DIB_IS_SERVER)
+  // Run either client, server or bots
+#if defined(DIB_IS_BOT)
+  // Every bot logs its joins, keep the output to the reports
+  DLOG_SET_LEVEL(dlog::Level::kWarning);
+  game::BotSwarm::Descriptor descriptor =
+    game::BotSwarm::Descriptor::FromArgs(argc, argv);
+  game::BotSwarm swarm(descriptor);
+  swarm.Run();
+#elif !defined(DIB_IS_SERVER)
   game::GameClient::Descriptor descriptor;
   descriptor.title = "Diabas - Client";
   descriptor.width = 1440;
   descriptor.height = 720;
   descriptor.enableVSync = false;
+  descriptor.enablePipelinedRendering = false;
   game::GameClient client(descriptor);
   client.Run();
 #else
-  game::GameServer::Descriptor descriptor;
+  game::GameServer::Descriptor descriptor =
+    game::GameServer::Descriptor::FromArgs(argc, argv);
   game::GameServer server(descriptor);
   server.Run();
 #endif
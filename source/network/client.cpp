@@ -5,27 +5,59 @@
 #include "game/ecs/systems/player_system.hpp"
 #include "game/ecs/systems/generic_system.hpp"
 #include <microprofile/microprofile.h>
+#include <tsl/robin_map.h>
 
 namespace dib {
 
+namespace {
+
+/**
+ * The status callbacks of every connection in the process are run together,
+ * this hands each of them to the client that owns the connection, so that
+ * several clients can live in one process.
+ */
+class ClientRouter : public ISteamNetworkingSocketsCallbacks
+{
+public:
+  void OnSteamNetConnectionStatusChanged(
+    SteamNetConnectionStatusChangedCallback_t* status) override
+  {
+    if (auto it = clients.find(status->m_hConn); it != clients.end()) {
+      ISteamNetworkingSocketsCallbacks* client = it->second;
+      client->OnSteamNetConnectionStatusChanged(status);
+    }
+  }
+
+  tsl::robin_map<HSteamNetConnection, Client*> clients{};
+};
+
+ClientRouter client_router{};
+
+}
+
 Client::Client(game::World* world)
   : connection_(k_HSteamNetConnection_Invalid)
   , socket_interface_(SteamNetworkingSockets())
   , connection_state_(ConnectionState::kDisconnected)
   , world_(world)
-{}
-
-Client::~Client()
+  , network_thread_(socket_interface_)
 {
-  CloseConnection();
+  network_thread_.Start(
+    [this](ISteamNetworkingMessage** messages, const int max_count) {
+      const HSteamNetConnection connection = connection_.load();
+      if (connection == k_HSteamNetConnection_Invalid) {
+        return 0;
+      }
+      return socket_interface_->ReceiveMessagesOnConnection(
+        connection, messages, max_count);
+    });
 }
 
-void
-Client::Poll(bool& got_packet, Packet& packet_out)
+Client::~Client()
 {
-  MICROPROFILE_SCOPEI("client", "poll", MP_YELLOW);
-  PollSocketStateChanges();
-  got_packet = PollIncomingPackets(packet_out);
+  Flush();
+  network_thread_.Stop();
+  CloseConnection();
 }
 
 void
@@ -34,16 +66,21 @@ Client::Connect(const SteamNetworkingIPAddr& address)
   connection_ = socket_interface_->ConnectByIPAddress(address);
   if (connection_ == k_HSteamNetConnection_Invalid) {
     DLOG_WARNING("failed to connect");
+  } else {
+    client_router.clients[connection_] = this;
   }
 }
 
 void
 Client::CloseConnection()
 {
-  if (connection_ != k_HSteamNetConnection_Invalid) {
+  const HSteamNetConnection connection =
+    connection_.exchange(k_HSteamNetConnection_Invalid);
+  if (connection != k_HSteamNetConnection_Invalid) {
+    client_router.clients.erase(connection);
+    outbox_.Drop(connection);
     SetConnectionState(ConnectionState::kDisconnected);
-    socket_interface_->CloseConnection(connection_, 0, nullptr, false);
-    connection_ = k_HSteamNetConnection_Invalid;
+    socket_interface_->CloseConnection(connection, 0, nullptr, false);
   }
 
   // TODO save our PlayerData
@@ -60,8 +97,26 @@ Client::CloseConnection()
 SendResult
 Client::PacketSend(const Packet& packet, const SendStrategy send_strategy)
 {
-  return Common::SendPacket(
-    packet, send_strategy, connection_, socket_interface_);
+  const HSteamNetConnection connection = connection_.load();
+  if (connection == k_HSteamNetConnection_Invalid) {
+    return SendResult::kReconnect;
+  }
+  const auto& packet_handler = world_->GetNetwork().GetPacketHandler();
+  outbox_.Add(packet_handler.CompressPacket(packet, compressed_packet_),
+              send_strategy,
+              connection);
+  return SendResult::kSuccess;
+}
+
+void
+Client::Flush()
+{
+  outbox_.Flush([this](const u8* data,
+                       const std::size_t data_count,
+                       const SendStrategy send_strategy,
+                       const HSteamNetConnection connection) {
+    return network_thread_.Send(data, data_count, send_strategy, connection);
+  });
 }
 
 std::optional<SteamNetworkingQuickConnectionStatus>
@@ -69,7 +124,7 @@ Client::GetConnectionStatus() const
 {
   SteamNetworkingQuickConnectionStatus status;
   const bool ok =
-    socket_interface_->GetQuickConnectionStatus(connection_, &status);
+    socket_interface_->GetQuickConnectionStatus(connection_.load(), &status);
   return ok ? std::optional(status) : std::nullopt;
 }
 
@@ -78,7 +133,7 @@ Client::PollSocketStateChanges()
 {
   MICROPROFILE_SCOPEI("client", "poll socket state changes", MP_YELLOW);
 
-  socket_interface_->RunCallbacks(this);
+  socket_interface_->RunCallbacks(&client_router);
 }
 
 bool
@@ -86,15 +141,12 @@ Client::PollIncomingPackets(Packet& packet_out)
 {
   MICROPROFILE_SCOPEI("client", "poll incoming packets", MP_YELLOW);
 
-  ISteamNetworkingMessage* msg = nullptr;
-  const int msg_count =
-    socket_interface_->ReceiveMessagesOnConnection(connection_, &msg, 1);
-
-  bool got_packet = false;
-  if (msg_count > 0) {
-    bool ok =
-      packet_out.SetPacket(static_cast<const u8*>(msg->m_pData), msg->m_cbSize);
-    if (ok) {
+  while (ISteamNetworkingMessage* msg = network_thread_.Receive()) {
+    bool got_packet = false;
+    if (msg->m_conn != connection_.load()) {
+      // received before we closed the connection
+    } else if (packet_out.SetPacket(static_cast<const u8*>(msg->m_pData),
+                                    msg->m_cbSize)) {
       packet_out.SetFromConnection(msg->m_conn);
       got_packet = true;
     } else {
@@ -102,16 +154,14 @@ Client::PollIncomingPackets(Packet& packet_out)
                  msg->m_cbSize,
                  packet_out.GetPacketCapacity());
     }
-    msg->Release();
 
-  } else if (msg_count < 0) {
-    if (connection_state_ != ConnectionState::kDisconnected) {
-      DLOG_VERBOSE("failed to check for messages, disconnecting");
-      CloseConnection();
+    msg->Release();
+    if (got_packet) {
+      return true;
     }
   }
 
-  return got_packet;
+  return false;
 }
 
 void
@@ -7,7 +7,10 @@
 #include <steam/isteamnetworkingutils.h>
 #include <steam/steamnetworkingsockets.h>
 #include "network/connection_state.hpp"
+#include "network/network_thread.hpp"
+#include "network/outbox.hpp"
 #include "core/macros.hpp"
+#include <atomic>
 
 // ========================================================================== //
 // Forward Declarations
@@ -31,9 +34,16 @@ public:
   virtual ~Client() final;
 
   /**
-   * Update internal state and check for packets.
+   * Run the connection status callbacks, game thread only.
    */
-  void Poll(bool& got_packet, Packet& packet_out);
+  void PollSocketStateChanges();
+
+  /**
+   * Pop the next packet received by the network thread, game thread only.
+   * Packets that can't be used are dropped.
+   * @return False if there are no more packets this tick.
+   */
+  bool PollIncomingPackets(Packet& packet_out);
 
   /**
    * The result of the connection attempt will be reported later when polling.
@@ -42,11 +52,23 @@ public:
 
   void CloseConnection();
 
+  /**
+   * Send a packet to the server. Packets are queued until the end of the
+   * tick, see Flush.
+   */
   SendResult PacketSend(const Packet& packet, const SendStrategy send_strategy);
 
+  /**
+   * Send everything that was queued during the tick, call once at the end of
+   * each tick.
+   */
+  void Flush();
+
   ConnectionState GetConnectionState() { return connection_state_; }
 
-  ConnectionId GetConnectionId() const { return connection_; }
+  ConnectionId GetConnectionId() const { return connection_.load(); }
+
+  Outbox& GetOutbox() { return outbox_; }
 
   std::optional<SteamNetworkingQuickConnectionStatus> GetConnectionStatus()
     const;
@@ -59,21 +81,23 @@ public:
   }
 
 private:
-  void PollSocketStateChanges();
-
-  bool PollIncomingPackets(Packet& packet_out);
-
   virtual void OnSteamNetConnectionStatusChanged(
     SteamNetConnectionStatusChangedCallback_t* status) override;
 
   void SetConnectionState(const ConnectionState connection_state);
 
 private:
-  HSteamNetConnection connection_;
+  /** Read by the network thread when receiving. */
+  std::atomic<HSteamNetConnection> connection_;
   ISteamNetworkingSockets* socket_interface_;
   ConnectionState connection_state_;
   game::World* world_;
   std::optional<u32> our_player_entity_;
+  NetworkThread network_thread_;
+  Outbox outbox_{};
+
+  /** Scratch packet for compressing sent packets. */
+  Packet compressed_packet_{};
 };
 }
 #endif // CLIENT_HPP_
@@ -8,11 +8,25 @@ SendPacket(const Packet& packet,
            const SendStrategy send_strategy,
            const HSteamNetConnection connection,
            ISteamNetworkingSockets* socket_interface)
+{
+  return SendPacket(packet.GetPacket(),
+                    packet.GetPacketSize(),
+                    send_strategy,
+                    connection,
+                    socket_interface);
+}
+
+SendResult
+SendPacket(const u8* data,
+           const std::size_t data_count,
+           const SendStrategy send_strategy,
+           const HSteamNetConnection connection,
+           ISteamNetworkingSockets* socket_interface)
 {
   const EResult res =
     socket_interface->SendMessageToConnection(connection,
-                                              packet.GetPacket(),
-                                              packet.GetPacketSize(),
+                                              data,
+                                              static_cast<u32>(data_count),
                                               static_cast<int>(send_strategy));
 
   SendResult result = SendResult::kSuccess;
@@ -23,8 +37,7 @@ SendPacket(const Packet& packet,
         DLOG_WARNING(
           "invalid connection handle, or the individual message is too big.");
         result = SendResult::kReconnect;
-        if (packet.GetPacketSize() >
-            k_cbMaxSteamNetworkingSocketsMessageSizeSend) {
+        if (data_count > k_cbMaxSteamNetworkingSocketsMessageSizeSend) {
           DLOG_ERROR(
             "packet size is too big to send, this case is not handled");
         }
@@ -37,6 +37,16 @@ enum class SendStrategy : int
 
 namespace Common {
 
+/**
+ * Send raw packet bytes, header included.
+ */
+SendResult
+SendPacket(const u8* data,
+           const std::size_t data_count,
+           const SendStrategy send_strategy,
+           const HSteamNetConnection connection,
+           ISteamNetworkingSockets* socket_interface);
+
 SendResult
 SendPacket(const Packet& packet,
            const SendStrategy send_strategy,
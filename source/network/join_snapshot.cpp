@@ -0,0 +1,263 @@
+#include "join_snapshot.hpp"
+#include "core/compression.hpp"
+#include "core/hash.hpp"
+#include "core/schema.hpp"
+#include "game/ecs/components/item_data_component.hpp"
+#include "game/ecs/components/npc_data_component.hpp"
+#include "game/ecs/components/player_data_component.hpp"
+#include "game/ecs/components/projectile_data_component.hpp"
+#include "game/ecs/components/tile_data_component.hpp"
+#include "game/gameplay/moveable.hpp"
+#include <alflib/memory/raw_memory_reader.hpp>
+#include <alflib/memory/raw_memory_writer.hpp>
+#include <microprofile/microprofile.h>
+#include <tsl/robin_set.h>
+#include <dlog.hpp>
+#include <algorithm>
+#include <cstring>
+
+namespace dib {
+
+namespace {
+
+/**
+ * Largest snapshot we accept, so that a corrupt fragment header cannot make
+ * us allocate everything.
+ */
+constexpr u32 kMaxRawSize = 64 * 1024 * 1024;
+
+struct UuidHash
+{
+  std::size_t operator()(const Uuid& uuid) const
+  {
+    return HashFNV1a64(reinterpret_cast<const u8*>(&uuid), sizeof(uuid));
+  }
+};
+
+using UuidSet = tsl::robin_set<Uuid, UuidHash>;
+
+/**
+ * Append the serialized @values to @raw.
+ */
+template<typename... TValues>
+void
+Append(std::vector<u8>& raw, const TValues&... values)
+{
+  const std::size_t offset = raw.size();
+  raw.resize(offset + SerializedSize(values...));
+  alflib::RawMemoryWriter mw{ raw.data() + offset, raw.size() - offset };
+  (Serializer<TValues>::Write(mw, values), ...);
+}
+
+template<typename TComponent>
+void
+WriteSection(entt::registry& registry, std::vector<u8>& raw)
+{
+  const auto view = registry.view<TComponent>();
+  Append(raw, static_cast<u32>(view.size()));
+  for (const auto entity : view) {
+    Append(raw, view.get(entity));
+  }
+}
+
+template<typename TComponent>
+UuidSet
+ExistingUuids(entt::registry& registry)
+{
+  UuidSet uuids{};
+  const auto view = registry.view<TComponent>();
+  uuids.reserve(view.size());
+  for (const auto entity : view) {
+    uuids.insert(view.get(entity).uuid);
+  }
+  return uuids;
+}
+
+/**
+ * Create an entity for each of @components, with one call into the registry.
+ */
+template<typename TComponent>
+std::vector<entt::entity>
+CreateInBulk(entt::registry& registry, std::vector<TComponent>& components)
+{
+  std::vector<entt::entity> entities(components.size());
+  registry.reserve<TComponent>(registry.size<TComponent>() +
+                               components.size());
+  registry.create(entities.begin(), entities.end());
+  for (std::size_t i = 0; i < entities.size(); i++) {
+    registry.assign<TComponent>(entities[i], std::move(components[i]));
+  }
+  return entities;
+}
+
+template<typename TComponent>
+bool
+ReadSection(entt::registry& registry,
+            alflib::RawMemoryReader& mr,
+            const u32 raw_size)
+{
+  const u32 count = Serializer<u32>::Read(mr);
+  if (count > raw_size) {
+    return false;
+  }
+
+  const UuidSet existing = ExistingUuids<TComponent>(registry);
+  std::vector<TComponent> components{};
+  components.reserve(count);
+  for (u32 i = 0; i < count; i++) {
+    auto component = mr.Read<TComponent>();
+    if (existing.count(component.uuid) == 0) {
+      components.push_back(std::move(component));
+    }
+  }
+  CreateInBulk(registry, components);
+  return true;
+}
+
+}
+
+// ============================================================ //
+
+void
+JoinSnapshot::Build(entt::registry& registry)
+{
+  MICROPROFILE_SCOPEI("network", "build join snapshot", MP_YELLOW);
+
+  std::vector<u8> raw{};
+
+  // players, with their moveable
+  std::vector<entt::entity> players{};
+  const auto view = registry.view<PlayerData, game::Moveable>();
+  for (const auto entity : view) {
+    players.push_back(entity);
+  }
+  Append(raw, static_cast<u32>(players.size()));
+  for (const auto entity : players) {
+    Append(
+      raw, view.get<PlayerData>(entity), view.get<game::Moveable>(entity));
+  }
+
+  WriteSection<ItemData>(registry, raw);
+  WriteSection<NpcData>(registry, raw);
+  WriteSection<ProjectileData>(registry, raw);
+  WriteSection<TileData>(registry, raw);
+
+  raw_size_ = static_cast<u32>(raw.size());
+  compressed_.clear();
+  LzCompress(raw.data(), raw.size(), compressed_);
+}
+
+u32
+JoinSnapshot::GetFragmentCount() const
+{
+  const u32 size = GetCompressedSize();
+  return std::max(1u, (size + kFragmentSize - 1) / kFragmentSize);
+}
+
+void
+JoinSnapshot::WriteFragment(const u32 index, Packet& packet) const
+{
+  FragmentHeader header{};
+  header.raw_size = raw_size_;
+  header.compressed_size = GetCompressedSize();
+  header.offset = std::min(index * kFragmentSize, header.compressed_size);
+  const u32 size =
+    std::min(kFragmentSize, header.compressed_size - header.offset);
+
+  const std::size_t payload_size = sizeof(header) + size;
+  if (packet.GetPayloadCapacity() < payload_size) {
+    packet.SetPacketCapacity(packet.GetHeaderSize() + payload_size);
+  }
+  packet.ClearPayload();
+  packet.SetPayload(reinterpret_cast<const u8*>(&header), sizeof(header));
+  packet.SetPayload(compressed_.data() + header.offset, size);
+}
+
+JoinSnapshot::ReadResult
+JoinSnapshot::ReadFragment(const Packet& packet)
+{
+  if (packet.GetPayloadSize() < sizeof(FragmentHeader)) {
+    return ReadResult::kError;
+  }
+  FragmentHeader header;
+  std::memcpy(&header, packet.GetPayload(), sizeof(header));
+  const u8* data = packet.GetPayload() + sizeof(header);
+  const u32 size = static_cast<u32>(packet.GetPayloadSize() - sizeof(header));
+
+  if (header.offset == 0) {
+    if (header.raw_size > kMaxRawSize ||
+        header.compressed_size > LzCompressBound(header.raw_size)) {
+      return ReadResult::kError;
+    }
+    raw_size_ = header.raw_size;
+    compressed_.resize(header.compressed_size);
+    received_ = 0;
+  }
+
+  // fragments are reliable, so they arrive in order
+  if (header.raw_size != raw_size_ ||
+      header.compressed_size != compressed_.size() ||
+      header.offset != received_ || size > compressed_.size() - received_) {
+    return ReadResult::kError;
+  }
+  if (size > 0) {
+    std::memcpy(compressed_.data() + received_, data, size);
+  }
+  received_ += size;
+
+  return received_ == compressed_.size() ? ReadResult::kComplete
+                                         : ReadResult::kIncomplete;
+}
+
+std::optional<std::vector<entt::entity>>
+JoinSnapshot::Apply(entt::registry& registry)
+{
+  MICROPROFILE_SCOPEI("network", "apply join snapshot", MP_YELLOW);
+
+  std::vector<u8> raw(raw_size_);
+  if (received_ != compressed_.size() ||
+      !LzDecompress(
+        compressed_.data(), compressed_.size(), raw.data(), raw.size())) {
+    return std::nullopt;
+  }
+  alflib::RawMemoryReader mr{ raw.data(), raw.size() };
+
+  // players, with their moveable
+  const u32 player_count = Serializer<u32>::Read(mr);
+  if (player_count > raw_size_) {
+    return std::nullopt;
+  }
+  const UuidSet existing = ExistingUuids<PlayerData>(registry);
+  std::vector<PlayerData> player_datas{};
+  std::vector<game::Moveable> moveables{};
+  player_datas.reserve(player_count);
+  moveables.reserve(player_count);
+  for (u32 i = 0; i < player_count; i++) {
+    auto player_data = mr.Read<PlayerData>();
+    auto moveable = mr.Read<game::Moveable>();
+    if (existing.count(player_data.uuid) == 0) {
+      player_datas.push_back(std::move(player_data));
+      moveables.push_back(moveable);
+    }
+  }
+  std::vector<entt::entity> players = CreateInBulk(registry, player_datas);
+  registry.reserve<game::Moveable>(registry.size<game::Moveable>() +
+                                   players.size());
+  for (std::size_t i = 0; i < players.size(); i++) {
+    registry.assign<game::Moveable>(players[i], moveables[i]);
+  }
+
+  const bool ok = ReadSection<ItemData>(registry, mr, raw_size_) &&
+                  ReadSection<NpcData>(registry, mr, raw_size_) &&
+                  ReadSection<ProjectileData>(registry, mr, raw_size_) &&
+                  ReadSection<TileData>(registry, mr, raw_size_);
+  if (!ok) {
+    DLOG_WARNING("join snapshot has a section of bad size");
+  }
+
+  compressed_.clear();
+  received_ = 0;
+  return players;
+}
+
+}
@@ -0,0 +1,99 @@
+#ifndef JOIN_SNAPSHOT_HPP_
+#define JOIN_SNAPSHOT_HPP_
+
+#include "core/types.hpp"
+#include "network/packet.hpp"
+#include <entt/entt.hpp>
+#include <optional>
+#include <vector>
+
+namespace dib {
+
+/**
+ * The state of the world that a joining player needs, sent as one compressed
+ * reliable stream instead of one packet per entity.
+ *
+ * The snapshot holds a section for each kind of synced entity, players with
+ * their moveable, items, npcs, projectiles and tiles. Each section is a u32
+ * count followed by the serialized components. The whole snapshot is
+ * compressed and split into fragments of at most kFragmentSize bytes, each
+ * sent as the payload of a kJoinSnapshot packet. Fragments are sent reliably,
+ * so they arrive in order.
+ *
+ * Terrain is not part of the snapshot, both sides generate it from the same
+ * content.
+ */
+class JoinSnapshot
+{
+public:
+  /**
+   * Largest fragment, must fit in the packet that received packets are read
+   * into.
+   */
+  static constexpr u32 kFragmentSize = 8 * 1024;
+
+  /**
+   * Written at the start of each fragment.
+   */
+  struct FragmentHeader
+  {
+    u32 raw_size;
+    u32 compressed_size;
+    u32 offset;
+  };
+
+  enum class ReadResult
+  {
+    kIncomplete = 0,
+    kComplete,
+    kError
+  };
+
+  // ============================================================ //
+
+  /**
+   * Server: Serialize and compress the synced entities of @registry. The
+   * joining player is included, the client skips it since it already exists.
+   */
+  void Build(entt::registry& registry);
+
+  u32 GetFragmentCount() const;
+
+  /**
+   * Server: Write fragment @index into the payload of @packet, the header is
+   * left untouched.
+   */
+  void WriteFragment(u32 index, Packet& packet) const;
+
+  /**
+   * Client: Add a received fragment, a fragment at offset 0 starts a new
+   * snapshot.
+   */
+  ReadResult ReadFragment(const Packet& packet);
+
+  /**
+   * Client: Create the entities of a complete snapshot in bulk. Entities that
+   * already exist, by uuid, are skipped.
+   * @return The created player entities, so that the caller can add what
+   * only the client has. Nullopt if the snapshot could not be decompressed.
+   */
+  std::optional<std::vector<entt::entity>> Apply(entt::registry& registry);
+
+  u32 GetRawSize() const { return raw_size_; }
+
+  u32 GetCompressedSize() const
+  {
+    return static_cast<u32>(compressed_.size());
+  }
+
+  // ============================================================ //
+
+private:
+  std::vector<u8> compressed_{};
+  u32 raw_size_{ 0 };
+  u32 received_{ 0 };
+};
+
+}
+
+#endif // JOIN_SNAPSHOT_HPP_
@@ -11,17 +11,81 @@
 #include "game/ecs/components/tile_data_component.hpp"
 #include "game/gameplay/moveable.hpp"
 #include "game/world.hpp"
+#include <algorithm>
 #include <limits>
 #include "game/chat/chat.hpp"
 #include <dutil/misc.hpp>
 #include <dutil/stopwatch.hpp>
 #include <microprofile/microprofile.h>
-#if !defined(DIB_IS_SERVER)
-#include "game/client/render_component.hpp"
-#endif
 
 namespace dib {
 
+namespace {
+
+/** Largest dictionary that the packet types are compressed with. */
+constexpr u64 kPacketDictionarySize = 1024;
+
+/**
+ * Serialize @values into a sample message for training a dictionary.
+ */
+template<typename... TValues>
+std::vector<u8>
+MakeSample(const TValues&... values)
+{
+  Packet packet{ SerializedSize(values...) };
+  packet.WritePayload(values...);
+  return std::vector<u8>(packet.GetPayload(),
+                         packet.GetPayload() + packet.GetPayloadSize());
+}
+
+/**
+ * Compress the packet types that are large or sent often. Client and server
+ * build the dictionaries from the same samples, so that they agree without
+ * sending them.
+ */
+void
+SetupCompression(PacketHandler& packet_handler)
+{
+  // player packets are mostly a PlayerData and a Moveable
+  PlayerData player_data{};
+  player_data.name = "player";
+  const std::vector<std::vector<u8>> player_samples{ MakeSample(
+    player_data, game::MoveableMakeDefault()) };
+  const auto player_dictionary = std::make_shared<const LzDictionary>(
+    LzTrainDictionary(player_samples, kPacketDictionarySize));
+
+  // the packet types in the sync packet always start with the static ones
+  std::vector<PacketTypeMetaSerializable> metas{};
+  for (const auto& meta : packet_handler.Serialize()) {
+    if (meta.type < kPacketHeaderStaticTypesCount) {
+      metas.push_back(meta);
+    }
+  }
+  std::sort(metas.begin(), metas.end(), [](const auto& a, const auto& b) {
+    return a.type < b.type;
+  });
+  std::vector<std::vector<u8>> sync_samples{};
+  for (const auto& meta : metas) {
+    sync_samples.push_back(MakeSample(meta));
+  }
+  const auto sync_dictionary = std::make_shared<const LzDictionary>(
+    LzTrainDictionary(sync_samples, kPacketDictionarySize));
+
+  bool ok =
+    packet_handler.SetCompression(PacketHeaderStaticTypes::kSync,
+                                  sync_dictionary) &&
+    packet_handler.SetCompression(PacketHeaderStaticTypes::kPlayerJoin,
+                                  player_dictionary) &&
+    packet_handler.SetCompression(PacketHeaderStaticTypes::kPlayerUpdate,
+                                  player_dictionary) &&
+    packet_handler.SetCompression(
+      PacketHeaderStaticTypes::kPlayerUpdateRejected, player_dictionary) &&
+    packet_handler.SetCompression(PacketHeaderStaticTypes::kChat);
+  AlfAssert(ok, "could not set compression of packet types");
+}
+
+}
+
 template<>
 void
 Network<Side::kServer>::PacketBroadcast(const Packet& packet) const
@@ -61,6 +125,24 @@ Network<Side::kClient>::PacketBroadcastExclude(const Packet&,
   AlfAssert(false, "cannot broadcastExclude from client");
 }
 
+template<>
+void
+Network<Side::kServer>::PacketUnicast(
+  const Packet& packet,
+  const ConnectionId target_connection) const
+{
+  auto server = GetServer();
+  server->PacketUnicast(
+    packet, SendStrategy::kUnreliableNoNagle, target_connection);
+}
+
+template<>
+void
+Network<Side::kClient>::PacketUnicast(const Packet&, const ConnectionId) const
+{
+  AlfAssert(false, "cannot unicast from client");
+}
+
 template<>
 void Network<Side::kServer>::ConnectToServer(u32, u16)
 {
@@ -141,6 +223,70 @@ Network<Side::kClient>::StartServer()
   AlfAssert(false, "cannot start server on client");
 }
 
+template<>
+bool
+Network<Side::kServer>::StartCapture(const Path& path)
+{
+  auto server = GetServer();
+  return server->StartCapture(path);
+}
+
+template<>
+bool
+Network<Side::kClient>::StartCapture(const Path&)
+{
+  AlfAssert(false, "cannot capture packets on client");
+  return false;
+}
+
+template<>
+void
+Network<Side::kServer>::StopCapture()
+{
+  auto server = GetServer();
+  server->StopCapture();
+}
+
+template<>
+void
+Network<Side::kClient>::StopCapture()
+{
+  AlfAssert(false, "cannot capture packets on client");
+}
+
+template<>
+void
+Network<Side::kServer>::ReplayPacket(const Packet& packet)
+{
+  auto server = GetServer();
+  server->AddReplayConnection(packet.GetFromConnection());
+  if (!packet_handler_.HandlePacket(packet)) {
+    DLOG_WARNING("Could not handle replayed packet");
+  }
+}
+
+template<>
+void
+Network<Side::kClient>::ReplayPacket(const Packet&)
+{
+  AlfAssert(false, "cannot replay packets on client");
+}
+
+template<>
+void
+Network<Side::kServer>::ReplayDisconnect(const ConnectionId connection)
+{
+  auto server = GetServer();
+  server->DisconnectConnection(connection);
+}
+
+template<>
+void
+Network<Side::kClient>::ReplayDisconnect(const ConnectionId)
+{
+  AlfAssert(false, "cannot replay packets on client");
+}
+
 template<>
 std::optional<entt::entity>
 Network<Side::kServer>::GetOurPlayerEntity() const
@@ -275,34 +421,32 @@ Network<Side::kClient>::NetworkInfo([
 
 template<>
 void
-Network<Side::kServer>::SendPlayerList(const ConnectionId connection_id) const
+Network<Side::kServer>::SendJoinSnapshot(const ConnectionId connection_id)
 {
-  Packet packet{};
+  if (!join_snapshot_built_) {
+    join_snapshot_.Build(world_->GetEntityManager().GetRegistry());
+    join_snapshot_built_ = true;
+    DLOG_VERBOSE("built join snapshot, {} bytes compressed to {}",
+                 join_snapshot_.GetRawSize(),
+                 join_snapshot_.GetCompressedSize());
+  }
+
+  Packet packet{ JoinSnapshot::kFragmentSize +
+                 sizeof(JoinSnapshot::FragmentHeader) };
   packet_handler_.BuildPacketHeader(packet,
-                                    PacketHeaderStaticTypes::kPlayerJoin);
-
-  world_->GetEntityManager()
-    .GetRegistry()
-    .view<PlayerData, game::Moveable>()
-    .each([&](const PlayerData& player_data, const game::Moveable& moveable) {
-      if (connection_id != player_data.connection_id) {
-        packet.ClearPayload();
-        auto mw = packet.GetMemoryWriter();
-        mw->Write(player_data);
-        mw->Write(moveable);
-        mw.Finalize();
-        auto server = GetServer();
-        server->PacketUnicast(
-          packet, SendStrategy::kUnreliableNoNagle, connection_id);
-      }
-    });
+                                    PacketHeaderStaticTypes::kJoinSnapshot);
+  auto server = GetServer();
+  for (u32 i = 0; i < join_snapshot_.GetFragmentCount(); i++) {
+    join_snapshot_.WriteFragment(i, packet);
+    server->PacketUnicast(packet, SendStrategy::kReliable, connection_id);
+  }
 }
 
 template<>
 void
-Network<Side::kClient>::SendPlayerList(const ConnectionId) const
+Network<Side::kClient>::SendJoinSnapshot(const ConnectionId)
 {
-  AlfAssert(false, "cannot send player list from client");
+  AlfAssert(false, "cannot send join snapshot from client");
 }
 
 // ============================================================ //
@@ -314,7 +458,14 @@ void
 Network<Side::kClient>::SetupPacketHandler()
 {
   const auto SyncCb = [&](const Packet& packet) {
-    packet_handler_.OnPacketSync(packet);
+    // our packet types differ, ask for the server's
+    if (!packet_handler_.OnPacketSync(packet)) {
+      Packet request{ sizeof(u64) };
+      packet_handler_.BuildPacketSyncHash(request);
+      auto client = GetClient();
+      client->PacketSend(request, SendStrategy::kReliable);
+      return;
+    }
 
     // we are connected
     {
@@ -336,15 +487,8 @@ Network<Side::kClient>::SetupPacketHandler()
       auto client = GetClient();
       client->SetOurPlayerEntity(maybe_entity);
 
-      // 3.1 Set our player RenderComponent
-#if !defined(DIB_IS_SERVER)
-      auto texture = std::make_shared<graphics::Texture>("Wizard");
-      texture->Load(Path{ "./res/entity/wizard.tga" });
-      game::RenderComponent renderComponent{ texture };
-      system::Assign(registry, *maybe_entity, renderComponent);
-#endif
-
-      // 3.2 Set our player Moveable (and Collideable)
+      // 3.1 Set our player Moveable (and Collideable). The RenderComponent is
+      // added by the game client, see AssignRenderComponents
       game::Moveable moveable = game::MoveableMakeDefault();
       system::Assign(registry, *maybe_entity, moveable);
 
@@ -352,10 +496,7 @@ Network<Side::kClient>::SetupPacketHandler()
       Packet player_join_packet{};
       packet_handler_.BuildPacketHeader(player_join_packet,
                                         PacketHeaderStaticTypes::kPlayerJoin);
-      auto mw = player_join_packet.GetMemoryWriter();
-      mw->Write(my_player_data);
-      mw->Write(moveable);
-      mw.Finalize();
+      player_join_packet.WritePayload(my_player_data, moveable);
       client->PacketSend(player_join_packet, SendStrategy::kUnreliableNoNagle);
     }
   };
@@ -393,18 +534,10 @@ Network<Side::kClient>::SetupPacketHandler()
       return;
     }
 
-    // 3. add RenderComponent
-#if !defined(DIB_IS_SERVER)
-    auto texture = std::make_shared<graphics::Texture>("Wizard");
-    texture->Load(Path{ "./res/entity/wizard.tga" });
-    game::RenderComponent renderComponent{ texture };
-    system::Assign(registry, *maybe_entity, renderComponent);
-#endif
-
-    // 4. add Moveable (and Collideable)
+    // 3. add Moveable (and Collideable), the client adds the RenderComponent
     system::Assign(registry, *maybe_entity, moveable);
 
-    // 5. display all connections
+    // 4. display all connections
     DLOG_INFO("All active connections:");
     std::string_view _{};
     NetworkInfo(_);
@@ -594,6 +727,40 @@ Network<Side::kClient>::SetupPacketHandler()
   ok = packet_handler_.AddStaticPacketType(
     PacketHeaderStaticTypes::kTileUpdate, "tile update", TileUpdateCb);
   AlfAssert(ok, "could not add packet type tile update");
+
+  // ============================================================ //
+
+  const auto JoinSnapshotCb = [this](const Packet& packet) {
+    const auto result = join_snapshot_.ReadFragment(packet);
+    if (result == JoinSnapshot::ReadResult::kError) {
+      DLOG_ERROR("got a bad join snapshot fragment, disconnecting us");
+      auto client = GetClient();
+      client->CloseConnection();
+      return;
+    }
+    if (result == JoinSnapshot::ReadResult::kIncomplete) {
+      return;
+    }
+
+    auto& registry = world_->GetEntityManager().GetRegistry();
+    const auto maybe_players = join_snapshot_.Apply(registry);
+    if (!maybe_players) {
+      DLOG_ERROR("could not apply the join snapshot, disconnecting us");
+      auto client = GetClient();
+      client->CloseConnection();
+      return;
+    }
+
+    // display all connections
+    DLOG_INFO("All active connections:");
+    std::string_view _{};
+    NetworkInfo(_);
+  };
+  ok = packet_handler_.AddStaticPacketType(
+    PacketHeaderStaticTypes::kJoinSnapshot, "join snapshot", JoinSnapshotCb);
+  AlfAssert(ok, "could not add packet type join snapshot");
+
+  SetupCompression(packet_handler_);
 }
 
 // ============================================================ //
@@ -604,8 +771,13 @@ template<>
 void
 Network<Side::kServer>::SetupPacketHandler()
 {
-  const auto SyncCb = [](const Packet&) {
-    DLOG_WARNING("got sync packet, but server does not handle sync packets");
+  // a client whose packet types differ from ours asks for them
+  const auto SyncCb = [&](const Packet& packet) {
+    Packet sync_packet{};
+    packet_handler_.BuildPacketSync(sync_packet);
+    auto server = GetServer();
+    server->PacketUnicast(
+      sync_packet, SendStrategy::kReliable, packet.GetFromConnection());
   };
   bool ok = packet_handler_.AddStaticPacketType(
     PacketHeaderStaticTypes::kSync, "sync", SyncCb);
@@ -619,11 +791,9 @@ Network<Side::kServer>::SetupPacketHandler()
     if (world_->GetChat().ValidateMessage(msg)) {
       world_->GetChat().FillFromTo(msg);
 
-      Packet new_packet{};
+      Packet new_packet{ SerializedSize(msg) };
       new_packet.SetHeader(*packet.GetHeader());
-      auto mw = new_packet.GetMemoryWriter();
-      mw->Write(msg);
-      mw.Finalize();
+      new_packet.WritePayload(msg);
       PacketBroadcast(new_packet);
     } else {
       DLOG_WARNING("[{}] attempted to send invalid chat message",
@@ -665,7 +835,7 @@ Network<Side::kServer>::SetupPacketHandler()
         registry.assign<game::Moveable>(*maybe_entity, moveable);
         server->PacketBroadcastExclude(
           packet, SendStrategy::kUnreliableNoNagle, packet.GetFromConnection());
-        SendPlayerList(packet.GetFromConnection());
+        SendJoinSnapshot(packet.GetFromConnection());
       } else {
         DLOG_WARNING("failed to create PlayerData, disconnecting the "
                      "connection {}",
@@ -738,11 +908,9 @@ Network<Side::kServer>::SetupPacketHandler()
               DLOG_WARNING("failed to get connection status");
             }
 
-            Packet modified_packet(packet.GetPacketSize());
+            Packet modified_packet(SerializedSize(player_data));
             modified_packet.SetHeader(*packet.GetHeader());
-            auto mw = modified_packet.GetMemoryWriter();
-            mw->Write(player_data);
-            mw.Finalize();
+            modified_packet.WritePayload(player_data);
             PacketBroadcastExclude(modified_packet, player_data.connection_id);
           }
         } else /* !accept */ {
@@ -752,9 +920,7 @@ Network<Side::kServer>::SetupPacketHandler()
           Packet reject_packet{};
           packet_handler_.BuildPacketHeader(
             reject_packet, PacketHeaderStaticTypes::kPlayerUpdateRejected);
-          auto mw = reject_packet.GetMemoryWriter();
-          mw->Write(**maybe_pd);
-          mw.Finalize();
+          reject_packet.WritePayload(**maybe_pd);
           auto server = GetServer();
           server->PacketUnicast(reject_packet,
                                 SendStrategy::kUnreliableNoNagle,
@@ -800,11 +966,12 @@ Network<Side::kServer>::SetupPacketHandler()
 
   // ============================================================ //
 
-  const auto PlayerIncrementCb = [this](const Packet& packet) {
+  // sent by every client each tick, so it skips the std::function
+  const auto PlayerIncrementCb = [](Network& network,
+                                    const game::MoveableIncrement& increment,
+                                    const Packet& packet) {
     MICROPROFILE_SCOPEI("network", "PlayerIncrementCb", MP_YELLOW2);
-    auto mr = packet.GetMemoryReader();
-    const auto moveable_increment = mr.Read<game::MoveableIncrement>();
-    auto& registry = world_->GetEntityManager().GetRegistry();
+    auto& registry = network.world_->GetEntityManager().GetRegistry();
     auto view = registry.view<PlayerData, game::Moveable>();
     bool found = false;
     for (const auto entity : view) {
@@ -813,7 +980,7 @@ Network<Side::kServer>::SetupPacketHandler()
         found = true;
         auto& moveable = view.get<game::Moveable>(entity);
         // TODO do some cheat checking
-        moveable.FromIncrement(moveable_increment);
+        moveable.FromIncrement(increment);
       }
     }
     if (!found) {
@@ -821,9 +988,10 @@ Network<Side::kServer>::SetupPacketHandler()
                    packet.GetFromConnection());
     }
   };
-  ok = packet_handler_.AddStaticPacketType(
+  ok = packet_handler_.AddHandler<game::MoveableIncrement>(
     PacketHeaderStaticTypes::kPlayerIncrement,
     "player increment",
+    *this,
     PlayerIncrementCb);
   AlfAssert(ok, "could not add packet type player increment");
 
@@ -888,6 +1056,20 @@ Network<Side::kServer>::SetupPacketHandler()
   ok = packet_handler_.AddStaticPacketType(
     PacketHeaderStaticTypes::kTileUpdate, "tile update", TileUpdateCb);
   AlfAssert(ok, "could not add packet type tile update");
+
+  // ============================================================ //
+
+  const auto JoinSnapshotCb = [this](const Packet& packet) {
+    DLOG_WARNING("got a JoinSnapshot packet, but client should "
+                 "not send those, disconnecting the client");
+    auto server = GetServer();
+    server->DisconnectConnection(packet.GetFromConnection());
+  };
+  ok = packet_handler_.AddStaticPacketType(
+    PacketHeaderStaticTypes::kJoinSnapshot, "join snapshot", JoinSnapshotCb);
+  AlfAssert(ok, "could not add packet type join snapshot");
+
+  SetupCompression(packet_handler_);
 }
 
 template<>
@@ -896,19 +1078,15 @@ Network<Side::kClient>::Update()
 {
   MICROPROFILE_SCOPEI("network", "update", MP_YELLOW);
 
-  // update network
-  static bool got_update;
+  // drain point, handle everything the network thread received since the last
+  // tick
   auto client = GetClient();
-  static const auto PollClient =
-    std::bind(&Client::Poll, client, std::ref(got_update), std::ref(packet_));
-  got_update = false;
-  dutil::FixedTimeUpdate(kNetTicksPerSec, PollClient);
-  while (got_update) {
+  client->PollSocketStateChanges();
+  while (client->PollIncomingPackets(packet_)) {
     bool success = packet_handler_.HandlePacket(packet_);
     if (!success) {
       DLOG_WARNING("Could not handle packet on client");
     }
-    PollClient(got_update, packet_);
   }
 }
 
@@ -918,22 +1096,47 @@ Network<Side::kServer>::Update()
 {
   MICROPROFILE_SCOPEI("network", "update", MP_YELLOW);
 
-  // update network
-  static bool got_update = false; // needs to be static?
+  // drain point, handle everything the network thread received since the last
+  // tick
+  join_snapshot_built_ = false;
   auto server = GetServer();
-  static const auto PollServer =
-    std::bind(&Server::Poll, server, std::ref(got_update), std::ref(packet_));
-  got_update = false;
-  dutil::FixedTimeUpdate(kNetTicksPerSec, PollServer);
-  while (got_update) {
+  server->PollSocketStateChanges();
+  while (server->PollIncomingPackets(packet_)) {
     bool success = packet_handler_.HandlePacket(packet_);
     if (!success) {
       DLOG_WARNING("Could not handle packet on server");
     }
-    PollServer(got_update, packet_);
   }
 }
 
+template<>
+Outbox&
+Network<Side::kClient>::GetOutbox() const
+{
+  return GetClient()->GetOutbox();
+}
+
+template<>
+Outbox&
+Network<Side::kServer>::GetOutbox() const
+{
+  return GetServer()->GetOutbox();
+}
+
+template<>
+void
+Network<Side::kClient>::Flush()
+{
+  GetClient()->Flush();
+}
+
+template<>
+void
+Network<Side::kServer>::Flush()
+{
+  GetServer()->Flush();
+}
+
 template<>
 void
 Network<Side::kServer>::Broadcast(const std::string_view message) const
@@ -9,6 +9,7 @@
 #include "network/common.hpp"
 #include "network/server.hpp"
 #include "network/packet_handler.hpp"
+#include "network/join_snapshot.hpp"
 #include <alflib/core/assert.hpp>
 #include <dlog.hpp>
 #include <functional>
@@ -56,14 +57,22 @@ public:
 public:
   static constexpr u16 kPort = 24812;
 
-  static constexpr f64 kNetTicksPerSec = 64;
-
   // ============================================================ //
   // Shared Methods
   // ============================================================ //
 public:
+  /**
+   * Drain point of the tick. Runs the connection status callbacks and handles
+   * the packets that the network thread has received since the last call.
+   */
   void Update();
 
+  /**
+   * Send the packets that were queued since the last flush, coalesced per
+   * connection. Called at the end of each tick.
+   */
+  void Flush();
+
   /**
    * Server: Broadcast the packet to all active connections.
    * Client: Unicast the packet to the server.
@@ -77,6 +86,13 @@ public:
   void PacketBroadcastExclude(const Packet& packet,
                               const ConnectionId exclude_connection) const;
 
+  /**
+   * Server: Unicast the packet to the given connection.
+   * Client: assert(false)
+   */
+  void PacketUnicast(const Packet& packet,
+                     const ConnectionId target_connection) const;
+
   void NetworkInfo(const std::string_view message) const;
 
   void Broadcast(const std::string_view message) const;
@@ -94,6 +110,8 @@ public:
 
   PacketHandler& GetPacketHandler() { return packet_handler_; }
 
+  Outbox& GetOutbox() const;
+
   // ============================================================ //
   // Client Only Methods
   // ============================================================ //
@@ -112,8 +130,31 @@ public:
   // Server Only Methods
   // ============================================================ //
 
+  /**
+   * Start listening for connections, the server does not until this is
+   * called.
+   */
   void StartServer();
 
+  /**
+   * Server only, record the received packets to a capture file, see
+   * Server::StartCapture.
+   */
+  bool StartCapture(const Path& path);
+
+  void StopCapture();
+
+  /**
+   * Server only, handle a packet read from a capture as if it was received
+   * now. Its connection is added, without a socket, when first seen.
+   */
+  void ReplayPacket(const Packet& packet);
+
+  /**
+   * Server only, close a connection of a replayed capture.
+   */
+  void ReplayDisconnect(const ConnectionId connection);
+
   /**
    * Server only, (client always return std::nullopt)
    */
@@ -132,16 +173,22 @@ private:
   Server* GetServer() const { return static_cast<Server*>(base_); }
 
   /**
-   * Call once at startup.
+   * Call when a network is created, only the first call initializes the
+   * sockets.
    */
   static bool InitNetwork();
 
   /**
-   * Call once before closing program.
+   * Call when a network is destroyed, only the last call shuts down the
+   * sockets.
    */
   static void ShutdownNetwork();
 
-  void SendPlayerList(const ConnectionId connection_id) const;
+  /**
+   * Send the join snapshot to a joining player. The snapshot is built at most
+   * once per tick, and shared by everyone joining in that tick.
+   */
+  void SendJoinSnapshot(const ConnectionId connection_id);
 
   void SetOurPlayerEntity(const std::optional<entt::entity> maybe_entity);
 
@@ -160,6 +207,18 @@ private:
   Packet packet_{ 10000 };
 
   game::World* world_;
+
+  /**
+   * Server: The snapshot built this tick, if join_snapshot_built_.
+   * Client: The snapshot being received.
+   */
+  JoinSnapshot join_snapshot_{};
+  bool join_snapshot_built_{ false };
+
+  /**
+   * Number of live networks in the process, several clients can share it.
+   */
+  static inline u32 network_count_ = 0;
 };
 
 // ============================================================ //
@@ -177,7 +236,6 @@ Network<side>::Network(game::World* world)
   SetupPacketHandler();
   if constexpr (side == Side::kServer) {
     base_ = new Server(world);
-    StartServer();
   } else {
     base_ = new Client(world);
   }
@@ -189,6 +247,8 @@ Network<side>::Network(Network&& other)
   , packet_handler_(std::move(other.packet_handler_))
   , packet_(std::move(other.packet_))
   , world_(std::move(other.world_))
+  , join_snapshot_(std::move(other.join_snapshot_))
+  , join_snapshot_built_(other.join_snapshot_built_)
 {
   other.base_ = nullptr;
   other.world_ = nullptr;
@@ -203,6 +263,8 @@ Network<side>::operator=(Network&& other)
     packet_handler_ = std::move(other.packet_handler_);
     packet_ = std::move(other.packet_);
     world_ = std::move(other.world_);
+    join_snapshot_ = std::move(other.join_snapshot_);
+    join_snapshot_built_ = other.join_snapshot_built_;
     other.base_ = nullptr;
     other.world_ = nullptr;
   }
@@ -212,6 +274,10 @@ Network<side>::operator=(Network&& other)
 template<Side side>
 Network<side>::~Network()
 {
+  // moved from
+  if (base_ == nullptr) {
+    return;
+  }
   if constexpr (side == Side::kServer) {
     auto server = GetServer();
     server->~Server();
@@ -230,6 +296,10 @@ template<Side side>
 bool
 Network<side>::InitNetwork()
 {
+  if (network_count_++ > 0) {
+    return true;
+  }
+
   SteamDatagramErrMsg errMsg;
   if (!GameNetworkingSockets_Init(nullptr, errMsg)) {
     DLOG_ERROR("GameNetworkingSockets_Init failed.  [{}]", errMsg);
@@ -254,6 +324,9 @@ template<Side side>
 void
 Network<side>::ShutdownNetwork()
 {
+  if (--network_count_ > 0) {
+    return;
+  }
   SleepAndKill();
 }
 }
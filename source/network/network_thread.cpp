@@ -0,0 +1,147 @@
+#include "network_thread.hpp"
+#include <dlog.hpp>
+#include <microprofile/microprofile.h>
+#include <chrono>
+
+namespace dib {
+
+NetworkThread::NetworkThread(ISteamNetworkingSockets* socket_interface)
+  : socket_interface_(socket_interface)
+{}
+
+NetworkThread::~NetworkThread()
+{
+  Stop();
+}
+
+void
+NetworkThread::Start(Receiver receiver)
+{
+  if (IsRunning()) {
+    DLOG_WARNING("network thread is already running");
+    return;
+  }
+  receiver_ = std::move(receiver);
+  running_.store(true, std::memory_order_release);
+  thread_ = std::thread(&NetworkThread::Run, this);
+}
+
+void
+NetworkThread::Stop()
+{
+  if (!thread_.joinable()) {
+    return;
+  }
+  running_.store(false, std::memory_order_release);
+  thread_.join();
+
+  // flush sends queued after the thread last looked
+  PumpSend();
+
+  for (int i = received_index_; i < received_count_; i++) {
+    received_[i]->Release();
+  }
+  received_count_ = 0;
+  received_index_ = 0;
+  ISteamNetworkingMessage* msg = nullptr;
+  while (inbound_.TryPop(msg)) {
+    msg->Release();
+  }
+}
+
+SendResult
+NetworkThread::Send(const Packet& packet,
+                    const SendStrategy send_strategy,
+                    const HSteamNetConnection connection)
+{
+  return Send(
+    packet.GetPacket(), packet.GetPacketSize(), send_strategy, connection);
+}
+
+SendResult
+NetworkThread::Send(const u8* data,
+                    const std::size_t data_count,
+                    const SendStrategy send_strategy,
+                    const HSteamNetConnection connection)
+{
+  // copy into the buffer of the slot, which is reused between sends
+  const bool pushed = outbound_.TryPushWith([&](Outbound& outbound) {
+    outbound.connection = connection;
+    outbound.send_strategy = send_strategy;
+    outbound.data.assign(data, data + data_count);
+  });
+  if (!pushed) {
+    DLOG_WARNING("outbound network queue is full");
+    return SendResult::kRetry;
+  }
+  return SendResult::kSuccess;
+}
+
+ISteamNetworkingMessage*
+NetworkThread::Receive()
+{
+  ISteamNetworkingMessage* msg = nullptr;
+  return inbound_.TryPop(msg) ? msg : nullptr;
+}
+
+void
+NetworkThread::Run()
+{
+  MicroProfileOnThreadCreate("network");
+  while (running_.load(std::memory_order_acquire)) {
+    MICROPROFILE_SCOPEI("network", "io", MP_YELLOW);
+    const bool sent = PumpSend();
+    const bool received = PumpReceive();
+    if (!sent && !received) {
+      std::this_thread::sleep_for(
+        std::chrono::microseconds(kIdleSleepMicroseconds));
+    }
+  }
+  MicroProfileOnThreadExit();
+}
+
+bool
+NetworkThread::PumpReceive()
+{
+  bool any = false;
+  for (;;) {
+    if (received_index_ == received_count_) {
+      received_index_ = 0;
+      received_count_ = receiver_(received_, kReceiveBatchSize);
+      if (received_count_ <= 0) {
+        // a failed receive only means that there is no connection yet, status
+        // changes are reported through the callbacks
+        received_count_ = 0;
+        return any;
+      }
+    }
+    while (received_index_ < received_count_) {
+      if (!inbound_.TryPush(received_[received_index_])) {
+        return any;
+      }
+      received_index_++;
+      any = true;
+    }
+  }
+}
+
+bool
+NetworkThread::PumpSend()
+{
+  bool any = false;
+  while (outbound_.TryPopWith([this](Outbound& outbound) {
+    Common::SendPacket(outbound.data.data(),
+                       outbound.data.size(),
+                       outbound.send_strategy,
+                       outbound.connection,
+                       socket_interface_);
+    if (outbound.data.capacity() > kMaxKeptBufferSize) {
+      outbound.data = std::vector<u8>{};
+    }
+  })) {
+    any = true;
+  }
+  return any;
+}
+
+}
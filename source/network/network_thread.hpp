@@ -0,0 +1,159 @@
+#ifndef NETWORK_THREAD_HPP_
+#define NETWORK_THREAD_HPP_
+
+#include "core/types.hpp"
+#include "core/lock_free_queue.hpp"
+#include "network/common.hpp"
+#include "network/packet.hpp"
+#include <steam/isteamnetworkingutils.h>
+#include <steam/steamnetworkingsockets.h>
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace dib {
+
+/**
+ * Thread that does all of the socket I/O, so that receiving and sending never
+ * stalls the game thread.
+ *
+ * Received messages are handed to the game thread through a single producer
+ * queue and are popped at the drain point of each tick. Packets sent from any
+ * thread are copied into a multiple producer queue and are sent from the
+ * network thread. The slots of the outbound queue keep their buffers between
+ * sends, so copying a packet does not allocate once the queue is warm. Both
+ * queues are bounded; when the inbound queue is full the network thread stops
+ * receiving until the game thread catches up. When the outbound queue is full
+ * a send reports that it should be retried, the outbox keeps what was not
+ * sent.
+ *
+ * Connection status callbacks are not run here, they touch the world and are
+ * run on the game thread by the owner.
+ */
+class NetworkThread
+{
+public:
+  static constexpr u64 kInboundCapacity = 4096;
+
+  static constexpr u64 kOutboundCapacity = 8192;
+
+  /**
+   * Largest buffer that an outbound slot keeps after its packet is sent. The
+   * buffer of a larger packet is freed, so that a few large packets do not
+   * hold on to their memory in the queue.
+   */
+  static constexpr std::size_t kMaxKeptBufferSize = 2048;
+
+  /**
+   * Maximum number of messages received with one call into the sockets.
+   */
+  static constexpr int kReceiveBatchSize = 64;
+
+  /**
+   * How long the thread sleeps when there was nothing to receive or send.
+   */
+  static constexpr u32 kIdleSleepMicroseconds = 500;
+
+  /**
+   * Receive up to @max_count messages into @messages.
+   * @return Number of messages received, negative on failure.
+   */
+  using Receiver =
+    std::function<int(ISteamNetworkingMessage** messages, int max_count)>;
+
+  // ============================================================ //
+
+  explicit NetworkThread(ISteamNetworkingSockets* socket_interface);
+
+  ~NetworkThread();
+
+  NetworkThread(const NetworkThread& other) = delete;
+
+  NetworkThread& operator=(const NetworkThread& other) = delete;
+
+  /**
+   * Start the thread. @receiver is called from the network thread.
+   */
+  void Start(Receiver receiver);
+
+  /**
+   * Send what is left in the outbound queue and join the thread. Messages
+   * that were received but never popped are released.
+   */
+  void Stop();
+
+  bool IsRunning() const { return running_.load(std::memory_order_acquire); }
+
+  /**
+   * Queue a packet to be sent from the network thread, may be called from any
+   * thread.
+   * @return kRetry if the outbound queue is full, otherwise kSuccess.
+   * Errors from the actual send are logged by the network thread.
+   */
+  SendResult Send(const Packet& packet,
+                  SendStrategy send_strategy,
+                  HSteamNetConnection connection);
+
+  /**
+   * Queue raw packet bytes, header included, see Send above.
+   */
+  SendResult Send(const u8* data,
+                  std::size_t data_count,
+                  SendStrategy send_strategy,
+                  HSteamNetConnection connection);
+
+  /**
+   * Pop the next received message, game thread only. The caller must release
+   * the message.
+   * @return Nullptr if there are no more messages.
+   */
+  ISteamNetworkingMessage* Receive();
+
+  u64 GetInboundCount() const { return inbound_.GetSize(); }
+
+  // ============================================================ //
+
+private:
+  struct Outbound
+  {
+    HSteamNetConnection connection{ k_HSteamNetConnection_Invalid };
+    SendStrategy send_strategy{ SendStrategy::kReliable };
+    std::vector<u8> data{};
+  };
+
+  void Run();
+
+  /**
+   * Move received messages to the inbound queue.
+   * @return True if any message was moved.
+   */
+  bool PumpReceive();
+
+  /**
+   * Send everything in the outbound queue.
+   * @return True if anything was sent.
+   */
+  bool PumpSend();
+
+  // ============================================================ //
+
+private:
+  ISteamNetworkingSockets* socket_interface_;
+  Receiver receiver_{};
+
+  SpscQueue<ISteamNetworkingMessage*> inbound_{ kInboundCapacity };
+  MpscQueue<Outbound> outbound_{ kOutboundCapacity };
+
+  /** Received messages that did not fit in the inbound queue yet. */
+  ISteamNetworkingMessage* received_[kReceiveBatchSize]{};
+  int received_count_{ 0 };
+  int received_index_{ 0 };
+
+  std::atomic<bool> running_{ false };
+  std::thread thread_{};
+};
+
+}
+
+#endif // NETWORK_THREAD_HPP_
@@ -0,0 +1,179 @@
+#include "outbox.hpp"
+#include "network/packet_header.hpp"
+#include <microprofile/microprofile.h>
+#include <cstring>
+
+namespace dib {
+
+namespace {
+
+constexpr std::size_t kFrameSizeBytes = sizeof(u16);
+
+constexpr std::size_t kMaxFramedPacketSize =
+  Outbox::kMaxBatchSize - sizeof(PacketHeader) - kFrameSizeBytes;
+
+void
+AppendBytes(std::vector<u8>& out, const void* data, const std::size_t count)
+{
+  const auto* bytes = static_cast<const u8*>(data);
+  out.insert(out.end(), bytes, bytes + count);
+}
+
+}
+
+void
+Outbox::Add(const Packet& packet,
+            const SendStrategy send_strategy,
+            const HSteamNetConnection connection)
+{
+  const bool reliable =
+    (static_cast<int>(send_strategy) & k_nSteamNetworkingSend_Reliable) != 0;
+  const u64 key = Key(connection, reliable);
+  auto it = indices_.find(key);
+  if (it == indices_.end()) {
+    it = indices_.insert({ key, static_cast<u32>(queues_.size()) }).first;
+    queues_.push_back(Queue{ connection, reliable });
+  }
+
+  Queue& queue = queues_[it->second];
+  const u32 size = static_cast<u32>(packet.GetPacketSize());
+  AppendBytes(queue.frames, &size, sizeof(size));
+  AppendBytes(queue.frames, packet.GetPacket(), size);
+  packet_count_++;
+}
+
+SendResult
+Outbox::Flush(const Sink& sink)
+{
+  MICROPROFILE_SCOPEI("network", "flush outbox", MP_YELLOW);
+  SendResult result = SendResult::kSuccess;
+  for (Queue& queue : queues_) {
+    if (!queue.frames.empty()) {
+      const SendResult queue_result = FlushQueue(queue, sink);
+      if (result == SendResult::kSuccess) {
+        result = queue_result;
+      }
+    }
+  }
+  return result;
+}
+
+void
+Outbox::Drop(const HSteamNetConnection connection)
+{
+  for (const bool reliable : { false, true }) {
+    const auto it = indices_.find(Key(connection, reliable));
+    if (it == indices_.end()) {
+      continue;
+    }
+
+    // move the last queue into the hole
+    const u32 index = it->second;
+    indices_.erase(it);
+    if (index + 1 != queues_.size()) {
+      queues_[index] = std::move(queues_.back());
+      indices_[Key(queues_[index].connection, queues_[index].reliable)] =
+        index;
+    }
+    queues_.pop_back();
+  }
+}
+
+void
+Outbox::ResetStats()
+{
+  packet_count_ = 0;
+  datagram_count_ = 0;
+}
+
+u64
+Outbox::Key(const HSteamNetConnection connection, const bool reliable)
+{
+  return (static_cast<u64>(connection) << 1u) | (reliable ? 1u : 0u);
+}
+
+SendResult
+Outbox::FlushQueue(Queue& queue, const Sink& sink)
+{
+  const SendStrategy send_strategy = queue.reliable
+                                       ? SendStrategy::kReliableNoNagle
+                                       : SendStrategy::kUnreliableNoNagle;
+
+  // frames before this offset have been taken by the sink
+  std::size_t sent = 0;
+  SendResult result = SendResult::kSuccess;
+  const auto send = [&](const u8* data,
+                        const std::size_t data_count,
+                        const std::size_t end) {
+    result = sink(data, data_count, send_strategy, queue.connection);
+    if (result != SendResult::kSuccess) {
+      return false;
+    }
+    datagram_count_++;
+    sent = end;
+    return true;
+  };
+
+  // a batch of one is sent as the packet itself
+  const u8* single = nullptr;
+  u32 single_size = 0;
+  u32 batched = 0;
+
+  const auto send_batch = [&](const std::size_t end) {
+    bool ok = true;
+    if (batched == 1) {
+      ok = send(single, single_size, end);
+    } else if (batched > 1) {
+      ok = send(batch_.data(), batch_.size(), end);
+    }
+    batched = 0;
+    batch_.resize(sizeof(PacketHeader));
+    return ok;
+  };
+
+  PacketHeader header{};
+  header.type = kBatchPacketHeaderType;
+  batch_.clear();
+  AppendBytes(batch_, &header, sizeof(header));
+
+  std::size_t offset = 0;
+  while (offset < queue.frames.size()) {
+    u32 size;
+    std::memcpy(&size, queue.frames.data() + offset, sizeof(size));
+    const u8* data = queue.frames.data() + offset + sizeof(size);
+    const std::size_t next = offset + sizeof(size) + size;
+
+    if (size > kMaxFramedPacketSize) {
+      if (!send_batch(offset) || !send(data, size, next)) {
+        break;
+      }
+      offset = next;
+      continue;
+    }
+
+    if (batch_.size() + kFrameSizeBytes + size > kMaxBatchSize &&
+        !send_batch(offset)) {
+      break;
+    }
+    const u16 frame_size = static_cast<u16>(size);
+    AppendBytes(batch_, &frame_size, sizeof(frame_size));
+    AppendBytes(batch_, data, size);
+    single = data;
+    single_size = size;
+    batched++;
+    offset = next;
+  }
+  if (result == SendResult::kSuccess) {
+    send_batch(offset);
+  }
+
+  // unreliable packets are stale by the next flush, so they are not kept
+  if (result != SendResult::kSuccess && !queue.reliable) {
+    queue.frames.clear();
+  } else {
+    queue.frames.erase(queue.frames.begin(), queue.frames.begin() + sent);
+  }
+  return result;
+}
+
+}
@@ -0,0 +1,119 @@
+#ifndef OUTBOX_HPP_
+#define OUTBOX_HPP_
+
+#include "core/types.hpp"
+#include "network/common.hpp"
+#include "network/packet.hpp"
+#include <steam/steamnetworkingsockets.h>
+#include <tsl/robin_map.h>
+#include <functional>
+#include <vector>
+
+namespace dib {
+
+/**
+ * Gathers the packets sent to each connection during a tick and sends them at
+ * the end of the tick as a few batch datagrams, instead of one message each.
+ *
+ * A batch is a packet with the header type kBatchPacketHeaderType, and a
+ * payload of frames. Each frame is a u16 size followed by a whole packet,
+ * header included. PacketHandler splits batches when handling them.
+ *
+ * Reliable and unreliable packets are batched separately, and packets keep
+ * their order within each. A batch is never larger than kMaxBatchSize, so
+ * it fits in a single datagram. Packets too large to fit in a batch are sent
+ * on their own, in order.
+ *
+ * Batches are sent without Nagle, since the outbox already coalesces the
+ * packets of a tick.
+ *
+ * When the sink fails, the reliable packets that it did not take stay in the
+ * outbox and are sent first on the next flush. The unreliable ones are
+ * dropped.
+ */
+class Outbox
+{
+public:
+  /**
+   * Largest batch, keeps each batch below a typical MTU.
+   */
+  static constexpr std::size_t kMaxBatchSize = 1200;
+
+  /**
+   * Sends the bytes of a packet or a batch.
+   */
+  using Sink = std::function<SendResult(const u8* data,
+                                        std::size_t data_count,
+                                        SendStrategy send_strategy,
+                                        HSteamNetConnection connection)>;
+
+  // ============================================================ //
+
+  /**
+   * Queue a packet until the next flush.
+   */
+  void Add(const Packet& packet,
+           SendStrategy send_strategy,
+           HSteamNetConnection connection);
+
+  /**
+   * Send everything that has been queued, call once at the end of a tick.
+   * @return kSuccess if everything was sent, otherwise the first failure of
+   * the sink. The reliable packets from the failed datagram onwards are kept
+   * for the next flush, the unreliable ones are dropped.
+   */
+  SendResult Flush(const Sink& sink);
+
+  /**
+   * Forget the packets queued for a connection, when it is closed.
+   */
+  void Drop(HSteamNetConnection connection);
+
+  /**
+   * Number of packets added since the last ResetStats.
+   */
+  u64 GetPacketCount() const { return packet_count_; }
+
+  /**
+   * Number of datagrams sent since the last ResetStats.
+   */
+  u64 GetDatagramCount() const { return datagram_count_; }
+
+  void ResetStats();
+
+  // ============================================================ //
+
+private:
+  struct Queue
+  {
+    HSteamNetConnection connection;
+    bool reliable;
+    /** Frames with a u32 size, which is narrowed when batched. */
+    std::vector<u8> frames{};
+  };
+
+  static u64 Key(HSteamNetConnection connection, bool reliable);
+
+  /**
+   * Send the frames of a queue and remove the ones that were sent, or all of
+   * them if the queue is unreliable and the sink failed.
+   */
+  SendResult FlushQueue(Queue& queue, const Sink& sink);
+
+  // ============================================================ //
+
+private:
+  std::vector<Queue> queues_{};
+
+  /** Index in queues_ of each connection and reliability. */
+  tsl::robin_map<u64, u32> indices_{};
+
+  std::vector<u8> batch_{};
+
+  u64 packet_count_{ 0 };
+  u64 datagram_count_{ 0 };
+};
+
+}
+
+#endif // OUTBOX_HPP_
@@ -212,6 +212,14 @@ Packet::GetPayloadCapacity() const
   return GetPacketCapacity() - kHeaderSize;
 }
 
+void
+Packet::ReservePayload(const std::size_t size)
+{
+  if (GetBytesLeft() < size) {
+    SetPacketCapacity(GetPacketSize() + size);
+  }
+}
+
 bool
 Packet::SetPayload(const Packet::ValueType* data, const std::size_t data_count)
 {
@@ -292,10 +300,25 @@ Packet::GetMemoryReader() const
   return mr;
 }
 
+BitMemoryWriter
+Packet::GetBitWriter()
+{
+  BitMemoryWriter bw{ this };
+  return bw;
+}
+
+BitReader
+Packet::GetBitReader() const
+{
+  BitReader br{ GetPayload(), GetPayloadSize() };
+  return br;
+}
+
 // ============================================================ //
 
 MemoryWriter::MemoryWriter(Packet* packet)
-  : mw_(packet->GetRawPayload(), packet->GetPayloadCapacity())
+  : mw_(packet->GetRawPayload() + packet->GetPayloadSize(),
+        packet->GetPayloadCapacity() - packet->GetPayloadSize())
   , packet_(packet)
   , did_finalize(false)
 {}
@@ -318,4 +341,30 @@ MemoryWriter::Finalize()
   packet_->SetPayloadSize(after);
 }
 
+// ============================================================ //
+
+BitMemoryWriter::BitMemoryWriter(Packet* packet)
+  : bw_(packet->GetRawPayload() + packet->GetPayloadSize(),
+        packet->GetPayloadCapacity() - packet->GetPayloadSize())
+  , packet_(packet)
+  , did_finalize(false)
+{}
+
+BitMemoryWriter::~BitMemoryWriter()
+{
+  AlfAssert(did_finalize,
+            "bit memory writer was destructed without have "
+            "gotten a call to finalize, this is a bug");
+}
+
+void
+BitMemoryWriter::Finalize()
+{
+  did_finalize = true;
+  bw_.Flush();
+  const std::size_t after = packet_->GetPayloadSize() + bw_.GetByteCount();
+  AlfAssert(after <= packet_->GetPayloadCapacity(), "offset too large");
+  packet_->SetPayloadSize(after);
+}
+
 }
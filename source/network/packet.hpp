@@ -2,6 +2,8 @@
 #define PACKET_HPP_
 
 #include "core/types.hpp"
+#include "core/bit_stream.hpp"
+#include "core/schema.hpp"
 #include "network/packet_header.hpp"
 #include "network/connection_id.hpp"
 #include <vector>
@@ -37,6 +39,29 @@ private:
   bool did_finalize;
 };
 
+/**
+ * Like MemoryWriter, but writes bits with a BitWriter.
+ */
+struct BitMemoryWriter
+{
+  BitMemoryWriter(Packet* packet);
+  ~BitMemoryWriter();
+
+  BitWriter* operator->() { return &bw_; }
+  BitWriter* operator*() { return &bw_; }
+
+  /**
+   * Will write the last partial byte and update the packet's payload size,
+   * realizing the writes.
+   */
+  void Finalize();
+
+private:
+  BitWriter bw_;
+  Packet* packet_;
+  bool did_finalize;
+};
+
 // ============================================================ //
 // Payload Iterator
 // ============================================================ //
@@ -214,6 +239,12 @@ public:
    */
   std::size_t GetPayloadCapacity() const;
 
+  /**
+   * Grow the packet, if needed, so that @size more bytes fit after the
+   * current payload.
+   */
+  void ReservePayload(const std::size_t size);
+
   /**
    * @return If we could write the entire data into payload.
    */
@@ -226,6 +257,7 @@ public:
 
 private:
   friend MemoryWriter;
+  friend BitMemoryWriter;
   ValueType* GetRawPayload();
 
 public:
@@ -258,6 +290,30 @@ public:
    */
   alflib::RawMemoryReader GetMemoryReader() const;
 
+  /**
+   * Use a bit writer to write the payload, see GetMemoryWriter. REMEMBER to
+   * call Finalize on the BitMemoryWriter when done.
+   *
+   * Will be invalidated on packet resize.
+   */
+  BitMemoryWriter GetBitWriter();
+
+  /**
+   * Read the payload with a bit reader. Pair it with the bit writer.
+   *
+   * Will be invalidated on packet resize.
+   */
+  BitReader GetBitReader() const;
+
+  /**
+   * Append @values to the payload. Their serialized size is computed first,
+   * so the packet grows at most once. See Serializer for what types can be
+   * written.
+   * @return False if a value failed to serialize.
+   */
+  template<typename... TValues>
+  bool WritePayload(const TValues&... values);
+
   // ============================================================ //
   // Constants
   // ============================================================ //
@@ -281,6 +337,22 @@ private:
   PacketContainer container_;
 };
 
+// ============================================================ //
+// Template Implementation
+// ============================================================ //
+
+template<typename... TValues>
+bool
+Packet::WritePayload(const TValues&... values)
+{
+  ReservePayload(SerializedSize(values...));
+  auto mw = GetMemoryWriter();
+  alflib::RawMemoryWriter& writer = **mw;
+  const bool ok = (Serializer<TValues>::Write(writer, values) && ...);
+  mw.Finalize();
+  return ok;
+}
+
 }
 
 #endif // PACKET_HPP_
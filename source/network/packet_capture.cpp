@@ -0,0 +1,204 @@
+#include "packet_capture.hpp"
+#include "core/bit_stream.hpp"
+#include <dlog.hpp>
+#include <algorithm>
+#include <iterator>
+
+namespace dib {
+
+namespace {
+
+/** Largest record header, three varints of at most 10 bytes. */
+constexpr std::size_t kMaxRecordHeaderSize = 30;
+
+}
+
+// ============================================================ //
+// PacketCaptureWriter
+// ============================================================ //
+
+PacketCaptureWriter::PacketCaptureWriter(const Path& path)
+  : io_(path)
+  , start_(std::chrono::steady_clock::now())
+{
+  const alflib::FileIO::Flag flags = alflib::FileIO::Flag::kWrite |
+                                     alflib::FileIO::Flag::kCreate |
+                                     alflib::FileIO::Flag::kOverwrite;
+  if (io_.Open(flags) != alflib::FileResult::kSuccess) {
+    DLOG_ERROR("could not create capture file [{}]", path.GetPathString());
+    return;
+  }
+  open_ = true;
+  buffer_.reserve(kBufferSize + kMaxRecordHeaderSize);
+  buffer_.insert(
+    buffer_.end(), std::begin(kCaptureMagic), std::end(kCaptureMagic));
+  buffer_.push_back(kCaptureVersion);
+}
+
+PacketCaptureWriter::~PacketCaptureWriter()
+{
+  Flush();
+}
+
+void
+PacketCaptureWriter::Record(const Packet& packet)
+{
+  Record(packet, Now());
+}
+
+void
+PacketCaptureWriter::Record(const Packet& packet, const u64 time)
+{
+  WriteRecord(time,
+              packet.GetFromConnection(),
+              packet.GetPacket(),
+              packet.GetPacketSize());
+}
+
+void
+PacketCaptureWriter::RecordDisconnect(const ConnectionId connection)
+{
+  RecordDisconnect(connection, Now());
+}
+
+void
+PacketCaptureWriter::RecordDisconnect(const ConnectionId connection,
+                                      const u64 time)
+{
+  WriteRecord(time, connection, nullptr, 0);
+}
+
+void
+PacketCaptureWriter::WriteRecord(const u64 time,
+                                 const ConnectionId connection,
+                                 const u8* data,
+                                 const std::size_t size)
+{
+  if (!open_) {
+    return;
+  }
+
+  // times are stored as deltas, so that they stay short varints
+  const u64 delta = time >= last_time_ ? time - last_time_ : 0;
+  last_time_ = std::max(time, last_time_);
+
+  u8 header[kMaxRecordHeaderSize];
+  BitWriter bw{ header, sizeof(header) };
+  bw.WriteVarint(delta);
+  bw.WriteVarint(connection);
+  bw.WriteVarint(size);
+  buffer_.insert(buffer_.end(), header, header + bw.GetByteCount());
+  if (size > 0) {
+    buffer_.insert(buffer_.end(), data, data + size);
+  }
+  record_count_++;
+
+  if (buffer_.size() >= kBufferSize) {
+    Flush();
+  }
+}
+
+void
+PacketCaptureWriter::Flush()
+{
+  if (!open_ || buffer_.empty()) {
+    return;
+  }
+  u64 written;
+  if (io_.Write(buffer_.data(), buffer_.size(), written) !=
+      alflib::FileResult::kSuccess) {
+    DLOG_ERROR("failed to write to capture file, capture stopped");
+    open_ = false;
+  }
+  buffer_.clear();
+}
+
+u64
+PacketCaptureWriter::Now() const
+{
+  return static_cast<u64>(
+    std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start_)
+      .count());
+}
+
+// ============================================================ //
+// PacketCaptureReader
+// ============================================================ //
+
+PacketCaptureReader::PacketCaptureReader(const Path& path)
+{
+  alflib::FileIO io(path);
+  if (io.Open(alflib::FileIO::Flag::kRead) != alflib::FileResult::kSuccess) {
+    DLOG_ERROR("could not open capture file [{}]", path.GetPathString());
+    return;
+  }
+  data_.resize(io.GetFile().GetSize());
+  u64 read;
+  if (!data_.empty() && io.Read(data_.data(), data_.size(), read) !=
+                          alflib::FileResult::kSuccess) {
+    DLOG_ERROR("could not read capture file [{}]", path.GetPathString());
+    return;
+  }
+
+  const std::size_t header_size = sizeof(kCaptureMagic) + 1;
+  if (data_.size() < header_size ||
+      !std::equal(std::begin(kCaptureMagic),
+                  std::end(kCaptureMagic),
+                  data_.begin(),
+                  [](const char8 a, const u8 b) {
+                    return static_cast<u8>(a) == b;
+                  })) {
+    DLOG_ERROR("[{}] is not a capture file", path.GetPathString());
+    return;
+  }
+  if (data_[sizeof(kCaptureMagic)] != kCaptureVersion) {
+    DLOG_ERROR("capture file [{}] has version {}, expected {}",
+               path.GetPathString(),
+               data_[sizeof(kCaptureMagic)],
+               kCaptureVersion);
+    return;
+  }
+  offset_ = header_size;
+  valid_ = true;
+}
+
+bool
+PacketCaptureReader::Next(CaptureRecord& record_out, Packet& packet_out)
+{
+  if (!valid_ || offset_ >= data_.size()) {
+    return false;
+  }
+
+  BitReader br{ data_.data() + offset_, data_.size() - offset_ };
+  const u64 delta = br.ReadVarint();
+  const u64 connection = br.ReadVarint();
+  const u64 size = br.ReadVarint();
+  offset_ += br.GetBitCount() / 8;
+  if (br.HasError() || size > data_.size() - offset_) {
+    DLOG_WARNING("capture is corrupt after {} bytes", offset_);
+    valid_ = false;
+    return false;
+  }
+
+  time_ += delta;
+  record_out.time = time_;
+  record_out.connection = static_cast<ConnectionId>(connection);
+  record_out.disconnect = size == 0;
+  if (size > 0) {
+    if (size < packet_out.GetHeaderSize()) {
+      DLOG_WARNING("capture has a packet without a header [{}]", size);
+      valid_ = false;
+      return false;
+    }
+    if (packet_out.GetPacketCapacity() < size) {
+      packet_out.SetPacketCapacity(size);
+    }
+    packet_out.SetPacket(data_.data() + offset_, size);
+    packet_out.SetFromConnection(record_out.connection);
+  }
+  offset_ += size;
+  return true;
+}
+
+}
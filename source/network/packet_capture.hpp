@@ -0,0 +1,148 @@
+#ifndef PACKET_CAPTURE_HPP_
+#define PACKET_CAPTURE_HPP_
+
+#include "core/types.hpp"
+#include "network/connection_id.hpp"
+#include "network/packet.hpp"
+#include <alflib/file/file_io.hpp>
+#include <chrono>
+#include <vector>
+
+namespace dib {
+
+/**
+ * A capture is a log of the packets that a server received, to replay them
+ * later without sockets.
+ *
+ * The file starts with kCaptureMagic and kCaptureVersion, followed by one
+ * record per packet. All integers of a record are varints (LEB128):
+ *   microseconds since the previous record
+ *   connection id
+ *   packet size, header included, 0 when the connection was closed
+ *   packet bytes
+ */
+constexpr char8 kCaptureMagic[] = { 'D', 'I', 'B', 'C', 'A', 'P' };
+constexpr u8 kCaptureVersion = 1;
+
+/**
+ * A record of a capture, without the packet.
+ */
+struct CaptureRecord
+{
+  /** Microseconds since the capture started. */
+  u64 time = 0;
+
+  ConnectionId connection = kConnectionIdUnknown;
+
+  /** The connection was closed, there is no packet. */
+  bool disconnect = false;
+};
+
+// ============================================================ //
+// PacketCaptureWriter
+// ============================================================ //
+
+/**
+ * Records are buffered, and written to the file when the buffer is full, on
+ * Flush and when the writer is destructed.
+ */
+class PacketCaptureWriter
+{
+public:
+  /**
+   * Create the capture file at @path, an existing file is overwritten. See
+   * IsOpen.
+   */
+  explicit PacketCaptureWriter(const Path& path);
+
+  ~PacketCaptureWriter();
+
+  PacketCaptureWriter(const PacketCaptureWriter& other) = delete;
+  PacketCaptureWriter& operator=(const PacketCaptureWriter& other) = delete;
+
+  /**
+   * False if the file could not be created, or a write failed.
+   */
+  bool IsOpen() const { return open_; }
+
+  /**
+   * Record a packet, as received now.
+   */
+  void Record(const Packet& packet);
+
+  /**
+   * Record a packet, received @time microseconds after the capture started.
+   * Times must not decrease.
+   */
+  void Record(const Packet& packet, const u64 time);
+
+  /**
+   * Record that a connection was closed, now.
+   */
+  void RecordDisconnect(const ConnectionId connection);
+
+  void RecordDisconnect(const ConnectionId connection, const u64 time);
+
+  /**
+   * Write the buffered records to the file.
+   */
+  void Flush();
+
+  u64 GetRecordCount() const { return record_count_; }
+
+private:
+  /**
+   * Records are written once this many bytes are buffered.
+   */
+  static constexpr std::size_t kBufferSize = 64 * 1024;
+
+  void WriteRecord(const u64 time,
+                   const ConnectionId connection,
+                   const u8* data,
+                   const std::size_t size);
+
+  u64 Now() const;
+
+  alflib::FileIO io_;
+  bool open_ = false;
+  std::vector<u8> buffer_{};
+  std::chrono::steady_clock::time_point start_;
+  u64 last_time_ = 0;
+  u64 record_count_ = 0;
+};
+
+// ============================================================ //
+// PacketCaptureReader
+// ============================================================ //
+
+class PacketCaptureReader
+{
+public:
+  /**
+   * Read the whole capture file at @path, see IsValid.
+   */
+  explicit PacketCaptureReader(const Path& path);
+
+  /**
+   * False if the file could not be read or is not a capture.
+   */
+  bool IsValid() const { return valid_; }
+
+  /**
+   * Read the next record, and its packet into @packet_out unless it is a
+   * disconnect. The packet grows if needed, and is from the connection of
+   * the record.
+   * @return False at the end of the capture, or if the rest is corrupt.
+   */
+  bool Next(CaptureRecord& record_out, Packet& packet_out);
+
+private:
+  std::vector<u8> data_{};
+  std::size_t offset_ = 0;
+  u64 time_ = 0;
+  bool valid_ = false;
+};
+
+}
+
+#endif // PACKET_CAPTURE_HPP_
@@ -3,10 +3,54 @@
 #include <alflib/core/assert.hpp>
 #include <dlog.hpp>
 #include <microprofile/microprofile.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 
 namespace dib {
 
-PacketHandler::PacketHandler() = default;
+namespace {
+
+/**
+ * Adds the time between its construction and destruction to @nanoseconds,
+ * unless it is null, in which case the clock is never read.
+ */
+class ScopedTimer
+{
+public:
+  explicit ScopedTimer(u64* nanoseconds)
+    : nanoseconds_(nanoseconds)
+  {
+    if (nanoseconds_ != nullptr) {
+      start_ = std::chrono::steady_clock::now();
+    }
+  }
+
+  ~ScopedTimer()
+  {
+    if (nanoseconds_ != nullptr) {
+      const auto end = std::chrono::steady_clock::now();
+      *nanoseconds_ += static_cast<u64>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - start_)
+          .count());
+    }
+  }
+
+  ScopedTimer(const ScopedTimer& other) = delete;
+
+  ScopedTimer& operator=(const ScopedTimer& other) = delete;
+
+private:
+  u64* nanoseconds_;
+  std::chrono::steady_clock::time_point start_{};
+};
+
+}
+
+PacketHandler::PacketHandler()
+{
+  static_types_.fill(kUnknownPacketHeaderType);
+}
 
 PacketHandler::~PacketHandler() = default;
 
@@ -14,28 +58,43 @@ bool
 PacketHandler::HandlePacket(const Packet& packet) const
 {
   MICROPROFILE_SCOPEI("packet handler", "handle packet", MP_YELLOW);
-  bool could_handle = false;
-
-  const PacketHeader* header = packet.GetHeader();
-  auto it = packet_type_metas_.find(header->type);
-  if (it != packet_type_metas_.end()) {
-    could_handle = true;
-    // TODO maybe not send the header, or clear the header first???
-    it->second.callback(packet);
-  } else {
-    DLOG_WARNING("got packet of unknown type [{}], ignoring", header->type);
+
+  const PacketHeaderType type = packet.GetHeader()->type;
+  if (type == kBatchPacketHeaderType) {
+    return HandleBatch(packet);
+  }
+  if ((type & kCompressedPacketFlag) != 0) {
+    return HandleCompressed(packet);
+  }
+
+  const PacketTypeMeta* meta = FindPacketTypeMeta(type);
+  if (meta == nullptr) {
+    DLOG_WARNING("got packet of unknown type [{}], ignoring", type);
+    return false;
+  }
+
+  // TODO maybe not send the header, or clear the header first???
+  {
+    ScopedTimer timer(timing_ ? &meta->handled_nanoseconds : nullptr);
+    meta->thunk(*meta, packet);
   }
 
-  return could_handle;
+  meta->handled_count++;
+  meta->handled_bytes += packet.GetPacketSize();
+  if (meta->received_packets_metric != nullptr) {
+    meta->received_packets_metric->Add();
+    meta->received_bytes_metric->Add(packet.GetPacketSize());
+  }
+  return true;
 }
 
 bool
 PacketHandler::AddDynamicPacketType(const String& packet_type_name,
                                     PacketHandlerCallback callback)
 {
-  PacketHeaderType type_hint =
-    HashFNV1a32(packet_type_name.GetUTF8(), packet_type_name.GetSize());
-
+  // dynamic types are numbered after the static types
+  const auto type_hint =
+    static_cast<PacketHeaderType>(kPacketHeaderStaticTypesCount);
   return AddDynamicPacketTypeBase(packet_type_name, type_hint, callback);
 }
 
@@ -52,42 +111,21 @@ PacketHandler::AddDynamicPacketTypeBase(const String& packet_type_name,
                                         PacketHeaderType type_hint,
                                         PacketHandlerCallback callback)
 {
-  // check for name collision
-  for (const auto it : packet_type_metas_) {
-    if (it.second.name == packet_type_name) {
-      DLOG_ERROR("could not add dynamic packet type for [{}] since it "
-                 "already exist an entry with that name.",
-                 packet_type_name);
-      return false;
-    }
-  }
-
-  // try @tries times to come up with a unique hash for the packet type
-  int tries = 50;
-  while (tries-- > 0) {
-    // ensure no collision
-    for (;;) {
-      if (packet_type_metas_.find(type_hint) == packet_type_metas_.end()) {
-        break;
-      }
-      ++type_hint;
-    }
-
-    [[maybe_unused]] const auto [it, ok] =
-      packet_type_metas_.insert({ type_hint, { packet_type_name, callback } });
-    if (ok) {
-      // add it to our name-type map
-      dynamic_types_.insert({ packet_type_name, it->first });
-      break;
-    } else {
-      ++type_hint;
-    }
+  PacketTypeMeta meta{};
+  meta.name = packet_type_name;
+  meta.callback = std::move(callback);
+  meta.thunk = &CallbackThunk;
+
+  const auto maybe_type = InsertPacketTypeMeta(type_hint, std::move(meta));
+  if (!maybe_type) {
+    DLOG_ERROR("could not add dynamic packet type for [{}] since it "
+               "already exist an entry with that name.",
+               packet_type_name);
+    return false;
   }
 
-  AlfAssert(tries != 0,
-            "could not add packet type [{}] after 50 attempts",
-            packet_type_name);
-
+  // add it to our name-type map
+  dynamic_types_.insert({ packet_type_name, *maybe_type });
   return true;
 }
 
@@ -95,53 +133,188 @@ bool
 PacketHandler::AddStaticPacketType(const PacketHeaderStaticTypes static_type,
                                    const String& packet_type_name,
                                    PacketHandlerCallback callback)
+{
+  PacketTypeMeta meta{};
+  meta.name = packet_type_name;
+  meta.callback = std::move(callback);
+  meta.thunk = &CallbackThunk;
+  return AddStaticPacketTypeBase(static_type, std::move(meta));
+}
+
+bool
+PacketHandler::AddStaticPacketTypeBase(
+  const PacketHeaderStaticTypes static_type,
+  PacketTypeMeta meta)
 {
   AlfAssert(static_cast<std::size_t>(static_type) >= 0 &&
               static_cast<std::size_t>(static_type) <
                 kPacketHeaderStaticTypesCount,
             "unknown static_type");
-  auto size = sizeof(static_type);
-  PacketHeaderType type_hint =
-    HashFNV1a32(reinterpret_cast<const u8*>(&static_type), size);
-
-  // Check for name collision
-  for (const auto it : packet_type_metas_) {
-    if (it.second.name == packet_type_name) {
-      DLOG_ERROR("could not add static packet type for [{}] since it already "
-                 "exists an entry with that name.",
-                 packet_type_name);
-      return false;
-    }
+
+  // static types are their own index, unless that is taken
+  const String packet_type_name = meta.name;
+  const auto maybe_type = InsertPacketTypeMeta(
+    static_cast<PacketHeaderType>(static_type), std::move(meta));
+  if (!maybe_type) {
+    DLOG_ERROR("could not add static packet type for [{}] since it already "
+               "exists an entry with that name.",
+               packet_type_name);
+    return false;
   }
 
-  // try @tries times to come up with a unique hash for the packet type
-  int tries = 50;
-  while (tries-- > 0) {
-    // ensure no collision
-    for (;;) {
-      if (packet_type_metas_.find(type_hint) == packet_type_metas_.end()) {
-        break;
-      }
-      ++type_hint;
+  static_types_[static_cast<std::size_t>(static_type)] = *maybe_type;
+  return true;
+}
+
+std::optional<PacketHeaderType>
+PacketHandler::InsertPacketTypeMeta(PacketHeaderType type_hint,
+                                    PacketTypeMeta meta)
+{
+  // check for name collision
+  for (const auto& it : packet_type_metas_) {
+    if (it.second.name == meta.name) {
+      return std::nullopt;
     }
+  }
 
-    [[maybe_unused]] const auto [it, ok] =
-      packet_type_metas_.insert({ type_hint, { packet_type_name, callback } });
-    if (ok) {
-      static_types_[static_cast<std::size_t>(static_type)] = it->first;
-      break;
-    } else {
-      ++type_hint;
+  // ensure no collision
+  while (packet_type_metas_.find(type_hint) != packet_type_metas_.end()) {
+    ++type_hint;
+  }
+  if (metrics_ != nullptr) {
+    AddMetrics(meta);
+  }
+  packet_type_metas_.insert({ type_hint, std::move(meta) });
+  RebuildDispatchTable();
+  sync_packet_.reset();
+  return type_hint;
+}
+
+void
+PacketHandler::RebuildDispatchTable()
+{
+  dispatch_table_.clear();
+  for (const auto& [type, meta] : packet_type_metas_) {
+    if (type >= kMaxDispatchTableSize) {
+      continue;
     }
+    if (type >= dispatch_table_.size()) {
+      dispatch_table_.resize(type + 1, nullptr);
+    }
+    dispatch_table_[type] = &meta;
   }
+}
+
+void
+PacketHandler::CallbackThunk(const PacketTypeMeta& meta, const Packet& packet)
+{
+  meta.callback(packet);
+}
 
-  AlfAssert(tries != 0,
-            "could not add packet type [{}] after 50 attempts",
-            packet_type_name);
+bool
+PacketHandler::HandleBatch(const Packet& batch) const
+{
+  const u8* payload = batch.GetPayload();
+  const std::size_t payload_size = batch.GetPayloadSize();
+
+  // every packet in the batch fits in a packet of the batch's size
+  Packet packet{ payload_size };
+  packet.SetFromConnection(batch.GetFromConnection());
+
+  std::size_t offset = 0;
+  while (offset < payload_size) {
+    u16 size;
+    if (offset + sizeof(size) > payload_size) {
+      DLOG_WARNING("batch ends in the middle of a frame");
+      return false;
+    }
+    std::memcpy(&size, payload + offset, sizeof(size));
+    offset += sizeof(size);
+    if (size < packet.GetHeaderSize() || offset + size > payload_size) {
+      DLOG_WARNING("batch has a frame of bad size [{}]", size);
+      return false;
+    }
+    packet.SetPacket(payload + offset, size);
+    offset += size;
 
+    // batches are never nested
+    if (packet.GetHeader()->type == kBatchPacketHeaderType) {
+      DLOG_WARNING("batch inside of a batch, ignoring it");
+      continue;
+    }
+    HandlePacket(packet);
+  }
   return true;
 }
 
+bool
+PacketHandler::HandleCompressed(const Packet& packet) const
+{
+  const PacketHeaderType type =
+    packet.GetHeader()->type & ~kCompressedPacketFlag;
+  const PacketTypeMeta* meta = FindPacketTypeMeta(type);
+  if (meta == nullptr) {
+    DLOG_WARNING("got compressed packet of unknown type [{}], ignoring", type);
+    return false;
+  }
+
+  CompressedPayloadHeader header;
+  if (packet.GetPayloadSize() < sizeof(header)) {
+    DLOG_WARNING("compressed packet is too small, ignoring");
+    return false;
+  }
+  std::memcpy(&header, packet.GetPayload(), sizeof(header));
+
+  const LzDictionary* dictionary = meta->dictionary.get();
+  const u32 checksum = dictionary != nullptr ? dictionary->GetChecksum() : 0;
+  if (header.dictionary_checksum != checksum) {
+    DLOG_WARNING("packet [{}] was compressed with another dictionary, "
+                 "ignoring",
+                 meta->name);
+    return false;
+  }
+  if (header.payload_size == 0 ||
+      header.payload_size > kMaxDecompressedPayloadSize) {
+    DLOG_WARNING("compressed packet has a bad size [{}], ignoring",
+                 header.payload_size);
+    return false;
+  }
+
+  Packet decompressed{ header.payload_size };
+  BuildPacketHeader(decompressed, type);
+  decompressed.SetFromConnection(packet.GetFromConnection());
+  decompressed.SetPayloadSize(header.payload_size);
+
+  bool ok;
+  {
+    ScopedTimer timer(timing_ ? &meta->decompress_nanoseconds : nullptr);
+    ok = LzDecompress(packet.GetPayload() + sizeof(header),
+                      packet.GetPayloadSize() - sizeof(header),
+                      decompressed.GetPayload(),
+                      header.payload_size,
+                      dictionary);
+  }
+
+  meta->decompressed_count++;
+  if (!ok) {
+    DLOG_WARNING("could not decompress packet [{}], ignoring", meta->name);
+    return false;
+  }
+  return HandlePacket(decompressed);
+}
+
+const PacketTypeMeta*
+PacketHandler::FindPacketTypeMeta(const PacketHeaderType type) const
+{
+  if (type < dispatch_table_.size() && dispatch_table_[type] != nullptr) {
+    return dispatch_table_[type];
+  }
+
+  // types outside of the table are only in the map
+  const auto it = packet_type_metas_.find(type);
+  return it != packet_type_metas_.end() ? &it->second : nullptr;
+}
+
 PacketHandler::SyncResult
 PacketHandler::Sync(const std::vector<PacketTypeMetaSerializable>& correct)
 {
@@ -158,31 +331,25 @@ PacketHandler::Sync(const std::vector<PacketTypeMetaSerializable>& correct)
                  packet_type_metas_.size() - correct.size());
   }
 
-  // for each name, are the hashes correct?
+  // our type of each name
+  std::unordered_map<String, PacketHeaderType> our_types{};
+  our_types.reserve(packet_type_metas_.size());
+  for (const auto& [type, meta] : packet_type_metas_) {
+    our_types.insert({ meta.name, type });
+  }
+
+  // for each name, are the types correct?
   String missing_names{};
-  std::vector<PacketTypeMetaSerializable> missing_typees{};
-  bool found_name;
-  bool found_type;
+  std::vector<std::pair<PacketHeaderType, PacketHeaderType>> moves{};
   for (const auto& correct_meta : correct) {
-    found_name = false;
-    found_type = false;
-    for (const auto& meta : packet_type_metas_) {
-      if (correct_meta.name == meta.second.name) {
-        found_name = true;
-        if (correct_meta.type == meta.first) {
-          found_type = true;
-          break;
-        }
-      }
-    }
-    if (!found_type) {
-      missing_typees.push_back(correct_meta);
-    }
-    if (!found_name) {
+    const auto it = our_types.find(correct_meta.name);
+    if (it == our_types.end()) {
       if (missing_names.GetSize() != 0) {
         missing_names += ", ";
       }
       missing_names += correct_meta.name;
+    } else if (it->second != correct_meta.type) {
+      moves.push_back({ it->second, correct_meta.type });
     }
   }
   if (missing_names.GetSize() != 0) {
@@ -190,54 +357,47 @@ PacketHandler::Sync(const std::vector<PacketTypeMetaSerializable>& correct)
     return SyncResult::kNameMissmatch;
   }
 
-  // correct the type-name
+  // index of our static types, looked up by their type before the sync
+  // since static_types_ is updated as we go
+  std::unordered_map<PacketHeaderType, std::size_t> static_indices{};
+  for (std::size_t i = 0; i < static_types_.size(); i++) {
+    if (static_types_[i] != kUnknownPacketHeaderType) {
+      static_indices.insert({ static_types_[i], i });
+    }
+  }
+
+  // correct the type-name, all are taken out before any is put back since
+  // the types may be swapped
   std::vector<std::pair<PacketHeaderType, PacketTypeMeta>> insert_vec{};
-  for (const auto& missing_type : missing_typees) {
+  for (const auto& [from, to] : moves) {
+    auto packet_type_metas_it = packet_type_metas_.find(from);
+    AlfAssert(packet_type_metas_it != packet_type_metas_.end(),
+              "could not find packet type, but previous code guarantees it");
 
     // is it a dynamic type?
-    if (auto dyn_it = dynamic_types_.find(missing_type.name);
+    if (auto dyn_it = dynamic_types_.find(packet_type_metas_it->second.name);
         dyn_it != dynamic_types_.end()) {
-      auto packet_type_metas_it = packet_type_metas_.find(dyn_it->second);
-      AlfAssert(packet_type_metas_it != packet_type_metas_.end(),
-                "could not find"
-                " packet type, but previous code guarantees it");
-      insert_vec.push_back(
-        { missing_type.type, { packet_type_metas_it->second } });
-      packet_type_metas_.erase(packet_type_metas_it);
-
-      dyn_it->second = missing_type.type;
+      dyn_it->second = to;
     }
 
     // else must be a static type
     else {
-      std::size_t i = 0;
-      bool found = false;
-      for (; i < static_types_.size(); i++) {
-        if (packet_type_metas_[static_types_[i]].name == missing_type.name) {
-          found = true;
-          break;
-        }
-      }
-      AlfAssert(found,
+      const auto static_it = static_indices.find(from);
+      AlfAssert(static_it != static_indices.end(),
                 "could not find static packet type, but previous code"
                 " guarantees it.");
-
-      auto packet_type_metas_it = packet_type_metas_.find(static_types_[i]);
-      AlfAssert(packet_type_metas_it != packet_type_metas_.end(),
-                "could not find"
-                " packet type, but previous code guarantees it");
-
-      insert_vec.push_back(
-        { missing_type.type, { packet_type_metas_it->second } });
-      packet_type_metas_.erase(packet_type_metas_it);
-
-      static_types_[i] = missing_type.type;
+      static_types_[static_it->second] = to;
     }
+
+    insert_vec.push_back({ to, std::move(packet_type_metas_it->second) });
+    packet_type_metas_.erase(packet_type_metas_it);
   }
   if (!insert_vec.empty()) {
-    for (const auto& item : insert_vec) {
-      packet_type_metas_.insert(item);
+    for (auto& item : insert_vec) {
+      packet_type_metas_.insert(std::move(item));
     }
+    RebuildDispatchTable();
+    sync_packet_.reset();
   }
 
   return SyncResult::kSuccess;
@@ -292,26 +452,132 @@ PacketHandler::BuildPacketHeader(Packet& packet,
   packet.SetHeader(header);
 }
 
+bool
+PacketHandler::SetCompression(const PacketHeaderStaticTypes static_type,
+                              std::shared_ptr<const LzDictionary> dictionary)
+{
+  const PacketHeaderType type =
+    static_types_[static_cast<std::size_t>(static_type)];
+  auto it = packet_type_metas_.find(type);
+  if (it == packet_type_metas_.end()) {
+    return false;
+  }
+  it->second.compress = true;
+  it->second.dictionary = std::move(dictionary);
+  return true;
+}
+
+bool
+PacketHandler::SetCompression(const String& packet_type_name,
+                              std::shared_ptr<const LzDictionary> dictionary)
+{
+  const auto maybe_type = FindDynamicType(packet_type_name);
+  if (!maybe_type) {
+    return false;
+  }
+  auto it = packet_type_metas_.find(*maybe_type);
+  if (it == packet_type_metas_.end()) {
+    return false;
+  }
+  it->second.compress = true;
+  it->second.dictionary = std::move(dictionary);
+  return true;
+}
+
+const Packet&
+PacketHandler::CompressPacket(const Packet& packet, Packet& out) const
+{
+  const PacketHeaderType type = packet.GetHeader()->type;
+  if (type == kBatchPacketHeaderType || (type & kCompressedPacketFlag) != 0 ||
+      packet.GetPayloadSize() < kMinCompressedPayloadSize) {
+    return packet;
+  }
+  const PacketTypeMeta* meta = FindPacketTypeMeta(type);
+  if (meta == nullptr || !meta->compress) {
+    return packet;
+  }
+  const LzDictionary* dictionary = meta->dictionary.get();
+
+  CompressedPayloadHeader header{};
+  header.payload_size = static_cast<u32>(packet.GetPayloadSize());
+  header.dictionary_checksum =
+    dictionary != nullptr ? dictionary->GetChecksum() : 0;
+
+  {
+    ScopedTimer timer(timing_ ? &meta->compress_nanoseconds : nullptr);
+    compress_buffer_.resize(sizeof(header));
+    std::memcpy(compress_buffer_.data(), &header, sizeof(header));
+    if (dictionary != nullptr) {
+      LzCompress(packet.GetPayload(),
+                 header.payload_size,
+                 compress_buffer_,
+                 *dictionary);
+    } else {
+      LzCompress(packet.GetPayload(), header.payload_size, compress_buffer_);
+    }
+  }
+
+  const bool smaller = compress_buffer_.size() < header.payload_size;
+  meta->compressed_count++;
+  meta->uncompressed_bytes += header.payload_size;
+  meta->compressed_bytes +=
+    smaller ? compress_buffer_.size() : header.payload_size;
+  if (!smaller) {
+    return packet;
+  }
+
+  const std::size_t size = out.GetHeaderSize() + compress_buffer_.size();
+  if (out.GetPacketCapacity() < size) {
+    out.SetPacketCapacity(size);
+  }
+  BuildPacketHeader(out, type | kCompressedPacketFlag);
+  out.SetFromConnection(packet.GetFromConnection());
+  out.ClearPayload();
+  out.SetPayload(compress_buffer_.data(), compress_buffer_.size());
+  return out;
+}
+
 void
 PacketHandler::BuildPacketSync(Packet& packet)
 {
-  BuildPacketHeader(packet, PacketHeaderStaticTypes::kSync);
-  auto vec = Serialize();
-
-  auto mw = packet.GetMemoryWriter();
-  for (const auto& data : vec) {
-    mw->Write(data);
+  UpdateSyncPacket();
+  const Packet& sync_packet = *sync_packet_;
+  if (packet.GetPacketCapacity() < sync_packet.GetPacketSize()) {
+    packet.SetPacketCapacity(sync_packet.GetPacketSize());
   }
-  mw.Finalize();
+  packet = sync_packet;
 }
 
 void
+PacketHandler::BuildPacketSyncHash(Packet& packet)
+{
+  BuildPacketHeader(packet, PacketHeaderStaticTypes::kSync);
+  packet.ClearPayload();
+  packet.WritePayload(GetSyncHash());
+}
+
+bool
 PacketHandler::OnPacketSync(const Packet& packet)
 {
-  std::vector<PacketTypeMetaSerializable> vec{};
+  if (packet.GetPayloadSize() < sizeof(u64)) {
+    DLOG_WARNING("sync packet is too small, asking for the packet types");
+    return false;
+  }
   auto mr = packet.GetMemoryReader();
+  const u64 hash = Serializer<u64>::Read(mr);
+
+  // only the hash, we are in sync if our packet types are the same
+  if (mr.GetOffset() == packet.GetPayloadSize()) {
+    if (hash != GetSyncHash()) {
+      DLOG_VERBOSE("packet types differ, asking for them");
+      return false;
+    }
+    DLOG_VERBOSE("Sync ok, packet types are the same");
+    return true;
+  }
 
-  for (std::size_t pos = 0; pos < packet.GetPayloadSize();
+  std::vector<PacketTypeMetaSerializable> vec{};
+  for (std::size_t pos = mr.GetOffset(); pos < packet.GetPayloadSize();
        pos = mr.GetOffset()) {
     vec.push_back(mr.Read<PacketTypeMetaSerializable>());
   }
@@ -319,15 +585,54 @@ PacketHandler::OnPacketSync(const Packet& packet)
   const auto res = Sync(vec);
   if (res != SyncResult::kSuccess) {
     DLOG_ERROR("failed to sync due to {}", SyncResultToString(res));
+  } else {
+    DLOG_VERBOSE("Sync ok");
+  }
+  return true;
+}
+
+u64
+PacketHandler::GetSyncHash()
+{
+  UpdateSyncPacket();
+  return sync_hash_;
+}
+
+void
+PacketHandler::UpdateSyncPacket()
+{
+  if (sync_packet_) {
+    return;
+  }
+
+  // ordered by type, so that equal packet types have equal hashes
+  auto metas = Serialize();
+  std::sort(metas.begin(), metas.end(), [](const auto& a, const auto& b) {
+    return a.type < b.type;
+  });
+  std::size_t size = 0;
+  for (const auto& meta : metas) {
+    size += SerializedSize(meta);
+  }
+  std::vector<u8> table(size);
+  alflib::RawMemoryWriter mw{ table.data(), table.size() };
+  for (const auto& meta : metas) {
+    Serializer<PacketTypeMetaSerializable>::Write(mw, meta);
   }
-  DLOG_VERBOSE("Sync ok");
+  sync_hash_ = HashFNV1a64(table.data(), table.size());
+
+  Packet packet{ sizeof(sync_hash_) + table.size() };
+  BuildPacketHeader(packet, PacketHeaderStaticTypes::kSync);
+  packet.WritePayload(sync_hash_);
+  packet.SetPayload(table.data(), table.size());
+  sync_packet_ = std::move(packet);
 }
 
 std::vector<PacketTypeMetaSerializable>
 PacketHandler::Serialize() const
 {
   std::vector<PacketTypeMetaSerializable> v{};
-  for (const auto it : packet_type_metas_) {
+  for (const auto& it : packet_type_metas_) {
     v.push_back({ it.first, it.second.name });
   }
   return v;
@@ -376,4 +681,137 @@ PacketHandler::PacketTypesToString() const
   }
   return str;
 }
+
+std::string
+PacketHandler::PacketStatsToString() const
+{
+  std::vector<const PacketTypeMeta*> metas;
+  for (const auto& packet_type_meta : packet_type_metas_) {
+    if (packet_type_meta.second.handled_count > 0) {
+      metas.push_back(&packet_type_meta.second);
+    }
+  }
+  // most expensive first, or most frequent when the times are not measured
+  std::sort(metas.begin(),
+            metas.end(),
+            [this](const PacketTypeMeta* a, const PacketTypeMeta* b) {
+              return timing_ ? a->handled_nanoseconds > b->handled_nanoseconds
+                             : a->handled_count > b->handled_count;
+            });
+
+  auto str = dlog::Format("{:<20}{:>10}{:>12}{:>12}{:>12}\n",
+                          "PACKET TYPE",
+                          "COUNT",
+                          "BYTES",
+                          "TOTAL MS",
+                          "AVG US");
+  for (const PacketTypeMeta* meta : metas) {
+    str += dlog::Format(
+      "{:<20}{:>10}{:>12}{:>12.2f}{:>12.2f}\n",
+      meta->name.GetUTF8(),
+      meta->handled_count,
+      meta->handled_bytes,
+      meta->handled_nanoseconds / 1e6,
+      meta->handled_nanoseconds / 1e3 / meta->handled_count);
+  }
+
+  // bytes saved by compression, and what it cost
+  bool any_compressed = false;
+  for (const auto& packet_type_meta : packet_type_metas_) {
+    const PacketTypeMeta& meta = packet_type_meta.second;
+    if (meta.compressed_count == 0 && meta.decompressed_count == 0) {
+      continue;
+    }
+    if (!any_compressed) {
+      any_compressed = true;
+      str += dlog::Format("{:<20}{:>10}{:>12}{:>12}{:>8}{:>12}{:>12}\n",
+                          "COMPRESSED TYPE",
+                          "SENT",
+                          "RAW BYTES",
+                          "BYTES",
+                          "SAVED",
+                          "COMPR MS",
+                          "DECOMPR MS");
+    }
+    const f64 saved =
+      meta.uncompressed_bytes > 0
+        ? 100.0 * (1.0 - static_cast<f64>(meta.compressed_bytes) /
+                           static_cast<f64>(meta.uncompressed_bytes))
+        : 0.0;
+    str += dlog::Format("{:<20}{:>10}{:>12}{:>12}{:>7.1f}%{:>12.2f}{:>12.2f}\n",
+                        meta.name.GetUTF8(),
+                        meta.compressed_count,
+                        meta.uncompressed_bytes,
+                        meta.compressed_bytes,
+                        saved,
+                        meta.compress_nanoseconds / 1e6,
+                        meta.decompress_nanoseconds / 1e6);
+  }
+
+  if (!timing_) {
+    str += "times are not measured while timing is off\n";
+  }
+  return str;
+}
+
+void
+PacketHandler::ResetStats()
+{
+  for (auto& packet_type_meta : packet_type_metas_) {
+    packet_type_meta.second.handled_count = 0;
+    packet_type_meta.second.handled_bytes = 0;
+    packet_type_meta.second.handled_nanoseconds = 0;
+    packet_type_meta.second.compressed_count = 0;
+    packet_type_meta.second.uncompressed_bytes = 0;
+    packet_type_meta.second.compressed_bytes = 0;
+    packet_type_meta.second.compress_nanoseconds = 0;
+    packet_type_meta.second.decompressed_count = 0;
+    packet_type_meta.second.decompress_nanoseconds = 0;
+  }
+}
+
+void
+PacketHandler::EnableMetrics(Metrics& metrics)
+{
+  metrics_ = &metrics;
+  for (auto& packet_type_meta : packet_type_metas_) {
+    AddMetrics(packet_type_meta.second);
+  }
+}
+
+void
+PacketHandler::AddMetrics(PacketTypeMeta& meta)
+{
+  // by name, the types are not stable between runs
+  const Metrics::Labels labels{ { "type", meta.name.GetUTF8() } };
+  meta.received_packets_metric =
+    &metrics_->AddCounter("dib_packets_received_total",
+                          "Packets received and handled, by packet type.",
+                          labels);
+  meta.received_bytes_metric = &metrics_->AddCounter(
+    "dib_packet_bytes_received_total",
+    "Bytes of the packets received and handled, by packet type.",
+    labels);
+  meta.sent_packets_metric = &metrics_->AddCounter(
+    "dib_packets_sent_total", "Packets sent, by packet type.", labels);
+  meta.sent_bytes_metric = &metrics_->AddCounter(
+    "dib_packet_bytes_sent_total",
+    "Bytes of the packets sent, after compression, by packet type.",
+    labels);
+}
+
+void
+PacketHandler::RecordSent(const Packet& packet,
+                          const std::size_t size,
+                          const u64 copies) const
+{
+  if (metrics_ == nullptr) {
+    return;
+  }
+  const PacketTypeMeta* meta = FindPacketTypeMeta(packet.GetHeader()->type);
+  if (meta != nullptr && meta->sent_packets_metric != nullptr) {
+    meta->sent_packets_metric->Add(copies);
+    meta->sent_bytes_metric->Add(size * copies);
+  }
+}
 }
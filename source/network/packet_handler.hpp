@@ -1,12 +1,18 @@
 #ifndef PACKET_HANDLER_HPP_
 #define PACKET_HANDLER_HPP_
 
+#include "core/compression.hpp"
+#include "core/metrics.hpp"
+#include "core/schema.hpp"
 #include "network/packet.hpp"
 #include <functional>
 #include <string_view>
 #include <optional>
 #include <array>
+#include <memory>
+#include <type_traits>
 #include <unordered_map>
+#include <vector>
 
 namespace dib {
 
@@ -18,7 +24,8 @@ namespace dib {
  * Steps to follow when ADDING a new packet type.
  * 1. Add the enum here.
  * 2. Register a packet handler callback on the packet_handler with
- *    AddStaticPacketType. Typically done in Networks's SetupPacketHandler.
+ *    AddStaticPacketType, or AddHandler if the payload is a single message.
+ *    Typically done in Networks's SetupPacketHandler.
  *    Remember to register both server and client side.
  * 3. Make sure to send the new packet from somewhere! You may want to make
  *    a packet factory function to make it easier to send these types of
@@ -28,7 +35,9 @@ enum class PacketHeaderStaticTypes : std::size_t
 {
   /**
    * Server syncs its packet types with client, make sure they agree on
-   * (name - key) combination.
+   * (name - key) combination. The server first sends only the hash of its
+   * packet types. A client whose packet types differ answers with its own
+   * hash, and then gets the hash followed by all of the packet types.
    */
   kSync = 0,
 
@@ -87,6 +96,12 @@ enum class PacketHeaderStaticTypes : std::size_t
    */
   kTileUpdate,
 
+  /**
+   * A fragment of the join snapshot, that the server sends to a joining
+   * player, see JoinSnapshot.
+   */
+  kJoinSnapshot,
+
   // ============================================================ //
   // Must be last, used to count number of elements in the enum
   /**
@@ -98,12 +113,32 @@ enum class PacketHeaderStaticTypes : std::size_t
 constexpr std::size_t kPacketHeaderStaticTypesCount =
   static_cast<std::size_t>(PacketHeaderStaticTypes::kChat) + 1;
 
+/**
+ * Type of static packet types that has not been added.
+ */
+constexpr PacketHeaderType kUnknownPacketHeaderType = ~PacketHeaderType{ 0 };
+
 // ============================================================ //
 // Helper Types
 // ============================================================ //
 
 using PacketHandlerCallback = std::function<void(const Packet&)>;
 
+struct PacketTypeMeta;
+
+/**
+ * Entry point of a packet type, knows how to call the handler in the meta.
+ */
+using PacketThunk = void (*)(const PacketTypeMeta& meta, const Packet& packet);
+
+/**
+ * Handler that gets the payload already deserialized, see AddHandler.
+ */
+template<typename TMessage, typename TContext>
+using PacketMessageHandler = void (*)(TContext& context,
+                                      const TMessage& message,
+                                      const Packet& packet);
+
 /**
  * Describes a packet type and how to handle it.
  * PacketHeaderType is stored separately, as key in a map.
@@ -116,8 +151,42 @@ struct PacketTypeMeta
   // unique name
   String name;
 
-  // called when this packet type is received.
+  // called when this packet type is received, unless it has a typed handler.
   PacketHandlerCallback callback;
+
+  // called when this packet type is received, calls callback or handler.
+  PacketThunk thunk;
+
+  // typed handler and its context, set by AddHandler.
+  void (*handler)() = nullptr;
+  void* context = nullptr;
+
+  // cost of handling this packet type, since the last ResetStats. The time is
+  // only measured while timing is on, see PacketHandler::SetTiming.
+  mutable u64 handled_count = 0;
+  mutable u64 handled_bytes = 0;
+  mutable u64 handled_nanoseconds = 0;
+
+  // compress the payload when sending, set by SetCompression.
+  bool compress = false;
+  std::shared_ptr<const LzDictionary> dictionary{};
+
+  // what compression of this packet type saved and cost, since the last
+  // ResetStats. compressed_bytes counts the payloads as sent, also the ones
+  // that did not get smaller and were sent uncompressed.
+  mutable u64 compressed_count = 0;
+  mutable u64 uncompressed_bytes = 0;
+  mutable u64 compressed_bytes = 0;
+  mutable u64 compress_nanoseconds = 0;
+  mutable u64 decompressed_count = 0;
+  mutable u64 decompress_nanoseconds = 0;
+
+  // packets and bytes received and sent, set by EnableMetrics. Never reset,
+  // unlike the stats above.
+  Counter* received_packets_metric = nullptr;
+  Counter* received_bytes_metric = nullptr;
+  Counter* sent_packets_metric = nullptr;
+  Counter* sent_bytes_metric = nullptr;
 };
 
 /**
@@ -128,18 +197,20 @@ struct PacketTypeMetaSerializable
   PacketHeaderType type;
   String name;
 
-  bool ToBytes(alflib::RawMemoryWriter& mr) const
+  static constexpr auto GetSchema()
   {
-    mr.Write(type);
-    return mr.Write(name);
+    return MakeSchema(&PacketTypeMetaSerializable::type,
+                      &PacketTypeMetaSerializable::name);
+  }
+
+  bool ToBytes(alflib::RawMemoryWriter& mw) const
+  {
+    return Serializer<PacketTypeMetaSerializable>::Write(mw, *this);
   }
 
   static PacketTypeMetaSerializable FromBytes(alflib::RawMemoryReader& mr)
   {
-    PacketTypeMetaSerializable p{};
-    p.type = mr.Read<decltype(type)>();
-    p.name = mr.Read<decltype(name)>();
-    return p;
+    return Serializer<PacketTypeMetaSerializable>::Read(mr);
   }
 };
 
@@ -149,6 +220,12 @@ struct PacketTypeMetaSerializable
 
 /**
  * Packet handler maps a packet type with a callback function.
+ *
+ * Packet types are small dense integers. Static types use their index in
+ * PacketHeaderStaticTypes and dynamic types are numbered after them, in the
+ * order they are added. The server sends its types in the sync packet, which
+ * the client adopts, so both sides agree even if they added the dynamic types
+ * in a different order. Handling a packet indexes a flat table with the type.
  */
 class PacketHandler
 {
@@ -156,12 +233,20 @@ public:
   PacketHandler();
   ~PacketHandler();
 
+  // the dispatch table points into the map, which moves with it
+  PacketHandler(PacketHandler&& other) = default;
+  PacketHandler& operator=(PacketHandler&& other) = default;
+  PacketHandler(const PacketHandler& other) = delete;
+  PacketHandler& operator=(const PacketHandler& other) = delete;
+
   // ============================================================ //
   // Packet Consumer
   // ============================================================ //
 public:
   /**
-   * @return If the packet type was known.
+   * Handle a packet, or each packet in a batch. Compressed packets are
+   * decompressed first.
+   * @return If the packet type was known, for a batch if it was well formed.
    */
   bool HandlePacket(const Packet& packet) const;
 
@@ -182,6 +267,30 @@ public:
                            const String& packet_type_name,
                            PacketHandlerCallback callback);
 
+  /**
+   * Add a static packet type whose payload is a single TMessage. The
+   * message is read into a stack value and passed to @handler, which is a
+   * plain function pointer, together with @context. Captureless lambdas
+   * convert to the handler type.
+   *
+   * @param packet_type_name Must be unique.
+   * @return If name is not unique, the add fails and returns false
+   */
+  template<typename TMessage, typename TContext>
+  bool AddHandler(
+    const PacketHeaderStaticTypes static_type,
+    const String& packet_type_name,
+    TContext& context,
+    std::common_type_t<PacketMessageHandler<TMessage, TContext>> handler)
+  {
+    PacketTypeMeta meta{};
+    meta.name = packet_type_name;
+    meta.thunk = &MessageThunk<TMessage, TContext>;
+    meta.handler = reinterpret_cast<void (*)()>(handler);
+    meta.context = &context;
+    return AddStaticPacketTypeBase(static_type, std::move(meta));
+  }
+
   enum class SyncResult
   {
     kSuccess = 0,
@@ -214,6 +323,9 @@ public:
    *   After Sync:
    *     Our     PlayerTypes = ["chat": 12, "player update": 22]
    *     Correct PlayerTypes = ["chat": 12, "player update": 22]
+   *
+   * Packet types are matched by name through a hash map, in time linear in
+   * the number of packet types.
    */
   SyncResult Sync(const std::vector<PacketTypeMetaSerializable>& correct);
 
@@ -229,6 +341,55 @@ private:
                                 PacketHeaderType type_hint,
                                 PacketHandlerCallback callback);
 
+  bool AddStaticPacketTypeBase(const PacketHeaderStaticTypes static_type,
+                               PacketTypeMeta meta);
+
+  /**
+   * Insert the meta at the first free type, starting from @type_hint.
+   * @return The type, or nullopt if the name is not unique.
+   */
+  std::optional<PacketHeaderType> InsertPacketTypeMeta(
+    PacketHeaderType type_hint,
+    PacketTypeMeta meta);
+
+  /**
+   * Add the counters of @meta to metrics_, by its name.
+   */
+  void AddMetrics(PacketTypeMeta& meta);
+
+  /**
+   * Point the dispatch table at the packet type metas, must be called
+   * whenever the metas change.
+   */
+  void RebuildDispatchTable();
+
+  static void CallbackThunk(const PacketTypeMeta& meta, const Packet& packet);
+
+  /**
+   * Split a batch made by Outbox and handle each of its packets.
+   */
+  bool HandleBatch(const Packet& batch) const;
+
+  /**
+   * Decompress a packet made by CompressPacket and handle it.
+   */
+  bool HandleCompressed(const Packet& packet) const;
+
+  /**
+   * @return Nullptr if there is no such packet type.
+   */
+  const PacketTypeMeta* FindPacketTypeMeta(PacketHeaderType type) const;
+
+  template<typename TMessage, typename TContext>
+  static void MessageThunk(const PacketTypeMeta& meta, const Packet& packet)
+  {
+    auto mr = packet.GetMemoryReader();
+    const TMessage message = mr.Read<TMessage>();
+    const auto handler =
+      reinterpret_cast<PacketMessageHandler<TMessage, TContext>>(meta.handler);
+    handler(*static_cast<TContext*>(meta.context), message, packet);
+  }
+
   // ============================================================ //
   // Packet Producer
   // ============================================================ //
@@ -252,12 +413,57 @@ private:
   void BuildPacketHeader(Packet& packet, const PacketHeaderType type) const;
 
 public:
+  /**
+   * Compress the payload of a packet type when it is sent, see
+   * CompressPacket. Both sides must set the same dictionary for the type,
+   * packets compressed with another dictionary are dropped.
+   * @return False if the packet type has not been added.
+   */
+  bool SetCompression(const PacketHeaderStaticTypes static_type,
+                      std::shared_ptr<const LzDictionary> dictionary = nullptr);
+
+  bool SetCompression(const String& packet_type_name,
+                      std::shared_ptr<const LzDictionary> dictionary = nullptr);
+
+  /**
+   * Compress the packet, if its type should be compressed and it gets
+   * smaller. The compressed packet has kCompressedPacketFlag set in the type
+   * and its payload is a CompressedPayloadHeader followed by the compressed
+   * payload.
+   * @return @packet, or @out holding the compressed packet.
+   */
+  const Packet& CompressPacket(const Packet& packet, Packet& out) const;
+
+public:
+  /**
+   * Make a sync packet with the hash of our packet types, followed by the
+   * packet types. It is built once and kept until the packet types change.
+   */
   void BuildPacketSync(Packet& packet);
 
+  /**
+   * Make a sync packet with only the hash of our packet types.
+   */
+  void BuildPacketSyncHash(Packet& packet);
+
   /**
    * When you get a sync packet, call this and it will sync for you.
+   * @return False if the packet only had a hash, which differs from ours.
+   * Then send our hash with BuildPacketSyncHash to ask for the packet types.
+   */
+  bool OnPacketSync(const Packet& packet);
+
+  /**
+   * Hash of our packet types, equal on both sides if they agree on all the
+   * (name - key) combinations.
+   */
+  u64 GetSyncHash();
+
+private:
+  /**
+   * Build the sync packet and its hash, unless they are cached.
    */
-  void OnPacketSync(const Packet& packet);
+  void UpdateSyncPacket();
 
   // ============================================================ //
   // Misc
@@ -298,19 +504,96 @@ public:
    */
   std::string PacketTypesToString() const;
 
+  /**
+   * Return a table of how many packets of each type have been handled, and
+   * how long the handlers took, since the last ResetStats.
+   */
+  std::string PacketStatsToString() const;
+
+  void ResetStats();
+
+  /**
+   * Measure how long the handlers, compression and decompression take, for
+   * PacketStatsToString. Off by default, since it reads the clock twice for
+   * every packet.
+   */
+  void SetTiming(bool timing) { timing_ = timing; }
+
+  bool IsTiming() const { return timing_; }
+
+  /**
+   * Count the packets and bytes received and sent of each packet type in
+   * @metrics, also of the types added later. @metrics must outlive the
+   * handler.
+   */
+  void EnableMetrics(Metrics& metrics);
+
+  /**
+   * Count a packet as sent @copies times, for the metrics. @size is the size
+   * of the packet as sent, after compression.
+   */
+  void RecordSent(const Packet& packet,
+                  const std::size_t size,
+                  const u64 copies) const;
+
   // ============================================================ //
   // Member Variables
   // ============================================================ //
 
+public:
+  /**
+   * Payloads smaller than this are never compressed.
+   */
+  static constexpr std::size_t kMinCompressedPayloadSize = 32;
+
+  /**
+   * Largest payload that a compressed packet may decompress into.
+   */
+  static constexpr u32 kMaxDecompressedPayloadSize = 1024 * 1024;
+
+  struct CompressedPayloadHeader
+  {
+    u32 payload_size;
+    u32 dictionary_checksum;
+  };
+
 private:
+  /**
+   * Types above this are not put in the dispatch table, only in the map.
+   */
+  static constexpr PacketHeaderType kMaxDispatchTableSize = 1024;
+
   std::unordered_map<PacketHeaderType, PacketTypeMeta> packet_type_metas_;
 
+  /**
+   * Indexed by packet type, points into packet_type_metas_.
+   */
+  std::vector<const PacketTypeMeta*> dispatch_table_{};
+
   /**
    * The PacketHeaderStaticTypes points to an index in this array.
    */
-  std::array<PacketHeaderType, kPacketHeaderStaticTypesCount> static_types_{};
+  std::array<PacketHeaderType, kPacketHeaderStaticTypesCount> static_types_;
 
   std::unordered_map<String, PacketHeaderType> dynamic_types_{};
+
+  mutable std::vector<u8> compress_buffer_{};
+
+  /**
+   * Cached by UpdateSyncPacket, reset whenever the packet types change.
+   */
+  std::optional<Packet> sync_packet_{};
+  u64 sync_hash_ = 0;
+
+  /**
+   * Set by EnableMetrics.
+   */
+  Metrics* metrics_ = nullptr;
+
+  /**
+   * Set by SetTiming.
+   */
+  bool timing_ = false;
 };
 }
 
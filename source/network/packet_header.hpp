@@ -12,6 +12,19 @@ struct PacketHeader
   PacketHeaderType type;
 };
 
+/**
+ * Set in the type of packets with a compressed payload, see
+ * PacketHandler::SetCompression. The rest of the type is the packet type.
+ */
+constexpr PacketHeaderType kCompressedPacketFlag = PacketHeaderType{ 1 }
+                                                   << 31u;
+
+/**
+ * Reserved type of packets that hold several packets, see Outbox. Never
+ * given to a packet type.
+ */
+constexpr PacketHeaderType kBatchPacketHeaderType = kCompressedPacketFlag - 2;
+
 }
 
 #endif // PACKET_HEADER_HPP_
@@ -11,24 +11,19 @@ namespace dib {
 Server::Server(game::World* world)
   : socket_interface_(SteamNetworkingSockets())
   , world_(world)
+  , network_thread_(socket_interface_)
 {}
 
 Server::~Server()
 {
+  Flush();
+  network_thread_.Stop();
   socket_interface_->CloseListenSocket(socket_);
   for (auto connection : connections_) {
     CloseConnection(connection);
   }
 }
 
-void
-Server::Poll(bool& got_packet, Packet& packet_out)
-{
-  MICROPROFILE_SCOPEI("server", "poll", MP_YELLOW);
-  PollSocketStateChanges();
-  got_packet = PollIncomingPackets(packet_out);
-}
-
 void
 Server::StartServer(const u16 port)
 {
@@ -41,6 +36,12 @@ Server::StartServer(const u16 port)
     std::exit(3);
   }
   DLOG_VERBOSE("listening on port {}.", port);
+
+  network_thread_.Start(
+    [this](ISteamNetworkingMessage** messages, const int max_count) {
+      return socket_interface_->ReceiveMessagesOnListenSocket(
+        socket_, messages, max_count);
+    });
 }
 
 void
@@ -51,12 +52,64 @@ Server::CloseConnection(HSteamNetConnection connection)
   }
 }
 
+void
+Server::Flush()
+{
+  // nowhere to send, the outbox still does its work so that a replay costs
+  // what serving does
+  if (!network_thread_.IsRunning()) {
+    outbox_.Flush([](const u8*,
+                     const std::size_t,
+                     const SendStrategy,
+                     const HSteamNetConnection) {
+      return SendResult::kSuccess;
+    });
+    return;
+  }
+
+  outbox_.Flush([this](const u8* data,
+                       const std::size_t data_count,
+                       const SendStrategy send_strategy,
+                       const HSteamNetConnection connection) {
+    return network_thread_.Send(data, data_count, send_strategy, connection);
+  });
+}
+
+bool
+Server::StartCapture(const Path& path)
+{
+  auto capture = std::make_unique<PacketCaptureWriter>(path);
+  if (!capture->IsOpen()) {
+    return false;
+  }
+  capture_ = std::move(capture);
+  DLOG_INFO("capturing packets to [{}]", path.GetPathString());
+  return true;
+}
+
+void
+Server::StopCapture()
+{
+  if (capture_) {
+    DLOG_INFO("captured {} records", capture_->GetRecordCount());
+    capture_.reset();
+  }
+}
+
+void
+Server::AddReplayConnection(const ConnectionId connection)
+{
+  connections_.insert(connection);
+}
+
 void
 Server::PacketBroadcast(const Packet& packet, const SendStrategy send_strategy)
 {
+  const Packet& out = CompressPacket(packet);
   for (auto connection : connections_) {
-    Common::SendPacket(packet, send_strategy, connection, socket_interface_);
+    outbox_.Add(out, send_strategy, connection);
   }
+  RecordSent(packet, out, connections_.size());
 }
 
 void
@@ -64,20 +117,39 @@ Server::PacketBroadcastExclude(const Packet& packet,
                                const SendStrategy send_strategy,
                                const ConnectionId exclude_connection)
 {
+  const Packet& out = CompressPacket(packet);
+  u64 copies = 0;
   for (auto connection : connections_) {
     if (connection != exclude_connection) {
-      Common::SendPacket(packet, send_strategy, connection, socket_interface_);
+      outbox_.Add(out, send_strategy, connection);
+      copies++;
     }
   }
+  RecordSent(packet, out, copies);
 }
 
-SendResult
+void
 Server::PacketUnicast(const Packet& packet,
                       const SendStrategy send_strategy,
                       const HSteamNetConnection target_connection)
 {
-  return Common::SendPacket(
-    packet, send_strategy, target_connection, socket_interface_);
+  const Packet& out = CompressPacket(packet);
+  outbox_.Add(out, send_strategy, target_connection);
+  RecordSent(packet, out, 1);
+}
+
+const Packet&
+Server::CompressPacket(const Packet& packet)
+{
+  const auto& packet_handler = world_->GetNetwork().GetPacketHandler();
+  return packet_handler.CompressPacket(packet, compressed_packet_);
+}
+
+void
+Server::RecordSent(const Packet& packet, const Packet& out, const u64 copies)
+{
+  const auto& packet_handler = world_->GetNetwork().GetPacketHandler();
+  packet_handler.RecordSent(packet, out.GetPacketSize(), copies);
 }
 
 std::optional<SteamNetworkingQuickConnectionStatus>
@@ -102,18 +174,17 @@ Server::PollIncomingPackets(Packet& packet_out)
 {
   MICROPROFILE_SCOPEI("server", "poll incoming packets", MP_YELLOW);
 
-  ISteamNetworkingMessage* msg = nullptr;
-  const int msg_count =
-    socket_interface_->ReceiveMessagesOnListenSocket(socket_, &msg, 1);
-
-  bool got_packet = false;
-  if (msg_count > 0) {
+  while (ISteamNetworkingMessage* msg = network_thread_.Receive()) {
+    bool got_packet = false;
     bool ok =
       packet_out.SetPacket(static_cast<const u8*>(msg->m_pData), msg->m_cbSize);
     if (ok) {
       if (auto it = connections_.find(msg->m_conn); it != connections_.end()) {
         packet_out.SetFromConnection(*it);
         got_packet = true;
+        if (capture_) {
+          capture_->Record(packet_out);
+        }
       } else {
         DLOG_WARNING("received packet from unknown connection, dropping it");
         DisconnectConnection(msg->m_conn);
@@ -125,15 +196,12 @@ Server::PollIncomingPackets(Packet& packet_out)
     }
 
     msg->Release();
-
-  } else if (msg_count < 0) {
-    DLOG_WARNING("failed to check for messages, closing connection");
-    if (msg != nullptr) {
-      DisconnectConnection(msg->m_conn);
+    if (got_packet) {
+      return true;
     }
   }
 
-  return got_packet;
+  return false;
 }
 
 void
@@ -188,17 +256,14 @@ Server::OnSteamNetConnectionStatusChanged(
     case k_ESteamNetworkingConnectionState_Connected: {
       DLOG_VERBOSE("connected");
 
-      // Send a sync packet to the connection
-      Packet packet{};
+      // Send the hash of our packet types to the connection, it asks for
+      // the packet types if its own differ. The packet is only queued here,
+      // the outbox keeps it until it has been sent, and a connection that
+      // fails is closed through its status change
+      Packet packet{ sizeof(u64) };
       auto& packet_handler = world_->GetNetwork().GetPacketHandler();
-      packet_handler.BuildPacketSync(packet);
-      const auto res =
-        PacketUnicast(packet, SendStrategy::kReliable, status->m_hConn);
-      if (res != SendResult::kSuccess) {
-        DLOG_WARNING("failed to send sync packet to {}, disconnecting them.",
-                     status->m_hConn);
-        DisconnectConnection(status->m_hConn);
-      }
+      packet_handler.BuildPacketSyncHash(packet);
+      PacketUnicast(packet, SendStrategy::kReliable, status->m_hConn);
       break;
     }
 
@@ -212,6 +277,10 @@ void
 Server::DisconnectConnection(const HSteamNetConnection connection)
 {
   if (auto it = connections_.find(connection); it != connections_.end()) {
+    if (capture_) {
+      capture_->RecordDisconnect(connection);
+    }
+    outbox_.Drop(connection);
     CloseConnection(connection);
     connections_.erase(it);
 
@@ -7,10 +7,14 @@
 #include "network/side.hpp"
 #include "network/connection_id.hpp"
 #include "network/connection_state.hpp"
+#include "network/network_thread.hpp"
+#include "network/outbox.hpp"
+#include "network/packet_capture.hpp"
 #include "core/macros.hpp"
 #include <steam/isteamnetworkingutils.h>
 #include <steam/steamnetworkingsockets.h>
 #include <tsl/robin_set.h>
+#include <memory>
 #include <optional>
 
 // ========================================================================== //
@@ -35,12 +39,19 @@ public:
   virtual ~Server() final;
 
   /**
-   * Let the server update, call continuously.
+   * Run the connection status callbacks, game thread only.
    */
-  void Poll(bool& got_packet, Packet& packet_out);
+  void PollSocketStateChanges();
+
+  /**
+   * Pop the next packet received by the network thread, game thread only.
+   * Packets that can't be used are dropped.
+   * @return False if there are no more packets this tick.
+   */
+  bool PollIncomingPackets(Packet& packet_out);
 
   /**
-   * Start a server on the given port.
+   * Start a server on the given port, and the network thread that serves it.
    */
   void StartServer(const u16 port);
 
@@ -49,6 +60,29 @@ public:
    */
   void DisconnectConnection(const HSteamNetConnection connection);
 
+  /**
+   * Send everything that was queued during the tick, call once at the end of
+   * each tick. If the server was never started, as when replaying a capture,
+   * the packets are dropped instead.
+   */
+  void Flush();
+
+  /**
+   * Record the packets received from now on, and the connections closed, to
+   * a capture file at @path. See PacketCaptureWriter.
+   * @return False if the file could not be created.
+   */
+  bool StartCapture(const Path& path);
+
+  void StopCapture();
+
+  bool IsCapturing() const { return capture_ != nullptr; }
+
+  /**
+   * Add a connection that has no socket, for replaying a capture.
+   */
+  void AddReplayConnection(const ConnectionId connection);
+
   /**
    * Broadcast a packet to all active connections.
    */
@@ -62,22 +96,21 @@ public:
                               const ConnectionId exclude_connection);
 
   /**
-   * Send a packet to a connection.
+   * Send a packet to a connection. Packets are queued until the end of the
+   * tick, see Flush, so sending cannot fail here.
    */
-  SendResult PacketUnicast(const Packet& packet,
-                           const SendStrategy send_strategy,
-                           const HSteamNetConnection target_connection);
+  void PacketUnicast(const Packet& packet,
+                     const SendStrategy send_strategy,
+                     const HSteamNetConnection target_connection);
 
   NetworkState GetNetworkState() const { return network_state_; }
 
   std::optional<SteamNetworkingQuickConnectionStatus> GetConnectionStatus(
     const ConnectionId connection_id) const;
 
-private:
-  void PollSocketStateChanges();
-
-  bool PollIncomingPackets(Packet& packet_out);
+  Outbox& GetOutbox() { return outbox_; }
 
+private:
   virtual void OnSteamNetConnectionStatusChanged(
     SteamNetConnectionStatusChangedCallback_t* status) override;
 
@@ -87,12 +120,32 @@ private:
    */
   void CloseConnection(HSteamNetConnection connection);
 
+  /**
+   * Compress the packet if its packet type should be compressed.
+   * @return @packet, or compressed_packet_.
+   */
+  const Packet& CompressPacket(const Packet& packet);
+
+  /**
+   * Count @packet as sent @copies times in the metrics, with the size of
+   * @out, the packet as sent.
+   */
+  void RecordSent(const Packet& packet, const Packet& out, const u64 copies);
+
 private:
-  HSteamListenSocket socket_;
+  HSteamListenSocket socket_ = k_HSteamListenSocket_Invalid;
   ISteamNetworkingSockets* socket_interface_;
   tsl::robin_set<ConnectionId> connections_{};
   NetworkState network_state_ = NetworkState::kServer;
   game::World* world_;
+  NetworkThread network_thread_;
+  Outbox outbox_{};
+
+  /** Scratch packet for CompressPacket. */
+  Packet compressed_packet_{};
+
+  /** Set while capturing, see StartCapture. */
+  std::unique_ptr<PacketCaptureWriter> capture_{};
 };
 }
 
@@ -11,6 +11,8 @@ enum class Side : bool
   kClient = true
 };
 
+// DIB_IS_BOT builds a headless client, so code that needs a window or the
+// renderer must also be left out for it.
 #ifdef DIB_IS_SERVER
 constexpr Side kSide = Side::kServer;
 #else
@@ -0,0 +1,195 @@
+#include "main.test.hpp"
+#include "core/bit_stream.hpp"
+#include "game/gameplay/moveable.hpp"
+#include "network/packet.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace dib;
+
+namespace {
+
+std::vector<game::MoveableIncrement>
+MakeIncrements(const u32 count)
+{
+  std::vector<game::MoveableIncrement> increments(count);
+  for (u32 i = 0; i < count; i++) {
+    game::MoveableIncrement& m = increments[i];
+    m.horizontal_velocity = static_cast<f32>(i % 21) - 10.0f;
+    m.vertical_velocity = -0.37f * static_cast<f32>(i % 50);
+    m.jumping = i % 7 == 0 ? 1 : 0;
+    m.position.x = game::TileToMeter(10 + i * 3);
+    m.position.y = game::TileToMeter(200) + 0.013f * static_cast<f32>(i);
+    m.input = game::PlayerInput{};
+    if (i % 3 == 0) {
+      m.input.ActionLeft();
+    }
+    if (i % 5 == 0) {
+      m.input.ActionJump();
+    }
+  }
+  return increments;
+}
+
+}
+
+TEST_SUITE("bit_stream")
+{
+  TEST_CASE("Encoders")
+  {
+    std::vector<u8> buffer(64);
+    BitWriter bw{ buffer.data(), buffer.size() };
+    CHECK(bw.WriteBits(5, 3));
+    CHECK(bw.WriteBool(true));
+    CHECK(bw.WriteVarint(300));
+    CHECK(bw.WriteZigZag(-2));
+    CHECK(bw.WriteZigZag(-4000000000ll));
+    CHECK(bw.WriteRange(17, 10, 20));
+    CHECK(bw.WriteBits(0xDEADBEEFCAFEull, 48));
+    CHECK(bw.WriteQuantized(1.25f, -10.0f, 10.0f, 16));
+    CHECK(bw.WriteQuantized(100.0f, -10.0f, 10.0f, 8));
+    bw.Flush();
+    CHECK(bw.GetBitCount() == 3 + 1 + 16 + 8 + 40 + 4 + 48 + 16 + 8);
+
+    BitReader br{ buffer.data(), bw.GetByteCount() };
+    CHECK(br.ReadBits(3) == 5);
+    CHECK(br.ReadBool());
+    CHECK(br.ReadVarint() == 300);
+    CHECK(br.ReadZigZag() == -2);
+    CHECK(br.ReadZigZag() == -4000000000ll);
+    CHECK(br.ReadRange(10, 20) == 17);
+    CHECK(br.ReadBits(48) == 0xDEADBEEFCAFEull);
+    CHECK(std::abs(br.ReadQuantized(-10.0f, 10.0f, 16) - 1.25f) < 0.001f);
+    CHECK(br.ReadQuantized(-10.0f, 10.0f, 8) == 10.0f);
+    CHECK(!br.HasError());
+
+    // past the end
+    br.ReadBits(32);
+    CHECK(br.HasError());
+  }
+
+  TEST_CASE("Full buffer")
+  {
+    std::vector<u8> buffer(2);
+    BitWriter bw{ buffer.data(), buffer.size() };
+    CHECK(bw.WriteBits(0x3FF, 10));
+    CHECK(!bw.WriteBits(0xFF, 7));
+    CHECK(bw.WriteBits(0x3F, 6));
+    CHECK(!bw.WriteBool(true));
+    CHECK(bw.GetByteCount() == 2);
+  }
+
+  TEST_CASE("Packet")
+  {
+    Packet packet{ 16 };
+    const u8 first = 9;
+    packet.SetPayload(&first, 1);
+
+    auto bw = packet.GetBitWriter();
+    bw->WriteRange(3, 0, 7);
+    bw->WriteVarint(1000);
+    bw.Finalize();
+    CHECK(packet.GetPayloadSize() == 1 + 3);
+    CHECK(packet.GetPayload()[0] == 9);
+
+    BitReader br{ packet.GetPayload() + 1, packet.GetPayloadSize() - 1 };
+    CHECK(br.ReadRange(0, 7) == 3);
+    CHECK(br.ReadVarint() == 1000);
+    CHECK(!br.HasError());
+  }
+
+  TEST_CASE("Increments")
+  {
+    const auto increments = MakeIncrements(300);
+    std::vector<u8> buffer(increments.size() *
+                           sizeof(game::MoveableIncrement));
+    BitWriter bw{ buffer.data(), buffer.size() };
+    REQUIRE(game::WriteIncrements(bw, increments.data(), increments.size()));
+    bw.Flush();
+    CHECK(bw.GetByteCount() < buffer.size() * 6 / 10);
+
+    std::vector<game::MoveableIncrement> read(increments.size());
+    BitReader br{ buffer.data(), bw.GetByteCount() };
+    REQUIRE(game::ReadIncrements(br, read.data(), read.size()));
+    for (std::size_t i = 0; i < read.size(); i++) {
+      CHECK(std::abs(read[i].horizontal_velocity -
+                     increments[i].horizontal_velocity) < 0.01f);
+      CHECK(std::abs(read[i].vertical_velocity -
+                     increments[i].vertical_velocity) < 0.01f);
+      CHECK(std::abs(read[i].position.x - increments[i].position.x) <
+            game::kPixelInMeter / 2.0f);
+      CHECK(std::abs(read[i].position.y - increments[i].position.y) <
+            game::kPixelInMeter / 2.0f);
+      CHECK(read[i].jumping == increments[i].jumping);
+      CHECK(read[i].input == increments[i].input);
+    }
+  }
+
+  /**
+   * Run with: test --no-skip --test-case="Benchmark*"
+   */
+  TEST_CASE("Benchmark increments" * doctest::skip())
+  {
+    constexpr u32 kCount = 256;
+    constexpr u32 kRounds = 20000;
+    const auto increments = MakeIncrements(kCount);
+    Packet packet{ kCount * sizeof(game::MoveableIncrement) };
+
+    const auto Measure = [&](const char* name, const auto write) {
+      const auto start = std::chrono::steady_clock::now();
+      std::size_t bytes = 0;
+      for (u32 round = 0; round < kRounds; round++) {
+        packet.ClearPayload();
+        write();
+        bytes = packet.GetPayloadSize();
+      }
+      const auto end = std::chrono::steady_clock::now();
+      const f64 ns =
+        std::chrono::duration<f64, std::nano>(end - start).count() /
+        (static_cast<f64>(kRounds) * kCount);
+      std::printf("%-16s %6.2f bytes/increment %7.2f ns/increment\n",
+                  name,
+                  static_cast<f64>(bytes) / kCount,
+                  ns);
+    };
+
+    Measure("raw", [&]() {
+      auto mw = packet.GetMemoryWriter();
+      for (const auto& increment : increments) {
+        mw->Write(increment);
+      }
+      mw.Finalize();
+    });
+    Measure("bits", [&]() {
+      auto bw = packet.GetBitWriter();
+      for (const auto& m : increments) {
+        bw->WriteQuantized(m.horizontal_velocity,
+                           -game::kIncrementVelocityLimit,
+                           game::kIncrementVelocityLimit,
+                           game::kIncrementVelocityBits);
+        bw->WriteQuantized(m.vertical_velocity,
+                           -game::kIncrementVelocityLimit,
+                           game::kIncrementVelocityLimit,
+                           game::kIncrementVelocityBits);
+        bw->WriteQuantized(m.position.x,
+                           0.0f,
+                           game::kIncrementPositionLimit,
+                           game::kIncrementPositionBits);
+        bw->WriteQuantized(m.position.y,
+                           0.0f,
+                           game::kIncrementPositionLimit,
+                           game::kIncrementPositionBits);
+        bw->WriteBool(m.jumping != 0);
+        bw->WriteBits(m.input.GetBits(), game::PlayerInput::kBitCount);
+      }
+      bw.Finalize();
+    });
+    Measure("bits bulk", [&]() {
+      auto bw = packet.GetBitWriter();
+      game::WriteIncrements(**bw, increments.data(), kCount);
+      bw.Finalize();
+    });
+  }
+}
@@ -0,0 +1,105 @@
+#include "main.test.hpp"
+#include "core/compression.hpp"
+#include <string>
+#include <vector>
+
+using namespace dib;
+
+TEST_SUITE("compression")
+{
+  static bool RoundTrip(const std::vector<u8>& data)
+  {
+    std::vector<u8> compressed{};
+    const u64 size = LzCompress(data.data(), data.size(), compressed);
+    if (size != compressed.size() || size > LzCompressBound(data.size())) {
+      return false;
+    }
+    std::vector<u8> out(data.size());
+    return LzDecompress(
+             compressed.data(), compressed.size(), out.data(), out.size()) &&
+           out == data;
+  }
+
+  TEST_CASE("Round trip")
+  {
+    CHECK(RoundTrip({}));
+    CHECK(RoundTrip({ 1 }));
+    CHECK(RoundTrip({ 1, 2, 3, 4, 5 }));
+
+    // long runs and long literal runs, both have extra length bytes
+    CHECK(RoundTrip(std::vector<u8>(100000, 7)));
+    std::vector<u8> noise(5000);
+    u32 state = 1;
+    for (u8& byte : noise) {
+      state = state * 1664525u + 1013904223u;
+      byte = static_cast<u8>(state >> 24u);
+    }
+    CHECK(RoundTrip(noise));
+  }
+
+  TEST_CASE("Compresses repeated data")
+  {
+    std::string text{};
+    for (u32 i = 0; i < 1000; i++) {
+      text += "player data, moveable, increment; ";
+    }
+    std::vector<u8> compressed{};
+    LzCompress(
+      reinterpret_cast<const u8*>(text.data()), text.size(), compressed);
+    CHECK(compressed.size() < text.size() / 20);
+  }
+
+  TEST_CASE("Corrupt block")
+  {
+    std::vector<u8> data(1000, 3);
+    std::vector<u8> compressed{};
+    LzCompress(data.data(), data.size(), compressed);
+    std::vector<u8> out(data.size());
+
+    // wrong size
+    CHECK(!LzDecompress(
+      compressed.data(), compressed.size(), out.data(), out.size() - 1));
+
+    // truncated
+    CHECK(!LzDecompress(
+      compressed.data(), compressed.size() / 2, out.data(), out.size()));
+
+    // offset before the start of the output
+    const u8 bad[] = { 0x10, 'a', 0x05, 0x00 };
+    CHECK(!LzDecompress(bad, sizeof(bad), out.data(), out.size()));
+  }
+
+  TEST_CASE("Dictionary")
+  {
+    // samples that share most of their bytes, like serialized messages
+    std::vector<std::vector<u8>> samples{};
+    for (u32 i = 0; i < 10; i++) {
+      const std::string text = "name: player, speed: 400, jump: 600, id: ";
+      std::vector<u8> sample(text.begin(), text.end());
+      sample.push_back(static_cast<u8>(i));
+      samples.push_back(sample);
+    }
+    const LzDictionary dictionary{ LzTrainDictionary(samples, 1024) };
+    CHECK(!dictionary.IsEmpty());
+    CHECK(dictionary.GetData().size() <= 1024);
+
+    const std::vector<u8>& data = samples[3];
+    std::vector<u8> plain{};
+    LzCompress(data.data(), data.size(), plain);
+    std::vector<u8> compressed{};
+    LzCompress(data.data(), data.size(), compressed, dictionary);
+    CHECK(compressed.size() < plain.size() / 2);
+
+    std::vector<u8> out(data.size());
+    CHECK(LzDecompress(compressed.data(),
+                       compressed.size(),
+                       out.data(),
+                       out.size(),
+                       &dictionary));
+    CHECK(out == data);
+
+    // without the dictionary the matches point before the output
+    CHECK(!LzDecompress(
+      compressed.data(), compressed.size(), out.data(), out.size()));
+  }
+}
@@ -0,0 +1,155 @@
+#include "main.test.hpp"
+#include "game/world.hpp"
+
+#include <algorithm>
+#include <vector>
+
+using namespace dib;
+using namespace dib::game;
+
+namespace {
+
+/**
+ * Move the moveable to the tile and update the spatial grid, which is what
+ * UpdateMoveables does each tick.
+ */
+void
+MoveTo(World& world, const Entity entity, const u32 x, const u32 y)
+{
+  auto& registry = world.GetEntityManager().GetRegistry();
+  Moveable& moveable = registry.get<Moveable>(entity);
+  moveable.position = Position{ TileToMeter(x), TileToMeter(y) };
+  Position min, max;
+  MoveableBounds(moveable, min, max);
+  world.GetSpatialGrid().Update(entity, min, max);
+}
+
+/**
+ * Moveable with the default collideable, positioned at the tile. The position
+ * is the origin of the moveable, middle x and bottom y, but the collideable
+ * is not centred on it: its rect reaches 1.4 tiles right of and 2.5 tiles
+ * above the position, see CollideableRects. Two of these overlap when their
+ * positions are less than 1.4 tiles apart in x and 2.5 tiles apart in y.
+ */
+Entity
+SpawnMoveable(World& world, const u32 x, const u32 y)
+{
+  auto& registry = world.GetEntityManager().GetRegistry();
+  const Entity entity = registry.create();
+  registry.assign<Moveable>(entity, MoveableMakeDefault());
+  MoveTo(world, entity, x, y);
+  return entity;
+}
+
+}
+
+TEST_SUITE("contact detector")
+{
+  TEST_CASE("enter, stay and exit")
+  {
+    World world;
+    ContactDetector detector(&world);
+    u32 batches = 0;
+    detector.AddCallback([&batches](World&, const std::vector<Contact>&) {
+      batches++;
+    });
+
+    const Entity a = SpawnMoveable(world, 10, 20);
+    const Entity b = SpawnMoveable(world, 11, 20);
+    const Entity far = SpawnMoveable(world, 40, 20);
+
+    // The pair that overlaps enters, the lowest entity first
+    detector.Update();
+    REQUIRE(detector.GetContacts().size() == 1);
+    const Contact enter = detector.GetContacts()[0];
+    CHECK(enter.phase == ContactPhase::kEnter);
+    CHECK(enter.a == std::min(a, b));
+    CHECK(enter.b == std::max(a, b));
+    CHECK(detector.IsTouching(a, b));
+    CHECK(detector.IsTouching(b, a));
+    CHECK(!detector.IsTouching(a, far));
+    CHECK(batches == 1);
+
+    // Still overlapping, so it stays instead of entering again
+    detector.Update();
+    REQUIRE(detector.GetContacts().size() == 1);
+    CHECK(detector.GetContacts()[0].phase == ContactPhase::kStay);
+    CHECK(batches == 2);
+
+    // Moved apart, the pair exits once and is then forgotten
+    MoveTo(world, b, 25, 20);
+    detector.Update();
+    REQUIRE(detector.GetContacts().size() == 1);
+    const Contact exit = detector.GetContacts()[0];
+    CHECK(exit.phase == ContactPhase::kExit);
+    CHECK(exit.a == std::min(a, b));
+    CHECK(exit.b == std::max(a, b));
+    CHECK(!detector.IsTouching(a, b));
+    CHECK(batches == 3);
+
+    detector.Update();
+    CHECK(detector.GetContacts().empty());
+    CHECK(batches == 3);
+  }
+
+  TEST_CASE("each pair once")
+  {
+    World world;
+    ContactDetector detector(&world);
+
+    // Every moveable overlaps every other, in a stack that is also sorted
+    // the other way along x than it was created
+    std::vector<Entity> entities;
+    for (u32 i = 0; i < 4; i++) {
+      entities.push_back(SpawnMoveable(world, 10 - i / 2, 20 + i % 2));
+    }
+
+    detector.Update();
+    const std::vector<Contact>& contacts = detector.GetContacts();
+    CHECK(contacts.size() == 6);
+    CHECK(detector.GetPairCount() == 6);
+    for (std::size_t i = 0; i < contacts.size(); i++) {
+      CHECK(contacts[i].phase == ContactPhase::kEnter);
+      CHECK(contacts[i].a < contacts[i].b);
+      for (std::size_t j = 0; j < i; j++) {
+        const bool same = contacts[i].a == contacts[j].a &&
+                          contacts[i].b == contacts[j].b;
+        CHECK(!same);
+      }
+    }
+
+    // A destroyed moveable exits the pairs that it was in
+    world.GetEntityManager().GetRegistry().destroy(entities[0]);
+    detector.Update();
+    u32 exits = 0;
+    for (const Contact& contact : detector.GetContacts()) {
+      if (contact.phase == ContactPhase::kExit) {
+        exits++;
+        CHECK((contact.a == entities[0] || contact.b == entities[0]));
+      }
+    }
+    CHECK(exits == 3);
+    CHECK(detector.GetPairCount() == 3);
+  }
+
+  TEST_CASE("moveables outside the grid")
+  {
+    World world;
+    ContactDetector detector(&world);
+
+    // Found from the one in the grid, whichever entity is lower
+    const Entity a = SpawnMoveable(world, 10, 20);
+    const Entity b = SpawnMoveable(world, 11, 20);
+    const Entity c = SpawnMoveable(world, 10, 21);
+    world.GetSpatialGrid().Remove(a);
+    world.GetSpatialGrid().Remove(c);
+    detector.Update();
+    CHECK(detector.GetPairCount() == 2);
+    CHECK(detector.IsTouching(a, b));
+    CHECK(detector.IsTouching(b, c));
+
+    // Two moveables that are both outside the grid are never compared, even
+    // though these overlap
+    CHECK(!detector.IsTouching(a, c));
+  }
+}
@@ -0,0 +1,78 @@
+#include "main.test.hpp"
+#include "network/join_snapshot.hpp"
+#include "game/ecs/components/npc_data_component.hpp"
+#include "game/ecs/components/player_data_component.hpp"
+#include "game/gameplay/moveable.hpp"
+
+using namespace dib;
+
+TEST_SUITE("join snapshot")
+{
+  TEST_CASE("Build and apply")
+  {
+    entt::registry server_registry{};
+    std::vector<PlayerData> players{};
+    for (u32 i = 0; i < 3; i++) {
+      PlayerData player_data{};
+      player_data.uuid.GenerateUuid();
+      player_data.name = "player";
+      const auto entity = server_registry.create();
+      server_registry.assign<PlayerData>(entity, player_data);
+      server_registry.assign<game::Moveable>(entity,
+                                             game::MoveableMakeDefault());
+      players.push_back(player_data);
+    }
+    for (u32 i = 0; i < 200; i++) {
+      NpcData npc_data{};
+      npc_data.uuid.GenerateUuid();
+      npc_data.npc_id = i;
+      server_registry.assign<NpcData>(server_registry.create(), npc_data);
+    }
+
+    JoinSnapshot server_snapshot{};
+    server_snapshot.Build(server_registry);
+    CHECK(server_snapshot.GetCompressedSize() > 0);
+
+    // the joining player already has its own player
+    entt::registry client_registry{};
+    client_registry.assign<PlayerData>(client_registry.create(), players[0]);
+
+    JoinSnapshot client_snapshot{};
+    Packet packet{};
+    const u32 count = server_snapshot.GetFragmentCount();
+    for (u32 i = 0; i < count; i++) {
+      server_snapshot.WriteFragment(i, packet);
+      const auto expected = i + 1 == count
+                              ? JoinSnapshot::ReadResult::kComplete
+                              : JoinSnapshot::ReadResult::kIncomplete;
+      CHECK(client_snapshot.ReadFragment(packet) == expected);
+    }
+
+    const auto maybe_players = client_snapshot.Apply(client_registry);
+    REQUIRE(maybe_players);
+    CHECK(maybe_players->size() == 2);
+    CHECK(client_registry.size<PlayerData>() == 3);
+    CHECK(client_registry.size<game::Moveable>() == 2);
+    CHECK(client_registry.size<NpcData>() == 200);
+  }
+
+  TEST_CASE("Fragments out of order")
+  {
+    entt::registry registry{};
+    for (u32 i = 0; i < 5000; i++) {
+      NpcData npc_data{};
+      npc_data.uuid.GenerateUuid();
+      npc_data.npc_id = i;
+      registry.assign<NpcData>(registry.create(), npc_data);
+    }
+    JoinSnapshot server_snapshot{};
+    server_snapshot.Build(registry);
+    REQUIRE(server_snapshot.GetFragmentCount() > 1);
+
+    JoinSnapshot client_snapshot{};
+    Packet packet{};
+    server_snapshot.WriteFragment(1, packet);
+    CHECK(client_snapshot.ReadFragment(packet) ==
+          JoinSnapshot::ReadResult::kError);
+  }
+}
@@ -0,0 +1,133 @@
+#include "main.test.hpp"
+#include "core/lock_free_queue.hpp"
+
+#include <thread>
+#include <vector>
+
+using namespace dib;
+
+TEST_SUITE("lock free queue")
+{
+  TEST_CASE("spsc bounded")
+  {
+    SpscQueue<u32> queue(3);
+    CHECK(queue.GetCapacity() == 4);
+    for (u32 i = 0; i < 4; i++) {
+      CHECK(queue.TryPush(i));
+    }
+    CHECK(!queue.TryPush(4u));
+    CHECK(queue.GetSize() == 4);
+
+    u32 value = 0;
+    for (u32 i = 0; i < 4; i++) {
+      REQUIRE(queue.TryPop(value));
+      CHECK(value == i);
+    }
+    CHECK(!queue.TryPop(value));
+    CHECK(queue.IsEmpty());
+  }
+
+  TEST_CASE("spsc threaded")
+  {
+    constexpr u32 kCount = 100000;
+    SpscQueue<u32> queue(64);
+    std::thread producer([&]() {
+      for (u32 i = 0; i < kCount; i++) {
+        while (!queue.TryPush(i)) {
+          std::this_thread::yield();
+        }
+      }
+    });
+
+    u32 expected = 0;
+    u32 value = 0;
+    while (expected < kCount) {
+      if (queue.TryPop(value)) {
+        REQUIRE(value == expected);
+        expected++;
+      }
+    }
+    producer.join();
+    CHECK(queue.IsEmpty());
+  }
+
+  TEST_CASE("mpsc bounded")
+  {
+    MpscQueue<std::vector<u8>> queue(2);
+    CHECK(queue.TryPush(std::vector<u8>{ 1, 2 }));
+    CHECK(queue.TryPush(std::vector<u8>{ 3 }));
+    CHECK(!queue.TryPush(std::vector<u8>{ 4 }));
+
+    std::vector<u8> value;
+    REQUIRE(queue.TryPop(value));
+    CHECK(value.size() == 2);
+    REQUIRE(queue.TryPop(value));
+    CHECK(value[0] == 3);
+    CHECK(!queue.TryPop(value));
+
+    // Slots are reused after wrapping around
+    CHECK(queue.TryPush(std::vector<u8>{ 5 }));
+    REQUIRE(queue.TryPop(value));
+    CHECK(value[0] == 5);
+  }
+
+  TEST_CASE("mpsc in place")
+  {
+    MpscQueue<std::vector<u8>> queue(1);
+    CHECK(queue.TryPushWith([](std::vector<u8>& value) {
+      value.assign(64, 7);
+    }));
+    CHECK(!queue.TryPushWith([](std::vector<u8>&) { FAIL("queue is full"); }));
+
+    // What the consumer leaves in the slot is what the next producer gets
+    const u8* buffer = nullptr;
+    REQUIRE(queue.TryPopWith([&buffer](std::vector<u8>& value) {
+      CHECK(value.size() == 64);
+      buffer = value.data();
+      value.clear();
+    }));
+    CHECK(queue.TryPushWith([buffer](std::vector<u8>& value) {
+      CHECK(value.empty());
+      CHECK(value.capacity() >= 64);
+      value.assign(32, 8);
+      CHECK(value.data() == buffer);
+    }));
+    std::vector<u8> value;
+    REQUIRE(queue.TryPop(value));
+    CHECK(value.size() == 32);
+  }
+
+  TEST_CASE("mpsc threaded")
+  {
+    constexpr u32 kProducers = 4;
+    constexpr u32 kCount = 25000;
+    MpscQueue<u32> queue(128);
+    std::vector<std::thread> producers;
+    for (u32 p = 0; p < kProducers; p++) {
+      producers.emplace_back([&queue, p]() {
+        for (u32 i = 0; i < kCount; i++) {
+          while (!queue.TryPush(p * kCount + i)) {
+            std::this_thread::yield();
+          }
+        }
+      });
+    }
+
+    // Items of each producer arrive in the order they were pushed
+    std::vector<u32> next(kProducers, 0);
+    u32 popped = 0;
+    u32 value = 0;
+    while (popped < kProducers * kCount) {
+      if (queue.TryPop(value)) {
+        const u32 p = value / kCount;
+        REQUIRE(value % kCount == next[p]);
+        next[p]++;
+        popped++;
+      }
+    }
+    for (std::thread& producer : producers) {
+      producer.join();
+    }
+    CHECK(!queue.TryPop(value));
+  }
+}
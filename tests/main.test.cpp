@@ -8,6 +8,7 @@ int main(int argc, char** argv) {
   DLOG_SET_LEVEL(dlog::Level::kError);
 
   doctest::Context context;
+  context.applyCommandLine(argc, argv);
   const int res = context.run();
 
   // if(context.shouldExit()) {
@@ -0,0 +1,135 @@
+#include "main.test.hpp"
+#include "core/metrics.hpp"
+#include "core/metrics_exporter.hpp"
+#include <string>
+#include <thread>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+using namespace dib;
+
+TEST_SUITE("metrics")
+{
+  TEST_CASE("text format")
+  {
+    Metrics metrics;
+    Counter& chat =
+      metrics.AddCounter("packets_total", "Packets.", { { "type", "chat" } });
+    metrics.AddGauge("players", "Players.").Set(3);
+    Counter& sync =
+      metrics.AddCounter("packets_total", "Packets.", { { "type", "a\"b" } });
+    Histogram& tick =
+      metrics.AddHistogram("tick_seconds", "Ticks.", { 0.01, 0.1 });
+
+    // the same name and labels is the same metric
+    CHECK(&metrics.AddCounter(
+            "packets_total", "Packets.", { { "type", "chat" } }) == &chat);
+    CHECK(metrics.GetMetricCount() == 4);
+
+    chat.Add();
+    chat.Add(2);
+    sync.Add();
+    tick.Observe(0.005);
+    tick.Observe(0.05);
+    tick.Observe(0.05);
+    tick.Observe(1.0);
+    CHECK(chat.Get() == 3);
+    CHECK(tick.GetCount() == 4);
+    CHECK(tick.GetSum() == doctest::Approx(1.105));
+
+    bool collected = false;
+    metrics.AddCollector([&]() { collected = true; });
+
+    const std::string expected = "# HELP packets_total Packets.\n"
+                                 "# TYPE packets_total counter\n"
+                                 "packets_total{type=\"chat\"} 3\n"
+                                 "packets_total{type=\"a\\\"b\"} 1\n"
+                                 "# HELP players Players.\n"
+                                 "# TYPE players gauge\n"
+                                 "players 3\n"
+                                 "# HELP tick_seconds Ticks.\n"
+                                 "# TYPE tick_seconds histogram\n"
+                                 "tick_seconds_bucket{le=\"0.01\"} 1\n"
+                                 "tick_seconds_bucket{le=\"0.1\"} 3\n"
+                                 "tick_seconds_bucket{le=\"+Inf\"} 4\n"
+                                 "tick_seconds_sum 1.105\n"
+                                 "tick_seconds_count 4\n";
+    CHECK(metrics.ToText() == expected);
+    CHECK(collected);
+  }
+
+  TEST_CASE("concurrent counting")
+  {
+    Metrics metrics;
+    Counter& counter = metrics.AddCounter("count_total", "Count.");
+    Histogram& histogram = metrics.AddHistogram(
+      "values", "Values.", Histogram::ExponentialBounds(1.0, 2.0, 4));
+    const std::vector<f64> bounds{ 1.0, 2.0, 4.0, 8.0 };
+    CHECK(histogram.GetBounds() == bounds);
+
+    std::vector<std::thread> threads;
+    for (u32 t = 0; t < 4; t++) {
+      threads.emplace_back([&]() {
+        for (u32 i = 0; i < 10000; i++) {
+          counter.Add();
+          histogram.Observe(f64(i % 10));
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    CHECK(counter.Get() == 40000);
+    CHECK(histogram.GetCount() == 40000);
+    CHECK(histogram.GetSum() == doctest::Approx(4 * 1000 * 45));
+  }
+
+#if !defined(_WIN32)
+  TEST_CASE("exporter")
+  {
+    Metrics metrics;
+    metrics.AddCounter("requests_total", "Requests.").Add(7);
+
+    MetricsExporter exporter;
+    REQUIRE(exporter.Start(metrics, 0));
+    CHECK(exporter.GetPort() != 0);
+
+    const auto Get = [&](const std::string& request) {
+      const int fd = socket(AF_INET, SOCK_STREAM, 0);
+      sockaddr_in address{};
+      address.sin_family = AF_INET;
+      address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+      address.sin_port = htons(exporter.GetPort());
+      std::string response;
+      if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) ==
+          0) {
+        send(fd, request.data(), request.size(), 0);
+        char buffer[256];
+        ssize_t n;
+        while ((n = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+          response.append(buffer, static_cast<std::size_t>(n));
+        }
+      }
+      close(fd);
+      return response;
+    };
+
+    const std::string ok = Get("GET /metrics HTTP/1.1\r\nHost: x\r\n\r\n");
+    CHECK(ok.rfind("HTTP/1.0 200 OK\r\n", 0) == 0);
+    CHECK(ok.find("\r\n\r\n# HELP requests_total") != std::string::npos);
+    CHECK(ok.find("requests_total 7\n") != std::string::npos);
+
+    const std::string missing = Get("GET /other HTTP/1.1\r\n\r\n");
+    CHECK(missing.rfind("HTTP/1.0 404", 0) == 0);
+
+    exporter.Stop();
+    CHECK(!exporter.IsRunning());
+  }
+#endif
+}
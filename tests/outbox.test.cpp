@@ -0,0 +1,179 @@
+#include "main.test.hpp"
+#include "network/outbox.hpp"
+#include "network/packet_handler.hpp"
+#include <cstring>
+#include <vector>
+
+using namespace dib;
+
+TEST_SUITE("outbox")
+{
+  /**
+   * Handle everything that a flush of the outbox sends.
+   */
+  static u32 FlushInto(Outbox& outbox, PacketHandler& packet_handler)
+  {
+    u32 datagram_count = 0;
+    outbox.Flush([&](const u8* data,
+                     const std::size_t data_count,
+                     const SendStrategy,
+                     const HSteamNetConnection) {
+      Packet packet{ data, data_count };
+      CHECK(packet_handler.HandlePacket(packet));
+      datagram_count++;
+      return SendResult::kSuccess;
+    });
+    return datagram_count;
+  }
+
+  TEST_CASE("Order and batching")
+  {
+    PacketHandler packet_handler{};
+    std::vector<u32> received{};
+    packet_handler.AddDynamicPacketType(
+      "value", [&received](const Packet& packet) {
+        u32 value;
+        std::memcpy(&value, packet.GetPayload(), sizeof(value));
+        received.push_back(value);
+      });
+
+    Outbox outbox{};
+    for (u32 i = 0; i < 100; i++) {
+      Packet packet{ sizeof(u32) };
+      packet.SetPayload(reinterpret_cast<const u8*>(&i), sizeof(i));
+      packet_handler.BuildPacketHeader(packet, "value");
+      outbox.Add(packet, SendStrategy::kReliable, 1);
+    }
+
+    const u32 datagram_count = FlushInto(outbox, packet_handler);
+    CHECK(datagram_count == 1);
+    CHECK(outbox.GetPacketCount() == 100);
+    CHECK(outbox.GetDatagramCount() == 1);
+    REQUIRE(received.size() == 100);
+    for (u32 i = 0; i < 100; i++) {
+      CHECK(received[i] == i);
+    }
+
+    // nothing is left after a flush
+    CHECK(FlushInto(outbox, packet_handler) == 0);
+  }
+
+  TEST_CASE("Single and oversized packets")
+  {
+    PacketHandler packet_handler{};
+    std::vector<std::size_t> received{};
+    packet_handler.AddDynamicPacketType(
+      "blob", [&received](const Packet& packet) {
+        received.push_back(packet.GetPayloadSize());
+      });
+
+    Outbox outbox{};
+    Packet small{ 8 };
+    std::vector<u8> small_data(8, 1);
+    small.SetPayload(small_data.data(), small_data.size());
+    packet_handler.BuildPacketHeader(small, "blob");
+
+    // a batch of one is sent as the packet itself
+    outbox.Add(small, SendStrategy::kUnreliable, 1);
+    std::size_t sent_size = 0;
+    outbox.Flush([&](const u8*,
+                     const std::size_t data_count,
+                     const SendStrategy,
+                     const HSteamNetConnection) {
+      sent_size = data_count;
+      return SendResult::kSuccess;
+    });
+    CHECK(sent_size == small.GetPacketSize());
+
+    // an oversized packet is sent alone, between the batches around it
+    Packet large{ 4000 };
+    std::vector<u8> large_data(4000, 2);
+    large.SetPayload(large_data.data(), large_data.size());
+    packet_handler.BuildPacketHeader(large, "blob");
+
+    outbox.Add(small, SendStrategy::kReliable, 1);
+    outbox.Add(small, SendStrategy::kReliable, 1);
+    outbox.Add(large, SendStrategy::kReliable, 1);
+    outbox.Add(small, SendStrategy::kReliable, 1);
+    CHECK(FlushInto(outbox, packet_handler) == 3);
+    REQUIRE(received.size() == 4);
+    CHECK(received[0] == 8);
+    CHECK(received[1] == 8);
+    CHECK(received[2] == 4000);
+    CHECK(received[3] == 8);
+  }
+
+  TEST_CASE("Retry")
+  {
+    PacketHandler packet_handler{};
+    std::vector<u32> received{};
+    packet_handler.AddDynamicPacketType(
+      "value", [&received](const Packet& packet) {
+        u32 value;
+        std::memcpy(&value, packet.GetPayload(), sizeof(value));
+        received.push_back(value);
+      });
+
+    // about ten packets fit in a batch
+    Outbox outbox{};
+    const auto add = [&](const u32 value, const SendStrategy send_strategy) {
+      std::vector<u8> payload(100, 0);
+      std::memcpy(payload.data(), &value, sizeof(value));
+      Packet packet{ payload.size() };
+      packet.SetPayload(payload.data(), payload.size());
+      packet_handler.BuildPacketHeader(packet, "value");
+      outbox.Add(packet, send_strategy, 1);
+    };
+    for (u32 i = 0; i < 50; i++) {
+      add(i, SendStrategy::kReliable);
+      add(1000 + i, SendStrategy::kUnreliable);
+    }
+
+    // the sink is full after two datagrams
+    u32 accepted = 0;
+    const SendResult result = outbox.Flush([&](const u8* data,
+                                               const std::size_t data_count,
+                                               const SendStrategy,
+                                               const HSteamNetConnection) {
+      if (accepted == 2) {
+        return SendResult::kRetry;
+      }
+      accepted++;
+      Packet packet{ data, data_count };
+      CHECK(packet_handler.HandlePacket(packet));
+      return SendResult::kSuccess;
+    });
+    CHECK(result == SendResult::kRetry);
+    CHECK(outbox.GetDatagramCount() == 2);
+    CHECK(received.size() > 0);
+    CHECK(received.size() < 50);
+
+    // the reliable packets that were not sent go first on the next flush,
+    // nothing is repeated and the unreliable ones are dropped
+    add(50, SendStrategy::kReliable);
+    CHECK(FlushInto(outbox, packet_handler) > 0);
+    REQUIRE(received.size() == 51);
+    for (u32 i = 0; i < 51; i++) {
+      CHECK(received[i] == i);
+    }
+  }
+
+  TEST_CASE("Drop")
+  {
+    PacketHandler packet_handler{};
+    u32 handled = 0;
+    packet_handler.AddDynamicPacketType(
+      "empty", [&handled](const Packet&) { handled++; });
+
+    Outbox outbox{};
+    Packet packet{ 0 };
+    packet_handler.BuildPacketHeader(packet, "empty");
+    outbox.Add(packet, SendStrategy::kReliable, 1);
+    outbox.Add(packet, SendStrategy::kUnreliable, 1);
+    outbox.Add(packet, SendStrategy::kReliable, 2);
+    outbox.Drop(1);
+
+    CHECK(FlushInto(outbox, packet_handler) == 1);
+    CHECK(handled == 1);
+  }
+}
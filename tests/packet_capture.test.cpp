@@ -0,0 +1,67 @@
+#include "main.test.hpp"
+#include "network/packet_capture.hpp"
+#include <cstdio>
+#include <vector>
+
+using namespace dib;
+
+TEST_SUITE("packet_capture")
+{
+  TEST_CASE("Round trip")
+  {
+    const char8* file_name = "packet_capture.test.bin";
+    std::vector<u8> big(3000);
+    for (std::size_t i = 0; i < big.size(); i++) {
+      big[i] = static_cast<u8>(i * 7);
+    }
+
+    {
+      PacketCaptureWriter writer{ Path{ file_name } };
+      REQUIRE(writer.IsOpen());
+
+      Packet small{ 4 };
+      const u8 payload[] = { 1, 2, 3, 4 };
+      small.SetPayload(payload, sizeof(payload));
+      small.SetFromConnection(7);
+      writer.Record(small, 100);
+
+      Packet large{ big.size() };
+      large.SetPayload(big.data(), big.size());
+      large.SetFromConnection(300000);
+      writer.Record(large, 16700);
+
+      writer.RecordDisconnect(7, 20000);
+      CHECK(writer.GetRecordCount() == 3);
+    }
+
+    PacketCaptureReader reader{ Path{ file_name } };
+    REQUIRE(reader.IsValid());
+
+    // smaller than the large packet, it grows
+    Packet packet{ 16 };
+    CaptureRecord record{};
+    REQUIRE(reader.Next(record, packet));
+    CHECK(record.time == 100);
+    CHECK(record.connection == 7);
+    CHECK(!record.disconnect);
+    CHECK(packet.GetFromConnection() == 7);
+    REQUIRE(packet.GetPayloadSize() == 4);
+    CHECK(packet.GetPayload()[3] == 4);
+
+    REQUIRE(reader.Next(record, packet));
+    CHECK(record.time == 16700);
+    CHECK(record.connection == 300000);
+    REQUIRE(packet.GetPayloadSize() == big.size());
+    CHECK(std::vector<u8>(packet.GetPayload(),
+                          packet.GetPayload() + packet.GetPayloadSize()) ==
+          big);
+
+    REQUIRE(reader.Next(record, packet));
+    CHECK(record.time == 20000);
+    CHECK(record.connection == 7);
+    CHECK(record.disconnect);
+
+    CHECK(!reader.Next(record, packet));
+    std::remove(file_name);
+  }
+}
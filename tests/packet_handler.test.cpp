@@ -1,6 +1,10 @@
 #include "main.test.hpp"
 #include "network/packet_handler.hpp"
 #include <dlog.hpp>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
 
 using namespace dib;
 
@@ -156,4 +160,207 @@ TEST_SUITE("packet_handler")
     CHECK(did_handle);
     CHECK(value == 10 * 0 + 2 * v);
   }
+
+  TEST_CASE("Sync packet")
+  {
+    const auto noop = [](const Packet&) {};
+    PacketHandler server{};
+    PacketHandler client{};
+    CHECK(server.AddStaticPacketType(
+      PacketHeaderStaticTypes::kSync, "sync", noop));
+    CHECK(client.AddStaticPacketType(
+      PacketHeaderStaticTypes::kSync, "sync", noop));
+    CHECK(server.AddDynamicPacketType("a", noop));
+    CHECK(server.AddDynamicPacketType("b", noop));
+    CHECK(client.AddDynamicPacketType("a", noop));
+    CHECK(client.AddDynamicPacketType("b", noop));
+
+    // same packet types, the hash is enough
+    Packet hash_packet{ sizeof(u64) };
+    server.BuildPacketSyncHash(hash_packet);
+    CHECK(hash_packet.GetPayloadSize() == sizeof(u64));
+    CHECK(client.OnPacketSync(hash_packet));
+
+    // adding a packet type changes the hash
+    const u64 hash = server.GetSyncHash();
+    CHECK(server.AddDynamicPacketType("c", noop));
+    CHECK(server.GetSyncHash() != hash);
+
+    // added in another order, the client needs the packet types
+    PacketHandler other_client{};
+    CHECK(other_client.AddStaticPacketType(
+      PacketHeaderStaticTypes::kSync, "sync", noop));
+    CHECK(other_client.AddDynamicPacketType("c", noop));
+    CHECK(other_client.AddDynamicPacketType("b", noop));
+    CHECK(other_client.AddDynamicPacketType("a", noop));
+    server.BuildPacketSyncHash(hash_packet);
+    CHECK(!other_client.OnPacketSync(hash_packet));
+
+    Packet sync_packet{ 1 };
+    server.BuildPacketSync(sync_packet);
+    CHECK(sync_packet.GetPayloadSize() > sizeof(u64));
+    CHECK(other_client.OnPacketSync(sync_packet));
+    CHECK(other_client.GetSyncHash() == server.GetSyncHash());
+    for (const char* name : { "a", "b", "c" }) {
+      CHECK(other_client.FindDynamicType(name) == server.FindDynamicType(name));
+    }
+  }
+
+  TEST_CASE("Dense types")
+  {
+    PacketHandler packet_handler{};
+    const auto noop = [](const Packet&) {};
+
+    bool ok = packet_handler.AddStaticPacketType(
+      PacketHeaderStaticTypes::kChat, "chat", noop);
+    CHECK(ok);
+    ok = packet_handler.AddDynamicPacketType("a", noop);
+    CHECK(ok);
+    ok = packet_handler.AddDynamicPacketType("b", noop);
+    CHECK(ok);
+
+    Packet packet{ 1 };
+    packet_handler.BuildPacketHeader(packet, PacketHeaderStaticTypes::kChat);
+    CHECK(packet.GetHeader()->type ==
+          static_cast<PacketHeaderType>(PacketHeaderStaticTypes::kChat));
+    packet_handler.BuildPacketHeader(packet, "a");
+    CHECK(packet.GetHeader()->type == kPacketHeaderStaticTypesCount);
+    packet_handler.BuildPacketHeader(packet, "b");
+    CHECK(packet.GetHeader()->type == kPacketHeaderStaticTypesCount + 1);
+  }
+
+  TEST_CASE("Typed handler")
+  {
+    PacketHandler packet_handler{};
+    u32 value = 10;
+
+    bool ok = packet_handler.AddHandler<u32>(
+      PacketHeaderStaticTypes::kChat,
+      "chat",
+      value,
+      [](u32& context, const u32& message, const Packet&) {
+        context += message;
+      });
+    CHECK(ok);
+
+    ok = packet_handler.AddHandler<u32>(
+      PacketHeaderStaticTypes::kSync,
+      "chat",
+      value,
+      [](u32& context, const u32&, const Packet&) { context = 0; });
+    CHECK(!ok);
+
+    Packet packet{};
+    packet_handler.BuildPacketHeader(packet, PacketHeaderStaticTypes::kChat);
+    auto mw = packet.GetMemoryWriter();
+    mw->Write(u32{ 32 });
+    mw.Finalize();
+
+    const bool did_handle = packet_handler.HandlePacket(packet);
+    CHECK(did_handle);
+    CHECK(value == 42);
+  }
+
+  TEST_CASE("Handler stats")
+  {
+    PacketHandler packet_handler{};
+    u32 calls = 0;
+    bool ok = packet_handler.AddStaticPacketType(
+      PacketHeaderStaticTypes::kChat, "chat", [&](const Packet&) { calls++; });
+    CHECK(ok);
+
+    Packet packet{};
+    packet_handler.BuildPacketHeader(packet, PacketHeaderStaticTypes::kChat);
+    packet_handler.HandlePacket(packet);
+    packet_handler.HandlePacket(packet);
+    CHECK(calls == 2);
+
+    const PacketTypeMeta& meta =
+      packet_handler[static_cast<PacketHeaderType>(
+        PacketHeaderStaticTypes::kChat)];
+    CHECK(meta.handled_count == 2);
+    CHECK(meta.handled_bytes == 2 * packet.GetPacketSize());
+    CHECK(meta.handled_nanoseconds == 0);
+
+    packet_handler.ResetStats();
+    CHECK(meta.handled_count == 0);
+    CHECK(meta.handled_bytes == 0);
+  }
+
+  TEST_CASE("Handler timing")
+  {
+    PacketHandler packet_handler{};
+    bool ok = packet_handler.AddStaticPacketType(
+      PacketHeaderStaticTypes::kChat, "chat", [](const Packet&) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      });
+    CHECK(ok);
+    const PacketTypeMeta& meta =
+      packet_handler[static_cast<PacketHeaderType>(
+        PacketHeaderStaticTypes::kChat)];
+
+    // the clock is only read while timing is on
+    Packet packet{};
+    packet_handler.BuildPacketHeader(packet, PacketHeaderStaticTypes::kChat);
+    CHECK(!packet_handler.IsTiming());
+    packet_handler.HandlePacket(packet);
+    CHECK(meta.handled_nanoseconds == 0);
+
+    packet_handler.SetTiming(true);
+    packet_handler.HandlePacket(packet);
+    CHECK(meta.handled_count == 2);
+    CHECK(meta.handled_nanoseconds >= 1000000);
+  }
+
+  TEST_CASE("Compression")
+  {
+    std::vector<u8> received{};
+    const auto OnChat = [&received](const Packet& packet) {
+      received.assign(packet.GetPayload(),
+                      packet.GetPayload() + packet.GetPayloadSize());
+    };
+    const auto dictionary = std::make_shared<const LzDictionary>(
+      std::vector<u8>{ 'h', 'e', 'l', 'l', 'o', ' ', 'w', 'o', 'r', 'l', 'd' });
+
+    PacketHandler sender{};
+    PacketHandler receiver{};
+    CHECK(sender.AddStaticPacketType(
+      PacketHeaderStaticTypes::kChat, "chat", OnChat));
+    CHECK(receiver.AddStaticPacketType(
+      PacketHeaderStaticTypes::kChat, "chat", OnChat));
+    CHECK(sender.SetCompression(PacketHeaderStaticTypes::kChat, dictionary));
+    CHECK(receiver.SetCompression(PacketHeaderStaticTypes::kChat, dictionary));
+
+    std::vector<u8> payload{};
+    for (u32 i = 0; i < 40; i++) {
+      const char* text = "hello world ";
+      payload.insert(payload.end(), text, text + std::strlen(text));
+    }
+    Packet packet{ payload.size() };
+    sender.BuildPacketHeader(packet, PacketHeaderStaticTypes::kChat);
+    packet.SetPayload(payload.data(), payload.size());
+
+    Packet compressed{};
+    const Packet& sent = sender.CompressPacket(packet, compressed);
+    CHECK(&sent == &compressed);
+    CHECK((sent.GetHeader()->type & kCompressedPacketFlag) != 0);
+    CHECK(sent.GetPayloadSize() < payload.size());
+
+    CHECK(receiver.HandlePacket(sent));
+    CHECK(received == payload);
+
+    // small payloads are sent as they are
+    Packet small{ 4 };
+    sender.BuildPacketHeader(small, PacketHeaderStaticTypes::kChat);
+    small.SetPayload(payload.data(), 4);
+    CHECK(&sender.CompressPacket(small, compressed) == &small);
+
+    // a receiver with another dictionary drops the packet
+    received.clear();
+    CHECK(receiver.SetCompression(PacketHeaderStaticTypes::kChat));
+    Packet compressed_again{};
+    const Packet& sent_again = sender.CompressPacket(packet, compressed_again);
+    CHECK(!receiver.HandlePacket(sent_again));
+    CHECK(received.empty());
+  }
 }
@@ -0,0 +1,64 @@
+#include "main.test.hpp"
+#include "game/palette_array.hpp"
+
+#include <vector>
+
+using namespace dib;
+using namespace dib::game;
+
+TEST_SUITE("palette array")
+{
+  TEST_CASE("single value")
+  {
+    PaletteArray array(1024, 7);
+    CHECK(array.GetBitsPerEntry() == 0);
+    CHECK(array.Get(0) == 7);
+    CHECK(array.Get(1023) == 7);
+
+    array.Set(10, 7);
+    CHECK(array.GetBitsPerEntry() == 0);
+  }
+
+  TEST_CASE("grow and compact")
+  {
+    PaletteArray array(1024, 0);
+    for (u32 i = 0; i < 1024; i++) {
+      array.Set(i, u16(i % 5));
+    }
+    CHECK(array.GetBitsPerEntry() == 4);
+    for (u32 i = 0; i < 1024; i++) {
+      CHECK(array.Get(i) == i % 5);
+    }
+
+    // Overwriting values with a new one compacts instead of growing
+    for (u32 i = 0; i < 1024; i++) {
+      array.Set(i, 3);
+    }
+    for (u16 value = 100; value < 120; value++) {
+      array.Set(value, value);
+    }
+    CHECK(array.GetBitsPerEntry() == 8);
+    CHECK(array.GetPaletteSize() <= 22);
+    CHECK(array.Get(105) == 105);
+    CHECK(array.Get(0) == 3);
+  }
+
+  TEST_CASE("assign")
+  {
+    std::vector<u16> values(1024);
+    for (u32 i = 0; i < values.size(); i++) {
+      values[i] = u16(i * 31);
+    }
+    PaletteArray array(1024);
+    array.Assign(values.data());
+    CHECK(array.GetBitsPerEntry() == 16);
+    for (u32 i = 0; i < values.size(); i++) {
+      CHECK(array.Get(i) == values[i]);
+    }
+
+    values.assign(1024, 9);
+    array.Assign(values.data());
+    CHECK(array.GetBitsPerEntry() == 0);
+    CHECK(array.Get(512) == 9);
+  }
+}
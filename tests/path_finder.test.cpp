@@ -0,0 +1,113 @@
+#include "main.test.hpp"
+#include "terrain.test.hpp"
+#include "game/world.hpp"
+
+#include <chrono>
+#include <thread>
+
+using namespace dib;
+using namespace dib::game;
+
+namespace {
+
+/**
+ * Flat floor with a wall that is too high to jump over at x = 50.
+ */
+void
+FillWalledTerrain(Terrain& terrain, const TestTiles& tiles)
+{
+  FillTerrain(terrain, 96, 48, [&](const u32 x, const u32 y) {
+    return y < 4 || x == 50 ? tiles.stone : tiles.air;
+  });
+}
+
+/**
+ * Update the path finder until every query is answered, the graphs are built
+ * and the searches are run on the workers.
+ */
+void
+Settle(PathFinder& finder)
+{
+  do {
+    finder.Update();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  } while (finder.GetPendingCount() > 0);
+}
+
+}
+
+TEST_SUITE("path finder")
+{
+  TEST_CASE("answers on a later update")
+  {
+    const TestTiles& tiles = GetTestTiles();
+    World world;
+    Terrain& terrain = world.GetTerrain();
+    PathFinder finder(&world);
+    terrain.RegisterChangeListener(&finder);
+    FillWalledTerrain(terrain, tiles);
+
+    const PathFinder::Ticket near = finder.RequestPath({ 2, 4 }, { 40, 10 });
+    const PathFinder::Ticket far = finder.RequestPath({ 2, 4 }, { 90, 4 });
+    std::vector<WorldPos> path;
+    CHECK(finder.PollPath(near, path) == PathFinder::Status::kPending);
+
+    // Never answered during the update that they are handed to the workers
+    finder.Update();
+    CHECK(finder.PollPath(near, path) == PathFinder::Status::kPending);
+    CHECK(finder.GetPendingCount() == 2);
+    Settle(finder);
+
+    REQUIRE(finder.PollPath(near, path) == PathFinder::Status::kFound);
+    REQUIRE(path.size() == 39);
+    for (std::size_t i = 0; i < path.size(); i++) {
+      CHECK(path[i].X() == 2 + i);
+      CHECK(path[i].Y() == 4);
+      CHECK(finder.IsStandable(path[i]));
+    }
+    CHECK(finder.PollPath(near, path) == PathFinder::Status::kUnknown);
+    CHECK(finder.PollPath(far, path) == PathFinder::Status::kNotFound);
+
+    terrain.UnregisterChangeListener(&finder);
+  }
+
+  TEST_CASE("terrain changes and cancelled queries")
+  {
+    const TestTiles& tiles = GetTestTiles();
+    World world;
+    Terrain& terrain = world.GetTerrain();
+    PathFinder finder(&world);
+    terrain.RegisterChangeListener(&finder);
+    FillWalledTerrain(terrain, tiles);
+
+    // Nothing is built before the first query
+    finder.Update();
+    CHECK(!finder.IsStandable({ 2, 4 }));
+
+    std::vector<WorldPos> path;
+    const PathFinder::Ticket walled = finder.RequestPath({ 2, 4 }, { 90, 4 });
+    Settle(finder);
+    CHECK(finder.IsStandable({ 2, 4 }));
+    CHECK(finder.PollPath(walled, path) == PathFinder::Status::kNotFound);
+
+    // Tear down the wall, the queries after it see the new terrain
+    {
+      Terrain::EditBatch batch(terrain);
+      for (u32 y = 4; y < terrain.GetHeight(); y++) {
+        terrain.SetTile(WorldPos{ 50, y }, tiles.air);
+      }
+    }
+    const PathFinder::Ticket kept = finder.RequestPath({ 2, 4 }, { 90, 4 });
+    const PathFinder::Ticket cancelled =
+      finder.RequestPath({ 2, 4 }, { 90, 4 });
+    finder.CancelPath(cancelled);
+    Settle(finder);
+
+    REQUIRE(finder.PollPath(kept, path) == PathFinder::Status::kFound);
+    CHECK(path.size() == 89);
+    CHECK(path.back().X() == 90);
+    CHECK(finder.PollPath(cancelled, path) == PathFinder::Status::kUnknown);
+
+    terrain.UnregisterChangeListener(&finder);
+  }
+}
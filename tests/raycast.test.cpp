@@ -0,0 +1,129 @@
+#include "main.test.hpp"
+#include "terrain.test.hpp"
+#include "game/world.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+
+using namespace dib;
+using namespace dib::game;
+
+namespace {
+
+constexpr f32 kNoHit = std::numeric_limits<f32>::infinity();
+
+/**
+ * Distance along @ray to where it enters the cell, or kNoHit. Exact slab
+ * test, 0 if the ray starts inside of the cell.
+ */
+f32
+EntryDistance(const Terrain::Ray& ray, const u32 x, const u32 y)
+{
+  const Vector2F direction = glm::normalize(ray.direction);
+  f32 enter = 0.0f;
+  f32 exit = ray.maxDistance;
+  for (s32 axis = 0; axis < 2; axis++) {
+    const f32 min = f32(axis == 0 ? x : y);
+    const f32 max = min + 1.0f;
+    if (direction[axis] == 0.0f) {
+      if (ray.origin[axis] < min || ray.origin[axis] >= max) {
+        return kNoHit;
+      }
+      continue;
+    }
+    f32 t0 = (min - ray.origin[axis]) / direction[axis];
+    f32 t1 = (max - ray.origin[axis]) / direction[axis];
+    if (t0 > t1) {
+      std::swap(t0, t1);
+    }
+    enter = std::max(enter, t0);
+    exit = std::min(exit, t1);
+  }
+  return enter <= exit ? enter : kNoHit;
+}
+
+/**
+ * Brute force reference, the closest entry over every solid cell.
+ */
+f32
+ReferenceDistance(const Terrain& terrain,
+                  const TestTiles& tiles,
+                  const Terrain::Ray& ray)
+{
+  f32 closest = kNoHit;
+  for (u32 y = 0; y < terrain.GetHeight(); y++) {
+    for (u32 x = 0; x < terrain.GetWidth(); x++) {
+      if (terrain.GetTileID(WorldPos{ x, y }) == tiles.stone) {
+        closest = std::min(closest, EntryDistance(ray, x, y));
+      }
+    }
+  }
+  return closest;
+}
+
+}
+
+TEST_SUITE("terrain raycast")
+{
+  TEST_CASE("matches brute force")
+  {
+    const TestTiles& tiles = GetTestTiles();
+    World world;
+    Terrain& terrain = world.GetTerrain();
+
+    // caves, a solid floor and a few scattered stones
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<f32> unit(0.0f, 1.0f);
+    constexpr u32 kWidth = 80;
+    constexpr u32 kHeight = 48;
+    FillTerrain(terrain, kWidth, kHeight, [&](const u32 x, const u32 y) {
+      const f32 cave = std::sin(x * 0.3f) + std::cos(y * 0.25f);
+      const bool solid = y < 4 || cave > 0.9f || unit(random) < 0.03f;
+      return solid ? tiles.stone : tiles.air;
+    });
+
+    std::uniform_real_distribution<f32> originX(-8.0f, kWidth + 8.0f);
+    std::uniform_real_distribution<f32> originY(-8.0f, kHeight + 8.0f);
+    std::uniform_real_distribution<f32> angle(0.0f, 6.2831853f);
+    std::uniform_real_distribution<f32> distance(0.0f, 120.0f);
+    u32 hits = 0;
+    for (u32 i = 0; i < 2000; i++) {
+      const f32 a = angle(random);
+      Terrain::Ray ray{ Vector2F{ originX(random), originY(random) },
+                        Vector2F{ std::cos(a), std::sin(a) } * 3.0f,
+                        distance(random) };
+      // every tenth ray is axis aligned, through the middle of the cells
+      if (i % 10 == 0) {
+        const Vector2F axes[] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+        ray.origin = glm::floor(ray.origin) + 0.5f;
+        ray.direction = axes[(i / 10) % 4];
+      }
+
+      Terrain::RaycastHit hit;
+      const bool found = terrain.Raycast(ray, hit);
+      const f32 expected = ReferenceDistance(terrain, tiles, ray);
+      REQUIRE(found == (expected != kNoHit));
+      if (!found) {
+        continue;
+      }
+      hits++;
+
+      // the hit cell is solid and is entered where the reference enters the
+      // closest cell, a ray through a corner may pick either cell
+      CHECK(terrain.GetTileID(hit.pos) == tiles.stone);
+      CHECK(std::abs(hit.distance - expected) < 1e-3f);
+      CHECK(std::abs(EntryDistance(ray, hit.pos.X(), hit.pos.Y()) - expected) <
+            1e-3f);
+      const Vector2F point =
+        ray.origin + glm::normalize(ray.direction) * hit.distance;
+      CHECK(std::abs(hit.point.x - point.x) < 1e-3f);
+      CHECK(std::abs(hit.point.y - point.y) < 1e-3f);
+    }
+
+    // the terrain is dense enough that both outcomes are covered
+    CHECK(hits > 200);
+    CHECK(hits < 1900);
+  }
+}
@@ -0,0 +1,120 @@
+#include "main.test.hpp"
+#include "core/schema.hpp"
+#include "core/value_store.hpp"
+#include <vector>
+
+using namespace dib;
+
+namespace {
+
+#pragma pack(push, 1)
+struct Fixed
+{
+  u32 a;
+  f32 b;
+  u8 c;
+
+  static constexpr auto GetSchema()
+  {
+    return MakeSchema(&Fixed::a, &Fixed::b, &Fixed::c);
+  }
+};
+#pragma pack(pop)
+
+struct Partial
+{
+  u16 kept;
+  u64 skipped;
+  Fixed fixed;
+
+  static constexpr auto GetSchema()
+  {
+    return MakeSchema(&Partial::kept, &Partial::fixed);
+  }
+};
+
+struct Variable
+{
+  String name;
+  Fixed fixed;
+  ValueStore store;
+
+  static constexpr auto GetSchema()
+  {
+    return MakeSchema(&Variable::name, &Variable::fixed, &Variable::store);
+  }
+};
+
+/**
+ * Serialize @value into exactly its serialized size and read it back.
+ */
+template<typename T>
+T
+RoundTrip(const T& value)
+{
+  std::vector<u8> buffer(SerializedSize(value));
+  alflib::RawMemoryWriter mw{ buffer.data(), buffer.size() };
+  CHECK(Serializer<T>::Write(mw, value));
+  CHECK(mw.GetOffset() == buffer.size());
+
+  alflib::RawMemoryReader mr{ buffer.data(), buffer.size() };
+  return Serializer<T>::Read(mr);
+}
+
+}
+
+TEST_SUITE("schema")
+{
+  TEST_CASE("Fixed size")
+  {
+    using FixedSchema = decltype(Fixed::GetSchema());
+    static_assert(FixedSchema::kIsFixedSize);
+    static_assert(FixedSchema::kIsBytes);
+    static_assert(Serializer<Fixed>::kFixedSize == sizeof(Fixed));
+
+    using PartialSchema = decltype(Partial::GetSchema());
+    static_assert(PartialSchema::kIsFixedSize);
+    static_assert(!PartialSchema::kIsBytes);
+    static_assert(Serializer<Partial>::kFixedSize ==
+                  sizeof(u16) + sizeof(Fixed));
+
+    const Fixed fixed{ 7, 1.5f, 3 };
+    const Fixed fixed_read = RoundTrip(fixed);
+    CHECK(fixed_read.a == 7);
+    CHECK(fixed_read.b == 1.5f);
+    CHECK(fixed_read.c == 3);
+
+    Partial partial{};
+    partial.kept = 12;
+    partial.skipped = 99;
+    partial.fixed = fixed;
+    const Partial partial_read = RoundTrip(partial);
+    CHECK(partial_read.kept == 12);
+    CHECK(partial_read.skipped == 0);
+    CHECK(partial_read.fixed.a == 7);
+  }
+
+  TEST_CASE("Variable size")
+  {
+    static_assert(!decltype(Variable::GetSchema())::kIsFixedSize);
+
+    Variable variable{};
+    variable.name = "player";
+    variable.fixed = Fixed{ 1, 2.0f, 3 };
+    variable.store.Store("count", u64{ 42 });
+    variable.store.Store("speed", f64{ 0.5 });
+    variable.store.Store("title", String{ "wizard" });
+    CHECK(SerializedSize(variable) ==
+          Serializer<String>::Size(variable.name) + sizeof(Fixed) +
+            variable.store.SerializedSize());
+
+    const Variable variable_read = RoundTrip(variable);
+    CHECK(variable_read.name == "player");
+    CHECK(variable_read.fixed.c == 3);
+    CHECK(variable_read.store == variable.store);
+
+    // empty strings are only their size
+    CHECK(SerializedSize(String{}) == sizeof(u32));
+    CHECK(RoundTrip(String{}) == String{});
+  }
+}
@@ -0,0 +1,54 @@
+#ifndef TERRAIN_TEST_HPP_
+#define TERRAIN_TEST_HPP_
+
+#include "game/terrain.hpp"
+#include "game/tile/tile.hpp"
+#include "game/tile/tile_registry.hpp"
+
+namespace dib::game {
+
+/**
+ * An empty and a solid tile for terrain tests, registered on first use.
+ */
+struct TestTiles
+{
+  TileRegistry::TileID air;
+  TileRegistry::TileID stone;
+};
+
+inline const TestTiles&
+GetTestTiles()
+{
+  static const TestTiles tiles = []() {
+    // the registry keeps pointers to the tiles for the whole run
+    TileRegistry& registry = TileRegistry::Instance();
+    Tile* air = new Tile(ResourcePath{ Path{ "./res/tiles/air.tga" } }, "air");
+    air->SetCollisionType(CollisionType::kNone);
+    registry.RegisterTile("test", "air", air);
+    Tile* stone =
+      new Tile(ResourcePath{ Path{ "./res/tiles/rock.tga" } }, "stone");
+    registry.RegisterTile("test", "stone", stone);
+    return TestTiles{ registry.GetTileID(air), registry.GetTileID(stone) };
+  }();
+  return tiles;
+}
+
+/**
+ * Resize the terrain and fill it with the tile returned by @tile(x, y).
+ */
+template<typename F>
+void
+FillTerrain(Terrain& terrain, const u32 width, const u32 height, F&& tile)
+{
+  terrain.Resize(width, height);
+  Terrain::EditBatch batch(terrain);
+  for (u32 y = 0; y < height; y++) {
+    for (u32 x = 0; x < width; x++) {
+      terrain.GenSetTile(WorldPos{ x, y }, tile(x, y));
+    }
+  }
+}
+
+}
+
+#endif // TERRAIN_TEST_HPP_
@@ -0,0 +1,75 @@
+#include "main.test.hpp"
+#include "game/tick_scheduler.hpp"
+
+#include <vector>
+
+using namespace dib;
+using namespace dib::game;
+
+TEST_SUITE("tick scheduler")
+{
+  TEST_CASE("due after delay")
+  {
+    TickScheduler scheduler;
+    scheduler.Schedule(1, 3);
+    scheduler.Schedule(2, 200);
+    scheduler.Schedule(3, 5000);
+
+    std::vector<u32> due;
+    std::vector<u64> ticks;
+    for (u32 i = 0; i < 6000; i++) {
+      scheduler.Advance();
+      const std::size_t before = due.size();
+      scheduler.PopReady(16, due);
+      for (std::size_t j = before; j < due.size(); j++) {
+        ticks.push_back(scheduler.GetTick());
+      }
+    }
+    REQUIRE(due.size() == 3);
+    CHECK(due[0] == 1);
+    CHECK(ticks[0] == 3);
+    CHECK(due[1] == 2);
+    CHECK(ticks[1] == 200);
+    CHECK(due[2] == 3);
+    CHECK(ticks[2] == 5000);
+    CHECK(scheduler.GetScheduledCount() == 0);
+  }
+
+  TEST_CASE("deduplicate keeps earliest")
+  {
+    TickScheduler scheduler;
+    scheduler.Schedule(7, 100);
+    scheduler.Schedule(7, 10);
+    scheduler.Schedule(7, 50);
+    CHECK(scheduler.GetScheduledCount() == 1);
+
+    std::vector<u32> due;
+    for (u32 i = 0; i < 200; i++) {
+      scheduler.Advance();
+      scheduler.PopReady(16, due);
+      if (scheduler.GetTick() == 10) {
+        CHECK(due.size() == 1);
+      }
+    }
+    CHECK(due.size() == 1);
+    CHECK_FALSE(scheduler.IsScheduled(7));
+  }
+
+  TEST_CASE("budget delays ready keys")
+  {
+    TickScheduler scheduler;
+    for (u32 key = 0; key < 10; key++) {
+      scheduler.Schedule(key, 1);
+    }
+    scheduler.Advance();
+
+    std::vector<u32> due;
+    CHECK(scheduler.PopReady(4, due) == 4);
+    CHECK(scheduler.GetReadyCount() == 6);
+    scheduler.Advance();
+    CHECK(scheduler.PopReady(4, due) == 4);
+    scheduler.Advance();
+    CHECK(scheduler.PopReady(4, due) == 2);
+    CHECK(due.size() == 10);
+  }
+}
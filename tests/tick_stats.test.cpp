@@ -0,0 +1,42 @@
+#include "main.test.hpp"
+#include "game/tick_stats.hpp"
+
+using namespace dib;
+using namespace dib::game;
+
+TEST_SUITE("tick stats")
+{
+  TEST_CASE("percentiles")
+  {
+    TickStats stats;
+    CHECK(stats.GetPercentile(50) == 0.0);
+
+    // 1ms to 100ms, in random-ish order
+    for (u32 i = 0; i < 100; i++) {
+      stats.RecordTick(((i * 37) % 100 + 1) / 1000.0);
+    }
+    CHECK(stats.GetTickCount() == 100);
+    CHECK(stats.GetPercentile(0) == doctest::Approx(0.001));
+    CHECK(stats.GetPercentile(50) == doctest::Approx(0.051).epsilon(0.02));
+    CHECK(stats.GetPercentile(99) == doctest::Approx(0.099).epsilon(0.02));
+    CHECK(stats.GetMax() == doctest::Approx(0.1));
+
+    stats.Reset();
+    CHECK(stats.GetTickCount() == 0);
+    CHECK(stats.GetMax() == 0.0);
+  }
+
+  TEST_CASE("window")
+  {
+    TickStats stats;
+    for (u32 i = 0; i < TickStats::kWindowSize; i++) {
+      stats.RecordTick(1.0);
+    }
+    // Old ticks fall out of the window
+    for (u32 i = 0; i < TickStats::kWindowSize; i++) {
+      stats.RecordTick(0.5);
+    }
+    CHECK(stats.GetTickCount() == 2 * TickStats::kWindowSize);
+    CHECK(stats.GetMax() == doctest::Approx(0.5));
+  }
+}
@@ -0,0 +1,52 @@
+#include "main.test.hpp"
+#include "core/worker_pool.hpp"
+
+#include <atomic>
+#include <vector>
+
+using namespace dib;
+
+TEST_SUITE("worker pool")
+{
+  TEST_CASE("parallel for")
+  {
+    for (const u32 thread_count : { 0u, 1u, 3u }) {
+      WorkerPool pool(thread_count);
+      std::vector<u32> visits(1000, 0);
+      std::vector<u32> threads(visits.size(), ~0u);
+
+      // the same pool is reused, no threads are created per call
+      for (u32 round = 0; round < 3; round++) {
+        pool.ParallelFor(static_cast<u32>(visits.size()),
+                         [&](const u32 i, const u32 thread) {
+                           visits[i]++;
+                           threads[i] = thread;
+                         });
+      }
+      for (std::size_t i = 0; i < visits.size(); i++) {
+        CHECK(visits[i] == 3);
+        CHECK(threads[i] <= thread_count);
+      }
+    }
+  }
+
+  TEST_CASE("submit and wait")
+  {
+    WorkerPool pool(2);
+    std::atomic<u32> sum{ 0 };
+    for (u32 i = 1; i <= 100; i++) {
+      pool.Submit([&sum, i](const u32 thread) {
+        CHECK(thread < 2);
+        sum += i;
+      });
+    }
+
+    // blocking work still runs while submitted tasks are in flight
+    std::atomic<u32> count{ 0 };
+    pool.ParallelFor(10, [&count](const u32, const u32) { count++; });
+    CHECK(count == 10);
+
+    pool.Wait();
+    CHECK(sum == 5050);
+  }
+}